@@ -0,0 +1,65 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// The client's per-frame micro-benchmarks, the ones the -benchmark launch option runs on the
+// device, on the host: writes the JSON results to the path given as the first argument (or to
+// the client's temp directory) and prints them. Fails when an operation exceeds its budget, such
+// as PoseFilter::kBudgetNs. Built with the allocation audit so allocations per op are counted.
+// The client is connected to the stand-in server first, so the audio callbacks write to an open
+// playback stream and send to a streaming receiver.
+#include <string>
+#include "ClientFixture.h"
+#include "MicroBenchmark.h"
+#include "StandinCloudXR.h"
+#include "StandinOboe.h"
+#include "StandinPxr.h"
+
+int main(int argc, char **argv) {
+    StandinPxr::Reset();
+    StandinOboe::Reset();
+    // the server sends no audio of its own, so whatever reaches the streams is the benchmarks'
+    StandinServerProfile profile;
+    profile.audioFrameMs = 0;
+    StandinCloudXR::SetProfile(profile);
+    ClientFixture fixture("client_benchmarks");
+    if (!CHECK(fixture.Connect())) {
+        return TestResult("ClientBenchmarks");
+    }
+    const cxrReceiverHandle receiver = StandinCloudXR::GetLastReceiver();
+    MicroBenchmark benchmark;
+    fixture.client->AddBenchmarks(benchmark);
+    const std::vector<BenchmarkResult> &results = benchmark.Run();
+    benchmark.Log();
+
+    const std::string path = argc > 1 ? argv[1] : fixture.dir + "/benchmarks.json";
+    if (CHECK(benchmark.WriteJson(path))) {
+        FILE *file = fopen(path.c_str(), "r");
+        if (CHECK(file != nullptr)) {
+            char buffer[4096];
+            size_t read;
+            while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+                fwrite(buffer, 1, read, stdout);
+            }
+            fclose(file);
+        }
+    }
+
+    uint32_t budgeted = 0;
+    for (const BenchmarkResult &result : results) {
+        CHECK(result.iterations > 0 && result.nsPerOp > 0);
+        // the audit build counts them; the per-frame functions do not allocate
+        CHECK(result.allocsPerOp >= 0 && result.allocsPerOp < 0.01);
+        if (result.budgetNsPerOp > 0) {
+            budgeted++;
+            if (result.nsPerOp > result.budgetNsPerOp) {
+                fprintf(stderr, "%s: %.1f ns/op over its budget of %.1f\n", result.name, result.nsPerOp,
+                        result.budgetNsPerOp);
+            }
+        }
+    }
+    CHECK(budgeted > 0);
+    // RenderAudio wrote its frames and onAudioReady sent them, rather than dropping them
+    CHECK(StandinOboe::GetFramesWritten() > 0);
+    CHECK(StandinCloudXR::GetCounters(receiver).audioFramesSent > 0);
+    CHECK(StandinCloudXR::GetLastReceiver() == receiver);
+    CHECK(benchmark.GetOverBudgetCount() == 0);
+    return TestResult("ClientBenchmarks");
+}
@@ -0,0 +1,78 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Caller-side cost of the LOGI/LOGE macros: queueing a record for the flusher thread, against
+// formatting and writing synchronously as __android_log_print does, and a call below the
+// minimum priority.
+#include <algorithm>
+#include <stdio.h>
+#include <vector>
+#include "util.h"
+#include "TestUtil.h"
+
+namespace {
+    const uint32_t kBatches = 200;
+    // stays below the ring capacity, so nothing is dropped
+    const uint32_t kCallsPerBatch = AsyncLog::kRingCapacity / 2;
+
+    // median of the per-batch costs, so a batch the scheduler preempted does not count
+    template<typename Fn>
+    double NsPerCall(Fn fn) {
+        std::vector<double> batches;
+        batches.reserve(kBatches);
+        for (uint32_t batch = 0; batch < kBatches; batch++) {
+            const uint64_t startNs = TestUtil::NowNs();
+            for (uint32_t i = 0; i < kCallsPerBatch; i++) {
+                fn(i);
+            }
+            batches.push_back(double(TestUtil::NowNs() - startNs) / kCallsPerBatch);
+            AsyncLog::Flush();
+        }
+        std::nth_element(batches.begin(), batches.begin() + kBatches / 2, batches.end());
+        return batches[kBatches / 2];
+    }
+}
+
+int main() {
+    AsyncLog::SetFile("/dev/null");
+    FILE *sink = fopen("/dev/null", "w");
+    const char *name = "playback";
+    const float fps = 71.9f;
+
+    // warm-up: the first batches fault in the ring and start the flusher
+    NsPerCall([](uint32_t) {
+        LOGI("Receiver created!");
+    });
+    const double noArgs = NsPerCall([](uint32_t) {
+        LOGI("Receiver created!");
+    });
+    const double numbers = NsPerCall([fps](uint32_t i) {
+        LOGI("clientstats framesPerSecond:%f, frame:%u, latency:%.1fms", fps, i, 31.5);
+    });
+    const double string = NsPerCall([name](uint32_t i) {
+        LOGE("%s stream error %d", name, int(i));
+    });
+    const double limited = NsPerCall([](uint32_t i) {
+        LOGE_RATE_LIMITED(1000, "Error in LatchFrame [%0d]", int(i));
+    });
+    AsyncLog::SetMinPriority(AsyncLogPriority_Error);
+    const double disabled = NsPerCall([fps](uint32_t i) {
+        LOGI("clientstats framesPerSecond:%f, frame:%u, latency:%.1fms", fps, i, 31.5);
+    });
+    AsyncLog::SetMinPriority(AsyncLogPriority_Debug);
+    const double sync = NsPerCall([sink, fps](uint32_t i) {
+        char line[256];
+        snprintf(line, sizeof(line), "clientstats framesPerSecond:%f, frame:%u, latency:%.1fms", fps, i, 31.5);
+        fputs(line, sink);
+        fflush(sink);
+    });
+    fclose(sink);
+
+    printf("{\"benchmark\":\"LogCallCost\",\"calls\":%u,\"nsPerCall\":{\"noArgs\":%.1f,\"numbers\":%.1f,"
+           "\"string\":%.1f,\"rateLimited\":%.1f,\"disabled\":%.1f,\"synchronous\":%.1f}}\n",
+           kBatches * kCallsPerBatch, noArgs, numbers, string, limited, disabled, sync);
+    CHECK(AsyncLog::GetDroppedCount() == 0);
+    // queueing skips the formatting and the write, so it beats doing both on the caller
+    CHECK(numbers < sync);
+    CHECK(disabled < numbers);
+    AsyncLog::Shutdown();
+    return TestResult("LogCallCost");
+}
@@ -0,0 +1,80 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Runtime queries per frame with the device state cache, against the per-call queries it
+// replaced: one IPD query per tracking callback, connect status and capabilities per hand per
+// callback, and a connect status query per hand per rendered frame.
+#include <string>
+#include "CloudXRClientPXR.h"
+#include "StandinPxr.h"
+#include "TestUtil.h"
+
+namespace {
+    const uint32_t kFps = 72;
+    const uint32_t kSeconds = 10;
+    const uint32_t kLegacyQueriesPerFrame = 1 + PXR_CONTROLLER_COUNT * 2 + PXR_CONTROLLER_COUNT;
+}
+
+int main() {
+    StandinPxr::Reset();
+    const std::string dir = TestUtil::MakeTempDir("pxr_call_count");
+    TestUtil::WriteFile(dir + "/options.txt", "");
+    CloudXRClientPXR client((dir + "/options.txt").c_str());
+    client.SetDataDir(dir);
+    PxrDeviceState &device = client.GetDeviceState();
+    device.Refresh();
+    CHECK(device.GetIPD() > 0.06f);
+    CHECK(device.IsControllerConnected(PXR_CONTROLLER_LEFT));
+    CHECK(device.IsControllerConnected(PXR_CONTROLLER_RIGHT));
+
+    // what dispatch_events, render_frame and the tracking callback do per frame, on simulated time
+    StandinPxr::ResetCallCounts();
+    const uint32_t frames = kFps * kSeconds;
+    uint32_t connectedChecks = 0;
+    cxrVRTrackingState tracking;
+    const uint64_t startNs = TestUtil::NowNs();
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        device.RefreshIfStale(frame * 1000ULL / kFps + 1);
+        for (uint32_t hand = 0; hand < PXR_CONTROLLER_COUNT; hand++) {
+            connectedChecks += device.IsControllerConnected(hand) ? 1 : 0;
+        }
+        client.GetTrackingState(&tracking);
+    }
+    const uint64_t elapsedNs = TestUtil::NowNs() - startNs;
+    CHECK(connectedChecks == frames * PXR_CONTROLLER_COUNT);
+    CHECK(tracking.hmd.ipd > 0.06f);
+
+    const uint64_t ipd = StandinPxr::GetCallCount(StandinPxrCall_GetIPD);
+    const uint64_t status = StandinPxr::GetCallCount(StandinPxrCall_GetControllerConnectStatus);
+    const uint64_t caps = StandinPxr::GetCallCount(StandinPxrCall_GetControllerCapabilities);
+    const uint64_t input = StandinPxr::GetCallCount(StandinPxrCall_GetControllerInputState);
+    const uint64_t cached = ipd + status + caps;
+    const uint64_t legacy = uint64_t(frames) * kLegacyQueriesPerFrame;
+    printf("%u frames: device queries cached:%llu (ipd:%llu, status:%llu, caps:%llu), per call:%llu, "
+           "input state:%llu, %.2fus per frame\n",
+           frames, (unsigned long long) cached, (unsigned long long) ipd, (unsigned long long) status,
+           (unsigned long long) caps, (unsigned long long) legacy, (unsigned long long) input,
+           elapsedNs / 1000.0 / frames);
+
+    // only the low-rate refresh queries the runtime: every 2s, IPD plus status and caps per hand
+    const uint64_t refreshes = kSeconds / 2;
+    CHECK(ipd <= refreshes);
+    CHECK(status <= refreshes * PXR_CONTROLLER_COUNT);
+    CHECK(caps <= refreshes * PXR_CONTROLLER_COUNT);
+    CHECK(cached * 100 < legacy);
+    // the input state is still read once per hand per callback
+    CHECK(input == uint64_t(frames) * PXR_CONTROLLER_COUNT);
+
+    // a controller event re-queries only that controller
+    StandinPxr::ResetCallCounts();
+    StandinPxr::SetControllerConnected(PXR_CONTROLLER_RIGHT, false);
+    PxrEventDataControllerChanged event = {};
+    event.type = PXR_TYPE_EVENT_DATA_CONTROLLER;
+    event.controller = PXR_CONTROLLER_RIGHT;
+    device.OnControllerEvent(event);
+    CHECK(!device.IsControllerConnected(PXR_CONTROLLER_RIGHT));
+    CHECK(device.IsControllerConnected(PXR_CONTROLLER_LEFT));
+    CHECK(StandinPxr::GetQueryCount() == 1);
+
+    client.GetTrackingState(&tracking);
+    CHECK(StandinPxr::GetCallCount(StandinPxrCall_GetControllerInputState) == 1);
+    return TestResult("PxrCallCount");
+}
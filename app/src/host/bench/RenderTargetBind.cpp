@@ -0,0 +1,197 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Per-frame cost of binding the eye render targets: one framebuffer per eye with the swapchain
+// texture re-attached every frame, against the RenderTargetPool's framebuffer per image. The
+// attach calls are counted by wrapping glFramebufferTexture2D, so the pool's saving is checked
+// on the calls it skips as well as on the CPU time.
+#include <dlfcn.h>
+#include <GLES3/gl3.h>
+#include <algorithm>
+#include <string>
+#include <time.h>
+#include <vector>
+#include "graphicsplugin.h"
+#include "StandinPxr.h"
+#include "TestUtil.h"
+
+namespace {
+    const int kLayerId = 0;
+    const uint32_t kSize = 256;
+    const uint32_t kWarmupFrames = 30;
+    const uint32_t kFrames = 300;
+    // the two ways alternate frame by frame, so load from other processes hits both alike; each
+    // keeps its fastest round
+    const uint32_t kRounds = 11;
+    // llvmpipe reports its clock for some timer queries instead of the time elapsed; anything
+    // this long is not a frame
+    const uint64_t kMaxGpuFrameNs = 1000000000ULL;
+
+    // the pool's share of re-attaching's CPU time in the median round must stay below this;
+    // it is 0.89 to 0.96 with the fault soak running alongside
+    const double kMaxCpuShare = 1.0;
+
+    uint64_t gAttachCount = 0;
+
+    // Draws a little into a target so its framebuffer state is actually validated.
+    void DrawEye(uint32_t eye, uint32_t frame) {
+        glViewport(0, 0, kSize, kSize);
+        glClearColor(eye, (frame % 255) / 255.0f, 0, 1);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    uint64_t ThreadCpuNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+    struct Result {
+        double cpuUsPerFrame;
+        double gpuUsPerFrame;
+        double attachesPerFrame;
+        // CPU time of this thread alone, which load from other processes does not inflate
+        double threadCpuUsPerFrame;
+    };
+
+    // One way of binding, measured over the frames of a round.
+    struct Measurement {
+        double cpuNs = 0, gpuNs = 0, threadCpuNs = 0;
+        uint32_t gpuFrames = 0;
+        uint64_t attaches = 0;
+
+        template<typename BindFn>
+        void Frame(IGraphicsPlugin &graphics, BindFn bind, uint32_t frame) {
+            const uint32_t image = frame % StandinPxr::kLayerImageCount;
+            const uint64_t attachesBefore = gAttachCount;
+            const uint64_t threadCpuStartNs = ThreadCpuNs();
+            graphics.BeginFrameTiming();
+            for (uint32_t eye = 0; eye < PXR_EYE_MAX; eye++) {
+                bind(eye, image);
+                DrawEye(eye, frame);
+            }
+            graphics.EndFrameTiming();
+            const uint64_t threadCpuEndNs = ThreadCpuNs();
+            glFlush();
+            if (frame < kWarmupFrames) {
+                return;
+            }
+            attaches += gAttachCount - attachesBefore;
+            threadCpuNs += threadCpuEndNs - threadCpuStartNs;
+            const FrameTiming timing = graphics.GetFrameTiming();
+            cpuNs += timing.cpuTimeNs;
+            if (timing.gpuTimeNs > 0 && timing.gpuTimeNs < kMaxGpuFrameNs) {
+                gpuNs += timing.gpuTimeNs;
+                gpuFrames++;
+            }
+        }
+
+        Result GetResult() const {
+            return {cpuNs / kFrames / 1000, gpuFrames > 0 ? gpuNs / gpuFrames / 1000 : 0, double(attaches) / kFrames,
+                    threadCpuNs / kFrames / 1000};
+        }
+    };
+
+    bool ReadsBack(GLuint texture, uint8_t red) {
+        GLuint framebuffer = 0;
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        uint8_t pixel[4] = {};
+        glReadPixels(kSize / 2, kSize / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &framebuffer);
+        return pixel[0] == red;
+    }
+}
+
+// Counts the attach calls of the bench and of the plugin linked into it.
+extern "C" void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
+    typedef void (*Attach)(GLenum, GLenum, GLenum, GLuint, GLint);
+    static const Attach attach = (Attach) dlsym(RTLD_NEXT, "glFramebufferTexture2D");
+    gAttachCount++;
+    attach(target, attachment, textarget, texture, level);
+}
+
+int main() {
+    StandinPxr::Reset();
+    GraphicsOptions options;
+    options.surfaceless = true;
+    std::shared_ptr<IGraphicsPlugin> graphics = CreateGraphicsPlugin(GraphicsApi_OpenGLES, options);
+    graphics->InitializeDevice();
+    cxrGraphicsContext context{};
+    if (!CHECK(graphics->GetCloudXRContext(&context))) {
+        return TestResult("RenderTargetBind");
+    }
+
+    PxrLayerParam layerParam = {};
+    layerParam.layerId = kLayerId;
+    layerParam.layerShape = PXR_LAYER_PROJECTION;
+    layerParam.layerLayout = PXR_LAYER_LAYOUT_STEREO;
+    layerParam.width = kSize;
+    layerParam.height = kSize;
+    layerParam.faceCount = 1;
+    layerParam.mipmapCount = 1;
+    layerParam.sampleCount = 1;
+    layerParam.arraySize = 1;
+    layerParam.format = GL_RGBA8;
+    CHECK(Pxr_CreateLayer(&layerParam) == 0);
+    CHECK(graphics->CreateRenderTargets(kLayerId, PXR_EYE_MAX));
+
+    // what SetupFramebuffer did: a framebuffer per eye, the image re-attached every frame
+    GLuint eyeFramebuffers[PXR_EYE_MAX] = {};
+    glGenFramebuffers(PXR_EYE_MAX, eyeFramebuffers);
+    bool bound = true;
+    const auto reattachBind = [&](uint32_t eye, uint32_t image) {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, eyeFramebuffers[eye]);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                               (GLuint) StandinPxr::GetLayerImage(kLayerId, eye, image), 0);
+    };
+    const auto poolBind = [&](uint32_t eye, uint32_t image) {
+        bound &= graphics->BindRenderTarget(eye, image);
+    };
+    Result reattach{}, pool{};
+    // per round, the pool's share of re-attaching's thread CPU time
+    std::vector<double> cpuShares;
+    for (uint32_t round = 0; round < kRounds; round++) {
+        Measurement reattachMeasurement, poolMeasurement;
+        for (uint32_t frame = 0; frame < kWarmupFrames + kFrames; frame++) {
+            reattachMeasurement.Frame(*graphics, reattachBind, frame);
+            poolMeasurement.Frame(*graphics, poolBind, frame);
+        }
+        glFinish();
+        const Result reattachRound = reattachMeasurement.GetResult();
+        const Result poolRound = poolMeasurement.GetResult();
+        cpuShares.push_back(poolRound.threadCpuUsPerFrame / reattachRound.threadCpuUsPerFrame);
+        if (round == 0 || reattachRound.cpuUsPerFrame < reattach.cpuUsPerFrame) {
+            reattach = reattachRound;
+        }
+        if (round == 0 || poolRound.cpuUsPerFrame < pool.cpuUsPerFrame) {
+            pool = poolRound;
+        }
+    }
+    glDeleteFramebuffers(PXR_EYE_MAX, eyeFramebuffers);
+    CHECK(bound);
+    CHECK(glGetError() == GL_NO_ERROR);
+
+    // the last frame drew into the last image of each eye, red = eye
+    const uint32_t lastImage = (kWarmupFrames + kFrames - 1) % StandinPxr::kLayerImageCount;
+    CHECK(ReadsBack((GLuint) StandinPxr::GetLayerImage(kLayerId, PXR_EYE_LEFT, lastImage), 0));
+    CHECK(ReadsBack((GLuint) StandinPxr::GetLayerImage(kLayerId, PXR_EYE_RIGHT, lastImage), 255));
+
+    std::sort(cpuShares.begin(), cpuShares.end());
+    const double medianCpuShare = cpuShares[kRounds / 2];
+    printf("{\"benchmark\":\"RenderTargetBind\",\"frames\":%u,\"size\":%u,\"medianCpuShare\":%.3f,"
+           "\"reattach\":{\"cpuUs\":%.2f,\"gpuUs\":%.2f,\"attaches\":%.2f},"
+           "\"pool\":{\"cpuUs\":%.2f,\"gpuUs\":%.2f,\"attaches\":%.2f}}\n",
+           kFrames, kSize, medianCpuShare, reattach.cpuUsPerFrame, reattach.gpuUsPerFrame, reattach.attachesPerFrame,
+           pool.cpuUsPerFrame, pool.gpuUsPerFrame, pool.attachesPerFrame);
+    // the pool attaches each image once, when its framebuffer is created, and never per frame
+    CHECK(reattach.attachesPerFrame == PXR_EYE_MAX);
+    CHECK(pool.attachesPerFrame == 0);
+    // so a plain bind costs less than re-attaching and re-validating
+    CHECK(medianCpuShare < kMaxCpuShare);
+
+    graphics->ReleaseRenderTargets();
+    Pxr_DestroyLayer(kLayerId);
+    graphics->Shutdown();
+    return TestResult("RenderTargetBind");
+}
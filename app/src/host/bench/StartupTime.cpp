@@ -0,0 +1,89 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Time to first frame of a cold start, from android_main to the first streamed frame submitted,
+// with the stand-ins taking as long as the real Oboe and CloudXR bring-up. Prints the startup
+// timeline of each launch and checks that opening the audio streams overlaps creating the
+// receiver instead of adding to it.
+#include <algorithm>
+#include <unistd.h>
+#include "AppHarness.h"
+#include "StartupTimeline.h"
+#include "StandinCloudXR.h"
+#include "StandinOboe.h"
+#include "StandinPxr.h"
+
+namespace {
+    const uint32_t kLaunches = 3;
+    // each of the playback and recording streams
+    const uint32_t kAudioOpenMs = 60;
+    const uint32_t kReceiverCreateMs = 120;
+    const uint32_t kConnectMs = 50;
+    // from android_main to the first frame, with llvmpipe and a loaded machine to spare
+    const uint32_t kBudgetMs = 5000;
+
+    double PhaseMs(StartupPhase phase) {
+        const uint64_t startNs = StartupTimeline::GetPhaseNs(StartupPhase_MainEntered);
+        const uint64_t phaseNs = StartupTimeline::GetPhaseNs(phase);
+        return phaseNs >= startNs ? (phaseNs - startNs) / 1e6 : -1;
+    }
+
+    bool WaitForPhase(StartupPhase phase, uint32_t timeoutMs) {
+        const uint64_t deadlineNs = TestUtil::NowNs() + timeoutMs * 1000000ULL;
+        while (StartupTimeline::GetPhaseNs(phase) == 0) {
+            if (TestUtil::NowNs() > deadlineNs) {
+                return false;
+            }
+            usleep(1000);
+        }
+        return true;
+    }
+}
+
+int main() {
+    StandinPxr::Reset();
+    StandinPxr::SetViewSize(256, 256);
+    StandinOboe::Reset();
+    StandinOboe::SetOpenDelayMs(kAudioOpenMs);
+    StandinServerProfile profile;
+    profile.createDelayMs = kReceiverCreateMs;
+    profile.connectDelayMs = kConnectMs;
+    StandinCloudXR::SetProfile(profile);
+
+    for (uint32_t launch = 0; launch < kLaunches; launch++) {
+        const AppRunResult result = RunApp("startup_time", "-s 127.0.0.1", [launch](android_app *app) {
+            StandinAndroid::PostCommand(app, APP_CMD_RESUME);
+            if (!CHECK(WaitForPhase(StartupPhase_FirstFrameSubmitted, kBudgetMs))) {
+                return;
+            }
+            printf("{\"benchmark\":\"StartupTime\",\"launch\":%u,\"phasesMs\":{", launch);
+            for (int phase = 0; phase < StartupPhase_Count; phase++) {
+                printf("%s\"%s\":%.1f", phase > 0 ? "," : "", StartupTimeline::GetPhaseName(StartupPhase(phase)),
+                       PhaseMs(StartupPhase(phase)));
+            }
+            // receiver and audio are set up from the first HandleStateChanges() after Pxr is ready
+            const double setupMs = std::max(PhaseMs(StartupPhase_ReceiverCreated), PhaseMs(StartupPhase_AudioReady)) -
+                                   PhaseMs(StartupPhase_PxrReady);
+            const uint32_t serialSetupMs = kReceiverCreateMs + 2 * kAudioOpenMs;
+            const double firstFrameMs = PhaseMs(StartupPhase_FirstFrameSubmitted);
+            printf("},\"receiverAndAudioMs\":%.1f,\"serialReceiverAndAudioMs\":%u,\"timeToFirstFrameMs\":%.1f}\n",
+                   setupMs, serialSetupMs, firstFrameMs);
+            fflush(stdout);
+
+            for (int phase = 0; phase < StartupPhase_Count; phase++) {
+                CHECK(PhaseMs(StartupPhase(phase)) >= 0);
+            }
+            // Pxr needs the context, the first frame needs everything before it
+            CHECK(PhaseMs(StartupPhase_PxrReady) >= PhaseMs(StartupPhase_GraphicsReady));
+            CHECK(PhaseMs(StartupPhase_PxrReady) >= PhaseMs(StartupPhase_OptionsLoaded));
+            CHECK(PhaseMs(StartupPhase_Connected) >= PhaseMs(StartupPhase_ReceiverCreated));
+            CHECK(PhaseMs(StartupPhase_FirstFrameLatched) >= PhaseMs(StartupPhase_Connected));
+            CHECK(firstFrameMs >= PhaseMs(StartupPhase_FirstFrameLatched));
+            // the streams open while the receiver is created, well under doing one after the other
+            CHECK(setupMs >= kReceiverCreateMs);
+            CHECK(setupMs < serialSetupMs * 0.8);
+            CHECK(firstFrameMs < kBudgetMs);
+        }, kBudgetMs * 2);
+        CHECK(result.exited && result.exitStatus == 0);
+        TestUtil::Failures() += result.failures;
+    }
+    return TestResult("StartupTime");
+}
@@ -0,0 +1,189 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Per-frame CPU and GPU time of the two eye layouts render_frame supports: a stereo layer with a
+// bind, viewport and blit per eye, and a double-wide layer with one bind and one blit of both
+// eyes. Frames come from the stand-in CloudXR server, which counts the blit calls.
+#include <GLES3/gl3.h>
+#include <algorithm>
+#include <time.h>
+#include <vector>
+#include "graphicsplugin.h"
+#include "ClientFixture.h"
+#include "StandinCloudXR.h"
+#include "StandinPxr.h"
+
+namespace {
+    const uint32_t kEyeSize = 512;
+    const uint32_t kWarmupFrames = 10;
+    const uint32_t kFrames = 40;
+    // the two layouts alternate this many times, so load from other processes hits both alike
+    const uint32_t kRounds = 15;
+    // how much slower than stereo the double-wide layout may come out in the median round, for
+    // the noise left when other processes run: up to 4% seen with the fault soak alongside
+    const double kNoiseShare = 0.1;
+    // llvmpipe reports its clock for timer queries around blits instead of the time elapsed;
+    // anything this long is not a frame
+    const uint64_t kMaxGpuFrameNs = 1000000000ULL;
+
+    struct Result {
+        double cpuUsPerFrame;
+        double gpuUsPerFrame;
+        uint32_t binds;
+        double blitsPerFrame;
+        // CPU time of the render thread alone, which load from other processes does not inflate
+        double threadCpuUsPerFrame;
+    };
+
+    uint64_t ThreadCpuNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+    // the eye part of render_frame, for one layout
+    Result Run(IGraphicsPlugin &graphics, CloudXRClientPXR &client, int layerId, bool doubleWide) {
+        const cxrReceiverHandle receiver = StandinCloudXR::GetLastReceiver();
+        uint64_t blitCalls = 0, threadCpuNs = 0;
+        PxrLayerParam layerParam = {};
+        layerParam.layerId = layerId;
+        layerParam.layerShape = PXR_LAYER_PROJECTION;
+        layerParam.layerLayout = doubleWide ? PXR_LAYER_LAYOUT_DOUBLE_WIDE : PXR_LAYER_LAYOUT_STEREO;
+        layerParam.width = doubleWide ? kEyeSize * PXR_EYE_MAX : kEyeSize;
+        layerParam.height = kEyeSize;
+        layerParam.faceCount = 1;
+        layerParam.mipmapCount = 1;
+        layerParam.sampleCount = 1;
+        layerParam.arraySize = 1;
+        layerParam.format = GL_RGBA8;
+        CHECK(Pxr_CreateLayer(&layerParam) == 0);
+        CHECK(graphics.CreateRenderTargets(layerId, doubleWide ? 1 : PXR_EYE_MAX));
+
+        Result result = {};
+        double cpuNs = 0, gpuNs = 0;
+        uint32_t gpuFrames = 0, latched = 0;
+        for (uint32_t frame = 0; frame < kWarmupFrames + kFrames; frame++) {
+            cxrFramesLatched framesLatched;
+            const bool frameValid = client.LatchFrame(&framesLatched);
+            latched += frameValid ? 1 : 0;
+            int imageIndex = 0;
+            Pxr_GetLayerNextImageIndex(layerId, &imageIndex);
+
+            const uint64_t blitCallsBefore = StandinCloudXR::GetCounters(receiver).blitCalls;
+            const uint64_t threadCpuStartNs = ThreadCpuNs();
+            graphics.BeginFrameTiming();
+            if (doubleWide) {
+                if (graphics.BindRenderTarget(PXR_EYE_LEFT, imageIndex)) {
+                    result.binds++;
+                    client.BlitStereoFrame(&framesLatched, frameValid, kEyeSize, kEyeSize);
+                }
+            } else {
+                for (int eye = 0; eye < PXR_EYE_MAX; eye++) {
+                    if (graphics.BindRenderTarget(eye, imageIndex)) {
+                        result.binds++;
+                        cxrVideoFrame &vf = framesLatched.frames[eye];
+                        glViewport(0, 0, vf.widthFinal, vf.heightFinal);
+                        client.BlitFrame(&framesLatched, frameValid, eye);
+                    }
+                }
+            }
+            graphics.EndFrameTiming();
+            if (frame >= kWarmupFrames) {
+                threadCpuNs += ThreadCpuNs() - threadCpuStartNs;
+                blitCalls += StandinCloudXR::GetCounters(receiver).blitCalls - blitCallsBefore;
+            }
+            if (frameValid) {
+                client.ReleaseFrame(&framesLatched);
+            }
+            glFlush();
+
+            const FrameTiming timing = graphics.GetFrameTiming();
+            if (frame >= kWarmupFrames) {
+                cpuNs += timing.cpuTimeNs;
+                if (timing.gpuTimeNs > 0 && timing.gpuTimeNs < kMaxGpuFrameNs) {
+                    gpuNs += timing.gpuTimeNs;
+                    gpuFrames++;
+                }
+            }
+        }
+        glFinish();
+        CHECK(latched == kWarmupFrames + kFrames);
+        CHECK(glGetError() == GL_NO_ERROR);
+        graphics.ReleaseRenderTargets();
+        Pxr_DestroyLayer(layerId);
+
+        result.cpuUsPerFrame = cpuNs / kFrames / 1000;
+        result.gpuUsPerFrame = gpuFrames > 0 ? gpuNs / gpuFrames / 1000 : 0;
+        result.binds /= kWarmupFrames + kFrames;
+        result.blitsPerFrame = double(blitCalls) / kFrames;
+        result.threadCpuUsPerFrame = threadCpuNs / 1000.0 / kFrames;
+        return result;
+    }
+}
+
+int main() {
+    StandinPxr::Reset();
+    StandinPxr::SetViewSize(kEyeSize, kEyeSize);
+    StandinServerProfile profile;
+    // frames are always ready, so only the blit is measured
+    profile.fps = 1000;
+    profile.latencyMs = 0;
+    profile.audioFrameMs = 0;
+    StandinCloudXR::SetProfile(profile);
+
+    GraphicsOptions options;
+    options.surfaceless = true;
+    std::shared_ptr<IGraphicsPlugin> graphics = CreateGraphicsPlugin(GraphicsApi_OpenGLES, options);
+    graphics->InitializeDevice();
+    cxrGraphicsContext context{};
+    if (!CHECK(graphics->GetCloudXRContext(&context))) {
+        return TestResult("StereoBlit");
+    }
+    ClientFixture fixture("stereo_blit");
+    fixture.client->SetGraphicsContext(context);
+    if (!CHECK(fixture.Connect())) {
+        return TestResult("StereoBlit");
+    }
+    CloudXRClientPXR &client = *fixture.client;
+
+    const cxrReceiverHandle receiver = StandinCloudXR::GetLastReceiver();
+    Result stereo{}, doubleWide{};
+    // per round, double-wide over stereo CPU time, both measured back to back under the same load
+    std::vector<double> cpuShares;
+    uint64_t stereoFrames = 0, doubleWideFrames = 0;
+    for (uint32_t round = 0; round < kRounds; round++) {
+        uint64_t blitted = StandinCloudXR::GetCounters(receiver).framesBlitted;
+        const Result stereoRound = Run(*graphics, client, 0, false);
+        stereoFrames += StandinCloudXR::GetCounters(receiver).framesBlitted - blitted;
+        blitted = StandinCloudXR::GetCounters(receiver).framesBlitted;
+        const Result doubleWideRound = Run(*graphics, client, 1, true);
+        doubleWideFrames += StandinCloudXR::GetCounters(receiver).framesBlitted - blitted;
+        cpuShares.push_back(doubleWideRound.threadCpuUsPerFrame / stereoRound.threadCpuUsPerFrame);
+        if (round == 0 || stereoRound.cpuUsPerFrame < stereo.cpuUsPerFrame) {
+            stereo = stereoRound;
+        }
+        if (round == 0 || doubleWideRound.cpuUsPerFrame < doubleWide.cpuUsPerFrame) {
+            doubleWide = doubleWideRound;
+        }
+    }
+    std::sort(cpuShares.begin(), cpuShares.end());
+    const double medianCpuShare = cpuShares[kRounds / 2];
+
+    printf("{\"benchmark\":\"StereoBlit\",\"frames\":%u,\"eyeSize\":%u,\"medianCpuShare\":%.3f,"
+           "\"stereo\":{\"cpuUs\":%.2f,\"gpuUs\":%.2f,\"binds\":%u,\"blits\":%.2f},"
+           "\"doubleWide\":{\"cpuUs\":%.2f,\"gpuUs\":%.2f,\"binds\":%u,\"blits\":%.2f}}\n",
+           kFrames, kEyeSize, medianCpuShare, stereo.cpuUsPerFrame, stereo.gpuUsPerFrame, stereo.binds,
+           stereo.blitsPerFrame, doubleWide.cpuUsPerFrame, doubleWide.gpuUsPerFrame, doubleWide.binds,
+           doubleWide.blitsPerFrame);
+    // one framebuffer bind and one blit call per frame instead of one of each per eye
+    CHECK(stereo.binds == PXR_EYE_MAX);
+    CHECK(doubleWide.binds == 1);
+    CHECK(stereo.blitsPerFrame == PXR_EYE_MAX);
+    CHECK(doubleWide.blitsPerFrame == 1);
+    // every eye still gets its frame
+    CHECK(stereoFrames == doubleWideFrames);
+    // and fewer calls cost no more CPU time, up to the noise
+    CHECK(medianCpuShare < 1 + kNoiseShare);
+
+    client.Stop();
+    graphics->Shutdown();
+    return TestResult("StereoBlit");
+}
@@ -0,0 +1,231 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_CLOUDXR_CLIENT_H
+#define CLIENT_HOST_CLOUDXR_CLIENT_H
+
+// Stand-in for the CloudXR 3.2 SDK header of the same name; see CloudXRCommon.h.
+
+#include "CloudXRCommon.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct cxrReceiver *cxrReceiverHandle;
+
+typedef enum cxrClientState {
+    cxrClientState_ReadyToConnect = 0,
+    cxrClientState_ConnectionAttemptInProgress = 1,
+    cxrClientState_ConnectionAttemptFailed = 2,
+    cxrClientState_StreamingSessionInProgress = 3,
+    cxrClientState_Disconnected = 4,
+    cxrClientState_Exiting = 5,
+} cxrClientState;
+
+typedef enum cxrStateReason {
+    cxrStateReason_NoError = 0,
+    cxrStateReason_HEVCUnsupported = 1,
+    cxrStateReason_VersionMismatch = 2,
+    cxrStateReason_DisabledFeature = 3,
+    cxrStateReason_RTSPCannotConnect = 4,
+    cxrStateReason_HolePunchFailed = 5,
+    cxrStateReason_NetworkError = 6,
+    cxrStateReason_AuthorizationFailed = 7,
+    cxrStateReason_DisconnectedExpected = 8,
+    cxrStateReason_DisconnectedUnexpected = 9,
+} cxrStateReason;
+
+typedef enum cxrDeliveryType {
+    cxrDeliveryType_Mono_RGB = 0,
+    cxrDeliveryType_Stereo_RGB = 1,
+} cxrDeliveryType;
+
+typedef enum cxrControllerType {
+    cxrControllerType_HTCVive = 0,
+    cxrControllerType_ValveIndex = 1,
+    cxrControllerType_OculusTouch = 2,
+} cxrControllerType;
+
+typedef enum cxrUniverseOrigin {
+    cxrUniverseOrigin_Seated = 0,
+    cxrUniverseOrigin_Standing = 1,
+} cxrUniverseOrigin;
+
+typedef struct cxrChaperone {
+    cxrUniverseOrigin universe;
+    cxrMatrix34 origin;
+    cxrVector2 playArea;
+} cxrChaperone;
+
+typedef struct cxrDeviceDesc {
+    cxrDeliveryType deliveryType;
+    uint32_t width;
+    uint32_t height;
+    float maxResFactor;
+    float fps;
+    float ipd;
+    float proj[CXR_NUM_VIDEO_STREAMS_XR][4];
+    // seconds the server adds to its pose prediction
+    float predOffset;
+    cxrBool receiveAudio;
+    cxrBool sendAudio;
+    cxrBool embedInfoInVideo;
+    int32_t posePollFreq;
+    cxrControllerType ctrlType;
+    cxrBool disablePosePrediction;
+    cxrBool angularVelocityInDeviceSpace;
+    cxrBool disableVVSync;
+    uint32_t foveatedScaleFactor;
+    cxrChaperone chaperone;
+} cxrDeviceDesc;
+
+typedef enum cxrNetworkInterface {
+    cxrNetworkInterface_Unknown = 0,
+    cxrNetworkInterface_Ethernet = 1,
+    cxrNetworkInterface_WiFi = 2,
+    cxrNetworkInterface_WiFi5Ghz = 3,
+    cxrNetworkInterface_WiFi24Ghz = 4,
+    cxrNetworkInterface_MobileLTE = 5,
+    cxrNetworkInterface_Mobile5G = 6,
+} cxrNetworkInterface;
+
+typedef enum cxrNetworkTopologyType {
+    cxrNetworkTopology_Unknown = 0,
+    cxrNetworkTopology_LAN = 1,
+    cxrNetworkTopology_WAN = 2,
+} cxrNetworkTopologyType;
+
+typedef struct cxrConnectionDesc {
+    cxrBool async;
+    uint32_t maxVideoBitrateKbps;
+    cxrNetworkInterface clientNetwork;
+    cxrNetworkTopologyType topology;
+} cxrConnectionDesc;
+
+typedef struct cxrClientCallbacks {
+    void (*GetTrackingState)(void *context, cxrVRTrackingState *trackingState);
+
+    void (*TriggerHaptic)(void *context, const cxrHapticFeedback *haptic);
+
+    cxrBool (*RenderAudio)(void *context, const cxrAudioFrame *audioFrame);
+
+    void (*UpdateClientState)(void *context, cxrClientState state, cxrStateReason reason);
+} cxrClientCallbacks;
+
+typedef enum cxrGraphicsContextType {
+    cxrGraphicsContext_D3D11 = 0,
+    cxrGraphicsContext_GLES = 1,
+    cxrGraphicsContext_Vulkan = 2,
+} cxrGraphicsContextType;
+
+typedef struct cxrGraphicsContext {
+    cxrGraphicsContextType type;
+    struct {
+        void *display;
+        void *context;
+    } egl;
+} cxrGraphicsContext;
+
+typedef enum cxrStreamingMode {
+    cxrStreamingMode_Generic = 0,
+    cxrStreamingMode_XR = 1,
+} cxrStreamingMode;
+
+typedef enum cxrDebugFlags {
+    cxrDebugFlags_LogVerbose = 0x00000001,
+    cxrDebugFlags_EnableAImageReaderDecoder = 0x00000400,
+    cxrDebugFlags_OutputLinearRGBColor = 0x00000800,
+} cxrDebugFlags;
+
+typedef struct cxrReceiverDesc {
+    uint32_t requestedVersion;
+    cxrDeviceDesc deviceDesc;
+    cxrClientCallbacks clientCallbacks;
+    void *clientContext;
+    const cxrGraphicsContext *shareContext;
+    uint32_t numStreams;
+    cxrStreamingMode receiverMode;
+    uint32_t debugFlags;
+    int32_t logMaxSizeKB;
+    int32_t logMaxAgeDays;
+} cxrReceiverDesc;
+
+typedef struct cxrVideoFrame {
+    // GL texture name of the decoded frame
+    uint32_t texture;
+    uint32_t widthFinal;
+    uint32_t heightFinal;
+    uint32_t pitch;
+    uint64_t timeStamp;
+} cxrVideoFrame;
+
+typedef struct cxrFramesLatched {
+    uint32_t count;
+    cxrVideoFrame frames[CXR_MAX_NUM_VIDEO_STREAMS];
+    // pose the frames were rendered with
+    cxrMatrix34 poseMatrix;
+    // client time of the tracking sample the server rendered the frames with, in ns
+    uint64_t timeStamp;
+} cxrFramesLatched;
+
+typedef uint32_t cxrFrameMask;
+#define cxrFrameMask_Left 0x1
+#define cxrFrameMask_Right 0x2
+#define cxrFrameMask_All 0xFFFFFFFF
+
+typedef enum cxrConnectionQuality {
+    cxrConnectionQuality_Unstable = 0,
+    cxrConnectionQuality_Bad = 1,
+    cxrConnectionQuality_Poor = 2,
+    cxrConnectionQuality_Fair = 3,
+    cxrConnectionQuality_Good = 4,
+    cxrConnectionQuality_Excellent = 5,
+} cxrConnectionQuality;
+
+typedef enum cxrConnectionQualityReason {
+    cxrConnectionQualityReason_EstimatingQuality = 0x0,
+    cxrConnectionQualityReason_LowBandwidth = 0x1,
+    cxrConnectionQualityReason_HighLatency = 0x2,
+    cxrConnectionQualityReason_HighPacketLoss = 0x4,
+} cxrConnectionQualityReason;
+
+typedef struct cxrConnectionStats {
+    float framesPerSecond;
+    float frameDeliveryTime;
+    float frameQueueTime;
+    float frameLatchTime;
+    uint32_t bandwidthAvailableKbps;
+    uint32_t bandwidthUtilizationKbps;
+    uint32_t bandwidthUtilizationPercent;
+    uint32_t roundTripDelayMs;
+    uint32_t jitterUs;
+    uint32_t totalPacketsReceived;
+    uint32_t totalPacketsLost;
+    uint32_t totalPacketsDropped;
+    cxrConnectionQuality quality;
+    uint32_t qualityReasons;
+} cxrConnectionStats;
+
+cxrError cxrCreateReceiver(const cxrReceiverDesc *description, cxrReceiverHandle *receiver);
+
+void cxrDestroyReceiver(cxrReceiverHandle receiver);
+
+cxrError cxrConnect(cxrReceiverHandle receiver, const char *serverAddr, cxrConnectionDesc *description);
+
+void cxrDisconnect(cxrReceiverHandle receiver);
+
+cxrError cxrLatchFrame(cxrReceiverHandle receiver, cxrFramesLatched *framesLatched, uint32_t frameMask,
+                       uint32_t timeoutMs);
+
+void cxrBlitFrame(cxrReceiverHandle receiver, cxrFramesLatched *framesLatched, uint32_t frameMask);
+
+void cxrReleaseFrame(cxrReceiverHandle receiver, cxrFramesLatched *framesLatched);
+
+cxrError cxrSendAudio(cxrReceiverHandle receiver, const cxrAudioFrame *audioFrame);
+
+cxrError cxrGetConnectionStats(cxrReceiverHandle receiver, cxrConnectionStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLIENT_HOST_CLOUDXR_CLIENT_H
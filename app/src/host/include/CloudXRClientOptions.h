@@ -0,0 +1,158 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_CLOUDXR_CLIENT_OPTIONS_H
+#define CLIENT_HOST_CLOUDXR_CLIENT_OPTIONS_H
+
+// Stand-in for the CloudXR 3.2 sample header of the same name: the option parser and the
+// CloudXR options the client reads. Tokens are split on whitespace; "-tag" and "--tag" both
+// match, and an option that takes a value takes the next token.
+
+#include <functional>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include "CloudXRClient.h"
+
+enum ParseStatus {
+    ParseStatus_Success = 0,
+    ParseStatus_Fail,
+    ParseStatus_ExitNormal,
+    ParseStatus_BadVal,
+};
+
+#define HANDLER_LAMBDA_FN [&](const std::string &tok) -> ParseStatus
+
+namespace CloudXR {
+
+    class OptionParser {
+
+    public:
+        typedef std::function<ParseStatus(const std::string &)> OptionHandler;
+
+        OptionParser() = default;
+
+        // the handlers usually capture this
+        OptionParser(const OptionParser &) = delete;
+
+        OptionParser &operator=(const OptionParser &) = delete;
+
+        void AddOption(const std::string &tag, const std::string &shortTag, bool hasArg, const std::string &desc,
+                       OptionHandler handler) {
+            mOptions.push_back({tag, shortTag, hasArg, desc, handler});
+        }
+
+        ParseStatus ParseString(const std::string &text) {
+            std::istringstream stream(text);
+            std::vector<std::string> tokens;
+            std::string token;
+            while (stream >> token) {
+                tokens.push_back(token);
+            }
+            for (size_t i = 0; i < tokens.size(); i++) {
+                const Option *option = Find(tokens[i]);
+                if (option == nullptr) {
+                    return ParseStatus_Fail;
+                }
+                std::string value;
+                if (option->hasArg) {
+                    if (i + 1 >= tokens.size()) {
+                        return ParseStatus_Fail;
+                    }
+                    value = tokens[++i];
+                }
+                const ParseStatus status = option->handler(value);
+                if (status != ParseStatus_Success) {
+                    return status;
+                }
+            }
+            return ParseStatus_Success;
+        }
+
+        ParseStatus ParseFile(const std::string &path) {
+            std::ifstream file(path);
+            if (!file) {
+                return ParseStatus_Fail;
+            }
+            std::stringstream text;
+            text << file.rdbuf();
+            return ParseString(text.str());
+        }
+
+    private:
+        struct Option {
+            std::string tag;
+            std::string shortTag;
+            bool hasArg;
+            std::string desc;
+            OptionHandler handler;
+        };
+
+        const Option *Find(const std::string &token) const {
+            size_t dashes = 0;
+            while (dashes < token.size() && dashes < 2 && token[dashes] == '-') {
+                dashes++;
+            }
+            if (dashes == 0) {
+                return nullptr;
+            }
+            const std::string name = token.substr(dashes);
+            for (const Option &option : mOptions) {
+                if (name == option.tag || name == option.shortTag) {
+                    return &option;
+                }
+            }
+            return nullptr;
+        }
+
+        std::vector<Option> mOptions;
+    };
+
+    class ClientOptions : public OptionParser {
+
+    public:
+        std::string mServerIP;
+        uint32_t mMaxVideoBitrate = 0;
+        uint32_t mFoveation = 0;
+        uint32_t mDebugFlags = 0;
+        cxrNetworkInterface mClientNetwork = cxrNetworkInterface_Unknown;
+        cxrNetworkTopologyType mTopology = cxrNetworkTopology_Unknown;
+
+        ClientOptions() {
+            AddOption("server", "s", true, "IP address of the CloudXR server.",
+                      HANDLER_LAMBDA_FN
+                      {
+                          mServerIP = tok;
+                          return ParseStatus_Success;
+                      });
+            AddOption("maxVideoBitrateKbps", "mbr", true, "Maximum video bitrate in kbps.",
+                      HANDLER_LAMBDA_FN
+                      {
+                          return ParseUnsigned(tok, &mMaxVideoBitrate);
+                      });
+            AddOption("foveation", "f", true, "Foveated scale factor in percent, 0 to disable.",
+                      HANDLER_LAMBDA_FN
+                      {
+                          return ParseUnsigned(tok, &mFoveation);
+                      });
+            AddOption("debug-flags", "d", true, "cxrDebugFlags bits, hex or decimal.",
+                      HANDLER_LAMBDA_FN
+                      {
+                          return ParseUnsigned(tok, &mDebugFlags);
+                      });
+        }
+
+    private:
+        static ParseStatus ParseUnsigned(const std::string &tok, uint32_t *value) {
+            char *end = nullptr;
+            const unsigned long parsed = strtoul(tok.c_str(), &end, 0);
+            if (end == tok.c_str() || *end != '\0') {
+                return ParseStatus_BadVal;
+            }
+            *value = uint32_t(parsed);
+            return ParseStatus_Success;
+        }
+    };
+}
+
+#endif //CLIENT_HOST_CLOUDXR_CLIENT_OPTIONS_H
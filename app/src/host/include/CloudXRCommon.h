@@ -0,0 +1,155 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_CLOUDXR_COMMON_H
+#define CLIENT_HOST_CLOUDXR_COMMON_H
+
+// Stand-in for the CloudXR 3.2 SDK header of the same name: the declarations the client uses,
+// with the SDK's names and layouts, so the client builds and runs on a Linux host against the
+// stand-in receiver in standin/CloudXRReceiver.cpp.
+
+#include <stdint.h>
+
+#define CLOUDXR_VERSION_MAJOR 3
+#define CLOUDXR_VERSION_MINOR 2
+#define CLOUDXR_VERSION_DWORD ((CLOUDXR_VERSION_MAJOR << 16) | (CLOUDXR_VERSION_MINOR << 8))
+
+#define CXR_NUM_CONTROLLERS 2
+#define CXR_NUM_VIDEO_STREAMS_XR 2
+#define CXR_MAX_NUM_VIDEO_STREAMS 4
+
+#define CXR_AUDIO_CHANNEL_COUNT 2
+#define CXR_AUDIO_SAMPLE_SIZE sizeof(int16_t)
+#define CXR_AUDIO_SAMPLING_RATE 48000
+#define CXR_AUDIO_FRAME_LENGTH_MS 5
+#define CXR_AUDIO_BYTES_PER_MS (CXR_AUDIO_CHANNEL_COUNT * CXR_AUDIO_SAMPLE_SIZE * CXR_AUDIO_SAMPLING_RATE / 1000)
+
+#define CLOUDXR_LOG_MAX_DEFAULT (-1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t cxrBool;
+#define cxrFalse 0
+#define cxrTrue 1
+
+typedef enum cxrError {
+    cxrError_Success = 0,
+    cxrError_Failed = 1,
+    cxrError_Not_Connected = 2,
+    cxrError_Receiver_Invalid = 3,
+    cxrError_No_Addr = 4,
+    cxrError_Frame_Not_Ready = 5,
+    cxrError_Frame_Not_Latched = 6,
+} cxrError;
+
+const char *cxrErrorString(cxrError error);
+
+typedef struct cxrVector2 {
+    float v[2];
+} cxrVector2;
+
+typedef struct cxrVector3 {
+    float v[3];
+} cxrVector3;
+
+typedef struct cxrQuaternion {
+    float w, x, y, z;
+} cxrQuaternion;
+
+typedef struct cxrMatrix34 {
+    float m[3][4];
+} cxrMatrix34;
+
+typedef enum cxrTrackingResult {
+    cxrTrackingResult_Uninitialized = 1,
+    cxrTrackingResult_Calibrating_InProgress = 100,
+    cxrTrackingResult_Calibrating_OutOfRange = 101,
+    cxrTrackingResult_Running_OK = 200,
+    cxrTrackingResult_Running_OutOfRange = 201,
+} cxrTrackingResult;
+
+typedef struct cxrTrackedDevicePose {
+    cxrVector3 position;
+    cxrQuaternion rotation;
+    cxrVector3 velocity;
+    cxrVector3 angularVelocity;
+    cxrVector3 acceleration;
+    cxrVector3 angularAcceleration;
+    cxrTrackingResult trackingResult;
+    cxrBool poseIsValid;
+    cxrBool deviceIsConnected;
+} cxrTrackedDevicePose;
+
+typedef enum cxrHmdTrackingFlags {
+    cxrHmdTrackingFlags_HasIPD = 0x1,
+    cxrHmdTrackingFlags_HasRefresh = 0x2,
+} cxrHmdTrackingFlags;
+
+typedef struct cxrHmdTrackingState {
+    cxrTrackedDevicePose pose;
+    uint64_t flags;
+    float ipd;
+    float displayRefresh;
+} cxrHmdTrackingState;
+
+typedef enum cxrButtonId {
+    cxrButton_System = 0,
+    cxrButton_ApplicationMenu = 1,
+    cxrButton_Grip = 2,
+    cxrButton_DPad_Left = 3,
+    cxrButton_DPad_Up = 4,
+    cxrButton_DPad_Right = 5,
+    cxrButton_DPad_Down = 6,
+    cxrButton_A = 7,
+    cxrButton_B = 8,
+    cxrButton_X = 9,
+    cxrButton_Y = 10,
+    cxrButton_Trigger_Touch = 11,
+    cxrButton_Trigger_Click = 12,
+    cxrButton_Touchpad_Touch = 13,
+    cxrButton_Touchpad_Click = 14,
+    cxrButton_Joystick_Touch = 15,
+    cxrButton_Joystick_Click = 16,
+    cxrButton_Grip_Touch = 17,
+    cxrButton_Grip_Click = 18,
+    cxrButton_Num = 19,
+} cxrButtonId;
+
+typedef enum cxrAnalogId {
+    cxrAnalog_Trigger = 0,
+    cxrAnalog_JoystickX = 1,
+    cxrAnalog_JoystickY = 2,
+    cxrAnalog_Grip = 3,
+    cxrAnalog_Num = 4,
+} cxrAnalogId;
+
+typedef struct cxrControllerTrackingState {
+    cxrTrackedDevicePose pose;
+    uint64_t booleanComps;
+    uint64_t booleanCompsChanged;
+    float scalarComps[cxrAnalog_Num];
+} cxrControllerTrackingState;
+
+typedef struct cxrVRTrackingState {
+    cxrHmdTrackingState hmd;
+    cxrControllerTrackingState controller[CXR_NUM_CONTROLLERS];
+    uint64_t poseTimeOffset;
+} cxrVRTrackingState;
+
+typedef struct cxrHapticFeedback {
+    uint32_t controllerIdx;
+    float frequency;
+    float amplitude;
+    float seconds;
+} cxrHapticFeedback;
+
+typedef struct cxrAudioFrame {
+    int16_t *streamBuffer;
+    uint32_t streamSizeBytes;
+} cxrAudioFrame;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLIENT_HOST_CLOUDXR_COMMON_H
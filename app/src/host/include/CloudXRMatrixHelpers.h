@@ -0,0 +1,64 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_CLOUDXR_MATRIX_HELPERS_H
+#define CLIENT_HOST_CLOUDXR_MATRIX_HELPERS_H
+
+// Stand-in for the CloudXR 3.2 SDK header of the same name; see CloudXRCommon.h.
+
+#include <math.h>
+#include "CloudXRCommon.h"
+
+static inline void cxrMatrixToVecQuat(const cxrMatrix34 *m, cxrVector3 *v, cxrQuaternion *q) {
+    v->v[0] = m->m[0][3];
+    v->v[1] = m->m[1][3];
+    v->v[2] = m->m[2][3];
+
+    const float trace = m->m[0][0] + m->m[1][1] + m->m[2][2];
+    if (trace > 0) {
+        const float s = 0.5f / sqrtf(trace + 1.0f);
+        q->w = 0.25f / s;
+        q->x = (m->m[2][1] - m->m[1][2]) * s;
+        q->y = (m->m[0][2] - m->m[2][0]) * s;
+        q->z = (m->m[1][0] - m->m[0][1]) * s;
+    } else if (m->m[0][0] > m->m[1][1] && m->m[0][0] > m->m[2][2]) {
+        const float s = 2.0f * sqrtf(1.0f + m->m[0][0] - m->m[1][1] - m->m[2][2]);
+        q->w = (m->m[2][1] - m->m[1][2]) / s;
+        q->x = 0.25f * s;
+        q->y = (m->m[0][1] + m->m[1][0]) / s;
+        q->z = (m->m[0][2] + m->m[2][0]) / s;
+    } else if (m->m[1][1] > m->m[2][2]) {
+        const float s = 2.0f * sqrtf(1.0f + m->m[1][1] - m->m[0][0] - m->m[2][2]);
+        q->w = (m->m[0][2] - m->m[2][0]) / s;
+        q->x = (m->m[0][1] + m->m[1][0]) / s;
+        q->y = 0.25f * s;
+        q->z = (m->m[1][2] + m->m[2][1]) / s;
+    } else {
+        const float s = 2.0f * sqrtf(1.0f + m->m[2][2] - m->m[0][0] - m->m[1][1]);
+        q->w = (m->m[1][0] - m->m[0][1]) / s;
+        q->x = (m->m[0][2] + m->m[2][0]) / s;
+        q->y = (m->m[1][2] + m->m[2][1]) / s;
+        q->z = 0.25f * s;
+    }
+}
+
+// Rotation and translation of a tracked pose as a 3x4 matrix.
+static inline cxrMatrix34 cxrConvertQuaternionToMatrix(const cxrQuaternion *q, const cxrVector3 *v) {
+    cxrMatrix34 m;
+    const float xx = q->x * q->x, yy = q->y * q->y, zz = q->z * q->z;
+    const float xy = q->x * q->y, xz = q->x * q->z, yz = q->y * q->z;
+    const float wx = q->w * q->x, wy = q->w * q->y, wz = q->w * q->z;
+    m.m[0][0] = 1 - 2 * (yy + zz);
+    m.m[0][1] = 2 * (xy - wz);
+    m.m[0][2] = 2 * (xz + wy);
+    m.m[0][3] = v->v[0];
+    m.m[1][0] = 2 * (xy + wz);
+    m.m[1][1] = 1 - 2 * (xx + zz);
+    m.m[1][2] = 2 * (yz - wx);
+    m.m[1][3] = v->v[1];
+    m.m[2][0] = 2 * (xz - wy);
+    m.m[2][1] = 2 * (yz + wx);
+    m.m[2][2] = 1 - 2 * (xx + yy);
+    m.m[2][3] = v->v[2];
+    return m;
+}
+
+#endif //CLIENT_HOST_CLOUDXR_MATRIX_HELPERS_H
@@ -0,0 +1,24 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_ANDROID_LOOPER_H
+#define CLIENT_HOST_ANDROID_LOOPER_H
+
+// Stand-in for the NDK's android/looper.h.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    ALOOPER_POLL_WAKE = -1,
+    ALOOPER_POLL_CALLBACK = -2,
+    ALOOPER_POLL_TIMEOUT = -3,
+    ALOOPER_POLL_ERROR = -4,
+};
+
+int ALooper_pollAll(int timeoutMillis, int *outFd, int *outEvents, void **outData);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLIENT_HOST_ANDROID_LOOPER_H
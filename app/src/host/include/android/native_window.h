@@ -0,0 +1,10 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_ANDROID_NATIVE_WINDOW_H
+#define CLIENT_HOST_ANDROID_NATIVE_WINDOW_H
+
+// Stand-in for the NDK's android/native_window.h; the client renders into Pxr layers only.
+
+struct ANativeWindow;
+typedef struct ANativeWindow ANativeWindow;
+
+#endif //CLIENT_HOST_ANDROID_NATIVE_WINDOW_H
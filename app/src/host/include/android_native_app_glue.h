@@ -0,0 +1,60 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_ANDROID_NATIVE_APP_GLUE_H
+#define CLIENT_HOST_ANDROID_NATIVE_APP_GLUE_H
+
+// Stand-in for the NDK's native_app_glue: the fields of android_app and ANativeActivity that
+// android_main() uses. Tests fill them in and call android_main() on a thread of their own.
+
+#include <jni.h>
+#include <android/looper.h>
+#include <android/native_window.h>
+
+struct android_app;
+
+struct ANativeActivity {
+    JavaVM *vm;
+    JNIEnv *env;
+    jobject clazz;
+    const char *internalDataPath;
+    const char *externalDataPath;
+};
+
+struct android_poll_source {
+    int32_t id;
+    struct android_app *app;
+
+    void (*process)(struct android_app *app, struct android_poll_source *source);
+};
+
+struct android_app {
+    void *userData;
+
+    void (*onAppCmd)(struct android_app *app, int32_t cmd);
+
+    ANativeActivity *activity;
+    ANativeWindow *window;
+    int destroyRequested;
+};
+
+enum {
+    APP_CMD_INPUT_CHANGED,
+    APP_CMD_INIT_WINDOW,
+    APP_CMD_TERM_WINDOW,
+    APP_CMD_WINDOW_RESIZED,
+    APP_CMD_WINDOW_REDRAW_NEEDED,
+    APP_CMD_CONTENT_RECT_CHANGED,
+    APP_CMD_GAINED_FOCUS,
+    APP_CMD_LOST_FOCUS,
+    APP_CMD_CONFIG_CHANGED,
+    APP_CMD_LOW_MEMORY,
+    APP_CMD_START,
+    APP_CMD_RESUME,
+    APP_CMD_SAVE_STATE,
+    APP_CMD_PAUSE,
+    APP_CMD_STOP,
+    APP_CMD_DESTROY,
+};
+
+void android_main(struct android_app *app);
+
+#endif //CLIENT_HOST_ANDROID_NATIVE_APP_GLUE_H
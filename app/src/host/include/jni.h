@@ -0,0 +1,22 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_JNI_H
+#define CLIENT_HOST_JNI_H
+
+// Stand-in for the NDK's jni.h: the client only passes the VM and activity through to Pxr.
+
+#include <stdint.h>
+
+typedef int32_t jint;
+typedef void *jobject;
+
+#define JNI_OK 0
+
+struct JNIEnv;
+
+struct JavaVM {
+    jint AttachCurrentThread(JNIEnv **env, void *args);
+
+    jint DetachCurrentThread();
+};
+
+#endif //CLIENT_HOST_JNI_H
@@ -0,0 +1,252 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_OBOE_H
+#define CLIENT_HOST_OBOE_H
+
+// Stand-in for the Oboe 1.6 API the client uses. Streams are fakes backed by
+// standin/Oboe.cpp: writes complete at once, and standin/StandinOboe.h lets a test take the
+// audio device away, bring it back and inject underruns.
+
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+
+namespace oboe {
+
+    constexpr int64_t kNanosPerMicrosecond = 1000;
+    constexpr int64_t kNanosPerMillisecond = kNanosPerMicrosecond * 1000;
+    constexpr int64_t kNanosPerSecond = kNanosPerMillisecond * 1000;
+
+    enum class Result : int32_t {
+        OK = 0,
+        ErrorBase = -900,
+        ErrorDisconnected = -899,
+        ErrorIllegalArgument = -898,
+        ErrorInternal = -896,
+        ErrorInvalidState = -895,
+        ErrorUnavailable = -881,
+        ErrorNoFreeHandles = -880,
+        ErrorNoMemory = -879,
+        ErrorTimeout = -885,
+        ErrorClosed = -869,
+    };
+
+    enum class Direction : int32_t {
+        Output = 0,
+        Input = 1,
+    };
+
+    enum class PerformanceMode : int32_t {
+        None = 10,
+        PowerSaving = 11,
+        LowLatency = 12,
+    };
+
+    enum class SharingMode : int32_t {
+        Exclusive = 0,
+        Shared = 1,
+    };
+
+    enum class AudioFormat : int32_t {
+        Invalid = -1,
+        Unspecified = 0,
+        I16 = 1,
+        Float = 2,
+    };
+
+    enum class InputPreset : int32_t {
+        Generic = 1,
+        Camcorder = 5,
+        VoiceRecognition = 6,
+        VoiceCommunication = 7,
+        Unprocessed = 9,
+        VoicePerformance = 10,
+    };
+
+    enum class DataCallbackResult : int32_t {
+        Continue = 0,
+        Stop = 1,
+    };
+
+    enum class StreamState : int32_t {
+        Uninitialized = 0,
+        Open = 2,
+        Starting = 3,
+        Started = 4,
+        Stopping = 9,
+        Stopped = 10,
+        Closing = 11,
+        Closed = 12,
+        Disconnected = 13,
+    };
+
+    enum ChannelCount : int32_t {
+        Unspecified = 0,
+        Mono = 1,
+        Stereo = 2,
+    };
+
+    const char *convertToText(Result result);
+
+    template<typename T>
+    class ResultWithValue {
+
+    public:
+        ResultWithValue(Result error) : mValue{}, mError(error) {}
+
+        ResultWithValue(T value) : mValue(value), mError(Result::OK) {}
+
+        Result error() const { return mError; }
+
+        T value() const { return mValue; }
+
+        explicit operator bool() const { return mError == Result::OK; }
+
+        operator Result() const { return mError; }
+
+    private:
+        T mValue;
+        Result mError;
+    };
+
+    class AudioStream;
+
+    class AudioStreamDataCallback {
+
+    public:
+        virtual ~AudioStreamDataCallback() = default;
+
+        virtual DataCallbackResult onAudioReady(AudioStream *audioStream, void *audioData, int32_t numFrames) = 0;
+    };
+
+    class AudioStreamErrorCallback {
+
+    public:
+        virtual ~AudioStreamErrorCallback() = default;
+
+        virtual bool onError(AudioStream *, Result) { return false; }
+
+        virtual void onErrorBeforeClose(AudioStream *, Result) {}
+
+        virtual void onErrorAfterClose(AudioStream *, Result) {}
+    };
+
+    class AudioStreamBuilder {
+
+    public:
+        AudioStreamBuilder &setDirection(Direction direction) {
+            mDirection = direction;
+            return *this;
+        }
+
+        AudioStreamBuilder &setPerformanceMode(PerformanceMode mode) {
+            mPerformanceMode = mode;
+            return *this;
+        }
+
+        AudioStreamBuilder &setSharingMode(SharingMode mode) {
+            mSharingMode = mode;
+            return *this;
+        }
+
+        AudioStreamBuilder &setFormat(AudioFormat format) {
+            mFormat = format;
+            return *this;
+        }
+
+        AudioStreamBuilder &setChannelCount(int32_t channelCount) {
+            mChannelCount = channelCount;
+            return *this;
+        }
+
+        AudioStreamBuilder &setSampleRate(int32_t sampleRate) {
+            mSampleRate = sampleRate;
+            return *this;
+        }
+
+        AudioStreamBuilder &setInputPreset(InputPreset preset) {
+            mInputPreset = preset;
+            return *this;
+        }
+
+        AudioStreamBuilder &setDataCallback(AudioStreamDataCallback *callback) {
+            mDataCallback = callback;
+            return *this;
+        }
+
+        AudioStreamBuilder &setErrorCallback(AudioStreamErrorCallback *callback) {
+            mErrorCallback = callback;
+            return *this;
+        }
+
+        Direction getDirection() const { return mDirection; }
+
+        int32_t getChannelCount() const { return mChannelCount; }
+
+        int32_t getSampleRate() const { return mSampleRate; }
+
+        AudioStreamDataCallback *getDataCallback() const { return mDataCallback; }
+
+        AudioStreamErrorCallback *getErrorCallback() const { return mErrorCallback; }
+
+        Result openStream(std::shared_ptr<AudioStream> &stream);
+
+    private:
+        Direction mDirection = Direction::Output;
+        PerformanceMode mPerformanceMode = PerformanceMode::None;
+        SharingMode mSharingMode = SharingMode::Shared;
+        AudioFormat mFormat = AudioFormat::Unspecified;
+        int32_t mChannelCount = ChannelCount::Unspecified;
+        int32_t mSampleRate = 0;
+        InputPreset mInputPreset = InputPreset::VoiceRecognition;
+        AudioStreamDataCallback *mDataCallback = nullptr;
+        AudioStreamErrorCallback *mErrorCallback = nullptr;
+    };
+
+    class AudioStream {
+
+    public:
+        explicit AudioStream(const AudioStreamBuilder &builder) : mBuilder(builder) {}
+
+        virtual ~AudioStream() = default;
+
+        Result start();
+
+        Result stop();
+
+        Result close();
+
+        ResultWithValue<int32_t> write(const void *buffer, int32_t numFrames, int64_t timeoutNanoseconds);
+
+        int32_t getFramesPerBurst() const { return kFramesPerBurst; }
+
+        ResultWithValue<int32_t> setBufferSizeInFrames(int32_t requestedFrames);
+
+        int32_t getBufferSizeInFrames() const { return mBufferSizeInFrames; }
+
+        ResultWithValue<int32_t> getXRunCount() const;
+
+        StreamState getState() const;
+
+        Direction getDirection() const { return mBuilder.getDirection(); }
+
+        int32_t getChannelCount() const { return mBuilder.getChannelCount(); }
+
+        int32_t getSampleRate() const { return mBuilder.getSampleRate(); }
+
+        int64_t getFramesWritten() const;
+
+    private:
+        friend struct StandinStreamAccess;
+
+        static const int32_t kFramesPerBurst = 192;
+
+        const AudioStreamBuilder mBuilder;
+        mutable std::mutex mMutex;
+        StreamState mState = StreamState::Open;
+        int32_t mBufferSizeInFrames = kFramesPerBurst * 2;
+        int32_t mXRuns = 0;
+        int64_t mFramesWritten = 0;
+    };
+}
+
+#endif //CLIENT_HOST_OBOE_H
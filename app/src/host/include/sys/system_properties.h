@@ -0,0 +1,19 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_SYS_SYSTEM_PROPERTIES_H
+#define CLIENT_HOST_SYS_SYSTEM_PROPERTIES_H
+
+// Stand-in for bionic's sys/system_properties.h; every property reads as unset.
+
+#define PROP_VALUE_MAX 92
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int __system_property_get(const char *name, char *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CLIENT_HOST_SYS_SYSTEM_PROPERTIES_H
@@ -0,0 +1,164 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// A streaming session under injected faults, run through android_main like on the device
+// against a lossy, jittery stand-in server that stalls now and then: dropped latches, render
+// thread stalls, late tracking callbacks, dropped audio and a reconnect every few seconds. The
+// soak counters come from the report the app logs when it shuts down. Prints the soak metrics
+// and checks that held frames stay near the injected rate, that no hold lasts long, that every
+// reconnect shows a frame again quickly and that memory does not keep growing.
+//
+// Runs for kDefaultSeconds; pass the number of seconds as the first argument for longer soaks.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include "AppHarness.h"
+#include "AsyncLog.h"
+#include "SoakStats.h"
+#include "StandinCloudXR.h"
+#include "StandinPxr.h"
+
+namespace {
+    const uint32_t kDefaultSeconds = 24;
+    const float kLatchDropPercent = 2;
+    const uint32_t kReconnectIntervalS = 4;
+    const char *kOptions = "-s 127.0.0.1 -fi latch-drop:2,latch-stall:20@1,tracking-delay:5@2,audio-drop:1,reconnect:4,seed:7";
+    // memory is compared from the end of the first reconnect on, once every pool has its size
+    const uint64_t kMaxRssGrowthKb = 16 * 1024;
+    const uint32_t kMaxRecoveryMs = 500;
+    const uint32_t kMaxHold = 6;
+    // connecting before the soak, and the shutdown after it
+    const uint32_t kHarnessMs = 20000;
+
+    // What SoakStats::Report() logged last.
+    struct SoakReport {
+        unsigned long long held = 0;
+        unsigned long long latches = 0;
+        unsigned long long injectedHeld = 0;
+        unsigned int longestHold = 0;
+        unsigned int reconnects = 0;
+        unsigned long long maxRecoveryMs = 0;
+        unsigned long long trackingDelays = 0;
+        unsigned long long audioDrops = 0;
+        unsigned int audioUnderruns = 0;
+    };
+
+    std::string ReadFile(const std::string &path) {
+        std::string contents;
+        FILE *file = fopen(path.c_str(), "r");
+        if (file == nullptr) {
+            return contents;
+        }
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            contents.append(buffer, read);
+        }
+        fclose(file);
+        return contents;
+    }
+
+    bool ParseSoakReport(const std::string &log, SoakReport *report) {
+        const size_t pos = log.rfind(" held:");
+        if (pos == std::string::npos) {
+            return false;
+        }
+        double heldPercent = 0;
+        unsigned long long lastRecoveryMs = 0;
+        return sscanf(log.c_str() + pos,
+                      " held:%llu/%llu (%lf%%, %llu injected, longest %u), reconnects:%u recovery last:%llums max:%llums, "
+                      "tracking delays:%llu, audio drops:%llu underruns:%u",
+                      &report->held, &report->latches, &heldPercent, &report->injectedHeld, &report->longestHold,
+                      &report->reconnects, &lastRecoveryMs, &report->maxRecoveryMs, &report->trackingDelays,
+                      &report->audioDrops, &report->audioUnderruns) == 11;
+    }
+
+    uint64_t FramesLatched() {
+        const cxrReceiverHandle receiver = StandinCloudXR::GetLastReceiver();
+        return receiver != nullptr ? StandinCloudXR::GetCounters(receiver).framesLatched : 0;
+    }
+
+    template<typename Predicate>
+    bool WaitUntil(Predicate predicate, uint32_t timeoutMs) {
+        const uint64_t deadlineNs = TestUtil::NowNs() + timeoutMs * 1000000ULL;
+        while (!predicate()) {
+            if (TestUtil::NowNs() > deadlineNs) {
+                return false;
+            }
+            usleep(1000);
+        }
+        return true;
+    }
+}
+
+int main(int argc, char **argv) {
+    const uint32_t seconds = argc > 1 ? uint32_t(atoi(argv[1])) : kDefaultSeconds;
+    StandinPxr::Reset();
+    // llvmpipe fills full size eye buffers at well below display rate
+    StandinPxr::SetViewSize(256, 256);
+    StandinServerProfile profile;
+    profile.latencyJitterMs = 4;
+    profile.frameLossPercent = 1;
+    profile.stallPeriodMs = 5000;
+    profile.stallMs = 150;
+    StandinCloudXR::SetProfile(profile);
+
+    // nothing is logged before the fork, see ShutdownTest
+    const std::string dir = TestUtil::MakeTempDir("fault_soak");
+    const std::string logPath = dir + "/log.txt";
+    const std::string rssPath = dir + "/rss_growth_kb";
+    const AppRunResult result = RunApp("fault_soak", kOptions, [&](android_app *app) {
+        AsyncLog::SetFile(logPath.c_str());
+        StandinAndroid::PostCommand(app, APP_CMD_RESUME);
+        if (!CHECK(WaitUntil([]() { return FramesLatched() > 0; }, 5000))) {
+            return;
+        }
+        const uint64_t startNs = TestUtil::NowNs();
+        usleep((kReconnectIntervalS + 1) * 1000000);
+        const uint64_t baselineRssKb = SoakStats::ReadRssKb();
+        const uint64_t endNs = startNs + seconds * 1000000000ULL;
+        while (TestUtil::NowNs() < endNs) {
+            usleep(100 * 1000);
+        }
+        const uint64_t rssKb = SoakStats::ReadRssKb();
+        CHECK(baselineRssKb > 0 && rssKb < baselineRssKb + kMaxRssGrowthKb);
+        TestUtil::WriteFile(rssPath, std::to_string((long long) rssKb - (long long) baselineRssKb));
+        // the run may end inside a reconnect; the session comes back with a single receiver and
+        // keeps latching, on a new receiver when the next reconnect falls in between. How fast
+        // it comes back is the report's recovery time, checked below; this only checks that it
+        // does, within a reconnect interval
+        const uint32_t aliveMs = kReconnectIntervalS * 1000;
+        CHECK(WaitUntil([]() { return StandinCloudXR::GetReceiverCount() == 1 && FramesLatched() > 0; }, aliveMs));
+        const cxrReceiverHandle receiver = StandinCloudXR::GetLastReceiver();
+        const uint64_t latched = FramesLatched();
+        CHECK(WaitUntil([receiver, latched]() {
+            return StandinCloudXR::GetLastReceiver() != receiver ? FramesLatched() > 0 : FramesLatched() > latched;
+        }, aliveMs));
+    }, seconds * 1000 + kHarnessMs);
+    CHECK(result.exited && result.exitStatus == 0);
+    TestUtil::Failures() += result.failures;
+
+    SoakReport report;
+    if (!CHECK(ParseSoakReport(ReadFile(logPath), &report)) || !CHECK(report.latches > 0)) {
+        return TestResult("FaultSoak");
+    }
+    const unsigned long long realHeld = report.held - report.injectedHeld;
+    const double injectedPercent = 100.0 * report.injectedHeld / report.latches;
+    const double realHeldPercent = 100.0 * realHeld / report.latches;
+    printf("{\"benchmark\":\"FaultSoak\",\"seconds\":%u,\"latches\":%llu,\"heldPercent\":%.3f,"
+           "\"injectedHeldPercent\":%.3f,\"longestHold\":%u,\"reconnects\":%u,\"maxRecoveryMs\":%llu,"
+           "\"trackingDelays\":%llu,\"audioDrops\":%llu,\"audioUnderruns\":%u,\"rssGrowthKb\":%s}\n",
+           seconds, report.latches, injectedPercent + realHeldPercent, injectedPercent, report.longestHold,
+           report.reconnects, report.maxRecoveryMs, report.trackingDelays, report.audioDrops, report.audioUnderruns,
+           ReadFile(rssPath).c_str());
+
+    CHECK(report.latches > seconds * 30);
+    // the injected drops show at their rate, late or lost frames from the server hold hardly any
+    CHECK(injectedPercent > kLatchDropPercent / 2 && injectedPercent < kLatchDropPercent * 2);
+    CHECK(realHeldPercent < 1);
+    CHECK(report.longestHold <= kMaxHold);
+    CHECK(report.reconnects + 2 >= seconds / kReconnectIntervalS);
+    CHECK(report.maxRecoveryMs > 0 && report.maxRecoveryMs < kMaxRecoveryMs);
+    CHECK(report.trackingDelays > 0);
+    CHECK(report.audioDrops > 0);
+    return TestResult("FaultSoak");
+}
@@ -0,0 +1,248 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Many streaming clients in one process, for sizing render servers without headsets. Each
+// client is a full CloudXRClientPXR with its own launch options file, all sharing one data
+// directory like the clients of one device would. Their frame loops run on one shared pool of
+// worker threads, each client's next frame scheduled at its own display rate, while the head
+// and controllers follow a synthetic motion and the triggers are pulled now and then. The
+// receiver backend is whatever the build links, the stand-in server here.
+//
+// Prints the metrics of every client and their sum, and checks that every client streamed at
+// close to the display rate and kept its own launch options.
+//
+//   MultiClientLoad [clients] [seconds] [workers]
+#include <algorithm>
+#include <condition_variable>
+#include <math.h>
+#include <mutex>
+#include <queue>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+#include "ClientFixture.h"
+#include "StandinCloudXR.h"
+#include "StandinPxr.h"
+#include "ThreadManager.h"
+
+namespace {
+    const uint32_t kDefaultClients = 16;
+    const uint32_t kDefaultSeconds = 10;
+    const uint32_t kDefaultWorkers = 4;
+    // haptics, input sampler, stats, audio recovery, options watch and the CloudXR tracking,
+    // audio out and record callbacks
+    const uint32_t kThreadsPerClient = 8;
+    // the async log and the main thread
+    const uint32_t kProcessThreads = 2;
+    const double kDisplayRate = 72;
+    // a frame runs this long after the server's frame became latchable, so it rarely waits
+    const uint64_t kLatchSlackNs = 1000000;
+    // a latch that took longer waited for its frame; the client's frames move to the server's
+    const uint64_t kLatchWaitNs = 1000000;
+    const uint64_t kIdleFrameNs = 10000000;
+    const double kPi = 3.14159265358979;
+
+    PxrPosef Pose(double yawRad, float x, float y, float z) {
+        PxrPosef pose = {};
+        pose.orientation.y = float(sin(yawRad / 2));
+        pose.orientation.w = float(cos(yawRad / 2));
+        pose.position.x = x;
+        pose.position.y = y;
+        pose.position.z = z;
+        return pose;
+    }
+
+    struct SimClient {
+        std::unique_ptr<ClientFixture> fixture;
+        uint64_t dueNs = 0;
+        uint64_t frames = 0;
+        uint64_t longestFrameNs = 0;
+    };
+
+    // Runs the clients' frames on a fixed set of threads: a worker takes the client whose frame
+    // is due first, runs it and schedules its next one. A client is only ever on one worker.
+    class ClientPool {
+
+    public:
+        explicit ClientPool(std::vector<SimClient> &clients) : mClients(clients) {}
+
+        void Run(uint32_t workers, uint64_t endNs) {
+            const uint64_t nowNs = TestUtil::NowNs();
+            for (uint32_t i = 0; i < mClients.size(); i++) {
+                mClients[i].dueNs = nowNs;
+                mDue.push(Entry{nowNs, i});
+            }
+            std::vector<std::thread> threads;
+            for (uint32_t i = 0; i < workers; i++) {
+                threads.emplace_back([this, endNs]() { Work(endNs); });
+            }
+            for (std::thread &thread : threads) {
+                thread.join();
+            }
+        }
+
+    private:
+        struct Entry {
+            uint64_t dueNs;
+            uint32_t client;
+
+            bool operator<(const Entry &other) const { return dueNs > other.dueNs; }
+        };
+
+        void Work(uint64_t endNs) {
+            ThreadManager::RegisterCurrentThread(ThreadRole_Render, "SimWorker");
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (true) {
+                mChanged.wait(lock, [this]() { return !mDue.empty(); });
+                const Entry next = mDue.top();
+                if (next.dueNs >= endNs) {
+                    // the others see the same, nothing is due before the end any more
+                    mChanged.notify_all();
+                    return;
+                }
+                const uint64_t nowNs = TestUtil::NowNs();
+                if (next.dueNs > nowNs) {
+                    mChanged.wait_for(lock, std::chrono::nanoseconds(next.dueNs - nowNs));
+                    continue;
+                }
+                mDue.pop();
+                lock.unlock();
+                const uint64_t dueNs = RunFrame(mClients[next.client]);
+                lock.lock();
+                mDue.push(Entry{dueNs, next.client});
+                mChanged.notify_one();
+            }
+        }
+
+        // Returns when the client's next frame is due.
+        static uint64_t RunFrame(SimClient &client) {
+            const uint64_t periodNs = uint64_t(1e9 / kDisplayRate);
+            const uint64_t startNs = TestUtil::NowNs();
+            client.fixture->RenderFrame();
+            const uint64_t endNs = TestUtil::NowNs();
+            client.frames++;
+            client.longestFrameNs = std::max(client.longestFrameNs, endNs - startNs);
+            if (!client.fixture->client->IsStreaming()) {
+                client.dueNs = endNs + kIdleFrameNs;
+            } else if (endNs - startNs > kLatchWaitNs) {
+                // the latch waited for the server's frame; the next one is a period later
+                client.dueNs = endNs + periodNs + kLatchSlackNs;
+            } else {
+                client.dueNs = std::max(client.dueNs + periodNs, endNs);
+            }
+            return client.dueNs;
+        }
+
+        std::vector<SimClient> &mClients;
+        std::mutex mMutex;
+        std::condition_variable mChanged;
+        std::priority_queue<Entry> mDue;
+    };
+
+    double CpuSeconds() {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+               (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    }
+
+    std::string ReadFile(const std::string &path) {
+        std::string contents;
+        FILE *file = fopen(path.c_str(), "r");
+        if (file == nullptr) {
+            return contents;
+        }
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            contents.append(buffer, read);
+        }
+        fclose(file);
+        return contents;
+    }
+}
+
+int main(int argc, char **argv) {
+    const uint32_t clientCount = argc > 1 ? uint32_t(atoi(argv[1])) : kDefaultClients;
+    const uint32_t seconds = argc > 2 ? uint32_t(atoi(argv[2])) : kDefaultSeconds;
+    const uint32_t workers = argc > 3 ? uint32_t(atoi(argv[3])) : kDefaultWorkers;
+    // every thread gets its policy, as it would with one client per process
+    CHECK(ThreadManager::SetMaxThreads(clientCount * kThreadsPerClient + workers + kProcessThreads));
+
+    StandinPxr::Reset();
+    float rates[] = {float(kDisplayRate)};
+    StandinPxr::SetRefreshRates(rates, 1, float(kDisplayRate));
+    // looking around at 0.25 Hz, hands swinging at 1 Hz
+    StandinPxr::SetHeadMotion([](double timeMs) {
+        return Pose(0.5 * sin(2 * kPi * 0.25 * timeMs / 1000), 0, 1.6f, 0);
+    });
+    for (uint32_t controller = 0; controller < PXR_CONTROLLER_COUNT; controller++) {
+        const float side = controller == PXR_CONTROLLER_LEFT ? -0.2f : 0.2f;
+        StandinPxr::SetControllerMotion(controller, [side](double timeMs) {
+            const double swing = sin(2 * kPi * timeMs / 1000);
+            return Pose(0.3 * swing, side, 1.2f, -0.3f + 0.1f * float(swing));
+        });
+    }
+    StandinCloudXR::SetProfile(StandinServerProfile());
+
+    // every client connects with a bitrate of its own, and caches it in the shared directory
+    const std::string dir = TestUtil::MakeTempDir("multi_client_load");
+    std::vector<SimClient> clients(clientCount);
+    std::vector<std::string> options(clientCount);
+    for (uint32_t i = 0; i < clientCount; i++) {
+        options[i] = "-mbr " + std::to_string(20000 + i * 100);
+        clients[i].fixture.reset(new ClientFixture(dir, "client" + std::to_string(i) + ".txt", options[i]));
+        CHECK(clients[i].fixture->Connect());
+    }
+
+    const double cpuStartS = CpuSeconds();
+    const uint64_t startNs = TestUtil::NowNs();
+    const uint64_t endNs = startNs + seconds * 1000000000ULL;
+    std::thread input([endNs]() {
+        // a trigger pull on both hands every half second
+        PxrControllerInputState state = {};
+        while (TestUtil::NowNs() < endNs) {
+            state.triggerValue = state.triggerValue > 0 ? 0 : 1;
+            for (uint32_t controller = 0; controller < PXR_CONTROLLER_COUNT; controller++) {
+                StandinPxr::SetControllerInput(controller, state);
+            }
+            usleep(250 * 1000);
+        }
+    });
+    ClientPool pool(clients);
+    pool.Run(workers, endNs);
+    input.join();
+    const double elapsedS = (TestUtil::NowNs() - startNs) / 1e9;
+    const double cpuS = CpuSeconds() - cpuStartS;
+
+    ClientMetrics total = {};
+    double minFps = kDisplayRate;
+    for (uint32_t i = 0; i < clientCount; i++) {
+        const ClientMetrics metrics = clients[i].fixture->client->GetMetrics();
+        const double fps = (metrics.latchedFrames - metrics.heldFrames) / elapsedS;
+        minFps = std::min(minFps, fps);
+        total.latchedFrames += metrics.latchedFrames;
+        total.heldFrames += metrics.heldFrames;
+        total.reconnects += metrics.reconnects;
+        total.audioUnderruns += metrics.audioUnderruns;
+        printf("{\"benchmark\":\"MultiClientLoad\",\"client\":%u,\"fps\":%.1f,\"heldFrames\":%llu,"
+               "\"reconnects\":%u,\"audioUnderruns\":%u,\"horizonMs\":%.1f,\"longestFrameMs\":%.1f}\n",
+               metrics.clientId, fps, (unsigned long long) metrics.heldFrames, metrics.reconnects,
+               metrics.audioUnderruns, metrics.predictionHorizonMs, clients[i].longestFrameNs / 1e6);
+
+        // the cache of this client holds its own options
+        const std::string cached = ReadFile(dir + "/launch_options_cache_" + std::to_string(metrics.clientId) + ".txt");
+        CHECK(cached.find(options[i]) != std::string::npos);
+    }
+    printf("{\"benchmark\":\"MultiClientLoad\",\"clients\":%u,\"workers\":%u,\"seconds\":%.1f,\"totalFps\":%.1f,"
+           "\"minClientFps\":%.1f,\"heldFrames\":%llu,\"reconnects\":%u,\"audioUnderruns\":%u,"
+           "\"cpuMsPerClientFrame\":%.3f}\n",
+           clientCount, workers, elapsedS, (total.latchedFrames - total.heldFrames) / elapsedS, minFps,
+           (unsigned long long) total.heldFrames, total.reconnects, total.audioUnderruns,
+           total.latchedFrames > 0 ? cpuS * 1000 / total.latchedFrames : 0.0);
+
+    CHECK(StandinCloudXR::GetReceiverCount() == clientCount);
+    CHECK(minFps > kDisplayRate * 0.8);
+    CHECK(total.reconnects == 0);
+    CHECK(ThreadManager::GetUnregisteredCount() == 0);
+    return TestResult("MultiClientLoad");
+}
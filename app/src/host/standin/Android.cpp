@@ -0,0 +1,129 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "StandinAndroid.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdarg.h>
+#include <stdio.h>
+#include <android/log.h>
+#include <sys/system_properties.h>
+
+namespace {
+    const int32_t kLooperIdMain = 1;
+
+    struct PendingCommand {
+        android_app *app;
+        int32_t cmd;
+    };
+
+    std::mutex gMutex;
+    std::condition_variable gPosted;
+    std::deque<PendingCommand> gCommands;
+    uint64_t gPollTimeouts = 0;
+    JavaVM gVm;
+    ANativeActivity gActivity;
+
+    void ProcessCommand(android_app *, android_poll_source *) {
+        PendingCommand command{};
+        {
+            std::lock_guard<std::mutex> lock(gMutex);
+            if (gCommands.empty()) {
+                return;
+            }
+            command = gCommands.front();
+            gCommands.pop_front();
+        }
+        if (command.app->onAppCmd != nullptr) {
+            command.app->onAppCmd(command.app, command.cmd);
+        }
+        if (command.cmd == APP_CMD_DESTROY) {
+            command.app->destroyRequested = 1;
+        }
+    }
+
+    android_poll_source gCommandSource{kLooperIdMain, nullptr, ProcessCommand};
+
+    char PriorityChar(int prio) {
+        static const char kChars[] = "??VDIWEFS";
+        return prio >= 0 && prio < int(sizeof(kChars) - 1) ? kChars[prio] : '?';
+    }
+}
+
+void StandinAndroid::PostCommand(android_app *app, int32_t cmd) {
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        gCommands.push_back({app, cmd});
+    }
+    gPosted.notify_all();
+}
+
+android_app StandinAndroid::MakeApp(const char *dataDir) {
+    gActivity.vm = &gVm;
+    gActivity.env = nullptr;
+    gActivity.clazz = nullptr;
+    gActivity.internalDataPath = dataDir;
+    gActivity.externalDataPath = dataDir;
+    android_app app{};
+    app.activity = &gActivity;
+    return app;
+}
+
+uint64_t StandinAndroid::GetPollTimeoutCount() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    return gPollTimeouts;
+}
+
+jint JavaVM::AttachCurrentThread(JNIEnv **env, void *) {
+    *env = nullptr;
+    return JNI_OK;
+}
+
+jint JavaVM::DetachCurrentThread() {
+    return JNI_OK;
+}
+
+extern "C" {
+
+int ALooper_pollAll(int timeoutMillis, int *outFd, int *outEvents, void **outData) {
+    std::unique_lock<std::mutex> lock(gMutex);
+    const auto ready = []() { return !gCommands.empty(); };
+    if (timeoutMillis < 0) {
+        gPosted.wait(lock, ready);
+    } else if (timeoutMillis > 0) {
+        gPosted.wait_for(lock, std::chrono::milliseconds(timeoutMillis), ready);
+    }
+    if (gCommands.empty()) {
+        gPollTimeouts++;
+        return ALOOPER_POLL_TIMEOUT;
+    }
+    if (outFd != nullptr) {
+        *outFd = -1;
+    }
+    if (outEvents != nullptr) {
+        *outEvents = 0;
+    }
+    gCommandSource.app = gCommands.front().app;
+    *outData = &gCommandSource;
+    return kLooperIdMain;
+}
+
+int __android_log_write(int prio, const char *tag, const char *text) {
+    return fprintf(stderr, "%c/%s: %s\n", PriorityChar(prio), tag, text);
+}
+
+int __android_log_print(int prio, const char *tag, const char *fmt, ...) {
+    char text[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    return __android_log_write(prio, tag, text);
+}
+
+int __system_property_get(const char *, char *value) {
+    value[0] = '\0';
+    return 0;
+}
+
+}
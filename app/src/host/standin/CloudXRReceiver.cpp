@@ -0,0 +1,538 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "StandinCloudXR.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <math.h>
+#include <time.h>
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+#include <CloudXRMatrixHelpers.h>
+
+namespace {
+    const uint32_t kQueueCapacity = 8;
+    // enough for a few hundred simulated clients
+    const uint32_t kMaxReceivers = 256;
+
+    uint64_t NowNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+    struct PendingFrame {
+        uint64_t sampleNs;
+        uint64_t availableNs;
+        cxrMatrix34 pose;
+    };
+
+    // Pose the server renders with: the sample extrapolated by predictionS.
+    cxrMatrix34 RenderedPose(const cxrTrackedDevicePose &pose, float predictionS) {
+        cxrVector3 position = pose.position;
+        cxrQuaternion rotation = pose.rotation;
+        if (predictionS != 0) {
+            for (int i = 0; i < 3; i++) {
+                position.v[i] += pose.velocity.v[i] * predictionS;
+            }
+            // integrate the angular velocity over the prediction interval
+            const float wx = pose.angularVelocity.v[0], wy = pose.angularVelocity.v[1], wz = pose.angularVelocity.v[2];
+            const float speed = sqrtf(wx * wx + wy * wy + wz * wz);
+            if (speed > 1e-6f) {
+                const float half = speed * predictionS * 0.5f;
+                const float s = sinf(half) / speed;
+                const cxrQuaternion d = {cosf(half), wx * s, wy * s, wz * s};
+                const cxrQuaternion q = rotation;
+                rotation.w = d.w * q.w - d.x * q.x - d.y * q.y - d.z * q.z;
+                rotation.x = d.w * q.x + d.x * q.w + d.y * q.z - d.z * q.y;
+                rotation.y = d.w * q.y - d.x * q.z + d.y * q.w + d.z * q.x;
+                rotation.z = d.w * q.z + d.x * q.y - d.y * q.x + d.z * q.w;
+            }
+        }
+        return cxrConvertQuaternionToMatrix(&rotation, &position);
+    }
+}
+
+struct cxrReceiver {
+    cxrReceiverDesc desc{};
+    StandinServerProfile profile;
+    uint64_t random = 1;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool connected = false;
+    bool streaming = false;
+    bool stopping = false;
+    bool dropRequested = false;
+    cxrConnectionDesc connection{};
+    uint64_t streamingSinceNs = 0;
+    PendingFrame queue[kQueueCapacity]{};
+    uint32_t queueHead = 0;
+    uint32_t queueTail = 0;
+    StandinReceiverCounters counters;
+
+    // stats window
+    uint64_t statsWindowNs = 0;
+    uint64_t statsLatched = 0;
+    double statsLatencyMs = 0;
+
+    std::thread server;
+    std::thread audio;
+
+    // created on the first blit, on the render thread's context
+    GLuint texture = 0;
+    GLuint framebuffer = 0;
+    EGLContext glContext = EGL_NO_CONTEXT;
+
+    // uniform in [0, 1)
+    double NextRandom() {
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+        return double(random >> 11) / double(1ULL << 53);
+    }
+
+    void SetState(cxrClientState state, cxrStateReason reason) {
+        if (desc.clientCallbacks.UpdateClientState != nullptr) {
+            desc.clientCallbacks.UpdateClientState(desc.clientContext, state, reason);
+        }
+    }
+
+    bool InStall(uint64_t nowNs) const {
+        if (profile.stallPeriodMs == 0 || profile.stallMs == 0) {
+            return false;
+        }
+        const uint64_t sinceMs = (nowNs - streamingSinceNs) / 1000000;
+        return sinceMs % profile.stallPeriodMs >= profile.stallPeriodMs - profile.stallMs;
+    }
+
+    void RenderFrame(uint64_t nowNs) {
+        cxrVRTrackingState tracking{};
+        if (desc.clientCallbacks.GetTrackingState != nullptr) {
+            desc.clientCallbacks.GetTrackingState(desc.clientContext, &tracking);
+        }
+        float predictionS = 0;
+        if (!desc.deviceDesc.disablePosePrediction) {
+            predictionS = profile.serverPredictionMs / 1000.0f + desc.deviceDesc.predOffset;
+        }
+        PendingFrame frame;
+        frame.sampleNs = nowNs;
+        frame.pose = RenderedPose(tracking.hmd.pose, predictionS);
+        const double jitterMs = profile.latencyJitterMs * (NextRandom() * 2 - 1);
+        frame.availableNs = nowNs + uint64_t(std::max(0.0, profile.latencyMs + jitterMs) * 1e6);
+        const bool lost = NextRandom() * 100 < profile.frameLossPercent || InStall(nowNs);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        counters.trackingPolls++;
+        if (lost) {
+            counters.framesLost++;
+            return;
+        }
+        counters.framesRendered++;
+        if (queueTail - queueHead >= kQueueCapacity) {
+            queueHead++;
+            counters.framesSkipped++;
+        }
+        queue[queueTail++ % kQueueCapacity] = frame;
+        changed.notify_all();
+    }
+
+    void RunServer() {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait_for(lock, std::chrono::milliseconds(profile.connectDelayMs), [this]() { return stopping; });
+            if (stopping) {
+                return;
+            }
+            if (profile.failConnect) {
+                connected = false;
+                lock.unlock();
+                SetState(cxrClientState_ConnectionAttemptFailed, cxrStateReason_RTSPCannotConnect);
+                return;
+            }
+            streaming = true;
+            streamingSinceNs = NowNs();
+            statsWindowNs = streamingSinceNs;
+        }
+        SetState(cxrClientState_StreamingSessionInProgress, cxrStateReason_NoError);
+
+        const uint64_t frameNs = uint64_t(1e9 / std::max(profile.fps, 1.0f));
+        uint64_t nextFrameNs = NowNs();
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                const uint64_t nowNs = NowNs();
+                const bool expired = profile.disconnectAfterMs > 0 &&
+                                     nowNs - streamingSinceNs >= uint64_t(profile.disconnectAfterMs) * 1000000ULL;
+                if (stopping) {
+                    return;
+                }
+                if (dropRequested || expired) {
+                    streaming = false;
+                    connected = false;
+                    changed.notify_all();
+                    lock.unlock();
+                    SetState(cxrClientState_Disconnected, cxrStateReason_DisconnectedUnexpected);
+                    return;
+                }
+            }
+            RenderFrame(NowNs());
+            nextFrameNs += frameNs;
+            std::unique_lock<std::mutex> lock(mutex);
+            const uint64_t nowNs = NowNs();
+            if (nextFrameNs > nowNs) {
+                changed.wait_for(lock, std::chrono::nanoseconds(nextFrameNs - nowNs),
+                                 [this]() { return stopping || dropRequested; });
+            } else {
+                // a late tracking callback delays the frames, like on the real server
+                nextFrameNs = nowNs;
+            }
+        }
+    }
+
+    void RunAudio() {
+        static int16_t silence[CXR_AUDIO_BYTES_PER_MS * 100 / sizeof(int16_t)];
+        const uint32_t frameMs = std::min<uint32_t>(profile.audioFrameMs, 100);
+        cxrAudioFrame frame{silence, uint32_t(frameMs * CXR_AUDIO_BYTES_PER_MS)};
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            changed.wait_for(lock, std::chrono::milliseconds(frameMs), [this]() { return stopping; });
+            if (stopping || !streaming || desc.clientCallbacks.RenderAudio == nullptr) {
+                continue;
+            }
+            lock.unlock();
+            const cxrBool played = desc.clientCallbacks.RenderAudio(desc.clientContext, &frame);
+            lock.lock();
+            counters.audioFramesRendered++;
+            counters.audioFramesRefused += played ? 0 : 1;
+        }
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            streaming = false;
+            connected = false;
+        }
+        changed.notify_all();
+        if (server.joinable()) {
+            server.join();
+        }
+        if (audio.joinable()) {
+            audio.join();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = false;
+        dropRequested = false;
+        queueHead = queueTail = 0;
+    }
+};
+
+namespace {
+    std::mutex gMutex;
+    StandinServerProfile gProfile;
+    cxrReceiver *gReceivers[kMaxReceivers] = {};
+    uint32_t gReceiverCount = 0;
+    cxrReceiver *gLastReceiver = nullptr;
+}
+
+void StandinCloudXR::SetProfile(const StandinServerProfile &profile) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    gProfile = profile;
+}
+
+StandinServerProfile StandinCloudXR::GetProfile() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    return gProfile;
+}
+
+cxrReceiverHandle StandinCloudXR::GetLastReceiver() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    return gLastReceiver;
+}
+
+uint32_t StandinCloudXR::GetReceiverCount() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    return gReceiverCount;
+}
+
+StandinReceiverCounters StandinCloudXR::GetCounters(cxrReceiverHandle receiver) {
+    std::lock_guard<std::mutex> lock(receiver->mutex);
+    return receiver->counters;
+}
+
+cxrDeviceDesc StandinCloudXR::GetDeviceDesc(cxrReceiverHandle receiver) {
+    std::lock_guard<std::mutex> lock(receiver->mutex);
+    return receiver->desc.deviceDesc;
+}
+
+cxrConnectionDesc StandinCloudXR::GetConnectionDesc(cxrReceiverHandle receiver) {
+    std::lock_guard<std::mutex> lock(receiver->mutex);
+    return receiver->connection;
+}
+
+void StandinCloudXR::SendHaptic(cxrReceiverHandle receiver, const cxrHapticFeedback &haptic) {
+    if (receiver->desc.clientCallbacks.TriggerHaptic != nullptr) {
+        receiver->desc.clientCallbacks.TriggerHaptic(receiver->desc.clientContext, &haptic);
+    }
+}
+
+void StandinCloudXR::Disconnect(cxrReceiverHandle receiver) {
+    {
+        std::lock_guard<std::mutex> lock(receiver->mutex);
+        receiver->dropRequested = true;
+    }
+    receiver->changed.notify_all();
+}
+
+extern "C" {
+
+const char *cxrErrorString(cxrError error) {
+    switch (error) {
+        case cxrError_Success:
+            return "Success";
+        case cxrError_Not_Connected:
+            return "Not connected";
+        case cxrError_Receiver_Invalid:
+            return "Receiver invalid";
+        case cxrError_No_Addr:
+            return "No server address";
+        case cxrError_Frame_Not_Ready:
+            return "Frame not ready";
+        case cxrError_Frame_Not_Latched:
+            return "Frame not latched";
+        default:
+            return "Failed";
+    }
+}
+
+cxrError cxrCreateReceiver(const cxrReceiverDesc *description, cxrReceiverHandle *receiver) {
+    if (description == nullptr || receiver == nullptr ||
+        description->requestedVersion != CLOUDXR_VERSION_DWORD) {
+        return cxrError_Failed;
+    }
+    const uint32_t delayMs = StandinCloudXR::GetProfile().createDelayMs;
+    if (delayMs > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+    }
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (gReceiverCount >= kMaxReceivers) {
+        return cxrError_Failed;
+    }
+    auto *created = new cxrReceiver();
+    created->desc = *description;
+    created->profile = gProfile;
+    created->random = uint64_t(gProfile.seed) * 2654435761ULL + gReceiverCount + 1;
+    gReceivers[gReceiverCount++] = created;
+    gLastReceiver = created;
+    *receiver = created;
+    return cxrError_Success;
+}
+
+void cxrDestroyReceiver(cxrReceiverHandle receiver) {
+    if (receiver == nullptr) {
+        return;
+    }
+    receiver->Stop();
+    if (receiver->glContext != EGL_NO_CONTEXT && eglGetCurrentContext() == receiver->glContext) {
+        glDeleteFramebuffers(1, &receiver->framebuffer);
+        glDeleteTextures(1, &receiver->texture);
+    }
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        for (uint32_t i = 0; i < gReceiverCount; i++) {
+            if (gReceivers[i] == receiver) {
+                gReceivers[i] = gReceivers[--gReceiverCount];
+                break;
+            }
+        }
+        if (gLastReceiver == receiver) {
+            gLastReceiver = gReceiverCount > 0 ? gReceivers[gReceiverCount - 1] : nullptr;
+        }
+    }
+    delete receiver;
+}
+
+cxrError cxrConnect(cxrReceiverHandle receiver, const char *serverAddr, cxrConnectionDesc *description) {
+    if (receiver == nullptr) {
+        return cxrError_Receiver_Invalid;
+    }
+    if (serverAddr == nullptr || serverAddr[0] == '\0') {
+        return cxrError_No_Addr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(receiver->mutex);
+        if (receiver->connected) {
+            return cxrError_Failed;
+        }
+        receiver->connected = true;
+        receiver->connection = *description;
+        receiver->counters.connects++;
+    }
+    receiver->SetState(cxrClientState_ConnectionAttemptInProgress, cxrStateReason_NoError);
+    receiver->server = std::thread([receiver]() { receiver->RunServer(); });
+    if (receiver->profile.audioFrameMs > 0 && receiver->desc.deviceDesc.receiveAudio) {
+        receiver->audio = std::thread([receiver]() { receiver->RunAudio(); });
+    }
+    if (!description->async) {
+        std::unique_lock<std::mutex> lock(receiver->mutex);
+        receiver->changed.wait(lock, [receiver]() { return receiver->streaming || !receiver->connected; });
+        return receiver->streaming ? cxrError_Success : cxrError_Failed;
+    }
+    return cxrError_Success;
+}
+
+void cxrDisconnect(cxrReceiverHandle receiver) {
+    if (receiver != nullptr) {
+        receiver->Stop();
+    }
+}
+
+cxrError cxrLatchFrame(cxrReceiverHandle receiver, cxrFramesLatched *framesLatched, uint32_t, uint32_t timeoutMs) {
+    if (receiver == nullptr) {
+        return cxrError_Receiver_Invalid;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    std::unique_lock<std::mutex> lock(receiver->mutex);
+    while (true) {
+        if (!receiver->streaming) {
+            return cxrError_Not_Connected;
+        }
+        const uint64_t nowNs = NowNs();
+        // newest decoded frame; older ones are skipped
+        int32_t ready = -1;
+        for (uint32_t i = receiver->queueHead; i != receiver->queueTail; i++) {
+            if (receiver->queue[i % kQueueCapacity].availableNs <= nowNs) {
+                ready = int32_t(i);
+            }
+        }
+        if (ready >= 0) {
+            const PendingFrame &frame = receiver->queue[uint32_t(ready) % kQueueCapacity];
+            receiver->counters.framesSkipped += uint32_t(ready) - receiver->queueHead;
+            receiver->counters.framesLatched++;
+            receiver->statsLatched++;
+            receiver->statsLatencyMs += double(nowNs - frame.sampleNs) / 1e6;
+
+            *framesLatched = cxrFramesLatched{};
+            framesLatched->count = receiver->desc.numStreams;
+            for (uint32_t eye = 0; eye < framesLatched->count && eye < CXR_MAX_NUM_VIDEO_STREAMS; eye++) {
+                cxrVideoFrame &video = framesLatched->frames[eye];
+                video.texture = receiver->texture;
+                video.widthFinal = receiver->desc.deviceDesc.width;
+                video.heightFinal = receiver->desc.deviceDesc.height;
+                video.pitch = video.widthFinal * 4;
+                video.timeStamp = frame.sampleNs;
+            }
+            framesLatched->poseMatrix = frame.pose;
+            framesLatched->timeStamp = frame.sampleNs;
+            receiver->queueHead = uint32_t(ready) + 1;
+            return cxrError_Success;
+        }
+        // wait for the next frame to arrive or become available
+        auto wake = deadline;
+        if (receiver->queueHead != receiver->queueTail) {
+            const uint64_t availableNs = receiver->queue[receiver->queueHead % kQueueCapacity].availableNs;
+            wake = std::min(wake, std::chrono::steady_clock::now() + std::chrono::nanoseconds(availableNs - nowNs));
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            receiver->counters.latchTimeouts++;
+            return cxrError_Frame_Not_Ready;
+        }
+        receiver->changed.wait_until(lock, wake);
+    }
+}
+
+void cxrBlitFrame(cxrReceiverHandle receiver, cxrFramesLatched *framesLatched, uint32_t frameMask) {
+    if (receiver == nullptr) {
+        return;
+    }
+    // the frames in the mask, side by side in the viewport
+    const uint32_t streams = framesLatched != nullptr ? std::min(framesLatched->count, uint32_t(CXR_MAX_NUM_VIDEO_STREAMS)) : 1;
+    const uint32_t count = uint32_t(__builtin_popcount(frameMask & ((1u << streams) - 1)));
+    const EGLContext context = eglGetCurrentContext();
+    if (context != EGL_NO_CONTEXT) {
+        if (receiver->glContext == EGL_NO_CONTEXT) {
+            // a 1x1 frame in the client's background-free test color
+            const uint8_t color[4] = {32, 96, 160, 255};
+            glGenTextures(1, &receiver->texture);
+            glBindTexture(GL_TEXTURE_2D, receiver->texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, color);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glGenFramebuffers(1, &receiver->framebuffer);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, receiver->framebuffer);
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, receiver->texture, 0);
+            receiver->glContext = context;
+        }
+        GLint viewport[4] = {};
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, receiver->framebuffer);
+        for (uint32_t i = 0; i < count; i++) {
+            const GLint x0 = viewport[0] + GLint(viewport[2] * i / count);
+            const GLint x1 = viewport[0] + GLint(viewport[2] * (i + 1) / count);
+            glBlitFramebuffer(0, 0, 1, 1, x0, viewport[1], x1, viewport[1] + viewport[3], GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+    std::lock_guard<std::mutex> lock(receiver->mutex);
+    receiver->counters.blitCalls++;
+    receiver->counters.framesBlitted += count;
+}
+
+void cxrReleaseFrame(cxrReceiverHandle receiver, cxrFramesLatched *) {
+    if (receiver == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(receiver->mutex);
+    receiver->counters.framesReleased++;
+}
+
+cxrError cxrSendAudio(cxrReceiverHandle receiver, const cxrAudioFrame *) {
+    if (receiver == nullptr) {
+        return cxrError_Receiver_Invalid;
+    }
+    std::lock_guard<std::mutex> lock(receiver->mutex);
+    if (!receiver->streaming) {
+        return cxrError_Not_Connected;
+    }
+    receiver->counters.audioFramesSent++;
+    return cxrError_Success;
+}
+
+cxrError cxrGetConnectionStats(cxrReceiverHandle receiver, cxrConnectionStats *stats) {
+    if (receiver == nullptr) {
+        return cxrError_Receiver_Invalid;
+    }
+    std::unique_lock<std::mutex> lock(receiver->mutex);
+    if (!receiver->streaming) {
+        return cxrError_Not_Connected;
+    }
+    const uint64_t nowNs = NowNs();
+    const double windowS = std::max(double(nowNs - receiver->statsWindowNs) / 1e9, 1e-3);
+    *stats = cxrConnectionStats{};
+    stats->framesPerSecond = float(double(receiver->statsLatched) / windowS);
+    stats->frameDeliveryTime = receiver->statsLatched > 0 ? float(receiver->statsLatencyMs / receiver->statsLatched) : 0;
+    stats->bandwidthAvailableKbps = 200000;
+    stats->bandwidthUtilizationKbps = receiver->connection.maxVideoBitrateKbps > 0
+                                      ? receiver->connection.maxVideoBitrateKbps : 50000;
+    stats->bandwidthUtilizationPercent = stats->bandwidthUtilizationKbps * 100 / stats->bandwidthAvailableKbps;
+    stats->roundTripDelayMs = uint32_t(receiver->profile.latencyMs / 2);
+    // ~100 packets per frame
+    stats->totalPacketsReceived = uint32_t(receiver->counters.framesRendered * 100);
+    stats->totalPacketsLost = uint32_t(receiver->counters.framesLost * 100);
+    stats->quality = cxrConnectionQuality_Excellent;
+    stats->qualityReasons = cxrConnectionQualityReason_EstimatingQuality;
+    receiver->statsWindowNs = nowNs;
+    receiver->statsLatched = 0;
+    receiver->statsLatencyMs = 0;
+    const uint64_t streamingMs = (nowNs - receiver->streamingSinceNs) / 1000000;
+    lock.unlock();
+    if (receiver->profile.stats) {
+        receiver->profile.stats(streamingMs, stats);
+    }
+    return cxrError_Success;
+}
+
+}
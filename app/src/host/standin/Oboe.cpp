@@ -0,0 +1,211 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "StandinOboe.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace oboe {
+    // The registry's view of a stream's state.
+    struct StandinStreamAccess {
+        static StreamState &State(AudioStream &stream) { return stream.mState; }
+
+        static int32_t &XRuns(AudioStream &stream) { return stream.mXRuns; }
+
+        static std::mutex &Mutex(AudioStream &stream) { return stream.mMutex; }
+
+        static const AudioStreamBuilder &Builder(AudioStream &stream) { return stream.mBuilder; }
+    };
+}
+
+namespace {
+    using Access = oboe::StandinStreamAccess;
+
+    std::mutex gMutex;
+    bool gAvailable = true;
+    std::atomic<uint32_t> gOpenDelayMs{0};
+    // open streams; owned by the client's shared_ptrs
+    std::vector<oboe::AudioStream *> gStreams;
+    uint32_t gOpenedTotal = 0;
+    std::atomic<int64_t> gFramesWritten{0};
+
+    void Unregister(oboe::AudioStream *stream) {
+        std::lock_guard<std::mutex> lock(gMutex);
+        gStreams.erase(std::remove(gStreams.begin(), gStreams.end(), stream), gStreams.end());
+    }
+}
+
+const char *oboe::convertToText(Result result) {
+    switch (result) {
+        case Result::OK:
+            return "OK";
+        case Result::ErrorDisconnected:
+            return "ErrorDisconnected";
+        case Result::ErrorIllegalArgument:
+            return "ErrorIllegalArgument";
+        case Result::ErrorInternal:
+            return "ErrorInternal";
+        case Result::ErrorInvalidState:
+            return "ErrorInvalidState";
+        case Result::ErrorUnavailable:
+            return "ErrorUnavailable";
+        case Result::ErrorClosed:
+            return "ErrorClosed";
+        default:
+            return "Error";
+    }
+}
+
+oboe::Result oboe::AudioStreamBuilder::openStream(std::shared_ptr<AudioStream> &stream) {
+    const uint32_t delayMs = gOpenDelayMs.load();
+    if (delayMs > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+    }
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (!gAvailable) {
+        return Result::ErrorUnavailable;
+    }
+    stream = std::make_shared<AudioStream>(*this);
+    gStreams.push_back(stream.get());
+    gOpenedTotal++;
+    return Result::OK;
+}
+
+oboe::Result oboe::AudioStream::start() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mState == StreamState::Closed || mState == StreamState::Disconnected) {
+        return Result::ErrorClosed;
+    }
+    mState = StreamState::Started;
+    return Result::OK;
+}
+
+oboe::Result oboe::AudioStream::stop() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mState == StreamState::Closed || mState == StreamState::Disconnected) {
+        return Result::ErrorClosed;
+    }
+    mState = StreamState::Stopped;
+    return Result::OK;
+}
+
+oboe::Result oboe::AudioStream::close() {
+    Unregister(this);
+    std::lock_guard<std::mutex> lock(mMutex);
+    mState = StreamState::Closed;
+    return Result::OK;
+}
+
+oboe::ResultWithValue<int32_t> oboe::AudioStream::write(const void *, int32_t numFrames, int64_t) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mState != StreamState::Started) {
+        return mState == StreamState::Closed || mState == StreamState::Disconnected ? Result::ErrorClosed
+                                                                                   : Result::ErrorInvalidState;
+    }
+    mFramesWritten += numFrames;
+    gFramesWritten.fetch_add(numFrames);
+    return numFrames;
+}
+
+oboe::ResultWithValue<int32_t> oboe::AudioStream::setBufferSizeInFrames(int32_t requestedFrames) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mBufferSizeInFrames = std::max(requestedFrames, kFramesPerBurst);
+    return mBufferSizeInFrames;
+}
+
+oboe::ResultWithValue<int32_t> oboe::AudioStream::getXRunCount() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mXRuns;
+}
+
+oboe::StreamState oboe::AudioStream::getState() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mState;
+}
+
+int64_t oboe::AudioStream::getFramesWritten() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mFramesWritten;
+}
+
+void StandinOboe::Reset() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    gAvailable = true;
+    gOpenDelayMs = 0;
+    gStreams.clear();
+    gOpenedTotal = 0;
+    gFramesWritten = 0;
+}
+
+void StandinOboe::SetDeviceAvailable(bool available) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    gAvailable = available;
+}
+
+void StandinOboe::SetOpenDelayMs(uint32_t delayMs) {
+    gOpenDelayMs = delayMs;
+}
+
+void StandinOboe::Disconnect() {
+    std::vector<oboe::AudioStream *> streams;
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        streams.swap(gStreams);
+    }
+    for (oboe::AudioStream *stream : streams) {
+        std::lock_guard<std::mutex> lock(Access::Mutex(*stream));
+        Access::State(*stream) = oboe::StreamState::Closed;
+    }
+    // Oboe reports from its own thread; the client keeps its shared_ptr until it reopens, so
+    // the streams outlive the callbacks
+    std::thread errors([&streams]() {
+        for (oboe::AudioStream *stream : streams) {
+            oboe::AudioStreamErrorCallback *callback = Access::Builder(*stream).getErrorCallback();
+            if (callback != nullptr) {
+                callback->onErrorAfterClose(stream, oboe::Result::ErrorDisconnected);
+            }
+        }
+    });
+    errors.join();
+}
+
+void StandinOboe::AddXRuns(int32_t count) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    for (oboe::AudioStream *stream : gStreams) {
+        if (stream->getDirection() == oboe::Direction::Output) {
+            std::lock_guard<std::mutex> streamLock(Access::Mutex(*stream));
+            Access::XRuns(*stream) += count;
+        }
+    }
+}
+
+void StandinOboe::PumpInput(int32_t numFrames) {
+    std::vector<oboe::AudioStream *> streams;
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        streams = gStreams;
+    }
+    std::vector<int16_t> silence(size_t(numFrames) * 2);
+    for (oboe::AudioStream *stream : streams) {
+        oboe::AudioStreamDataCallback *callback = Access::Builder(*stream).getDataCallback();
+        if (stream->getDirection() == oboe::Direction::Input && stream->getState() == oboe::StreamState::Started &&
+            callback != nullptr) {
+            callback->onAudioReady(stream, silence.data(), numFrames);
+        }
+    }
+}
+
+uint32_t StandinOboe::GetOpenStreamCount() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    return uint32_t(gStreams.size());
+}
+
+uint32_t StandinOboe::GetOpenedTotal() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    return gOpenedTotal;
+}
+
+int64_t StandinOboe::GetFramesWritten() {
+    return gFramesWritten.load();
+}
@@ -0,0 +1,505 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "StandinPxr.h"
+#include <atomic>
+#include <errno.h>
+#include <math.h>
+#include <mutex>
+#include <string.h>
+#include <time.h>
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+#include <PxrApi.h>
+
+namespace {
+    const uint32_t kMaxLayers = 4;
+    const uint32_t kMaxEvents = 256;
+    const uint32_t kMaxRates = 8;
+
+    struct Layer {
+        bool used = false;
+        PxrLayerParam param{};
+        uint32_t eyeCount = 0;
+        bool glImages = false;
+        uint64_t images[PXR_EYE_MAX][StandinPxr::kLayerImageCount]{};
+        uint32_t nextImage = 0;
+    };
+
+    std::atomic<uint64_t> gCalls[StandinPxrCall_Count];
+
+    // everything below
+    std::mutex gMutex;
+    bool gRunning = true;
+    float gIpd = 0.064f;
+    bool gControllerConnected[PXR_CONTROLLER_COUNT] = {true, true};
+    PxrControllerInputState gControllerInput[PXR_CONTROLLER_COUNT]{};
+    float gRates[kMaxRates] = {72, 90};
+    uint32_t gRateCount = 2;
+    float gRate = 72;
+    uint32_t gViewWidth = 1920;
+    uint32_t gViewHeight = 1920;
+    StandinPxr::Motion gHeadMotion;
+    StandinPxr::Motion gControllerMotion[PXR_CONTROLLER_COUNT];
+    StandinPxr::VibrationSink gVibrationSink;
+    PxrEventDataBuffer gEvents[kMaxEvents];
+    uint32_t gEventHead = 0;
+    uint32_t gEventTail = 0;
+    Layer gLayers[kMaxLayers];
+    PxrLayerProjection gLastSubmitted{};
+    uint64_t gNextImageId = 1;
+
+    void Count(StandinPxrCall call) {
+        gCalls[call].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    double NowMs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return double(ts.tv_sec) * 1000.0 + double(ts.tv_nsec) / 1e6;
+    }
+
+    PxrPosef StillPose() {
+        PxrPosef pose{};
+        pose.orientation.w = 1;
+        pose.position.y = 1.6f;
+        return pose;
+    }
+
+    PxrPosef Evaluate(const StandinPxr::Motion &motion, double timeMs) {
+        return motion ? motion(timeMs) : StillPose();
+    }
+
+    Layer *FindLayer(int layerId) {
+        for (Layer &layer : gLayers) {
+            if (layer.used && layer.param.layerId == layerId) {
+                return &layer;
+            }
+        }
+        return nullptr;
+    }
+
+    void ReleaseImages(Layer &layer) {
+        if (layer.glImages && eglGetCurrentContext() != EGL_NO_CONTEXT) {
+            for (uint32_t eye = 0; eye < layer.eyeCount; eye++) {
+                for (uint64_t &image : layer.images[eye]) {
+                    GLuint texture = GLuint(image);
+                    glDeleteTextures(1, &texture);
+                }
+            }
+        }
+        layer = Layer();
+    }
+
+    bool PushEventLocked(const PxrEventDataBuffer &event) {
+        if (gEventTail - gEventHead >= kMaxEvents) {
+            return false;
+        }
+        gEvents[gEventTail++ % kMaxEvents] = event;
+        return true;
+    }
+}
+
+void StandinPxr::Reset() {
+    ResetCallCounts();
+    std::lock_guard<std::mutex> lock(gMutex);
+    gRunning = true;
+    gIpd = 0.064f;
+    for (uint32_t i = 0; i < PXR_CONTROLLER_COUNT; i++) {
+        gControllerConnected[i] = true;
+        gControllerInput[i] = PxrControllerInputState{};
+        gControllerMotion[i] = nullptr;
+    }
+    gRates[0] = 72;
+    gRates[1] = 90;
+    gRateCount = 2;
+    gRate = 72;
+    gViewWidth = 1920;
+    gViewHeight = 1920;
+    gHeadMotion = nullptr;
+    gVibrationSink = nullptr;
+    gEventHead = gEventTail = 0;
+    for (Layer &layer : gLayers) {
+        if (layer.used) {
+            ReleaseImages(layer);
+        }
+    }
+    gLastSubmitted = PxrLayerProjection{};
+}
+
+uint64_t StandinPxr::GetCallCount(StandinPxrCall call) {
+    return gCalls[call].load(std::memory_order_relaxed);
+}
+
+uint64_t StandinPxr::GetQueryCount() {
+    static const StandinPxrCall kQueries[] = {
+            StandinPxrCall_GetIPD, StandinPxrCall_GetControllerConnectStatus,
+            StandinPxrCall_GetControllerCapabilities, StandinPxrCall_GetControllerInputState,
+            StandinPxrCall_GetControllerTrackingState, StandinPxrCall_GetPredictedDisplayTime,
+            StandinPxrCall_GetPredictedMainSensorState, StandinPxrCall_GetConfigViewsInfos,
+            StandinPxrCall_GetFov, StandinPxrCall_GetDisplayRefreshRate,
+            StandinPxrCall_GetDisplayRefreshRatesAvailable, StandinPxrCall_GetLayerImage,
+            StandinPxrCall_GetLayerNextImageIndex,
+    };
+    uint64_t count = 0;
+    for (StandinPxrCall call : kQueries) {
+        count += GetCallCount(call);
+    }
+    return count;
+}
+
+void StandinPxr::ResetCallCounts() {
+    for (auto &calls : gCalls) {
+        calls.store(0, std::memory_order_relaxed);
+    }
+}
+
+void StandinPxr::SetRunning(bool running) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    gRunning = running;
+}
+
+void StandinPxr::SetIpd(float ipd) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    gIpd = ipd;
+}
+
+void StandinPxr::SetControllerConnected(uint32_t controller, bool connected) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (controller < PXR_CONTROLLER_COUNT) {
+        gControllerConnected[controller] = connected;
+    }
+}
+
+void StandinPxr::SetControllerInput(uint32_t controller, const PxrControllerInputState &state) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (controller < PXR_CONTROLLER_COUNT) {
+        gControllerInput[controller] = state;
+    }
+}
+
+void StandinPxr::SetRefreshRates(const float *rates, uint32_t count, float current) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    gRateCount = count < kMaxRates ? count : kMaxRates;
+    memcpy(gRates, rates, gRateCount * sizeof(float));
+    gRate = current;
+}
+
+float StandinPxr::GetRefreshRate() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    return gRate;
+}
+
+void StandinPxr::SetViewSize(uint32_t width, uint32_t height) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    gViewWidth = width;
+    gViewHeight = height;
+}
+
+void StandinPxr::SetHeadMotion(Motion motion) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    gHeadMotion = std::move(motion);
+}
+
+void StandinPxr::SetControllerMotion(uint32_t controller, Motion motion) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (controller < PXR_CONTROLLER_COUNT) {
+        gControllerMotion[controller] = std::move(motion);
+    }
+}
+
+void StandinPxr::SetVibrationSink(VibrationSink sink) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    gVibrationSink = std::move(sink);
+}
+
+bool StandinPxr::PushEvent(const PxrEventDataBuffer &event) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    return PushEventLocked(event);
+}
+
+uint32_t StandinPxr::GetPendingEventCount() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    return gEventTail - gEventHead;
+}
+
+PxrLayerProjection StandinPxr::GetLastSubmittedLayer() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    return gLastSubmitted;
+}
+
+uint64_t StandinPxr::GetLayerImage(int layerId, uint32_t eye, uint32_t index) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    const Layer *layer = FindLayer(layerId);
+    return layer != nullptr && eye < layer->eyeCount && index < kLayerImageCount ? layer->images[eye][index] : 0;
+}
+
+extern "C" {
+
+int Pxr_SetInitializeData(PxrInitParamData *) {
+    return 0;
+}
+
+int Pxr_Initialize() {
+    return 0;
+}
+
+int Pxr_Shutdown() {
+    return 0;
+}
+
+bool Pxr_IsRunning() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    return gRunning;
+}
+
+int Pxr_BeginXr() {
+    return 0;
+}
+
+int Pxr_EndXr() {
+    return 0;
+}
+
+float Pxr_GetIPD() {
+    Count(StandinPxrCall_GetIPD);
+    std::lock_guard<std::mutex> lock(gMutex);
+    return gIpd;
+}
+
+int Pxr_GetConfigViewsInfos(uint32_t *maxImageRectWidth, uint32_t *maxImageRectHeight,
+                            uint32_t *recommendedImageRectWidth, uint32_t *recommendedImageRectHeight) {
+    Count(StandinPxrCall_GetConfigViewsInfos);
+    std::lock_guard<std::mutex> lock(gMutex);
+    *maxImageRectWidth = gViewWidth * 2;
+    *maxImageRectHeight = gViewHeight * 2;
+    *recommendedImageRectWidth = gViewWidth;
+    *recommendedImageRectHeight = gViewHeight;
+    return 0;
+}
+
+int Pxr_GetFov(PxrEyeType, float *fovLeft, float *fovRight, float *fovUp, float *fovDown) {
+    Count(StandinPxrCall_GetFov);
+    *fovLeft = *fovRight = *fovUp = *fovDown = 0.8f;
+    return 0;
+}
+
+int Pxr_GetDisplayRefreshRatesAvailable(uint32_t *count, float **rateArray) {
+    Count(StandinPxrCall_GetDisplayRefreshRatesAvailable);
+    std::lock_guard<std::mutex> lock(gMutex);
+    *count = gRateCount;
+    *rateArray = gRates;
+    return 0;
+}
+
+int Pxr_GetDisplayRefreshRate(float *refreshRate) {
+    Count(StandinPxrCall_GetDisplayRefreshRate);
+    std::lock_guard<std::mutex> lock(gMutex);
+    *refreshRate = gRate;
+    return 0;
+}
+
+int Pxr_SetDisplayRefreshRate(float refreshRate) {
+    Count(StandinPxrCall_SetDisplayRefreshRate);
+    std::lock_guard<std::mutex> lock(gMutex);
+    bool supported = false;
+    for (uint32_t i = 0; i < gRateCount; i++) {
+        supported |= gRates[i] == refreshRate;
+    }
+    if (!supported) {
+        return -1;
+    }
+    gRate = refreshRate;
+    // the runtime confirms every switch, also to the rate it already runs at
+    PxrEventDataBuffer event{};
+    auto &changed = (PxrEventDataRefreshRateChanged &) event;
+    changed.type = PXR_TYPE_EVENT_DATA_REFRESH_RATE_CHANGED;
+    changed.refrashRate = refreshRate;
+    PushEventLocked(event);
+    return 0;
+}
+
+bool Pxr_PollEvent(int eventCountMAX, int *eventDataCountOutput, PxrEventDataBuffer **eventDataPtr) {
+    Count(StandinPxrCall_PollEvent);
+    std::lock_guard<std::mutex> lock(gMutex);
+    int count = 0;
+    for (; count < eventCountMAX && gEventHead != gEventTail; count++) {
+        *eventDataPtr[count] = gEvents[gEventHead++ % kMaxEvents];
+    }
+    *eventDataCountOutput = count;
+    return count > 0;
+}
+
+int Pxr_GetPredictedDisplayTime(double *predictedDisplayTimeMs) {
+    Count(StandinPxrCall_GetPredictedDisplayTime);
+    std::lock_guard<std::mutex> lock(gMutex);
+    *predictedDisplayTimeMs = NowMs() + StandinPxr::kDisplayLatencyFrames * 1000.0 / gRate;
+    return 0;
+}
+
+int Pxr_GetPredictedMainSensorState(double predictTimeMs, PxrSensorState *sensorState, int *sensorFrameIndex) {
+    Count(StandinPxrCall_GetPredictedMainSensorState);
+    static std::atomic<int> frameIndex{0};
+    std::lock_guard<std::mutex> lock(gMutex);
+    *sensorState = PxrSensorState{};
+    sensorState->status = 3;
+    sensorState->pose = Evaluate(gHeadMotion, predictTimeMs);
+    sensorState->poseTimeStampNs = uint64_t(predictTimeMs * 1e6);
+    *sensorFrameIndex = frameIndex.fetch_add(1);
+    return 0;
+}
+
+int Pxr_BeginFrame() {
+    Count(StandinPxrCall_BeginFrame);
+    float rate = 0;
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        rate = gRate;
+    }
+    // the runtime paces the frame loop: wait for the next vsync
+    const double periodMs = 1000.0 / rate;
+    const double vsyncMs = (floor(NowMs() / periodMs) + 1) * periodMs;
+    struct timespec deadline;
+    deadline.tv_sec = time_t(vsyncMs / 1000);
+    deadline.tv_nsec = long((vsyncMs - deadline.tv_sec * 1000.0) * 1e6);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+    }
+    return 0;
+}
+
+int Pxr_SubmitLayer(const PxrLayerHeader *layer) {
+    Count(StandinPxrCall_SubmitLayer);
+    std::lock_guard<std::mutex> lock(gMutex);
+    gLastSubmitted = *(const PxrLayerProjection *) layer;
+    return 0;
+}
+
+int Pxr_EndFrame() {
+    Count(StandinPxrCall_EndFrame);
+    return 0;
+}
+
+int Pxr_CreateLayer(const PxrLayerParam *layerParam) {
+    Count(StandinPxrCall_CreateLayer);
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (FindLayer(layerParam->layerId) != nullptr) {
+        return -1;
+    }
+    for (Layer &layer : gLayers) {
+        if (layer.used) {
+            continue;
+        }
+        layer.used = true;
+        layer.param = *layerParam;
+        layer.eyeCount = layerParam->layerLayout == PXR_LAYER_LAYOUT_DOUBLE_WIDE ? 1 : PXR_EYE_MAX;
+        layer.glImages = eglGetCurrentContext() != EGL_NO_CONTEXT;
+        for (uint32_t eye = 0; eye < layer.eyeCount; eye++) {
+            for (uint64_t &image : layer.images[eye]) {
+                if (!layer.glImages) {
+                    image = gNextImageId++;
+                    continue;
+                }
+                GLuint texture = 0;
+                glGenTextures(1, &texture);
+                glBindTexture(GL_TEXTURE_2D, texture);
+                glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, layerParam->width, layerParam->height);
+                image = texture;
+            }
+        }
+        if (layer.glImages) {
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        return 0;
+    }
+    return -1;
+}
+
+int Pxr_DestroyLayer(int layerId) {
+    Count(StandinPxrCall_DestroyLayer);
+    std::lock_guard<std::mutex> lock(gMutex);
+    Layer *layer = FindLayer(layerId);
+    if (layer == nullptr) {
+        return -1;
+    }
+    ReleaseImages(*layer);
+    return 0;
+}
+
+int Pxr_GetLayerImageCount(int layerId, PxrEyeType eye, uint32_t *imageCount) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    const Layer *layer = FindLayer(layerId);
+    *imageCount = layer != nullptr && uint32_t(eye) < layer->eyeCount ? StandinPxr::kLayerImageCount : 0;
+    return layer != nullptr ? 0 : -1;
+}
+
+int Pxr_GetLayerImage(int layerId, PxrEyeType eye, int imageIndex, uint64_t *image) {
+    Count(StandinPxrCall_GetLayerImage);
+    std::lock_guard<std::mutex> lock(gMutex);
+    const Layer *layer = FindLayer(layerId);
+    if (layer == nullptr || uint32_t(eye) >= layer->eyeCount || imageIndex < 0 ||
+        uint32_t(imageIndex) >= StandinPxr::kLayerImageCount) {
+        return -1;
+    }
+    *image = layer->images[eye][imageIndex];
+    return 0;
+}
+
+int Pxr_GetLayerNextImageIndex(int layerId, int *imageIndex) {
+    Count(StandinPxrCall_GetLayerNextImageIndex);
+    std::lock_guard<std::mutex> lock(gMutex);
+    Layer *layer = FindLayer(layerId);
+    if (layer == nullptr) {
+        return -1;
+    }
+    *imageIndex = int(layer->nextImage);
+    layer->nextImage = (layer->nextImage + 1) % StandinPxr::kLayerImageCount;
+    return 0;
+}
+
+int Pxr_GetControllerConnectStatus(uint32_t deviceID) {
+    Count(StandinPxrCall_GetControllerConnectStatus);
+    std::lock_guard<std::mutex> lock(gMutex);
+    return deviceID < PXR_CONTROLLER_COUNT && gControllerConnected[deviceID] ? 1 : 0;
+}
+
+int Pxr_GetControllerCapabilities(uint32_t deviceID, PxrControllerCapability *capability) {
+    Count(StandinPxrCall_GetControllerCapabilities);
+    if (deviceID >= PXR_CONTROLLER_COUNT) {
+        return -1;
+    }
+    *capability = PxrControllerCapability{};
+    capability->type = PXR_CV3_Optics_Controller;
+    return 0;
+}
+
+int Pxr_GetControllerTrackingState(uint32_t deviceID, double predictTime, float[], PxrControllerTracking *tracking) {
+    Count(StandinPxrCall_GetControllerTrackingState);
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (deviceID >= PXR_CONTROLLER_COUNT) {
+        return -1;
+    }
+    *tracking = PxrControllerTracking{};
+    tracking->localControllerPose.status = 3;
+    tracking->localControllerPose.pose = Evaluate(gControllerMotion[deviceID], predictTime);
+    tracking->globalControllerPose = tracking->localControllerPose;
+    return 0;
+}
+
+int Pxr_GetControllerInputState(uint32_t deviceID, PxrControllerInputState *state) {
+    Count(StandinPxrCall_GetControllerInputState);
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (deviceID >= PXR_CONTROLLER_COUNT) {
+        return -1;
+    }
+    *state = gControllerInput[deviceID];
+    return 0;
+}
+
+int Pxr_SetControllerVibration(uint32_t deviceID, float strength, int time) {
+    Count(StandinPxrCall_SetControllerVibration);
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (gVibrationSink) {
+        gVibrationSink(deviceID, strength, time);
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,23 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_STANDIN_ANDROID_H
+#define CLIENT_HOST_STANDIN_ANDROID_H
+
+#include <android_native_app_glue.h>
+
+// Host implementation of the NDK pieces android_main() runs on, in standin/Android.cpp.
+//
+// ALooper_pollAll() waits for commands posted with PostCommand() and delivers each through a
+// poll source that calls the app's onAppCmd, like native_app_glue; APP_CMD_DESTROY also sets
+// destroyRequested. Logcat output goes to stderr.
+namespace StandinAndroid {
+    void PostCommand(android_app *app, int32_t cmd);
+
+    // An app with an activity whose data paths point to dataDir; the strings must outlive it.
+    android_app MakeApp(const char *dataDir);
+
+    // ALooper_pollAll() calls that returned ALOOPER_POLL_TIMEOUT: the main loop has one per
+    // iteration, after the commands.
+    uint64_t GetPollTimeoutCount();
+}
+
+#endif //CLIENT_HOST_STANDIN_ANDROID_H
@@ -0,0 +1,88 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_STANDIN_CLOUDXR_H
+#define CLIENT_HOST_STANDIN_CLOUDXR_H
+
+#include <functional>
+#include <stdint.h>
+#include <CloudXRClient.h>
+
+// How the stand-in server behind a receiver behaves.
+struct StandinServerProfile {
+    // frames rendered per second
+    float fps = 72;
+    // from the tracking sample a frame is rendered with to the frame being latchable
+    float latencyMs = 30;
+    // uniform, added to latencyMs per frame
+    float latencyJitterMs = 0;
+    float frameLossPercent = 0;
+    // no frames for stallMs every stallPeriodMs, 0 for none
+    uint32_t stallPeriodMs = 0;
+    uint32_t stallMs = 0;
+    // unless the device disables pose prediction, the server extrapolates each sample by its
+    // own latency estimate plus predOffset, like the CloudXR server
+    float serverPredictionMs = 30;
+    // cxrCreateReceiver() blocks this long, like the SDK bringing up its decoder and network
+    uint32_t createDelayMs = 0;
+    // async connects complete after this long
+    uint32_t connectDelayMs = 20;
+    bool failConnect = false;
+    // the server drops the session after this long streaming, 0 for never
+    uint32_t disconnectAfterMs = 0;
+    // one RenderAudio() callback of this length, 0 for no audio
+    uint32_t audioFrameMs = 10;
+    // overrides fields of the stats of each cxrGetConnectionStats() call, e.g. bandwidth traces
+    std::function<void(uint64_t streamingMs, cxrConnectionStats *stats)> stats;
+    uint32_t seed = 1;
+};
+
+// Counters of one receiver.
+struct StandinReceiverCounters {
+    uint64_t trackingPolls = 0;
+    uint64_t framesRendered = 0;
+    uint64_t framesLost = 0;
+    uint64_t framesLatched = 0;
+    // frames replaced in the decode queue before they were latched
+    uint64_t framesSkipped = 0;
+    uint64_t latchTimeouts = 0;
+    // cxrBlitFrame() calls, and the eye frames they blitted
+    uint64_t blitCalls = 0;
+    uint64_t framesBlitted = 0;
+    uint64_t framesReleased = 0;
+    uint64_t audioFramesRendered = 0;
+    uint64_t audioFramesRefused = 0;
+    uint64_t audioFramesSent = 0;
+    uint32_t connects = 0;
+};
+
+// Host implementation of the CloudXR receiver API, in standin/CloudXRReceiver.cpp.
+//
+// Each receiver runs a server thread that polls the client's GetTrackingState callback at the
+// profile's frame rate, renders a frame with that pose and makes it latchable latencyMs later.
+// Frames carry the sample's CLOCK_MONOTONIC time in cxrFramesLatched::timeStamp. cxrBlitFrame
+// fills the viewport of the bound draw framebuffer with a solid color per frame in the mask,
+// side by side, when a GL context is current. Nothing is allocated per frame.
+namespace StandinCloudXR {
+    // Used by receivers created afterwards.
+    void SetProfile(const StandinServerProfile &profile);
+
+    StandinServerProfile GetProfile();
+
+    // The receiver created last that is not destroyed yet, or null.
+    cxrReceiverHandle GetLastReceiver();
+
+    uint32_t GetReceiverCount();
+
+    StandinReceiverCounters GetCounters(cxrReceiverHandle receiver);
+
+    cxrDeviceDesc GetDeviceDesc(cxrReceiverHandle receiver);
+
+    cxrConnectionDesc GetConnectionDesc(cxrReceiverHandle receiver);
+
+    // Sends a haptic feedback request to the client, from the server thread.
+    void SendHaptic(cxrReceiverHandle receiver, const cxrHapticFeedback &haptic);
+
+    // Drops the session as if the network went away.
+    void Disconnect(cxrReceiverHandle receiver);
+}
+
+#endif //CLIENT_HOST_STANDIN_CLOUDXR_H
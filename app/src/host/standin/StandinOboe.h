@@ -0,0 +1,38 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_STANDIN_OBOE_H
+#define CLIENT_HOST_STANDIN_OBOE_H
+
+#include <stdint.h>
+#include <oboe/Oboe.h>
+
+// Controls the fake audio device behind the stand-in Oboe streams, in standin/Oboe.cpp.
+namespace StandinOboe {
+    // One available device, no streams, no counts.
+    void Reset();
+
+    // While unavailable, openStream() fails with ErrorUnavailable.
+    void SetDeviceAvailable(bool available);
+
+    // openStream() takes this long, like opening an AAudio device; 0 after Reset().
+    void SetOpenDelayMs(uint32_t delayMs);
+
+    // Like unplugging the device: every open stream is closed and its error callback gets
+    // onErrorAfterClose(ErrorDisconnected) on a separate thread; returns once all were called.
+    void Disconnect();
+
+    // Adds underruns to every open output stream.
+    void AddXRuns(int32_t count);
+
+    // Runs the data callback of every started input stream with numFrames of silence.
+    void PumpInput(int32_t numFrames);
+
+    uint32_t GetOpenStreamCount();
+
+    // streams opened since Reset()
+    uint32_t GetOpenedTotal();
+
+    // frames written to output streams since Reset()
+    int64_t GetFramesWritten();
+}
+
+#endif //CLIENT_HOST_STANDIN_OBOE_H
@@ -0,0 +1,96 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_STANDIN_PXR_H
+#define CLIENT_HOST_STANDIN_PXR_H
+
+#include <functional>
+#include <stdint.h>
+#include <sys/types.h>
+#include <PxrTypes.h>
+#include <PxrInput.h>
+
+// Pxr runtime functions the stand-in counts, one counter each.
+enum StandinPxrCall {
+    StandinPxrCall_GetIPD = 0,
+    StandinPxrCall_GetControllerConnectStatus,
+    StandinPxrCall_GetControllerCapabilities,
+    StandinPxrCall_GetControllerInputState,
+    StandinPxrCall_GetControllerTrackingState,
+    StandinPxrCall_GetPredictedDisplayTime,
+    StandinPxrCall_GetPredictedMainSensorState,
+    StandinPxrCall_GetConfigViewsInfos,
+    StandinPxrCall_GetFov,
+    StandinPxrCall_GetDisplayRefreshRate,
+    StandinPxrCall_GetDisplayRefreshRatesAvailable,
+    StandinPxrCall_SetDisplayRefreshRate,
+    StandinPxrCall_SetControllerVibration,
+    StandinPxrCall_PollEvent,
+    StandinPxrCall_BeginFrame,
+    StandinPxrCall_SubmitLayer,
+    StandinPxrCall_EndFrame,
+    StandinPxrCall_CreateLayer,
+    StandinPxrCall_DestroyLayer,
+    StandinPxrCall_GetLayerImage,
+    StandinPxrCall_GetLayerNextImageIndex,
+    StandinPxrCall_Count,
+};
+
+// Host implementation of the Pxr runtime, in standin/Pxr.cpp.
+//
+// Every call the client makes is counted. Device properties, controllers, refresh rates and the
+// head motion are set by the test; Pxr_PollEvent() hands out the events pushed with PushEvent(),
+// and Pxr_SetDisplayRefreshRate() confirms a switch with a refresh rate event like the runtime.
+// Pxr_BeginFrame() blocks until the next vsync of the current refresh rate. Display times are
+// CLOCK_MONOTONIC milliseconds, kDisplayLatencyFrames frames ahead.
+// Motions and the vibration sink run with the runtime's lock held and must not call into it.
+// Layer images are GL textures when a context is current on Pxr_CreateLayer(), plain ids
+// otherwise.
+namespace StandinPxr {
+    static const uint32_t kLayerImageCount = 3;
+    static const uint32_t kDisplayLatencyFrames = 2;
+
+    typedef std::function<PxrPosef(double timeMs)> Motion;
+    typedef std::function<void(uint32_t controller, float strength, int durationMs)> VibrationSink;
+
+    // Back to a running headset at 72 Hz with both controllers connected and a still head.
+    void Reset();
+
+    uint64_t GetCallCount(StandinPxrCall call);
+
+    // calls of every Pxr_Get* query
+    uint64_t GetQueryCount();
+
+    void ResetCallCounts();
+
+    void SetRunning(bool running);
+
+    void SetIpd(float ipd);
+
+    void SetControllerConnected(uint32_t controller, bool connected);
+
+    void SetControllerInput(uint32_t controller, const PxrControllerInputState &state);
+
+    void SetRefreshRates(const float *rates, uint32_t count, float current);
+
+    float GetRefreshRate();
+
+    void SetViewSize(uint32_t width, uint32_t height);
+
+    void SetHeadMotion(Motion motion);
+
+    void SetControllerMotion(uint32_t controller, Motion motion);
+
+    void SetVibrationSink(VibrationSink sink);
+
+    // Queued until polled; false when the runtime queue is full.
+    bool PushEvent(const PxrEventDataBuffer &event);
+
+    uint32_t GetPendingEventCount();
+
+    // Last layer handed to Pxr_SubmitLayer().
+    PxrLayerProjection GetLastSubmittedLayer();
+
+    // Image of a layer created with Pxr_CreateLayer(), 0 when there is none.
+    uint64_t GetLayerImage(int layerId, uint32_t eye, uint32_t index);
+}
+
+#endif //CLIENT_HOST_STANDIN_PXR_H
@@ -0,0 +1,139 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Runs the audit build of the app until the allocation audit is armed and well past the first
+// thread and soak reports, and checks that no audited path allocated or locked (either would have
+// aborted the app). Then checks what the hooks see: operator new, malloc, allocations inside libc,
+// mutex and rwlock locks but not try-locks, and that a violation aborts.
+#include <mutex>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include "AllocationAudit.h"
+#include "AppHarness.h"
+#include "StandinCloudXR.h"
+#include "StandinPxr.h"
+
+namespace {
+    // stats windows are 1 s; the thread and soak reports come every 10 of them
+    const uint32_t kStreamAfterArmMs = 6000;
+
+    template<typename Predicate>
+    bool WaitUntil(Predicate predicate, uint32_t timeoutMs) {
+        const uint64_t deadlineNs = TestUtil::NowNs() + timeoutMs * 1000000ULL;
+        while (!predicate()) {
+            if (TestUtil::NowNs() > deadlineNs) {
+                return false;
+            }
+            usleep(10000);
+        }
+        return true;
+    }
+
+    // keeps the compiler from eliding allocations that are freed right away
+    void *volatile gSink;
+
+    // Allocates in each way the hooks should see; returns the violations it caused.
+    uint64_t AllocateInScope() {
+        const uint64_t before = AllocationAudit::GetViolationCount();
+        ALLOCATION_AUDIT_SCOPE("AllocationAuditTest");
+        gSink = new int(1);
+        delete (int *) gSink;
+        gSink = malloc(16);
+        free(gSink);
+        gSink = calloc(4, 4);
+        free(gSink);
+        gSink = realloc(nullptr, 16);
+        free(gSink);
+        // stdio buffers come from malloc inside libc
+        FILE *file = fopen("/proc/self/statm", "r");
+        if (file != nullptr) {
+            fclose(file);
+        }
+        return AllocationAudit::GetViolationCount() - before;
+    }
+
+    std::mutex gMutex;
+    pthread_rwlock_t gRwLock = PTHREAD_RWLOCK_INITIALIZER;
+
+    // Locks in each way the hooks should see, and try-locks they should not; returns the
+    // violations it caused.
+    uint64_t LockInScope() {
+        const uint64_t before = AllocationAudit::GetLockViolationCount();
+        ALLOCATION_AUDIT_SCOPE("AllocationAuditTest");
+        if (gMutex.try_lock()) {
+            gMutex.unlock();
+        }
+        {
+            std::lock_guard<std::mutex> lock(gMutex);
+        }
+        pthread_rwlock_rdlock(&gRwLock);
+        pthread_rwlock_unlock(&gRwLock);
+        pthread_rwlock_wrlock(&gRwLock);
+        pthread_rwlock_unlock(&gRwLock);
+        return AllocationAudit::GetLockViolationCount() - before;
+    }
+}
+
+int main() {
+    StandinPxr::Reset();
+    StandinPxr::SetViewSize(256, 256);
+    StandinCloudXR::SetProfile(StandinServerProfile());
+
+    const AppRunResult result = RunApp("allocation_audit", "-s 127.0.0.1", [](android_app *app) {
+        StandinAndroid::PostCommand(app, APP_CMD_RESUME);
+        const uint32_t warmupMs = AllocationAudit::kWarmupFrames * 1000 / 60 + 5000;
+        if (!CHECK(WaitUntil([]() { return AllocationAudit::IsArmed(); }, warmupMs))) {
+            return;
+        }
+        const uint64_t frames = StandinPxr::GetCallCount(StandinPxrCall_BeginFrame);
+        const uint64_t latched = StandinCloudXR::GetCounters(StandinCloudXR::GetLastReceiver()).framesLatched;
+        usleep(kStreamAfterArmMs * 1000);
+        // the audited paths kept running: frames, tracking, audio
+        CHECK(StandinPxr::GetCallCount(StandinPxrCall_BeginFrame) - frames > kStreamAfterArmMs * 60 / 1000);
+        const StandinReceiverCounters counters = StandinCloudXR::GetCounters(StandinCloudXR::GetLastReceiver());
+        CHECK(counters.framesLatched - latched > kStreamAfterArmMs * 60 / 1000);
+        CHECK(counters.audioFramesRendered > 0);
+        CHECK(AllocationAudit::GetViolationCount() == 0);
+        CHECK(AllocationAudit::GetLockViolationCount() == 0);
+    }, 60000);
+    // an allocation on an audited path aborts the app instead of exiting
+    CHECK(result.exited);
+    CHECK(result.exitStatus == 0);
+    TestUtil::Failures() += result.failures;
+
+    // not armed yet: nothing counts
+    CHECK(AllocateInScope() == 0);
+    CHECK(LockInScope() == 0);
+
+    // a violation aborts, naming the scope
+    for (auto violate : {AllocateInScope, LockInScope}) {
+        fflush(nullptr);
+        const pid_t pid = fork();
+        if (pid == 0) {
+            AllocationAudit::Arm();
+            violate();
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        CHECK(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+    }
+
+    // counting only: operator new, malloc, calloc, realloc and fopen inside the scope
+    AllocationAudit::SetFatal(false);
+    AllocationAudit::Arm();
+    CHECK(AllocateInScope() >= 5);
+    CHECK(LockInScope() == 3);
+    const uint64_t violations = AllocationAudit::GetViolationCount() + AllocationAudit::GetLockViolationCount();
+    // outside of any scope allocations are fine
+    gSink = new int(2);
+    delete (int *) gSink;
+    gSink = malloc(16);
+    free(gSink);
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+    }
+    CHECK(AllocationAudit::GetViolationCount() + AllocationAudit::GetLockViolationCount() == violations);
+    CHECK(AllocationAudit::Report() == violations);
+    return TestResult("AllocationAuditTest");
+}
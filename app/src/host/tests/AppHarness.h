@@ -0,0 +1,82 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_APP_HARNESS_H
+#define CLIENT_HOST_APP_HARNESS_H
+
+#include <signal.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include "StandinAndroid.h"
+#include "TestUtil.h"
+
+// Shared between the harness and the app process.
+struct AppRunShared {
+    int failures;
+    // when the script posted APP_CMD_DESTROY
+    uint64_t destroyPostedNs;
+};
+
+// Outcome of RunApp(), in the harness process.
+struct AppRunResult {
+    bool exited = false;
+    int exitStatus = -1;
+    int failures = 0;
+    uint64_t destroyPostedNs = 0;
+    uint64_t exitedNs = 0;
+};
+
+// Runs android_main() with the stand-ins in a child process, because android_main() ends the
+// process. The child works in a new temp directory holding the given launch options. script(app)
+// runs on a second thread of the child, drives the app through StandinAndroid::PostCommand and
+// checks what it sees; when it returns, APP_CMD_DESTROY is posted and the app shuts down. The
+// child is killed after timeoutMs.
+template<typename Script>
+AppRunResult RunApp(const char *name, const std::string &options, Script script, uint32_t timeoutMs) {
+    const std::string dir = TestUtil::MakeTempDir(name);
+    TestUtil::WriteFile(dir + "/CloudXRLaunchOptions.txt", options);
+    auto *shared = (AppRunShared *) mmap(nullptr, sizeof(AppRunShared), PROT_READ | PROT_WRITE,
+                                         MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    *shared = AppRunShared{};
+    fflush(nullptr);
+    const pid_t pid = fork();
+    if (pid == 0) {
+        if (chdir(dir.c_str()) != 0) {
+            _exit(3);
+        }
+        static std::string dataDir;
+        dataDir = dir;
+        static android_app app = StandinAndroid::MakeApp(dataDir.c_str());
+        std::thread([script, shared]() mutable {
+            script(&app);
+            shared->failures = TestUtil::Failures();
+            shared->destroyPostedNs = TestUtil::NowNs();
+            StandinAndroid::PostCommand(&app, APP_CMD_DESTROY);
+        }).detach();
+        android_main(&app);
+        _exit(0);
+    }
+
+    AppRunResult result;
+    const uint64_t deadlineNs = TestUtil::NowNs() + timeoutMs * 1000000ULL;
+    int status = 0;
+    while (waitpid(pid, &status, WNOHANG) == 0) {
+        if (TestUtil::NowNs() > deadlineNs) {
+            fprintf(stderr, "%s: app did not exit within %ums\n", name, timeoutMs);
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            break;
+        }
+        usleep(1000);
+    }
+    result.exitedNs = TestUtil::NowNs();
+    result.exited = WIFEXITED(status);
+    result.exitStatus = result.exited ? WEXITSTATUS(status) : -1;
+    result.failures = shared->failures;
+    result.destroyPostedNs = shared->destroyPostedNs;
+    munmap(shared, sizeof(AppRunShared));
+    return result;
+}
+
+#endif //CLIENT_HOST_APP_HARNESS_H
@@ -0,0 +1,78 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// String arguments of the async log, which are copied when the call is queued: strings that
+// fit come out whole, longer ones end in "…" so a cut path or server address is not mistaken
+// for the full one, and a multi-byte character is never split by the cut. A null string is
+// logged as "(null)".
+#include <string>
+#include "AsyncLog.h"
+#include "TestUtil.h"
+
+namespace {
+    const size_t kFits = AsyncLogDetail::kMaxStringArg - 1;
+    const std::string kEllipsis = AsyncLogDetail::kEllipsis;
+
+    std::string ReadFile(const std::string &path) {
+        std::string contents;
+        FILE *file = fopen(path.c_str(), "r");
+        if (file == nullptr) {
+            return contents;
+        }
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            contents.append(buffer, read);
+        }
+        fclose(file);
+        return contents;
+    }
+
+    // Logs the string between markers and returns what the flusher wrote between them.
+    std::string Logged(const std::string &path, const std::string &value) {
+        AsyncLog::Write(AsyncLogPriority_Info, "AsyncLogTest", "<%s>", value.c_str());
+        AsyncLog::Flush();
+        const std::string log = ReadFile(path);
+        const size_t end = log.rfind(">\n");
+        const size_t begin = log.rfind('<', end);
+        if (end == std::string::npos || begin == std::string::npos) {
+            return "";
+        }
+        return log.substr(begin + 1, end - begin - 1);
+    }
+}
+
+int main() {
+    const std::string path = TestUtil::MakeTempDir("async_log") + "/log.txt";
+    AsyncLog::SetFile(path.c_str());
+
+    CHECK(Logged(path, "playback") == "playback");
+    CHECK(Logged(path, "") == "");
+    AsyncLog::Write(AsyncLogPriority_Info, "AsyncLogTest", "<%s>", (const char *) nullptr);
+    AsyncLog::Flush();
+    CHECK(ReadFile(path).find("<(null)>") != std::string::npos);
+    const std::string fits(kFits, 'a');
+    CHECK(Logged(path, fits) == fits);
+
+    // one byte too long: cut, and marked as cut
+    const std::string over = fits + "b";
+    const std::string cut = Logged(path, over);
+    CHECK(cut.size() <= kFits);
+    CHECK(cut.size() > kEllipsis.size() && cut.compare(cut.size() - kEllipsis.size(), kEllipsis.size(), kEllipsis) == 0);
+    CHECK(over.compare(0, cut.size() - kEllipsis.size(), cut, 0, cut.size() - kEllipsis.size()) == 0);
+    CHECK(Logged(path, std::string(1000, 'c')) == std::string(kFits - kEllipsis.size(), 'c') + kEllipsis);
+
+    // "é" is two bytes; at every offset the cut keeps whole characters only
+    for (size_t offset = 0; offset < 2; offset++) {
+        std::string accents(offset, 'x');
+        while (accents.size() < AsyncLogDetail::kMaxStringArg) {
+            accents += "\xC3\xA9";
+        }
+        const std::string logged = Logged(path, accents);
+        const std::string kept = logged.substr(0, logged.size() - kEllipsis.size());
+        CHECK(logged.size() <= kFits);
+        CHECK(accents.compare(0, kept.size(), kept) == 0);
+        CHECK((kept.size() - offset) % 2 == 0);
+    }
+
+    AsyncLog::Shutdown();
+    return TestResult("AsyncLogTest");
+}
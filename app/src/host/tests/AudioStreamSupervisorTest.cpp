@@ -0,0 +1,232 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// AudioStreamSupervisor against the stand-in Oboe device: disconnects with the device still
+// there, gone for a while and gone past the fast retries, writes racing the reopen, xruns kept
+// across streams, closing while retrying, and a streaming client whose session survives the
+// audio device going away.
+#include <atomic>
+#include <thread>
+#include "AudioStreamSupervisor.h"
+#include "ClientFixture.h"
+#include "StandinCloudXR.h"
+#include "StandinOboe.h"
+#include "StandinPxr.h"
+
+namespace {
+    const uint32_t kReopenTimeoutMs = 1000;
+    const int32_t kFrames = 480;
+
+    oboe::AudioStreamBuilder OutputBuilder() {
+        oboe::AudioStreamBuilder builder;
+        builder.setDirection(oboe::Direction::Output);
+        builder.setFormat(oboe::AudioFormat::I16);
+        builder.setChannelCount(2);
+        builder.setSampleRate(48000);
+        return builder;
+    }
+
+    bool WaitForReroutes(const AudioStreamSupervisor &stream, uint32_t count, uint32_t timeoutMs) {
+        return ClientFixture::WaitUntil([&]() { return stream.GetRerouteCount() >= count; }, timeoutMs);
+    }
+}
+
+int main() {
+    int16_t buffer[kFrames * 2] = {};
+
+    // the device is still there: reopened and restarted right away
+    {
+        StandinOboe::Reset();
+        AudioStreamSupervisor stream("playback");
+        CHECK(stream.Open(OutputBuilder(), 2) == oboe::Result::OK);
+        CHECK(stream.Start() == oboe::Result::OK);
+        CHECK(stream.IsOpen());
+        CHECK(stream.Write(buffer, kFrames, 0));
+        CHECK(StandinOboe::GetFramesWritten() == kFrames);
+
+        StandinOboe::Disconnect();
+        CHECK(WaitForReroutes(stream, 1, kReopenTimeoutMs));
+        CHECK(StandinOboe::GetOpenStreamCount() == 1);
+        CHECK(StandinOboe::GetOpenedTotal() == 2);
+        CHECK(stream.GetFailedReopenCount() == 0);
+        CHECK(stream.GetLastRecoveryMs() < 100);
+        // the new stream was started like the old one, with the same buffer size
+        CHECK(stream.Write(buffer, kFrames, 0));
+        CHECK(StandinOboe::GetFramesWritten() == 2 * kFrames);
+        stream.Close();
+        CHECK(!stream.IsOpen());
+        CHECK(StandinOboe::GetOpenStreamCount() == 0);
+    }
+
+    // the device is gone for a while: writes drop without blocking, reopening retries
+    {
+        StandinOboe::Reset();
+        AudioStreamSupervisor stream("playback");
+        CHECK(stream.Open(OutputBuilder(), 2) == oboe::Result::OK);
+        CHECK(stream.Start() == oboe::Result::OK);
+        StandinOboe::SetDeviceAvailable(false);
+        StandinOboe::Disconnect();
+        CHECK(!stream.Write(buffer, kFrames, 0));
+        CHECK(stream.GetDroppedFrames() == uint64_t(kFrames));
+        CHECK(ClientFixture::WaitUntil([&]() { return stream.GetFailedReopenCount() >= 2; },
+                                       AudioStreamSupervisor::kRetryIntervalMs * 3));
+        CHECK(stream.GetRerouteCount() == 0);
+
+        StandinOboe::SetDeviceAvailable(true);
+        CHECK(WaitForReroutes(stream, 1, AudioStreamSupervisor::kRetryIntervalMs * 2));
+        CHECK(stream.GetLastRecoveryMs() >= AudioStreamSupervisor::kRetryIntervalMs);
+        CHECK(stream.GetMaxRecoveryMs() == stream.GetLastRecoveryMs());
+        CHECK(stream.Write(buffer, kFrames, 0));
+    }
+
+    // the device is gone past the fast retries: retried at the slow interval until it is back
+    {
+        StandinOboe::Reset();
+        const uint32_t fastRetries = 2;
+        AudioStreamSupervisor stream("playback", fastRetries);
+        CHECK(stream.Open(OutputBuilder(), 2) == oboe::Result::OK);
+        CHECK(stream.Start() == oboe::Result::OK);
+        StandinOboe::SetDeviceAvailable(false);
+        StandinOboe::Disconnect();
+        CHECK(ClientFixture::WaitUntil([&]() { return stream.GetFailedReopenCount() >= fastRetries; },
+                                       AudioStreamSupervisor::kRetryIntervalMs * 3));
+        // the first slow retry, and still trying after it, a slow interval later
+        CHECK(ClientFixture::WaitUntil([&]() { return stream.GetFailedReopenCount() >= fastRetries + 1; },
+                                       AudioStreamSupervisor::kSlowRetryIntervalMs * 3 / 2));
+        const uint64_t retryNs = TestUtil::NowNs();
+        CHECK(ClientFixture::WaitUntil([&]() { return stream.GetFailedReopenCount() >= fastRetries + 2; },
+                                       AudioStreamSupervisor::kSlowRetryIntervalMs * 3 / 2));
+        CHECK(TestUtil::NowNs() - retryNs > AudioStreamSupervisor::kSlowRetryIntervalMs * 1000000ULL * 9 / 10);
+        CHECK(stream.GetRerouteCount() == 0);
+
+        StandinOboe::SetDeviceAvailable(true);
+        CHECK(WaitForReroutes(stream, 1, AudioStreamSupervisor::kSlowRetryIntervalMs * 3 / 2));
+        CHECK(stream.GetLastRecoveryMs() >= AudioStreamSupervisor::kSlowRetryIntervalMs);
+        CHECK(stream.Write(buffer, kFrames, 0));
+    }
+
+    // a recording stream that was never started is reopened, but not started
+    {
+        StandinOboe::Reset();
+        oboe::AudioStreamBuilder builder = OutputBuilder();
+        builder.setDirection(oboe::Direction::Input);
+        AudioStreamSupervisor stream("recording");
+        CHECK(stream.Open(builder, 0) == oboe::Result::OK);
+        StandinOboe::Disconnect();
+        CHECK(WaitForReroutes(stream, 1, kReopenTimeoutMs));
+        CHECK(stream.IsOpen());
+        stream.Write(buffer, kFrames, 0);
+        CHECK(StandinOboe::GetFramesWritten() == 0);
+    }
+
+    // xruns of closed streams still count
+    {
+        StandinOboe::Reset();
+        AudioStreamSupervisor stream("playback");
+        CHECK(stream.Open(OutputBuilder(), 2) == oboe::Result::OK);
+        CHECK(stream.Start() == oboe::Result::OK);
+        StandinOboe::AddXRuns(3);
+        CHECK(stream.SampleXRunCount() == 3);
+        StandinOboe::Disconnect();
+        CHECK(WaitForReroutes(stream, 1, kReopenTimeoutMs));
+        StandinOboe::AddXRuns(2);
+        CHECK(stream.SampleXRunCount() == 5);
+    }
+
+    // a writer on the audio callback thread through repeated disconnects: never blocks on the
+    // recovery, and writes again once the stream is back
+    {
+        StandinOboe::Reset();
+        AudioStreamSupervisor stream("playback");
+        CHECK(stream.Open(OutputBuilder(), 2) == oboe::Result::OK);
+        CHECK(stream.Start() == oboe::Result::OK);
+        std::atomic<bool> writing{true};
+        std::atomic<uint64_t> writes{0};
+        std::atomic<uint64_t> longestWriteNs{0};
+        std::thread writer([&]() {
+            int16_t samples[kFrames * 2] = {};
+            while (writing.load()) {
+                const uint64_t startNs = TestUtil::NowNs();
+                stream.Write(samples, kFrames, 0);
+                const uint64_t writeNs = TestUtil::NowNs() - startNs;
+                if (writeNs > longestWriteNs.load()) {
+                    longestWriteNs.store(writeNs);
+                }
+                writes++;
+                std::this_thread::yield();
+            }
+        });
+        CHECK(ClientFixture::WaitUntil([&]() { return writes.load() > 0; }, kReopenTimeoutMs));
+        const uint32_t kDisconnects = 20;
+        for (uint32_t i = 1; i <= kDisconnects; i++) {
+            StandinOboe::Disconnect();
+            CHECK(WaitForReroutes(stream, i, kReopenTimeoutMs));
+        }
+        const int64_t written = StandinOboe::GetFramesWritten();
+        CHECK(ClientFixture::WaitUntil([&]() { return StandinOboe::GetFramesWritten() > written; }, kReopenTimeoutMs));
+        writing = false;
+        writer.join();
+        CHECK(StandinOboe::GetOpenStreamCount() == 1);
+        CHECK(StandinOboe::GetOpenedTotal() == kDisconnects + 1);
+        // a write takes the stream's lock at most, never the supervisor's
+        CHECK(longestWriteNs < 50000000ULL);
+        printf("{\"benchmark\":\"AudioReroute\",\"disconnects\":%u,\"maxRecoveryMs\":%.2f,\"longestWriteUs\":%.1f}\n",
+               kDisconnects, stream.GetMaxRecoveryMs(), longestWriteNs / 1e3);
+    }
+
+    // closing while the worker waits for the device returns without waiting out the retries
+    {
+        StandinOboe::Reset();
+        AudioStreamSupervisor stream("playback");
+        CHECK(stream.Open(OutputBuilder(), 2) == oboe::Result::OK);
+        CHECK(stream.Start() == oboe::Result::OK);
+        StandinOboe::SetDeviceAvailable(false);
+        StandinOboe::Disconnect();
+        CHECK(ClientFixture::WaitUntil([&]() { return stream.GetFailedReopenCount() >= 1; }, kReopenTimeoutMs));
+        const uint64_t startNs = TestUtil::NowNs();
+        stream.Close();
+        CHECK(TestUtil::NowNs() - startNs < AudioStreamSupervisor::kRetryIntervalMs * 1000000ULL / 2);
+        StandinOboe::SetDeviceAvailable(true);
+        usleep(AudioStreamSupervisor::kRetryIntervalMs * 2 * 1000);
+        CHECK(StandinOboe::GetOpenStreamCount() == 0);
+        CHECK(stream.GetRerouteCount() == 0);
+    }
+
+    // a closed stream ignores late errors
+    {
+        StandinOboe::Reset();
+        AudioStreamSupervisor stream("playback");
+        CHECK(stream.Open(OutputBuilder(), 2) == oboe::Result::OK);
+        stream.Close();
+        StandinOboe::Disconnect();
+        usleep(50 * 1000);
+        CHECK(stream.GetRerouteCount() == 0);
+        CHECK(StandinOboe::GetOpenStreamCount() == 0);
+    }
+
+    // a streaming client: the session goes on while both streams come back
+    {
+        StandinOboe::Reset();
+        StandinPxr::Reset();
+        StandinCloudXR::SetProfile(StandinServerProfile());
+        ClientFixture fixture("audio_reroute");
+        if (CHECK(fixture.Connect())) {
+            const cxrReceiverHandle receiver = StandinCloudXR::GetLastReceiver();
+            CHECK(ClientFixture::WaitUntil([]() { return StandinOboe::GetFramesWritten() > 0; }, kReopenTimeoutMs));
+            const uint32_t openStreams = StandinOboe::GetOpenStreamCount();
+            const uint32_t opened = StandinOboe::GetOpenedTotal();
+            // playback, and recording when the device sends audio
+            CHECK(openStreams >= 1);
+
+            StandinOboe::Disconnect();
+            CHECK(ClientFixture::WaitUntil([&]() { return StandinOboe::GetOpenStreamCount() == openStreams; },
+                                           kReopenTimeoutMs));
+            CHECK(StandinOboe::GetOpenedTotal() == opened + openStreams);
+            const int64_t written = StandinOboe::GetFramesWritten();
+            CHECK(ClientFixture::WaitUntil([&]() { return StandinOboe::GetFramesWritten() > written; },
+                                           kReopenTimeoutMs));
+            CHECK(fixture.client->IsStreaming());
+            CHECK(StandinCloudXR::GetLastReceiver() == receiver);
+            CHECK(StandinCloudXR::GetCounters(receiver).connects == 1);
+        }
+    }
+    return TestResult("AudioStreamSupervisorTest");
+}
@@ -0,0 +1,85 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_CLIENT_FIXTURE_H
+#define CLIENT_HOST_CLIENT_FIXTURE_H
+
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include "CloudXRClientPXR.h"
+#include "PxrApi.h"
+#include "TestUtil.h"
+
+// A client with its own launch options file and data directory in a new temp directory,
+// pointed at the stand-in server.
+struct ClientFixture {
+    std::string dir;
+    std::unique_ptr<CloudXRClientPXR> client;
+
+    explicit ClientFixture(const char *name, const std::string &options = "")
+            : ClientFixture(TestUtil::MakeTempDir(name), "CloudXRLaunchOptions.txt", options) {}
+
+    // A client reading optionsFile in dataDir, for several clients sharing one data directory.
+    ClientFixture(const std::string &dataDir, const std::string &optionsFile, const std::string &options)
+            : dir(dataDir) {
+        TestUtil::WriteFile(dir + "/" + optionsFile, "-s 127.0.0.1 " + options);
+        client.reset(new CloudXRClientPXR((dir + "/" + optionsFile).c_str()));
+        client->SetDataDir(dir);
+        client->GetDeviceState().Refresh();
+    }
+
+    // Resumes the client and waits for the stand-in server to start streaming.
+    bool Connect(uint32_t timeoutMs = 2000) {
+        client->SetPaused(false);
+        client->HandleStateChanges();
+        return WaitUntil([this]() { return client->IsStreaming(); }, timeoutMs);
+    }
+
+    // One iteration of android_main's loop without graphics: the state updates, then
+    // render_frame's poses, stats, latch and release. Pxr_BeginFrame() is left out, the caller
+    // paces the frames; while streaming, the latch waits for the server's next frame. Returns
+    // whether a frame was latched.
+    bool RenderFrame() {
+        client->UpdateClientState();
+        client->HandleStateChanges();
+        pxrPose pose = {};
+        int sensorFrameIndex = 0;
+        Pxr_GetPredictedDisplayTime(&pose.predictedDisplayTimeMs);
+        Pxr_GetPredictedMainSensorState(pose.predictedDisplayTimeMs, &pose.headPose, &sensorFrameIndex);
+        for (int i = 0; i < PXR_CONTROLLER_COUNT && client->IsStreaming(); i++) {
+            if (client->GetDeviceState().IsControllerConnected(i)) {
+                PxrControllerTracking tracking;
+                float headSensor[7] = {pose.headPose.pose.orientation.x, pose.headPose.pose.orientation.y,
+                                       pose.headPose.pose.orientation.z, pose.headPose.pose.orientation.w,
+                                       pose.headPose.pose.position.x, pose.headPose.pose.position.y,
+                                       pose.headPose.pose.position.z};
+                Pxr_GetControllerTrackingState(i, pose.predictedDisplayTimeMs, headSensor, &tracking);
+                (i == PXR_CONTROLLER_LEFT ? pose.leftControllerPose : pose.rightControllerPose) =
+                        tracking.localControllerPose;
+            }
+        }
+        client->SetPoseData(pose);
+        client->GetConnectionStats(uint64_t(pose.predictedDisplayTimeMs));
+
+        cxrFramesLatched framesLatched;
+        const bool frameValid = client->LatchFrame(&framesLatched);
+        if (frameValid) {
+            client->TrackLatency(framesLatched, pose.predictedDisplayTimeMs);
+            client->ReleaseFrame(&framesLatched);
+        }
+        return frameValid;
+    }
+
+    template<typename Predicate>
+    static bool WaitUntil(Predicate predicate, uint32_t timeoutMs) {
+        const uint64_t deadlineNs = TestUtil::NowNs() + timeoutMs * 1000000ULL;
+        while (!predicate()) {
+            if (TestUtil::NowNs() > deadlineNs) {
+                return false;
+            }
+            usleep(1000);
+        }
+        return true;
+    }
+};
+
+#endif //CLIENT_HOST_CLIENT_FIXTURE_H
@@ -0,0 +1,140 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// The OpenGL ES plugin on a surfaceless EGL context: render targets, the blit/submit path of
+// render_frame with stand-in CloudXR and Pxr layers, frame timing and shutdown.
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+#include "graphicsplugin.h"
+#include "ClientFixture.h"
+#include "StandinCloudXR.h"
+#include "StandinPxr.h"
+
+namespace {
+    const int kLayerId = 0;
+    const uint32_t kEyeSize = 64;
+
+    void ReadPixel(GLuint texture, uint8_t pixel[4]) {
+        GLuint framebuffer = 0;
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        glReadPixels(kEyeSize / 2, kEyeSize / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &framebuffer);
+    }
+}
+
+int main() {
+    StandinPxr::Reset();
+    StandinPxr::SetViewSize(kEyeSize, kEyeSize);
+    StandinServerProfile profile;
+    profile.fps = 500;
+    profile.latencyMs = 0;
+    profile.audioFrameMs = 0;
+    StandinCloudXR::SetProfile(profile);
+
+    GraphicsOptions options;
+    options.surfaceless = true;
+    std::shared_ptr<IGraphicsPlugin> graphics = CreateGraphicsPlugin(GraphicsApi_OpenGLES, options);
+    CHECK(graphics->GetApi() == GraphicsApi_OpenGLES);
+    cxrGraphicsContext context{};
+    CHECK(!graphics->GetCloudXRContext(&context));
+    graphics->InitializeDevice();
+    if (!CHECK(graphics->GetCloudXRContext(&context))) {
+        return TestResult("GraphicsPluginTest");
+    }
+    CHECK(context.type == cxrGraphicsContext_GLES);
+    CHECK(context.egl.context == eglGetCurrentContext());
+    CHECK(eglGetCurrentSurface(EGL_DRAW) == EGL_NO_SURFACE);
+
+    PxrLayerParam layerParam = {};
+    layerParam.layerId = kLayerId;
+    layerParam.layerShape = PXR_LAYER_PROJECTION;
+    layerParam.layerLayout = PXR_LAYER_LAYOUT_STEREO;
+    layerParam.width = kEyeSize;
+    layerParam.height = kEyeSize;
+    layerParam.faceCount = 1;
+    layerParam.mipmapCount = 1;
+    layerParam.sampleCount = 1;
+    layerParam.arraySize = 1;
+    layerParam.format = GL_RGBA8;
+    CHECK(Pxr_CreateLayer(&layerParam) == 0);
+    CHECK(graphics->CreateRenderTargets(kLayerId, PXR_EYE_MAX));
+    CHECK(graphics->BindRenderTarget(PXR_EYE_RIGHT, StandinPxr::kLayerImageCount - 1));
+    CHECK(!graphics->BindRenderTarget(PXR_EYE_RIGHT, StandinPxr::kLayerImageCount));
+    CHECK(!graphics->BindRenderTarget(PXR_EYE_MAX, 0));
+
+    ClientFixture fixture("graphics_plugin");
+    CloudXRClientPXR &client = *fixture.client;
+    client.SetGraphicsContext(context);
+    if (!CHECK(fixture.Connect())) {
+        return TestResult("GraphicsPluginTest");
+    }
+
+    // render_frame's pose, blit and submit, without the controllers
+    const uint32_t frames = 10;
+    uint32_t valid = 0;
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        Pxr_BeginFrame();
+        pxrPose pose = {};
+        int sensorFrameIndex = 0;
+        Pxr_GetPredictedDisplayTime(&pose.predictedDisplayTimeMs);
+        Pxr_GetPredictedMainSensorState(pose.predictedDisplayTimeMs, &pose.headPose, &sensorFrameIndex);
+        client.SetPoseData(pose);
+        cxrFramesLatched framesLatched;
+        const bool frameValid = client.LatchFrame(&framesLatched);
+        valid += frameValid ? 1 : 0;
+        int imageIndex = 0;
+        Pxr_GetLayerNextImageIndex(kLayerId, &imageIndex);
+        graphics->BeginFrameTiming();
+        for (int eye = 0; eye < PXR_EYE_MAX; eye++) {
+            if (graphics->BindRenderTarget(eye, imageIndex)) {
+                glViewport(0, 0, framesLatched.frames[eye].widthFinal, framesLatched.frames[eye].heightFinal);
+                client.BlitFrame(&framesLatched, frameValid, eye);
+            }
+        }
+        graphics->EndFrameTiming();
+
+        PxrLayerProjection layerProjection = {};
+        layerProjection.header.layerId = kLayerId;
+        layerProjection.header.layerFlags |= PXR_LAYER_FLAG_USE_EXTERNAL_HEAD_POSE;
+        layerProjection.header.headPose.orientation = client.cxrToQuaternion(framesLatched.poseMatrix);
+        layerProjection.header.headPose.position = client.cxrGetTranslation(framesLatched.poseMatrix);
+        if (frameValid) {
+            client.ReleaseFrame(&framesLatched);
+        }
+        Pxr_SubmitLayer((PxrLayerHeader *) &layerProjection);
+        Pxr_EndFrame();
+    }
+    glFinish();
+    CHECK(valid == frames);
+    CHECK(glGetError() == GL_NO_ERROR);
+    CHECK(graphics->GetFrameTiming().cpuTimeNs > 0);
+    CHECK(StandinPxr::GetCallCount(StandinPxrCall_SubmitLayer) == frames);
+    CHECK(StandinPxr::GetLastSubmittedLayer().header.layerId == kLayerId);
+    // still pose at head height, rendered by the server with the client's tracking
+    CHECK(StandinPxr::GetLastSubmittedLayer().header.headPose.position.y > 1.0f);
+
+    const StandinReceiverCounters counters = StandinCloudXR::GetCounters(StandinCloudXR::GetLastReceiver());
+    CHECK(counters.framesBlitted == frames * PXR_EYE_MAX);
+    CHECK(counters.framesReleased == frames);
+
+    // the stand-in frame is a solid color; every eye image written this frame shows it
+    int lastImage = 0;
+    Pxr_GetLayerNextImageIndex(kLayerId, &lastImage);
+    lastImage = (lastImage + StandinPxr::kLayerImageCount - 1) % StandinPxr::kLayerImageCount;
+    for (uint32_t eye = 0; eye < PXR_EYE_MAX; eye++) {
+        uint8_t pixel[4] = {};
+        ReadPixel((GLuint) StandinPxr::GetLayerImage(kLayerId, eye, lastImage), pixel);
+        CHECK(pixel[0] == 32 && pixel[1] == 96 && pixel[2] == 160);
+    }
+
+    client.Stop();
+    graphics->ReleaseRenderTargets();
+    CHECK(!graphics->BindRenderTarget(PXR_EYE_LEFT, 0));
+    Pxr_DestroyLayer(kLayerId);
+    graphics->Shutdown();
+    CHECK(eglGetCurrentContext() == EGL_NO_CONTEXT);
+    CHECK(!graphics->GetCloudXRContext(&context));
+    graphics->Shutdown();
+    return TestResult("GraphicsPluginTest");
+}
@@ -0,0 +1,176 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Drives HapticsScheduler with a recording vibration sink: submit-to-sink latency, bursts,
+// a short strong pulse on a long weak rumble, ramps and stop requests.
+#include <atomic>
+#include <math.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "HapticsScheduler.h"
+#include "TestUtil.h"
+
+namespace {
+    // scheduling slack allowed on top of the expected sink call times
+    const uint64_t kSlackNs = 15000000ULL;
+
+    struct SinkCall {
+        uint64_t timeNs;
+        uint32_t controller;
+        float amplitude;
+        uint32_t durationMs;
+    };
+
+    class RecordingSink {
+    public:
+        HapticsScheduler::VibrationSink Get() {
+            return [this](uint32_t controller, float amplitude, float, uint32_t durationMs) {
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    mCalls.push_back({TestUtil::NowNs(), controller, amplitude, durationMs});
+                }
+                const uint32_t delayMs = mCallDelayMs.load();
+                if (delayMs > 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+                }
+            };
+        }
+
+        // each call takes this long, like a runtime that is slow to take vibration requests
+        void SetCallDelayMs(uint32_t delayMs) {
+            mCallDelayMs.store(delayMs);
+        }
+
+        std::vector<SinkCall> Take() {
+            std::lock_guard<std::mutex> lock(mMutex);
+            std::vector<SinkCall> calls;
+            calls.swap(mCalls);
+            return calls;
+        }
+
+    private:
+        std::atomic<uint32_t> mCallDelayMs{0};
+        std::mutex mMutex;
+        std::vector<SinkCall> mCalls;
+    };
+
+    HapticPulse MakePulse(float startAmplitude, float endAmplitude, uint32_t durationMs) {
+        HapticPulse pulse;
+        pulse.startAmplitude = startAmplitude;
+        pulse.endAmplitude = endAmplitude;
+        pulse.durationMs = durationMs;
+        return pulse;
+    }
+
+    void SleepMs(uint32_t ms) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+
+    bool Near(float a, float b) {
+        return fabsf(a - b) < 0.001f;
+    }
+}
+
+int main() {
+    RecordingSink sink;
+    HapticsScheduler scheduler(sink.Get());
+    scheduler.Start();
+
+    // a single pulse reaches the sink right away, as one call
+    uint64_t submitNs = TestUtil::NowNs();
+    CHECK(scheduler.Submit(MakePulse(0.5f, 0.5f, 40)));
+    SleepMs(80);
+    std::vector<SinkCall> calls = sink.Take();
+    if (CHECK(calls.size() == 1)) {
+        CHECK(calls[0].timeNs - submitNs < kSlackNs);
+        CHECK(Near(calls[0].amplitude, 0.5f));
+        CHECK(calls[0].durationMs == 40);
+    }
+
+    // a short strong pulse on a long weak rumble plays for its own duration, then the rumble
+    // comes back until its own end
+    submitNs = TestUtil::NowNs();
+    CHECK(scheduler.Submit(MakePulse(0.2f, 0.2f, 300)));
+    SleepMs(50);
+    CHECK(scheduler.Submit(MakePulse(1.0f, 1.0f, 50)));
+    SleepMs(300);
+    calls = sink.Take();
+    if (CHECK(calls.size() == 3)) {
+        CHECK(Near(calls[0].amplitude, 0.2f));
+        CHECK(Near(calls[1].amplitude, 1.0f));
+        CHECK(calls[1].durationMs == 50);
+        CHECK(Near(calls[2].amplitude, 0.2f));
+        // back to the rumble when the strong pulse ends, and only for what is left of it
+        CHECK(calls[2].timeNs - calls[1].timeNs >= 50000000ULL);
+        CHECK(calls[2].timeNs - calls[1].timeNs < 50000000ULL + kSlackNs);
+        const uint64_t rumbleEndNs = calls[2].timeNs + calls[2].durationMs * 1000000ULL;
+        CHECK(rumbleEndNs >= submitNs + 300000000ULL - kSlackNs);
+        CHECK(rumbleEndNs < submitNs + 300000000ULL + kSlackNs);
+    }
+
+    // pulses that queue up while the sink is busy coalesce into fewer sink calls than pulses
+    const uint64_t coalescedBefore = scheduler.GetCoalescedCount();
+    const uint32_t kBurst = 20;
+    sink.SetCallDelayMs(10);
+    for (uint32_t i = 0; i < kBurst; i++) {
+        CHECK(scheduler.Submit(MakePulse(0.6f, 0.6f, 20)));
+        SleepMs(1);
+    }
+    SleepMs(60);
+    sink.SetCallDelayMs(0);
+    calls = sink.Take();
+    CHECK(!calls.empty());
+    CHECK(calls.size() < kBurst);
+    CHECK(scheduler.GetCoalescedCount() > coalescedBefore);
+    for (const SinkCall &call : calls) {
+        CHECK(Near(call.amplitude, 0.6f));
+    }
+
+    // a ramp is played in envelope steps of rising amplitude
+    CHECK(scheduler.Submit(MakePulse(0.0f, 1.0f, 100)));
+    SleepMs(150);
+    calls = sink.Take();
+    CHECK(calls.size() >= 100 / HapticsScheduler::kEnvelopeStepMs - 2);
+    for (size_t i = 1; i < calls.size(); i++) {
+        CHECK(calls[i].amplitude > calls[i - 1].amplitude);
+        CHECK(calls[i].durationMs <= HapticsScheduler::kEnvelopeStepMs);
+    }
+
+    // a stop request silences the controller right away, and the covered rumble stays stopped
+    HapticPulse rumble = MakePulse(0.3f, 0.3f, 500);
+    rumble.controller = 1;
+    CHECK(scheduler.Submit(rumble));
+    rumble = MakePulse(0.9f, 0.9f, 100);
+    rumble.controller = 1;
+    CHECK(scheduler.Submit(rumble));
+    SleepMs(20);
+    HapticPulse stop;
+    stop.controller = 1;
+    submitNs = TestUtil::NowNs();
+    CHECK(scheduler.Submit(stop));
+    SleepMs(200);
+    calls = sink.Take();
+    if (CHECK(!calls.empty())) {
+        const SinkCall &last = calls.back();
+        CHECK(last.controller == 1);
+        CHECK(last.durationMs == 0);
+        CHECK(last.timeNs - submitNs < kSlackNs);
+    }
+
+    // bad controllers are rejected without reaching the sink
+    HapticPulse bad = MakePulse(1.0f, 1.0f, 10);
+    bad.controller = HapticsScheduler::kMaxControllers;
+    CHECK(!scheduler.Submit(bad));
+    CHECK(scheduler.GetRejectedCount() == 1);
+    CHECK(scheduler.GetStaleCount() == 0);
+
+    // stopping silences whatever still plays
+    CHECK(scheduler.Submit(MakePulse(0.4f, 0.4f, 1000)));
+    SleepMs(20);
+    scheduler.Stop();
+    calls = sink.Take();
+    if (CHECK(calls.size() == 2)) {
+        CHECK(calls[1].durationMs == 0);
+    }
+    CHECK(!scheduler.Submit(MakePulse(0.4f, 0.4f, 10)));
+    return TestResult("HapticsSchedulerTest");
+}
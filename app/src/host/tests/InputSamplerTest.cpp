@@ -0,0 +1,253 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// InputSampler with synthetic sub-millisecond taps: taps a sample lands on reach the next fold
+// as down and the one after as up, overlapping buttons fold together, several taps between two
+// folds and a release and re-press of a held button each show as their own down and up, a burst
+// that overflows the queue keeps its presses, and taps between two samples are missed in
+// proportion to how much of the sample interval they leave uncovered. Then the sampler thread
+// against a tapping thread and a folding thread.
+#include <atomic>
+#include <math.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <CloudXRCommon.h>
+#include "InputSampler.h"
+#include "TestUtil.h"
+
+namespace {
+    const uint64_t kUs = 1000ULL;
+    const uint64_t kMs = 1000000ULL;
+    const uint64_t kIntervalNs = InputSampler::kSampleIntervalUs * kUs;
+    // tracking callbacks at 90 Hz
+    const uint64_t kFoldIntervalNs = 11 * kMs;
+    const uint64_t kTrigger = 1ULL << cxrButton_Trigger_Click;
+    const uint64_t kA = 1ULL << cxrButton_A;
+    const uint64_t kX = 1ULL << cxrButton_X;
+
+    struct Tap {
+        uint32_t controller;
+        uint64_t buttons;
+        uint64_t startNs;
+        uint64_t endNs;
+    };
+
+    // Buttons held at the current simulated time, from a list of taps.
+    struct Timeline {
+        std::vector<Tap> taps;
+        uint64_t nowNs = 0;
+
+        InputSampler::Source GetSource() {
+            return [this](uint32_t controller, uint64_t *buttons) {
+                *buttons = 0;
+                for (const Tap &tap : taps) {
+                    if (tap.controller == controller && tap.startNs <= nowNs && nowNs < tap.endNs) {
+                        *buttons |= tap.buttons;
+                    }
+                }
+                return true;
+            };
+        }
+
+        // Samples every kIntervalNs up to endNs, like the sampler thread.
+        void SampleUntil(InputSampler &sampler, uint64_t endNs) {
+            for (nowNs = (nowNs / kIntervalNs + 1) * kIntervalNs; nowNs <= endNs; nowNs += kIntervalNs) {
+                sampler.Sample(nowNs);
+            }
+            nowNs = endNs;
+        }
+    };
+
+    uint32_t Random(uint32_t &seed) {
+        seed = seed * 1103515245 + 12345;
+        return seed >> 16;
+    }
+}
+
+int main() {
+    // a tap of any length a sample lands on is down for one fold, up with the next
+    for (uint64_t durationUs : {100, 250, 500, 900}) {
+        Timeline timeline;
+        const uint64_t startNs = 5 * kMs - durationUs * kUs / 2;
+        timeline.taps.push_back({PXR_CONTROLLER_RIGHT, kTrigger, startNs, startNs + durationUs * kUs});
+        InputSampler sampler(timeline.GetSource());
+        timeline.SampleUntil(sampler, kFoldIntervalNs);
+        CHECK(sampler.Fold(PXR_CONTROLLER_RIGHT) == kTrigger);
+        CHECK(sampler.Fold(PXR_CONTROLLER_LEFT) == 0);
+        timeline.SampleUntil(sampler, 2 * kFoldIntervalNs);
+        CHECK(sampler.Fold(PXR_CONTROLLER_RIGHT) == 0);
+        CHECK(sampler.GetEdgeCount() == 2);
+        CHECK(sampler.GetShortPressCount() == 1);
+    }
+
+    // overlapping buttons and both hands fold together; a press held over a fold stays down
+    {
+        Timeline timeline;
+        timeline.taps.push_back({PXR_CONTROLLER_RIGHT, kA, 1800 * kUs, 2200 * kUs});
+        timeline.taps.push_back({PXR_CONTROLLER_RIGHT, kTrigger, 1900 * kUs, 2200 * kUs});
+        timeline.taps.push_back({PXR_CONTROLLER_LEFT, kX, 3800 * kUs, 4100 * kUs});
+        timeline.taps.push_back({PXR_CONTROLLER_LEFT, kTrigger, 9 * kMs, 25 * kMs});
+        InputSampler sampler(timeline.GetSource());
+        timeline.SampleUntil(sampler, kFoldIntervalNs);
+        CHECK(sampler.Fold(PXR_CONTROLLER_RIGHT) == (kA | kTrigger));
+        CHECK(sampler.Fold(PXR_CONTROLLER_LEFT) == kX);
+        timeline.SampleUntil(sampler, 2 * kFoldIntervalNs);
+        CHECK(sampler.Fold(PXR_CONTROLLER_RIGHT) == 0);
+        CHECK(sampler.Fold(PXR_CONTROLLER_LEFT) == kTrigger);
+        timeline.SampleUntil(sampler, 3 * kFoldIntervalNs);
+        CHECK(sampler.Fold(PXR_CONTROLLER_LEFT) == 0);
+        CHECK(sampler.GetOverflowCount() == 0);
+    }
+
+    // two taps between two folds: down, up, down, up over the next four folds
+    {
+        Timeline timeline;
+        timeline.taps.push_back({PXR_CONTROLLER_RIGHT, kTrigger, 1900 * kUs, 2300 * kUs});
+        timeline.taps.push_back({PXR_CONTROLLER_RIGHT, kTrigger, 5900 * kUs, 6300 * kUs});
+        InputSampler sampler(timeline.GetSource());
+        timeline.SampleUntil(sampler, kFoldIntervalNs);
+        CHECK(sampler.Fold(PXR_CONTROLLER_RIGHT) == kTrigger);
+        CHECK(sampler.Fold(PXR_CONTROLLER_RIGHT) == 0);
+        CHECK(sampler.Fold(PXR_CONTROLLER_RIGHT) == kTrigger);
+        CHECK(sampler.Fold(PXR_CONTROLLER_RIGHT) == 0);
+        CHECK(sampler.Fold(PXR_CONTROLLER_RIGHT) == 0);
+        CHECK(sampler.GetShortPressCount() == 2);
+    }
+
+    // a held button released and pressed again between two folds: the release shows with the
+    // next fold and the press with the one after, so the tracking state changes twice
+    {
+        Timeline timeline;
+        timeline.taps.push_back({PXR_CONTROLLER_RIGHT, kTrigger, 5 * kMs, 14200 * kUs});
+        timeline.taps.push_back({PXR_CONTROLLER_RIGHT, kTrigger, 15800 * kUs, 40 * kMs});
+        timeline.taps.push_back({PXR_CONTROLLER_RIGHT, kA, 18 * kMs, 30 * kMs});
+        InputSampler sampler(timeline.GetSource());
+        timeline.SampleUntil(sampler, kFoldIntervalNs);
+        uint64_t reported = sampler.Fold(PXR_CONTROLLER_RIGHT);
+        CHECK(reported == kTrigger);
+        timeline.SampleUntil(sampler, 2 * kFoldIntervalNs);
+        // what ProcessControllers reports as changed
+        uint64_t next = sampler.Fold(PXR_CONTROLLER_RIGHT);
+        CHECK(next == 0);
+        CHECK((reported ^ next) == kTrigger);
+        reported = next;
+        // the press of A after the re-press folds with it
+        next = sampler.Fold(PXR_CONTROLLER_RIGHT);
+        CHECK(next == (kTrigger | kA));
+        CHECK((reported ^ next) == (kTrigger | kA));
+        timeline.SampleUntil(sampler, 3 * kFoldIntervalNs);
+        CHECK(sampler.Fold(PXR_CONTROLLER_RIGHT) == kTrigger);
+    }
+
+    // a burst of taps longer than the queue, while nothing folds: timing is lost, the presses
+    // are not, and the folds end on the current mask
+    {
+        Timeline timeline;
+        const uint32_t taps = InputSampler::kQueueCapacity;
+        for (uint32_t i = 0; i < taps; i++) {
+            timeline.taps.push_back({PXR_CONTROLLER_RIGHT, kA, (2 * i + 1) * kIntervalNs, (2 * i + 2) * kIntervalNs});
+        }
+        timeline.taps.push_back({PXR_CONTROLLER_RIGHT, kX, (2 * taps + 1) * kIntervalNs, (2 * taps + 2) * kIntervalNs});
+        timeline.taps.push_back({PXR_CONTROLLER_RIGHT, kTrigger, (2 * taps + 2) * kIntervalNs, 1000 * kMs});
+        InputSampler sampler(timeline.GetSource());
+        timeline.SampleUntil(sampler, (2 * taps + 3) * kIntervalNs);
+        CHECK(sampler.GetOverflowCount() > 0);
+        uint32_t downsA = 0, downsX = 0;
+        uint64_t reported = 0, last = 0;
+        for (uint32_t fold = 0; fold < 2 * taps + 8; fold++) {
+            // the sampler goes on while the queue drains
+            timeline.SampleUntil(sampler, timeline.nowNs + kIntervalNs);
+            last = sampler.Fold(PXR_CONTROLLER_RIGHT);
+            downsA += (last & ~reported & kA) != 0 ? 1 : 0;
+            downsX += (last & ~reported & kX) != 0 ? 1 : 0;
+            reported = last;
+        }
+        CHECK(downsA >= taps / 2 && downsA <= taps);
+        CHECK(downsX == 1);
+        CHECK(last == kTrigger);
+    }
+
+    // taps at random phases: the share a sample lands on is their length over the sample
+    // interval, and every tap that was sampled reaches a fold
+    printf("{\"benchmark\":\"InputSubMsTaps\",\"sampleIntervalUs\":%u,\"caughtShare\":{",
+           InputSampler::kSampleIntervalUs);
+    const uint64_t durationsUs[] = {100, 250, 500, 900};
+    for (uint32_t d = 0; d < 4; d++) {
+        const uint32_t taps = 2000;
+        const uint64_t slotNs = 3 * kIntervalNs;
+        uint32_t seed = 17 + d;
+        Timeline timeline;
+        InputSampler sampler(timeline.GetSource());
+        uint32_t foldedDown = 0;
+        for (uint32_t i = 0; i < taps; i++) {
+            const uint64_t startNs = i * slotNs + kIntervalNs + Random(seed) % 1000 * kIntervalNs / 1000;
+            timeline.taps.assign(1, {PXR_CONTROLLER_RIGHT, kTrigger, startNs, startNs + durationsUs[d] * kUs});
+            timeline.SampleUntil(sampler, (i + 1) * slotNs);
+            // a sampled tap is down in the first fold and up in the second
+            foldedDown += (sampler.Fold(PXR_CONTROLLER_RIGHT) & kTrigger) != 0 ? 1 : 0;
+            CHECK(sampler.Fold(PXR_CONTROLLER_RIGHT) == 0);
+        }
+        const uint64_t sampled = sampler.GetEdgeCount() / 2;
+        const double share = double(sampled) / taps;
+        printf("%s\"%lluus\":%.3f", d > 0 ? "," : "", (unsigned long long) durationsUs[d], share);
+        CHECK(sampler.GetEdgeCount() % 2 == 0);
+        CHECK(foldedDown == sampled);
+        CHECK(fabs(share - double(durationsUs[d] * kUs) / kIntervalNs) < 0.05);
+    }
+    printf("}}\n");
+
+    // the sampler thread against sub-millisecond taps from another thread, folded at 90 Hz
+    {
+        std::atomic<uint64_t> held{0};
+        std::atomic<uint64_t> reads{0};
+        InputSampler sampler([&held, &reads](uint32_t controller, uint64_t *buttons) {
+            reads++;
+            *buttons = controller == PXR_CONTROLLER_RIGHT ? held.load() : 0;
+            return true;
+        });
+        sampler.Start();
+        std::atomic<bool> tapping{true};
+        std::atomic<uint32_t> foldedDown{0};
+        std::atomic<uint64_t> otherButtons{0};
+        std::thread folder([&]() {
+            while (tapping.load()) {
+                const uint64_t buttons = sampler.Fold(PXR_CONTROLLER_RIGHT);
+                foldedDown += (buttons & kTrigger) != 0 ? 1 : 0;
+                otherButtons |= buttons & ~kTrigger;
+                otherButtons |= sampler.Fold(PXR_CONTROLLER_LEFT);
+                usleep(kFoldIntervalNs / kUs);
+            }
+        });
+        // each tap takes two folds, so the taps come at most every two fold intervals
+        const uint32_t taps = 60;
+        uint32_t seed = 5;
+        const uint64_t startNs = TestUtil::NowNs();
+        for (uint32_t i = 0; i < taps; i++) {
+            // sleeping, not spinning, so the sampler gets the core while the trigger is down
+            held = kTrigger;
+            usleep(500);
+            held = 0;
+            // random gaps, so the taps do not lock to the sampler's phase
+            usleep(2 * kFoldIntervalNs / kUs + Random(seed) % 10000);
+        }
+        const double elapsedMs = (TestUtil::NowNs() - startNs) / 1e6;
+        usleep(4 * kFoldIntervalNs / kUs);
+        tapping = false;
+        folder.join();
+        sampler.Stop();
+        const uint64_t sampled = sampler.GetEdgeCount() / 2;
+        printf("{\"benchmark\":\"InputSamplerThread\",\"taps\":%u,\"sampled\":%llu,\"foldedDown\":%u,"
+               "\"sampleRateHz\":%.0f,\"meanEdgeAgeMs\":%.2f}\n",
+               taps, (unsigned long long) sampled, foldedDown.load(), reads / 2 / elapsedMs * 1000,
+               sampler.GetMeanEdgeAgeMs());
+        CHECK(sampler.GetEdgeCount() % 2 == 0);
+        CHECK(sampled > 0);
+        // every sampled tap folds into its own down
+        CHECK(foldedDown == sampled);
+        CHECK(otherButtons == 0);
+        CHECK(sampler.GetOverflowCount() == 0);
+        CHECK(sampler.Fold(PXR_CONTROLLER_RIGHT) == 0);
+        // a loaded machine delays the sampler, but not to a fraction of its rate
+        CHECK(reads / 2 / elapsedMs * 1000 > 1e6 / InputSampler::kSampleIntervalUs / 4);
+    }
+    return TestResult("InputSamplerTest");
+}
@@ -0,0 +1,94 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Feeds LatencyTracker a synthetic 72 Hz tracking stream and frames tagged with their sample
+// time: skewed tags, a head that does not move, lost and late frames, samples too close to tell
+// apart, and the prediction residual.
+#include <math.h>
+#include "LatencyTracker.h"
+#include "TestUtil.h"
+
+namespace {
+    const uint64_t kMs = 1000000ULL;
+    const uint64_t kFrameNs = 1000000000ULL / 72;
+    const uint64_t kStartNs = 1000 * kMs;
+
+    bool NearMs(double a, double b, double toleranceMs) {
+        return fabs(a - b) <= toleranceMs;
+    }
+}
+
+int main() {
+    // The server tags each frame with its own reading of the sample time, up to 1.5 ms off the
+    // time the client recorded; frames are latched 40 ms and displayed 55 ms after the sample.
+    // Matching by pose could not tell these samples apart, the head never moves.
+    {
+        LatencyTracker tracker;
+        const uint32_t kFrames = 500;
+        uint32_t matched = 0;
+        for (uint32_t i = 0; i < kFrames; i++) {
+            const uint64_t sampleNs = kStartNs + i * kFrameNs;
+            tracker.RecordPose(sampleNs, sampleNs + 50 * kMs);
+            if (i < 3) {
+                continue;
+            }
+            // the frame of the sample three frames back
+            const uint64_t frameSampleNs = sampleNs - 3 * kFrameNs;
+            const int64_t skewNs = int64_t(i % 7) * 500000 - 1500000;
+            if (tracker.OnFrameLatched(uint64_t(int64_t(frameSampleNs) + skewNs), frameSampleNs + 40 * kMs,
+                                       frameSampleNs + 55 * kMs)) {
+                matched++;
+            }
+        }
+        CHECK(matched == kFrames - 3);
+        CHECK(tracker.GetUnmatchedCount() == 0);
+        CHECK(tracker.GetAmbiguousCount() == 0);
+        CHECK(NearMs(tracker.GetPoseToLatch().GetMeanMs(), 40, 0.01));
+        CHECK(NearMs(tracker.GetLatchToDisplay().GetMeanMs(), 15, 0.01));
+        CHECK(NearMs(tracker.GetPoseToDisplay().GetMeanMs(), 55, 0.01));
+        CHECK(NearMs(tracker.GetPoseToDisplay().GetPercentileMs(99), 55.5, 0.01));
+        // predicted 50 ms ahead, displayed 55 ms after the sample
+        CHECK(tracker.GetResidualCount() == matched);
+        CHECK(NearMs(tracker.GetMeanResidualMs(), 5, 0.01));
+
+        tracker.ResetWindow();
+        CHECK(tracker.GetPoseToLatch().GetCount() == 0);
+        CHECK(tracker.GetResidualCount() == 0);
+    }
+
+    // the nearest sample wins; tags further than the skew from every sample, untagged frames and
+    // samples older than the history are not matched
+    {
+        LatencyTracker tracker;
+        for (uint32_t i = 0; i < LatencyTracker::kHistorySize + 10; i++) {
+            tracker.RecordPose(kStartNs + i * kFrameNs);
+        }
+        const uint64_t lastNs = kStartNs + (LatencyTracker::kHistorySize + 9) * kFrameNs;
+        const uint64_t latchNs = lastNs + 30 * kMs;
+        CHECK(tracker.OnFrameLatched(lastNs - kFrameNs + kMs, latchNs, 0));
+        CHECK(NearMs(tracker.GetPoseToLatch().GetMeanMs(), (latchNs - (lastNs - kFrameNs)) / 1e6, 0.01));
+        CHECK(!tracker.OnFrameLatched(lastNs - kFrameNs / 2, latchNs, 0));
+        CHECK(!tracker.OnFrameLatched(0, latchNs, 0));
+        CHECK(!tracker.OnFrameLatched(kStartNs, latchNs, 0));
+        // a sample recorded after the latch cannot be the frame's
+        CHECK(!tracker.OnFrameLatched(lastNs, lastNs - kMs, 0));
+        CHECK(tracker.GetUnmatchedCount() == 4);
+        CHECK(tracker.GetAmbiguousCount() == 0);
+        // no display time: only pose-to-latch
+        CHECK(tracker.GetPoseToDisplay().GetCount() == 0);
+    }
+
+    // two samples within the skew of the tag cannot be told apart
+    {
+        LatencyTracker tracker;
+        tracker.RecordPose(kStartNs);
+        tracker.RecordPose(kStartNs + kMs);
+        CHECK(!tracker.OnFrameLatched(kStartNs + kMs / 2, kStartNs + 30 * kMs, 0));
+        CHECK(tracker.GetAmbiguousCount() == 1);
+        tracker.RecordPose(kStartNs + 20 * kMs);
+        CHECK(tracker.OnFrameLatched(kStartNs + 20 * kMs, kStartNs + 30 * kMs, kStartNs + 40 * kMs));
+        // a display time that does not fit the latch is left out
+        CHECK(tracker.OnFrameLatched(kStartNs + 20 * kMs, kStartNs + 30 * kMs, kStartNs + 2000 * kMs));
+        CHECK(tracker.GetLatchToDisplay().GetCount() == 1);
+        CHECK(tracker.GetResidualCount() == 0);
+    }
+    return TestResult("LatencyTrackerTest");
+}
@@ -0,0 +1,212 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// LaunchOptionsStore: parsing and validation, loads that keep the active options on errors, the
+// cache of the last valid options, and the watcher picking up rewritten and replaced files while
+// readers on other threads only ever see whole snapshots.
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+#include <unistd.h>
+#include "ClientFixture.h"
+#include "LaunchOptionsStore.h"
+
+namespace {
+    // longer than the watcher's debounce, for changes that must not be picked up
+    const uint32_t kSettleMs = LaunchOptionsStore::kDebounceMs * 3;
+    const uint32_t kReloadTimeoutMs = 3000;
+
+    bool Rejected(const std::string &text, const char *expectedError) {
+        std::string error;
+        const bool rejected = LaunchOptionsStore::Parse(text, error) == nullptr;
+        return rejected && error.find(expectedError) != std::string::npos;
+    }
+
+    // Replaces the file the way adb push and most editors do: write a copy, then rename it over.
+    bool ReplaceFile(const std::string &path, const std::string &text) {
+        const std::string tmpPath = path + ".new";
+        return TestUtil::WriteFile(tmpPath, text) && rename(tmpPath.c_str(), path.c_str()) == 0;
+    }
+
+    bool WaitForGeneration(const LaunchOptionsStore &store, uint32_t generation) {
+        return ClientFixture::WaitUntil([&]() { return store.GetGeneration() >= generation; }, kReloadTimeoutMs);
+    }
+}
+
+int main() {
+    // parsing: every option reaches its field
+    std::string error;
+    std::shared_ptr<PxrLaunchOptions> parsed = LaunchOptionsStore::Parse(
+            "-s 10.0.0.2 -mbr 50000 -f 40 -d 0x10 -sl double-wide -rr 90 -aq on -ta render:big -tp worker:10 "
+            "-ll warn -fi latch-drop:1 -pf all -pfc 2.5 -pfb 0.5", error);
+    if (CHECK(parsed != nullptr)) {
+        CHECK(parsed->mServerIP == "10.0.0.2");
+        CHECK(parsed->mMaxVideoBitrate == 50000);
+        CHECK(parsed->mFoveation == 40);
+        CHECK(parsed->mDebugFlags == 0x10);
+        CHECK(parsed->mStereoLayout == PxrStereoLayout_DoubleWide);
+        CHECK(parsed->mRefreshRate == 90);
+        CHECK(parsed->mAdaptiveQuality == PxrAdaptiveQuality_OnConnect);
+        CHECK(parsed->mThreadAffinity == "render:big");
+        CHECK(parsed->mThreadPriority == "worker:10");
+        CHECK(parsed->mLogLevel == AsyncLogPriority_Warn);
+        CHECK(parsed->mFaultInjection == "latch-drop:1");
+        CHECK(parsed->mPoseFilter == PxrPoseFilter_All);
+        CHECK(parsed->mPoseFilterCutoff == 2.5f);
+        CHECK(parsed->mPoseFilterBeta == 0.5f);
+    }
+    // empty text is the defaults
+    parsed = LaunchOptionsStore::Parse("", error);
+    CHECK(parsed != nullptr && parsed->mServerIP.empty() && parsed->mAdaptiveQuality == PxrAdaptiveQuality_Off);
+
+    // syntax errors and values out of range
+    CHECK(Rejected("-s", "parse failed"));
+    CHECK(Rejected("--no-such-option 1", "parse failed"));
+    CHECK(Rejected("-sl sideways", "parse failed"));
+    CHECK(Rejected("-rr fast", "parse failed"));
+    CHECK(Rejected("-mbr 500", "maxVideoBitrateKbps"));
+    CHECK(Rejected("-mbr 2000000", "maxVideoBitrateKbps"));
+    CHECK(Rejected("-f 101", "foveation"));
+    CHECK(Rejected("-rr 20", "refresh-rate"));
+    CHECK(Rejected("-rr 500", "refresh-rate"));
+    CHECK(Rejected("-pfc 0", "pose-filter-cutoff"));
+    CHECK(Rejected("-pfb -1", "pose-filter-beta"));
+    CHECK(Rejected("-ta render:huge", "thread-affinity"));
+    CHECK(Rejected("-tp nobody:3", "thread-priority"));
+    CHECK(Rejected("-fi latch-drop:x", ""));
+    // the limits themselves pass
+    CHECK(LaunchOptionsStore::Parse("-mbr 1000 -f 100 -rr 30 -pfc 100 -pfb 0", error) != nullptr);
+
+    const std::string dir = TestUtil::MakeTempDir("launch_options");
+    const std::string path = dir + "/CloudXRLaunchOptions.txt";
+    const std::string cachePath = dir + "/launch_options_cache.txt";
+
+    // loading: a missing or broken file keeps the active options, an unchanged one is not republished
+    {
+        LaunchOptionsStore store;
+        const uint32_t initial = store.GetGeneration();
+        CHECK(!store.Load(path));
+        CHECK(store.GetGeneration() == initial);
+        CHECK(store.Get()->mServerIP.empty());
+
+        CHECK(TestUtil::WriteFile(path, "-s 10.0.0.3 -f 30"));
+        CHECK(store.Load(path));
+        CHECK(store.GetGeneration() == initial + 1);
+        const std::shared_ptr<const PxrLaunchOptions> loaded = store.Get();
+        CHECK(loaded->mServerIP == "10.0.0.3" && loaded->mFoveation == 30);
+        CHECK(store.Load(path));
+        CHECK(store.GetGeneration() == initial + 1);
+
+        CHECK(TestUtil::WriteFile(path, "-s 10.0.0.4 -f 300"));
+        CHECK(!store.Load(path));
+        CHECK(store.GetGeneration() == initial + 1);
+        CHECK(store.Get() == loaded);
+
+        // a valid file is cached as soon as there is a cache
+        CHECK(TestUtil::WriteFile(path, "-s 10.0.0.5"));
+        CHECK(store.Load(path));
+        store.SetCacheFile(cachePath);
+        CHECK(access(cachePath.c_str(), R_OK) == 0);
+    }
+
+    // the cache stands in for a broken options file at startup, and never for a good one
+    {
+        CHECK(TestUtil::WriteFile(path, "-s 10.0.0.6 -rr 500"));
+        LaunchOptionsStore store;
+        CHECK(!store.Load(path));
+        store.SetCacheFile(cachePath);
+        CHECK(store.Get()->mServerIP == "10.0.0.5");
+    }
+    {
+        CHECK(TestUtil::WriteFile(path, "-s 10.0.0.7"));
+        LaunchOptionsStore store;
+        CHECK(store.Load(path));
+        store.SetCacheFile(cachePath);
+        CHECK(store.Get()->mServerIP == "10.0.0.7");
+    }
+    // a broken cache is ignored
+    {
+        CHECK(TestUtil::WriteFile(path, "-f 300"));
+        CHECK(TestUtil::WriteFile(cachePath, "-mbr 1"));
+        LaunchOptionsStore store;
+        CHECK(!store.Load(path));
+        store.SetCacheFile(cachePath);
+        CHECK(store.Get()->mServerIP.empty() && store.Get()->mMaxVideoBitrate == 0);
+    }
+
+    // the watcher: rewrites and replacements are picked up, broken files and deletes are not
+    {
+        CHECK(TestUtil::WriteFile(path, "-s 10.0.0.8 -rr 60 -pfc 6"));
+        LaunchOptionsStore store;
+        store.SetCacheFile(cachePath);
+        CHECK(store.Load(path));
+        CHECK(!LaunchOptionsStore().StartWatching());
+        CHECK(store.StartWatching());
+
+        // readers never see a refresh rate from one file and a cutoff from another
+        std::atomic<bool> reading{true};
+        std::atomic<uint32_t> torn{0};
+        std::atomic<uint64_t> reads{0};
+        std::thread reader([&]() {
+            while (reading.load()) {
+                const std::shared_ptr<const PxrLaunchOptions> options = store.Get();
+                if (options->mRefreshRate != options->mPoseFilterCutoff * 10) {
+                    torn++;
+                }
+                reads++;
+            }
+        });
+
+        uint32_t generation = store.GetGeneration();
+        CHECK(TestUtil::WriteFile(path, "-s 10.0.0.8 -rr 72 -pfc 7.2"));
+        CHECK(WaitForGeneration(store, ++generation));
+        CHECK(store.Get()->mRefreshRate == 72);
+
+        CHECK(ReplaceFile(path, "-s 10.0.0.8 -rr 90 -pfc 9"));
+        CHECK(WaitForGeneration(store, ++generation));
+        CHECK(store.Get()->mRefreshRate == 90);
+
+        // several writes within the debounce are one reload of the last one
+        CHECK(TestUtil::WriteFile(path, "-s 10.0.0.8 -rr 100 -pfc 10"));
+        CHECK(TestUtil::WriteFile(path, "-s 10.0.0.8 -rr 110 -pfc 11"));
+        CHECK(TestUtil::WriteFile(path, "-s 10.0.0.8 -rr 120 -pfc 12"));
+        CHECK(WaitForGeneration(store, ++generation));
+        usleep(kSettleMs * 1000);
+        CHECK(store.GetGeneration() == generation);
+        CHECK(store.Get()->mRefreshRate == 120);
+
+        CHECK(ReplaceFile(path, "-s 10.0.0.8 -rr 1000 -pfc 100"));
+        usleep(kSettleMs * 1000);
+        CHECK(store.GetGeneration() == generation);
+        CHECK(unlink(path.c_str()) == 0);
+        usleep(kSettleMs * 1000);
+        CHECK(store.GetGeneration() == generation);
+        CHECK(store.Get()->mRefreshRate == 120);
+
+        // other files in the directory do not trigger reloads
+        CHECK(TestUtil::WriteFile(dir + "/other.txt", "-rr 60"));
+        usleep(kSettleMs * 1000);
+        CHECK(store.GetGeneration() == generation);
+
+        // a file that comes back is loaded again, and cached
+        CHECK(ReplaceFile(path, "-s 10.0.0.8 -rr 144 -pfc 14.4"));
+        CHECK(WaitForGeneration(store, ++generation));
+        CHECK(store.Get()->mRefreshRate == 144);
+
+        reading = false;
+        reader.join();
+        CHECK(reads > 0);
+        CHECK(torn == 0);
+
+        store.StopWatching();
+        CHECK(TestUtil::WriteFile(path, "-s 10.0.0.8 -rr 60 -pfc 6"));
+        usleep(kSettleMs * 1000);
+        CHECK(store.GetGeneration() == generation);
+    }
+    {
+        CHECK(TestUtil::WriteFile(path, "-f 300"));
+        LaunchOptionsStore store;
+        CHECK(!store.Load(path));
+        store.SetCacheFile(cachePath);
+        CHECK(store.Get()->mRefreshRate == 144);
+    }
+    return TestResult("LaunchOptionsStoreTest");
+}
@@ -0,0 +1,100 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Runs android_main through paused, idle (connecting) and streaming and counts main loop
+// iterations and rendered frames per second in each state.
+#include <time.h>
+#include "AppHarness.h"
+#include "StandinCloudXR.h"
+#include "StandinPxr.h"
+
+namespace {
+    const uint32_t kWindowMs = 1000;
+    const uint32_t kConnectDelayMs = 2000;
+
+    struct Rates {
+        double iterations;
+        double frames;
+        double cpuMs;
+    };
+
+    uint64_t ProcessCpuNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+    bool WaitForLatchedFrames(uint32_t timeoutMs) {
+        const uint64_t deadlineNs = TestUtil::NowNs() + timeoutMs * 1000000ULL;
+        while (TestUtil::NowNs() < deadlineNs) {
+            const cxrReceiverHandle receiver = StandinCloudXR::GetLastReceiver();
+            if (receiver != nullptr && StandinCloudXR::GetCounters(receiver).framesLatched > 0) {
+                return true;
+            }
+            usleep(1000);
+        }
+        return false;
+    }
+
+    // per second, over one window
+    Rates Measure(const char *state) {
+        const uint64_t iterations = StandinAndroid::GetPollTimeoutCount();
+        const uint64_t frames = StandinPxr::GetCallCount(StandinPxrCall_BeginFrame);
+        const uint64_t cpuNs = ProcessCpuNs();
+        usleep(kWindowMs * 1000);
+        Rates rates;
+        rates.iterations = (StandinAndroid::GetPollTimeoutCount() - iterations) * 1000.0 / kWindowMs;
+        rates.frames = (StandinPxr::GetCallCount(StandinPxrCall_BeginFrame) - frames) * 1000.0 / kWindowMs;
+        rates.cpuMs = (ProcessCpuNs() - cpuNs) / 1e6 * 1000.0 / kWindowMs;
+        printf("%-9s iterations:%5.1f/s, frames:%5.1f/s, process cpu:%6.1fms/s\n",
+               state, rates.iterations, rates.frames, rates.cpuMs);
+        return rates;
+    }
+}
+
+int main() {
+    StandinPxr::Reset();
+    StandinPxr::SetRunning(false);
+    // llvmpipe fills full size eye buffers at well below display rate
+    StandinPxr::SetViewSize(256, 256);
+    StandinServerProfile profile;
+    profile.connectDelayMs = kConnectDelayMs;
+    StandinCloudXR::SetProfile(profile);
+
+    const AppRunResult result = RunApp("loop_scheduler", "-s 127.0.0.1", [](android_app *app) {
+        // in the background: blocks 100ms per poll, renders nothing
+        usleep(500 * 1000);
+        const Rates paused = Measure("paused");
+        CHECK(paused.iterations <= 12);
+        CHECK(paused.frames == 0);
+
+        // foreground while the server accepts the connection: 10 Hz static frames
+        StandinPxr::SetRunning(true);
+        StandinAndroid::PostCommand(app, APP_CMD_RESUME);
+        usleep(200 * 1000);
+        const Rates idle = Measure("idle");
+        CHECK(idle.frames >= 8 && idle.frames <= 12);
+        CHECK(idle.iterations <= idle.frames + 4);
+        CHECK(StandinCloudXR::GetLastReceiver() != nullptr);
+
+        // streaming: paced by the runtime at the display rate
+        if (CHECK(WaitForLatchedFrames(kConnectDelayMs + 2000))) {
+            usleep(200 * 1000);
+            const Rates stream = Measure("streaming");
+            const float rate = StandinPxr::GetRefreshRate();
+            CHECK(stream.frames >= rate * 0.85 && stream.frames <= rate * 1.05);
+            CHECK(stream.iterations <= stream.frames + 2);
+        }
+
+        // back to the background
+        StandinAndroid::PostCommand(app, APP_CMD_PAUSE);
+        StandinPxr::SetRunning(false);
+        usleep(300 * 1000);
+        const Rates pausedAgain = Measure("paused");
+        CHECK(pausedAgain.iterations <= 12);
+        CHECK(pausedAgain.frames == 0);
+    }, 20000);
+
+    CHECK(result.exited);
+    CHECK(result.exitStatus == 0);
+    TestUtil::Failures() += result.failures;
+    return TestResult("LoopSchedulerHarness");
+}
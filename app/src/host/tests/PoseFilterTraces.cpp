@@ -0,0 +1,302 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Runs PoseFilter over noisy pose traces and measures what it costs and what it buys: the
+// latency it adds, as the delay of the raw trace that best matches the filtered one, and the
+// jitter it removes, as the drop in RMS frame-to-frame acceleration. The traces are synthetic
+// motions with tracking noise, filtered the way the client does, head and both controllers in
+// one Filter() call per frame. Recorded traces are passed as files, one "timeMs px py pz qx qy
+// qz qw" line per sample and "#" comment lines; the test runs with tests/data/pose_trace_hand.txt.
+//
+// Checks that a hand at rest loses most of its jitter, that a fast swing is followed with a
+// fraction of the lag a fixed low-pass with the same rest cutoff adds, and that the default
+// parameters add less latency the faster the motion. On recorded traces, with their irregular
+// frame times, the jitter still drops and the lag stays within that of the slow reach.
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "PoseFilter.h"
+#include "TestUtil.h"
+
+namespace {
+    const double kPi = 3.14159265358979;
+    const double kFps = 72;
+    const double kSeconds = 20;
+    // the filter settles before anything is measured
+    const double kWarmupMs = 2000;
+    // tracking noise of the traces: position in m, orientation in rad
+    const double kPositionNoise = 0.0005;
+    const double kRotationNoise = 0.002;
+    const double kMaxLagMs = 150;
+    const double kLagStepMs = 0.25;
+    // m, or rad for orientations
+    const double kMinMotion = 0.05;
+
+    struct Sample {
+        double timeMs;
+        PxrPosef pose;
+    };
+
+    typedef std::vector<Sample> Trace;
+
+    struct Noise {
+        uint32_t seed;
+
+        double Uniform() {
+            seed = seed * 1103515245 + 12345;
+            return ((seed >> 8) + 0.5) / double(1 << 24);
+        }
+
+        double Gaussian() {
+            return sqrt(-2 * log(Uniform())) * cos(2 * kPi * Uniform());
+        }
+    };
+
+    // yaw about y, then pitch about x
+    PxrQuaternionf Rotation(double yaw, double pitch) {
+        const double cy = cos(yaw / 2), sy = sin(yaw / 2), cp = cos(pitch / 2), sp = sin(pitch / 2);
+        return {float(cy * sp), float(sy * cp), float(-sy * sp), float(cy * cp)};
+    }
+
+    struct Motion {
+        const char *name;
+        // position amplitude in m and orientation amplitude in rad of a back and forth at hz
+        double positionAmplitude;
+        double rotationAmplitude;
+        double hz;
+    };
+
+    Trace MakeTrace(const Motion &motion, uint32_t seed) {
+        Noise noise{seed};
+        Trace trace;
+        for (uint32_t frame = 0; frame < uint32_t(kSeconds * kFps); frame++) {
+            const double t = frame / kFps;
+            const double phase = sin(2 * kPi * motion.hz * t);
+            Sample sample;
+            sample.timeMs = 1000 + t * 1000;
+            sample.pose.position = {float(0.2 + motion.positionAmplitude * phase + kPositionNoise * noise.Gaussian()),
+                                    float(1.2 + kPositionNoise * noise.Gaussian()),
+                                    float(-0.3 + motion.positionAmplitude * 0.5 * phase + kPositionNoise * noise.Gaussian())};
+            sample.pose.orientation = Rotation(motion.rotationAmplitude * phase + kRotationNoise * noise.Gaussian(),
+                                               0.2 + kRotationNoise * noise.Gaussian());
+            trace.push_back(sample);
+        }
+        return trace;
+    }
+
+    bool ReadTrace(const char *path, Trace *trace) {
+        FILE *file = fopen(path, "r");
+        if (file == nullptr) {
+            return false;
+        }
+        Sample sample;
+        PxrVector3f &p = sample.pose.position;
+        PxrQuaternionf &q = sample.pose.orientation;
+        char line[256];
+        while (fgets(line, sizeof(line), file) != nullptr) {
+            if (line[0] == '#') {
+                continue;
+            }
+            if (sscanf(line, "%lf %f %f %f %f %f %f %f", &sample.timeMs, &p.x, &p.y, &p.z, &q.x, &q.y, &q.z, &q.w) != 8) {
+                break;
+            }
+            trace->push_back(sample);
+        }
+        fclose(file);
+        return trace->size() > 3;
+    }
+
+    // position in m, then orientation as a quaternion in the hemisphere of the trace's first
+    // sample scaled by two, so that both are in the units of a small rotation in rad
+    void Channels(const PxrPosef &pose, const PxrQuaternionf &reference, double channels[7]) {
+        const PxrQuaternionf &q = pose.orientation;
+        const double sign = q.x * reference.x + q.y * reference.y + q.z * reference.z + q.w * reference.w < 0 ? -2 : 2;
+        channels[0] = pose.position.x;
+        channels[1] = pose.position.y;
+        channels[2] = pose.position.z;
+        channels[3] = sign * q.x;
+        channels[4] = sign * q.y;
+        channels[5] = sign * q.z;
+        channels[6] = sign * q.w;
+    }
+
+    // RMS frame-to-frame acceleration of the position (m) and orientation (rad) after the warmup.
+    void Jitter(const Trace &trace, double *position, double *rotation) {
+        double sums[2] = {};
+        uint32_t count = 0;
+        for (size_t i = 2; i < trace.size(); i++) {
+            if (trace[i].timeMs - trace[0].timeMs < kWarmupMs) {
+                continue;
+            }
+            double a[7], b[7], c[7];
+            Channels(trace[i - 2].pose, trace[0].pose.orientation, a);
+            Channels(trace[i - 1].pose, trace[0].pose.orientation, b);
+            Channels(trace[i].pose, trace[0].pose.orientation, c);
+            for (int k = 0; k < 7; k++) {
+                const double d = c[k] - 2 * b[k] + a[k];
+                sums[k < 3 ? 0 : 1] += d * d;
+            }
+            count++;
+        }
+        *position = count > 0 ? sqrt(sums[0] / count) : 0;
+        *rotation = count > 0 ? sqrt(sums[1] / count) : 0;
+    }
+
+    // Delay of the raw trace, linearly interpolated, that matches the filtered one best; -1 when
+    // the raw trace does not move more than a few cm or degrees, there is no lag to see then.
+    double LagMs(const Trace &raw, const Trace &filtered, bool orientation) {
+        const int first = orientation ? 3 : 0;
+        const int last = orientation ? 7 : 3;
+        double range = 0;
+        for (int k = first; k < last; k++) {
+            double low = 0, high = 0;
+            for (size_t i = 0; i < raw.size(); i++) {
+                double channels[7];
+                Channels(raw[i].pose, raw[0].pose.orientation, channels);
+                low = i == 0 ? channels[k] : fmin(low, channels[k]);
+                high = i == 0 ? channels[k] : fmax(high, channels[k]);
+            }
+            range = fmax(range, high - low);
+        }
+        if (range < kMinMotion) {
+            return -1;
+        }
+        double bestLagMs = 0;
+        double bestError = -1;
+        for (double lagMs = 0; lagMs <= kMaxLagMs; lagMs += kLagStepMs) {
+            double error = 0;
+            size_t j = 0;
+            for (size_t i = 0; i < filtered.size(); i++) {
+                const double timeMs = filtered[i].timeMs - lagMs;
+                if (filtered[i].timeMs - raw[0].timeMs < kWarmupMs) {
+                    continue;
+                }
+                while (j + 2 < raw.size() && raw[j + 1].timeMs <= timeMs) {
+                    j++;
+                }
+                const double f = (timeMs - raw[j].timeMs) / (raw[j + 1].timeMs - raw[j].timeMs);
+                double a[7], b[7], out[7];
+                Channels(raw[j].pose, raw[0].pose.orientation, a);
+                Channels(raw[j + 1].pose, raw[0].pose.orientation, b);
+                Channels(filtered[i].pose, raw[0].pose.orientation, out);
+                for (int k = first; k < last; k++) {
+                    const double d = out[k] - (a[k] + f * (b[k] - a[k]));
+                    error += d * d;
+                }
+            }
+            if (bestError < 0 || error < bestError) {
+                bestError = error;
+                bestLagMs = lagMs;
+            }
+        }
+        return bestLagMs;
+    }
+
+    struct Result {
+        double positionLagMs;
+        double rotationLagMs;
+        // share of the raw jitter the filter removed
+        double positionJitterRemoved;
+        double rotationJitterRemoved;
+    };
+
+    Result Measure(const char *name, const Trace &raw, const Trace &filtered) {
+        double rawPosition, rawRotation, outPosition, outRotation;
+        Jitter(raw, &rawPosition, &rawRotation);
+        Jitter(filtered, &outPosition, &outRotation);
+        Result result;
+        result.positionLagMs = LagMs(raw, filtered, false);
+        result.rotationLagMs = LagMs(raw, filtered, true);
+        result.positionJitterRemoved = rawPosition > 0 ? 1 - outPosition / rawPosition : 0;
+        result.rotationJitterRemoved = rawRotation > 0 ? 1 - outRotation / rawRotation : 0;
+        printf("{\"benchmark\":\"PoseFilterTraces\",\"trace\":\"%s\",\"lagMs\":{\"position\":%.2f,\"rotation\":%.2f},"
+               "\"jitterRemoved\":{\"position\":%.3f,\"rotation\":%.3f},"
+               "\"rawJitter\":{\"positionMm\":%.3f,\"rotationDeg\":%.4f}}\n",
+               name, result.positionLagMs, result.rotationLagMs, result.positionJitterRemoved,
+               result.rotationJitterRemoved, rawPosition * 1000, rawRotation * 180 / kPi);
+        return result;
+    }
+
+    // Filters the three traces as head, left and right controller, one Filter() call per frame.
+    void FilterTraces(const PoseFilterParams &params, const Trace *raw[PoseFilterDevice_Count],
+                      Trace filtered[PoseFilterDevice_Count]) {
+        PoseFilter filter;
+        filter.SetParams(params);
+        filter.SetDeviceMask((1u << PoseFilterDevice_Count) - 1);
+        PxrPosef poses[PoseFilterDevice_Count];
+        PxrPosef *const posePointers[PoseFilterDevice_Count] = {&poses[0], &poses[1], &poses[2]};
+        for (uint32_t d = 0; d < PoseFilterDevice_Count; d++) {
+            filtered[d] = *raw[d];
+        }
+        for (size_t i = 0; i < raw[0]->size(); i++) {
+            for (uint32_t d = 0; d < PoseFilterDevice_Count; d++) {
+                poses[d] = (*raw[d])[i].pose;
+            }
+            filter.Filter((*raw[0])[i].timeMs, posePointers, (1u << PoseFilterDevice_Count) - 1);
+            for (uint32_t d = 0; d < PoseFilterDevice_Count; d++) {
+                filtered[d][i].pose = poses[d];
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    const Motion rest = {"rest", 0, 0, 0.2};
+    const Motion reach = {"reach", 0.1, 0.3, 0.4};
+    const Motion swing = {"swing", 0.4, 1.0, 1.2};
+    const Motion turn = {"headTurn", 0, 0.8, 0.3};
+    const Trace head = MakeTrace(turn, 1);
+    const Trace left = MakeTrace(rest, 2);
+    const Trace right = MakeTrace(swing, 3);
+    const Trace reaching = MakeTrace(reach, 4);
+
+    // the defaults, head, hand at rest and swinging hand in one call per frame
+    const PoseFilterParams defaults;
+    Trace filtered[PoseFilterDevice_Count];
+    const Trace *traces[PoseFilterDevice_Count] = {&head, &left, &right};
+    FilterTraces(defaults, traces, filtered);
+    const Result headResult = Measure(turn.name, head, filtered[PoseFilterDevice_Head]);
+    const Result restResult = Measure(rest.name, left, filtered[PoseFilterDevice_LeftController]);
+    const Result swingResult = Measure(swing.name, right, filtered[PoseFilterDevice_RightController]);
+    // a slower hand on the right, with the same head and left hand
+    const Trace *reachTraces[PoseFilterDevice_Count] = {&head, &left, &reaching};
+    FilterTraces(defaults, reachTraces, filtered);
+    const Result reachResult = Measure(reach.name, reaching, filtered[PoseFilterDevice_RightController]);
+
+    // a fixed low-pass at the same rest cutoff: as smooth, but as slow on every motion
+    PoseFilterParams fixed = defaults;
+    fixed.beta = 0;
+    FilterTraces(fixed, traces, filtered);
+    const Result fixedSwing = Measure("swingFixedCutoff", right, filtered[PoseFilterDevice_RightController]);
+
+    // a hand at rest loses most of its jitter
+    CHECK(restResult.positionJitterRemoved > 0.8);
+    CHECK(restResult.rotationJitterRemoved > 0.8);
+    // moving, the jitter still drops
+    CHECK(reachResult.positionJitterRemoved > 0.5);
+    CHECK(headResult.rotationJitterRemoved > 0.5);
+    // the faster the motion, the less the lag; a fixed cutoff lags far more on the swing
+    CHECK(swingResult.positionLagMs < reachResult.positionLagMs);
+    CHECK(swingResult.positionLagMs < fixedSwing.positionLagMs / 2);
+    CHECK(swingResult.rotationLagMs < fixedSwing.rotationLagMs / 2);
+    CHECK(swingResult.positionLagMs < 40);
+    CHECK(headResult.rotationLagMs < 60);
+
+    // recorded traces, measured through the head lane; every lane has the same parameters
+    CHECK(argc > 1);
+    for (int i = 1; i < argc; i++) {
+        Trace recorded;
+        if (!CHECK(ReadTrace(argv[i], &recorded))) {
+            continue;
+        }
+        const Trace *recordedTraces[PoseFilterDevice_Count] = {&recorded, &recorded, &recorded};
+        FilterTraces(defaults, recordedTraces, filtered);
+        const Result result = Measure(argv[i], recorded, filtered[PoseFilterDevice_Head]);
+        // a trace mixes rest and motion, so it keeps less than a rest trace; the fast turns of a
+        // flick keep the most, like the swing above. The lag stays near the reach's
+        CHECK(result.positionJitterRemoved > 0.7);
+        CHECK(result.rotationJitterRemoved > 0.3);
+        CHECK(result.positionLagMs < 50);
+        CHECK(result.rotationLagMs < 40);
+    }
+    return TestResult("PoseFilterTraces");
+}
@@ -0,0 +1,154 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Simulates a head turning back and forth through a streaming pipeline with a fixed latency
+// profile and compares the pose error at display time for three prediction setups: server
+// prediction only, the calibrated client horizon on top of server prediction, and the client's
+// own device description (calibrated horizon, server prediction off).
+//
+// The horizon is learned first, in simulated time, by PredictionCalibrator from LatencyTracker
+// residuals, and stored for the stand-in server like the client does on exit. The poses are
+// then sent through a real client that loaded it on connecting: each runtime sample, predicted
+// to the local display time, goes through SetPoseData() and GetTrackingState(), which runs
+// DoTracking() and ExtrapolatePose(). The server extrapolates the tracked pose by its latency
+// estimate plus predOffset unless pose prediction is disabled, like the stand-in server.
+#include <math.h>
+#include <memory>
+#include <stdio.h>
+#include "ClientFixture.h"
+#include "LatencyTracker.h"
+#include "PredictionCalibrator.h"
+
+namespace {
+    const double kPi = 3.14159265358979;
+    const uint64_t kMs = 1000000ULL;
+    const double kFps = 72;
+    // head yaw: +-30 degrees at 0.5 Hz
+    const double kAmplitudeDeg = 30;
+    const double kFrequencyHz = 0.5;
+    // runtime prediction to the local display time, and sample-to-photon latency of the stream
+    const double kLocalPredictionMs = 25;
+    const double kLatencyMs = 60;
+    const double kLatencyJitterMs = 4;
+    // the server's own latency estimate, as in the stand-in profile
+    const double kServerPredictionMs = 30;
+    const double kLatchToDisplayMs = 12;
+    // the horizon is learned over kLearnSeconds, errors measured over kMeasureSeconds after
+    const uint32_t kLearnSeconds = 30;
+    const uint32_t kMeasureSeconds = 30;
+    const char *kServer = "127.0.0.1";
+
+    double YawDeg(double t) {
+        return kAmplitudeDeg * sin(2 * kPi * kFrequencyHz * t);
+    }
+
+    double YawRateDegPerS(double t) {
+        return kAmplitudeDeg * 2 * kPi * kFrequencyHz * cos(2 * kPi * kFrequencyHz * t);
+    }
+
+    // display latency of one frame, the same sequence for every setup
+    double DisplayMs(uint32_t &seed) {
+        seed = seed * 1103515245 + 12345;
+        return kLatencyMs + kLatencyJitterMs * ((seed >> 16) % 1001 / 500.0 - 1);
+    }
+
+    // The horizon PredictionCalibrator settles on for the latency profile.
+    float LearnHorizonMs() {
+        LatencyTracker tracker;
+        PredictionCalibrator calibrator;
+        uint32_t seed = 7;
+        const uint32_t frames = uint32_t(kLearnSeconds * kFps);
+        for (uint32_t frame = 0; frame < frames; frame++) {
+            const uint64_t sampleNs = 1000 * kMs + uint64_t(frame / kFps * 1e9);
+            const uint64_t targetNs = sampleNs + uint64_t((kLocalPredictionMs + calibrator.GetHorizonMs()) * 1e6);
+            const uint64_t displayNs = sampleNs + uint64_t(DisplayMs(seed) * 1e6);
+            tracker.RecordPose(sampleNs, targetNs);
+            tracker.OnFrameLatched(sampleNs, displayNs - uint64_t(kLatchToDisplayMs * 1e6), displayNs);
+            if ((frame + 1) % uint32_t(kFps) == 0) {
+                calibrator.OnWindow(tracker.GetMeanResidualMs(), tracker.GetResidualCount());
+                tracker.ResetWindow();
+            }
+        }
+        return calibrator.GetHorizonMs();
+    }
+
+    // A client that loaded the horizon, or none, from its data directory, no longer connected
+    // so that the stand-in server's tracking thread stays out of the way.
+    std::unique_ptr<ClientFixture> CreateClient(const char *name, float horizonMs) {
+        std::unique_ptr<ClientFixture> fixture(new ClientFixture(name));
+        if (horizonMs > 0) {
+            PredictionCalibrator calibrator;
+            calibrator.SetHorizonMs(horizonMs);
+            CHECK(calibrator.Save(fixture->dir, kServer));
+        }
+        CHECK(fixture->Connect());
+        fixture->client->SetPaused(true);
+        fixture->client->HandleStateChanges();
+        return fixture;
+    }
+
+    struct Result {
+        double rmsErrorDeg;
+        float horizonMs;
+    };
+
+    // serverPredictionMs is what the server adds to the pose the client tracked
+    Result Simulate(CloudXRClientPXR &client, double serverPredictionMs) {
+        uint32_t seed = 7;
+        double sumSquares = 0;
+        const uint32_t frames = uint32_t(kMeasureSeconds * kFps);
+        for (uint32_t frame = 0; frame < frames; frame++) {
+            const double t = kLearnSeconds + frame / kFps;
+            // the runtime's sample, predicted to the local display time; Pxr velocities are in
+            // milli-units per second
+            const double yawRad = (YawDeg(t) + YawRateDegPerS(t) * kLocalPredictionMs / 1000) * kPi / 180;
+            pxrPose pose = {};
+            pose.predictedDisplayTimeMs = t * 1000 + kLocalPredictionMs;
+            pose.headPose.status = 3;
+            pose.headPose.pose.orientation.y = float(sin(yawRad / 2));
+            pose.headPose.pose.orientation.w = float(cos(yawRad / 2));
+            pose.headPose.angularVelocity.y = float(YawRateDegPerS(t) * kPi / 180 * 1000);
+            client.SetPoseData(pose);
+
+            cxrVRTrackingState tracking = {};
+            client.GetTrackingState(&tracking);
+            const cxrTrackedDevicePose &hmd = tracking.hmd.pose;
+            const double trackedDeg = 2 * atan2(hmd.rotation.y, hmd.rotation.w) * 180 / kPi;
+            const double renderedDeg = trackedDeg + hmd.angularVelocity.v[1] * 180 / kPi * serverPredictionMs / 1000;
+            const double errorDeg = renderedDeg - YawDeg(t + DisplayMs(seed) / 1000);
+            sumSquares += errorDeg * errorDeg;
+        }
+        return {sqrt(sumSquares / frames), client.GetMetrics().predictionHorizonMs};
+    }
+}
+
+int main() {
+    const float learnedHorizonMs = LearnHorizonMs();
+    std::unique_ptr<ClientFixture> uncalibrated = CreateClient("PredictionSimulation", 0);
+    std::unique_ptr<ClientFixture> calibrated = CreateClient("PredictionSimulationCalibrated", learnedHorizonMs);
+    cxrDeviceDesc desc = {};
+    calibrated->client->GetDeviceDesc(&desc);
+    const double clientServerPredictionMs =
+            desc.disablePosePrediction ? 0 : kServerPredictionMs + desc.predOffset * 1000;
+    // the device description before the client took over prediction
+    const double previousServerPredictionMs = kServerPredictionMs - 20;
+
+    const Result serverOnly = Simulate(*uncalibrated->client, previousServerPredictionMs);
+    const Result both = Simulate(*calibrated->client, previousServerPredictionMs);
+    const Result client = Simulate(*calibrated->client, clientServerPredictionMs);
+    printf("{\"benchmark\":\"PredictionSimulation\",\"latencyMs\":%.0f,\"localPredictionMs\":%.0f,"
+           "\"rmsErrorDeg\":{\"serverOnly\":%.3f,\"serverAndClient\":%.3f,\"client\":%.3f},"
+           "\"horizonMs\":{\"serverAndClient\":%.1f,\"client\":%.1f}}\n",
+           kLatencyMs, kLocalPredictionMs, serverOnly.rmsErrorDeg, both.rmsErrorDeg, client.rmsErrorDeg,
+           both.horizonMs, client.horizonMs);
+
+    CHECK(desc.disablePosePrediction);
+    CHECK(desc.predOffset == 0);
+    // the clients extrapolated by what they loaded
+    CHECK(serverOnly.horizonMs == 0);
+    CHECK(fabs(client.horizonMs - learnedHorizonMs) < 0.1f);
+    // the horizon learns the latency the runtime does not cover
+    CHECK(fabs(client.horizonMs - (kLatencyMs - kLocalPredictionMs)) <= PredictionCalibrator::kDeadbandMs + 1);
+    // with the server predicting as well, the learned horizon overshoots by the server's part
+    CHECK(client.rmsErrorDeg < both.rmsErrorDeg);
+    CHECK(client.rmsErrorDeg < serverOnly.rmsErrorDeg);
+    return TestResult("PredictionSimulation");
+}
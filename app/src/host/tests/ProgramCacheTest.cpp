@@ -0,0 +1,187 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// The GL program binary cache on a surfaceless EGL context: the key and file format without GL,
+// then a program compiled once and loaded from its binary on the next launch, a binary the
+// driver rejects falling back to the compile and being replaced, and programs warmed on a
+// shared context being loaded without a compile. Every program drawn from a binary draws what
+// the compiled one does. Prints the compile and the load time.
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "graphicsplugin.h"
+#include "GLUtils.h"
+#include "TestUtil.h"
+
+namespace {
+    const char *kVertexShader = R"(#version 300 es
+void main() {
+    // one triangle covering the viewport
+    vec2 position = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+    const char *kFragmentShader = R"(#version 300 es
+precision mediump float;
+out vec4 color;
+void main() {
+    color = vec4(0.2, 0.4, 0.6, 1.0);
+}
+)";
+
+    const char *kOtherFragmentShader = R"(#version 300 es
+precision mediump float;
+out vec4 color;
+void main() {
+    color = vec4(1.0, 0.5, 0.0, 1.0);
+}
+)";
+
+    std::string CachePath(const std::string &dir, uint64_t key) {
+        char name[32];
+        snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long) key);
+        return dir + name;
+    }
+
+    std::string GetDriver() {
+        return std::string((const char *) glGetString(GL_RENDERER)) + "|" + (const char *) glGetString(GL_VERSION);
+    }
+
+    // Draws with the program into a small texture and returns the pixel in its middle.
+    uint32_t Draw(GLuint program) {
+        GLuint texture = 0, framebuffer = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, 8, 8);
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        glViewport(0, 0, 8, 8);
+        glClearColor(0, 0, 0, 0);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glUseProgram(program);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        uint8_t pixel[4] = {};
+        glReadPixels(4, 4, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+        glUseProgram(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteTextures(1, &texture);
+        return uint32_t(pixel[0]) | uint32_t(pixel[1]) << 8 | uint32_t(pixel[2]) << 16 | uint32_t(pixel[3]) << 24;
+    }
+
+    GLuint CreateProgram(const char *fragmentShader, double *ms = nullptr) {
+        const uint64_t startNs = TestUtil::NowNs();
+        GLuint vertexHandle = 0, fragmentHandle = 0;
+        const GLuint program = GLUtils::CreateProgram(kVertexShader, fragmentShader, vertexHandle, fragmentHandle);
+        if (ms != nullptr) {
+            *ms = (TestUtil::NowNs() - startNs) / 1e6;
+        }
+        return program;
+    }
+}
+
+int main() {
+    // the key and the file format need no context
+    const uint64_t key = GLUtils::ProgramCacheKey("a", "b", "driver");
+    CHECK(key == GLUtils::ProgramCacheKey("a", "b", "driver"));
+    CHECK(key != GLUtils::ProgramCacheKey("a", "b", "driver 2"));
+    CHECK(key != GLUtils::ProgramCacheKey("ab", "", "driver"));
+    CHECK(key != GLUtils::ProgramCacheKey("b", "a", "driver"));
+
+    const std::string fileDir = TestUtil::MakeTempDir("program_cache_file");
+    const std::vector<uint8_t> binary = {1, 2, 3, 4, 5};
+    CHECK(GLUtils::WriteProgramBinary(fileDir + "/p.bin", key, 0x1234, binary));
+    GLenum format = 0;
+    std::vector<uint8_t> read;
+    CHECK(GLUtils::ReadProgramBinary(fileDir + "/p.bin", key, format, read));
+    CHECK(format == 0x1234 && read == binary);
+    CHECK(!GLUtils::ReadProgramBinary(fileDir + "/p.bin", key + 1, format, read));
+    CHECK(!GLUtils::ReadProgramBinary(fileDir + "/missing.bin", key, format, read));
+    // a truncated file is not taken
+    CHECK(TestUtil::WriteFile(fileDir + "/short.bin", "CXPB"));
+    CHECK(!GLUtils::ReadProgramBinary(fileDir + "/short.bin", key, format, read));
+
+    GraphicsOptions options;
+    options.surfaceless = true;
+    std::shared_ptr<IGraphicsPlugin> graphics = CreateGraphicsPlugin(GraphicsApi_OpenGLES, options);
+    graphics->InitializeDevice();
+    cxrGraphicsContext context{};
+    if (!CHECK(graphics->GetCloudXRContext(&context))) {
+        return TestResult("ProgramCacheTest");
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (!CHECK(formats > 0)) {
+        fprintf(stderr, "the driver keeps no program binaries\n");
+        return TestResult("ProgramCacheTest");
+    }
+
+    // without a cache directory every program is compiled
+    const GLuint uncached = CreateProgram(kFragmentShader);
+    const uint32_t expected = Draw(uncached);
+    CHECK(expected != 0);
+    CHECK(GLUtils::GetProgramCacheStats().misses == 0);
+
+    // first launch: compiled and its binary written
+    const std::string dir = TestUtil::MakeTempDir("program_cache");
+    GLUtils::SetProgramCacheDir(dir);
+    double compileMs = 0;
+    GLuint program = CreateProgram(kFragmentShader, &compileMs);
+    CHECK(program != 0 && Draw(program) == expected);
+    CHECK(GLUtils::GetProgramCacheStats().misses == 1);
+    const std::string path = CachePath(dir, GLUtils::ProgramCacheKey(kVertexShader, kFragmentShader, GetDriver()));
+    std::vector<uint8_t> cached;
+    CHECK(GLUtils::ReadProgramBinary(path, GLUtils::ProgramCacheKey(kVertexShader, kFragmentShader, GetDriver()),
+                                     format, cached));
+    GLUtils::DeleteProgram(program);
+
+    // next launch: loaded from the file
+    GLUtils::SetProgramCacheDir(dir);
+    double loadMs = 0;
+    program = CreateProgram(kFragmentShader, &loadMs);
+    CHECK(program != 0 && Draw(program) == expected);
+    CHECK(GLUtils::GetProgramCacheStats().hits == 1);
+    CHECK(GLUtils::GetProgramCacheStats().misses == 0);
+    GLUtils::DeleteProgram(program);
+
+    // a binary the driver rejects, as after a driver update: compiled again and replaced
+    FILE *file = fopen(path.c_str(), "r+b");
+    if (CHECK(file != nullptr)) {
+        fseek(file, -16, SEEK_END);
+        const uint8_t garbage[16] = {0xde, 0xad, 0xbe, 0xef, 0xde, 0xad, 0xbe, 0xef,
+                                     0xde, 0xad, 0xbe, 0xef, 0xde, 0xad, 0xbe, 0xef};
+        fwrite(garbage, 1, sizeof(garbage), file);
+        fclose(file);
+    }
+    GLUtils::SetProgramCacheDir(dir);
+    program = CreateProgram(kFragmentShader);
+    CHECK(program != 0 && Draw(program) == expected);
+    const GLUtils::ProgramCacheStats stats = GLUtils::GetProgramCacheStats();
+    CHECK(stats.rejected == 1 && stats.misses == 1 && stats.hits == 0);
+    GLUtils::DeleteProgram(program);
+    GLUtils::SetProgramCacheDir(dir);
+    program = CreateProgram(kFragmentShader);
+    CHECK(GLUtils::GetProgramCacheStats().hits == 1);
+    GLUtils::DeleteProgram(program);
+
+    // warmed on a worker thread with a shared context: the render thread only loads
+    GLUtils::SetProgramCacheDir(TestUtil::MakeTempDir("program_cache_warm"));
+    GLUtils::WarmProgramCache((EGLDisplay) context.egl.display, (EGLContext) context.egl.context,
+                              {{kVertexShader, kFragmentShader}, {kVertexShader, kOtherFragmentShader}}).wait();
+    CHECK(eglGetCurrentContext() == (EGLContext) context.egl.context);
+    CHECK(GLUtils::GetProgramCacheStats().misses == 2);
+    program = CreateProgram(kOtherFragmentShader);
+    const uint32_t other = Draw(program);
+    CHECK(other != 0 && other != expected);
+    CHECK(GLUtils::GetProgramCacheStats().hits == 1 && GLUtils::GetProgramCacheStats().misses == 2);
+    GLUtils::DeleteProgram(program);
+
+    printf("{\"benchmark\":\"ProgramCache\",\"compileMs\":%.3f,\"loadMs\":%.3f,\"binaryBytes\":%zu}\n",
+           compileMs, loadMs, cached.size());
+    GLuint uncachedProgram = uncached;
+    GLUtils::DeleteProgram(uncachedProgram);
+    graphics->Shutdown();
+    return TestResult("ProgramCacheTest");
+}
@@ -0,0 +1,116 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Bursts of runtime events through PxrEventDispatcher: per-call limits, order, deferred polling
+// when the queue is nearly full, lost events and the polling thread.
+#include <string.h>
+#include <thread>
+#include <vector>
+#include "PxrEventDispatcher.h"
+#include "ClientFixture.h"
+#include "StandinPxr.h"
+
+namespace {
+    PxrEventDataBuffer MakeEvent(PxrStructureType type, uint32_t sequence) {
+        PxrEventDataBuffer event = {};
+        event.type = type;
+        memcpy(event.varying, &sequence, sizeof(sequence));
+        return event;
+    }
+
+    uint32_t GetSequence(const PxrEventDataBuffer &event) {
+        uint32_t sequence = 0;
+        memcpy(&sequence, event.varying, sizeof(sequence));
+        return sequence;
+    }
+
+    void PushBurst(uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; i++) {
+            const PxrStructureType type = i % 2 == 0 ? PXR_TYPE_EVENT_DATA_CONTROLLER : PXR_TYPE_EVENT_HARDIPD_STATE_CHANGED;
+            CHECK(StandinPxr::PushEvent(MakeEvent(type, i)));
+        }
+    }
+}
+
+int main() {
+    StandinPxr::Reset();
+    // the buffers are on the heap, so the dispatcher fits on android_main's stack
+    CHECK(sizeof(PxrEventDispatcher) < 4096);
+
+    PxrEventDispatcher dispatcher;
+    std::vector<uint32_t> handled;
+    handled.reserve(256);
+    std::thread::id handlerThread;
+    auto handler = [&](const PxrEventDataBuffer &event) {
+        handled.push_back(GetSequence(event));
+        handlerThread = std::this_thread::get_id();
+    };
+    dispatcher.SetHandler(PXR_TYPE_EVENT_DATA_CONTROLLER, handler);
+    dispatcher.SetHandler(PXR_TYPE_EVENT_HARDIPD_STATE_CHANGED, handler);
+
+    // a burst is spread over frames, at most maxEvents handlers each, in order
+    const uint32_t kBurst = 100;
+    const uint32_t kMaxEvents = 8;
+    PushBurst(0, kBurst);
+    uint32_t frames = 0;
+    while (handled.size() < kBurst && frames < 100) {
+        const size_t before = handled.size();
+        dispatcher.Dispatch(kMaxEvents);
+        CHECK(handled.size() - before <= kMaxEvents);
+        frames++;
+    }
+    CHECK(handled.size() == kBurst);
+    CHECK(frames == (kBurst + kMaxEvents - 1) / kMaxEvents);
+    for (uint32_t i = 0; i < handled.size(); i++) {
+        CHECK(handled[i] == i);
+    }
+    CHECK(dispatcher.GetDroppedCount() == 0);
+    CHECK(dispatcher.GetQueuedCount() == 0);
+
+    // while less than a full poll fits, the events wait in the runtime instead of being dropped
+    handled.clear();
+    PushBurst(0, 60);
+    dispatcher.Dispatch(0);
+    dispatcher.Dispatch(0);
+    dispatcher.Dispatch(0);
+    CHECK(dispatcher.GetQueuedCount() == 60);
+    dispatcher.Dispatch(0);
+    CHECK(dispatcher.GetQueuedCount() == 60);
+    CHECK(StandinPxr::GetPendingEventCount() == 0);
+    PushBurst(60, 40);
+    dispatcher.Dispatch(0);
+    CHECK(dispatcher.GetQueuedCount() == 60);
+    CHECK(StandinPxr::GetPendingEventCount() == 40);
+    while (handled.size() < 100 && frames < 1000) {
+        dispatcher.Dispatch(kMaxEvents);
+        frames++;
+    }
+    CHECK(handled.size() == 100);
+    CHECK(dispatcher.GetDroppedCount() == 0);
+    for (uint32_t i = 0; i < handled.size(); i++) {
+        CHECK(handled[i] == i);
+    }
+
+    // unhandled types are skipped, lost events are counted
+    PxrEventDataBuffer lost = {};
+    auto &lostData = (PxrEventDataEventsLost &) lost;
+    lostData.type = PXR_TYPE_EVENT_DATA_EVENTS_LOST;
+    lostData.lostEventCount = 5;
+    StandinPxr::PushEvent(lost);
+    StandinPxr::PushEvent(MakeEvent(PXR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED, 0));
+    handled.clear();
+    dispatcher.Dispatch(kMaxEvents);
+    CHECK(handled.empty());
+    CHECK(dispatcher.GetDroppedCount() == 5);
+
+    // with the polling thread the handlers still run on the dispatching thread
+    dispatcher.StartPollingThread(1);
+    PushBurst(0, 30);
+    CHECK(ClientFixture::WaitUntil([&]() { return dispatcher.GetQueuedCount() == 30; }, 2000));
+    while (handled.size() < 30 && frames < 2000) {
+        dispatcher.Dispatch(kMaxEvents);
+        frames++;
+    }
+    CHECK(handled.size() == 30);
+    CHECK(handlerThread == std::this_thread::get_id());
+    dispatcher.StopPollingThread();
+    return TestResult("PxrEventDispatcherTest");
+}
@@ -0,0 +1,93 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// RefreshRateController decisions on scripted stats windows: steps down and up, the cooldown
+// after a switch and the runtime's confirmation of it, step-up backoff and outside changes.
+#include "RefreshRateController.h"
+#include "TestUtil.h"
+
+namespace {
+    const float kRates[] = {90, 72, 120, 72, 0};
+
+    // frames per second and delivery time that keep up with 72 Hz and leave room for 90 Hz
+    const float kSteadyFps = 72;
+    const float kFastDeliveryMs = 5;
+
+    // Feeds windows until one returns a switch; returns the window it came in (1-based), 0 if none.
+    uint32_t WindowsUntilSwitch(RefreshRateController &controller, float fps, float deliveryMs, uint32_t maxWindows,
+                                float *rate) {
+        for (uint32_t window = 1; window <= maxWindows; window++) {
+            *rate = controller.OnWindow(fps, deliveryMs);
+            if (*rate > 0) {
+                return window;
+            }
+        }
+        return 0;
+    }
+}
+
+int main() {
+    RefreshRateController controller;
+    controller.SetAvailableRates(kRates, sizeof(kRates) / sizeof(kRates[0]));
+    CHECK(controller.GetRateCount() == 3);
+
+    // startup: no decision while the first cooldown runs, even with frames missing
+    controller.SetCurrentRate(90);
+    float rate = 0;
+    CHECK(WindowsUntilSwitch(controller, 50, kFastDeliveryMs, RefreshRateController::kCooldownWindows, &rate) == 0);
+    // then kDownWindows missed windows step down to the highest rate the frame rate covers
+    CHECK(WindowsUntilSwitch(controller, 60, kFastDeliveryMs, 10, &rate) == RefreshRateController::kDownWindows);
+    CHECK(rate == 72);
+    CHECK(controller.GetCurrentRate() == 72);
+    CHECK(controller.GetPendingRate() == 72);
+
+    // the runtime confirms the switch midway through the cooldown, reporting 71.99; that neither
+    // changes the rate nor starts the cooldown over, so the step up comes right after
+    // kCooldownWindows + kUpWindows windows
+    CHECK(controller.OnWindow(kSteadyFps, kFastDeliveryMs) == 0);
+    CHECK(controller.OnWindow(kSteadyFps, kFastDeliveryMs) == 0);
+    CHECK(!controller.OnRateChanged(71.99f));
+    CHECK(controller.GetPendingRate() == 0);
+    CHECK(controller.GetCurrentRate() == 72);
+    // a repeated event for the rate already running changes nothing either
+    CHECK(!controller.OnRateChanged(72));
+    const uint32_t upAfter = RefreshRateController::kCooldownWindows - 2 + RefreshRateController::kUpWindows;
+    CHECK(WindowsUntilSwitch(controller, kSteadyFps, kFastDeliveryMs, 40, &rate) == upAfter);
+    CHECK(rate == 90);
+    CHECK(!controller.OnRateChanged(90));
+
+    // a step up undone within the probation doubles the windows needed for the next one
+    CHECK(WindowsUntilSwitch(controller, 60, kFastDeliveryMs, 20,
+                             &rate) == RefreshRateController::kCooldownWindows + RefreshRateController::kDownWindows);
+    CHECK(rate == 72);
+    CHECK(!controller.OnRateChanged(72));
+    CHECK(WindowsUntilSwitch(controller, kSteadyFps, kFastDeliveryMs, 60,
+                             &rate) == RefreshRateController::kCooldownWindows + 2 * RefreshRateController::kUpWindows);
+    CHECK(rate == 90);
+    CHECK(!controller.OnRateChanged(90));
+
+    // no step up while the delivery time does not fit the higher rate's frame time
+    CHECK(WindowsUntilSwitch(controller, 90, 7.5f, 60, &rate) == 0);
+
+    // a rate the client did not ask for is taken as is and starts a cooldown
+    CHECK(controller.OnRateChanged(120));
+    CHECK(controller.GetCurrentRate() == 120);
+    CHECK(WindowsUntilSwitch(controller, 50, kFastDeliveryMs, RefreshRateController::kCooldownWindows, &rate) == 0);
+    CHECK(WindowsUntilSwitch(controller, 50, kFastDeliveryMs, 10, &rate) == RefreshRateController::kDownWindows);
+    // 50 fps is below 90% of every rate; the lowest one it is
+    CHECK(rate == 72);
+
+    // a switch the runtime refused: the caller restores the previous rate, nothing stays pending
+    controller.SetCurrentRate(120);
+    CHECK(controller.GetPendingRate() == 0);
+    CHECK(controller.GetCurrentRate() == 120);
+    // and a confirmation that differs from the pending switch is taken as the current rate
+    CHECK(WindowsUntilSwitch(controller, 80, kFastDeliveryMs, 20, &rate) > 0);
+    CHECK(rate == 72);
+    CHECK(controller.OnRateChanged(90));
+    CHECK(controller.GetCurrentRate() == 90);
+    CHECK(controller.GetPendingRate() == 0);
+
+    // a rate that is not one of the supported ones makes no decisions
+    controller.SetCurrentRate(60);
+    CHECK(WindowsUntilSwitch(controller, 20, kFastDeliveryMs, 30, &rate) == 0);
+    return TestResult("RefreshRateControllerTest");
+}
@@ -0,0 +1,152 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Shutdown: the sequence runs its steps in order and times them, its deadline ends a hung
+// teardown, and the app tears a streaming session down in dependency order, well within the
+// deadline, without tearing the client down a second time and without running exit handlers.
+#include <chrono>
+#include <stdlib.h>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <vector>
+#include "AppHarness.h"
+#include "AsyncLog.h"
+#include "ShutdownSequence.h"
+#include "StandinCloudXR.h"
+#include "StandinPxr.h"
+
+namespace {
+    // main.cpp's deadline
+    const uint32_t kDeadlineMs = 3000;
+    const uint32_t kStepMs = 20;
+
+    std::string gExitMarkerPath;
+
+    void WriteExitMarker() {
+        TestUtil::WriteFile(gExitMarkerPath, "exit handlers ran");
+    }
+
+    std::string ReadFile(const std::string &path) {
+        std::string contents;
+        FILE *file = fopen(path.c_str(), "r");
+        if (file == nullptr) {
+            return contents;
+        }
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            contents.append(buffer, read);
+        }
+        fclose(file);
+        return contents;
+    }
+
+    // The step names of the "shutdown <step>: <ms>ms" lines, in order.
+    std::vector<std::string> LoggedSteps(const std::string &log) {
+        std::vector<std::string> steps;
+        const std::string prefix = "shutdown ";
+        for (size_t pos = log.find(prefix); pos != std::string::npos; pos = log.find(prefix, pos + 1)) {
+            const size_t start = pos + prefix.size();
+            const size_t colon = log.find(": ", start);
+            const size_t end = log.find('\n', start);
+            if (colon != std::string::npos && colon < end && log.compare(start, 5, "total") != 0) {
+                steps.push_back(log.substr(start, colon - start));
+            }
+        }
+        return steps;
+    }
+}
+
+int main() {
+    // the app after streaming; first, because a child forked after this process started logging
+    // would wait for a log thread it does not have
+    StandinPxr::Reset();
+    StandinPxr::SetViewSize(256, 256);
+    StandinCloudXR::SetProfile(StandinServerProfile());
+    const std::string dir = TestUtil::MakeTempDir("shutdown");
+    const std::string logPath = dir + "/log.txt";
+    gExitMarkerPath = dir + "/exit_marker";
+    const AppRunResult result = RunApp("shutdown", "-s 127.0.0.1", [logPath](android_app *app) {
+        AsyncLog::SetFile(logPath.c_str());
+        atexit(WriteExitMarker);
+        StandinAndroid::PostCommand(app, APP_CMD_RESUME);
+        const uint64_t deadlineNs = TestUtil::NowNs() + 5000000000ULL;
+        while (StandinCloudXR::GetLastReceiver() == nullptr ||
+               StandinCloudXR::GetCounters(StandinCloudXR::GetLastReceiver()).framesLatched < 30) {
+            if (TestUtil::NowNs() > deadlineNs) {
+                CHECK(false);
+                return;
+            }
+            usleep(1000);
+        }
+    }, 20000);
+    CHECK(result.exited && result.exitStatus == 0);
+    TestUtil::Failures() += result.failures;
+    const double shutdownMs = (result.exitedNs - result.destroyPostedNs) / 1e6;
+    printf("{\"benchmark\":\"Shutdown\",\"destroyToExitMs\":%.1f}\n", shutdownMs);
+    CHECK(shutdownMs < kDeadlineMs / 2);
+
+    const std::string log = ReadFile(logPath);
+    // the log step stops the logger, its own line and the total do not make it
+    const std::vector<std::string> expected = {
+            "stats reporter", "soak report", "audio input", "receiver", "audio output", "haptics",
+            "options watcher", "save state", "event thread", "client", "eye layer", "pxr", "graphics"};
+    std::vector<std::string> steps = LoggedSteps(log);
+    steps.resize(std::min(steps.size(), expected.size()));
+    CHECK(steps == expected);
+    // the client was torn down by the steps, deleting it released nothing twice
+    CHECK(log.find("TeardownReceiver") == std::string::npos);
+    // the process ended with _exit() once the sequence was done
+    CHECK(access(gExitMarkerPath.c_str(), F_OK) != 0);
+
+    // steps run in order on the calling thread, the total covers all of them
+    {
+        ShutdownSequence sequence;
+        std::vector<int> order;
+        const std::thread::id caller = std::this_thread::get_id();
+        bool sameThread = true;
+        for (int i = 0; i < 3; i++) {
+            sequence.Add("step", [&order, &sameThread, caller, i]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(kStepMs));
+                order.push_back(i);
+                sameThread &= std::this_thread::get_id() == caller;
+            });
+        }
+        bool deadlineMissed = false;
+        sequence.SetDeadlineHandler([&deadlineMissed](const char *) { deadlineMissed = true; });
+        const double totalMs = sequence.Run(kDeadlineMs);
+        CHECK((order == std::vector<int>{0, 1, 2}));
+        CHECK(sameThread);
+        CHECK(totalMs >= 3 * kStepMs);
+        CHECK(!deadlineMissed);
+    }
+
+    // a step still running at the deadline is named to the handler
+    {
+        ShutdownSequence sequence;
+        sequence.Add("quick", []() {});
+        sequence.Add("hung", []() { std::this_thread::sleep_for(std::chrono::milliseconds(300)); });
+        std::string missedStep;
+        sequence.SetDeadlineHandler([&missedStep](const char *step) { missedStep = step; });
+        sequence.Run(100);
+        CHECK(missedStep == "hung");
+    }
+
+    // without a handler the deadline ends the process soon after it passes
+    {
+        fflush(nullptr);
+        const uint64_t startNs = TestUtil::NowNs();
+        const pid_t pid = fork();
+        if (pid == 0) {
+            ShutdownSequence sequence;
+            sequence.Add("hung", []() { std::this_thread::sleep_for(std::chrono::seconds(30)); });
+            sequence.Run(200);
+            _exit(1);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        const double elapsedMs = (TestUtil::NowNs() - startNs) / 1e6;
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        CHECK(elapsedMs >= 200 && elapsedMs < 2000);
+    }
+    return TestResult("ShutdownTest");
+}
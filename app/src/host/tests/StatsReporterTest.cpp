@@ -0,0 +1,103 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Checks that the thread and soak reports run on the StatsReporter's worker: requesting one from
+// an audited render_frame scope neither allocates nor locks, while reporting in place does, and
+// the worker logs the counters it was handed.
+#include <string>
+#include <unistd.h>
+#include "AllocationAudit.h"
+#include "AsyncLog.h"
+#include "SoakStats.h"
+#include "StatsReporter.h"
+#include "TestUtil.h"
+#include "ThreadManager.h"
+
+namespace {
+    bool WaitForReports(const StatsReporter &reporter, uint32_t count) {
+        const uint64_t deadlineNs = TestUtil::NowNs() + 5000000000ULL;
+        while (reporter.GetReportCount() < count) {
+            if (TestUtil::NowNs() > deadlineNs) {
+                return false;
+            }
+            usleep(1000);
+        }
+        return true;
+    }
+
+    std::string ReadFile(const std::string &path) {
+        std::string contents;
+        FILE *file = fopen(path.c_str(), "r");
+        if (file == nullptr) {
+            return contents;
+        }
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            contents.append(buffer, read);
+        }
+        fclose(file);
+        return contents;
+    }
+}
+
+int main() {
+    const std::string logPath = TestUtil::MakeTempDir("stats_reporter") + "/log.txt";
+    AsyncLog::SetFile(logPath.c_str());
+    ThreadManager::RegisterCurrentThread(ThreadRole_Render, "StatsTest");
+
+    SoakStats soak;
+    soak.Start(0);
+    soak.OnLatch(true, false, 10);
+    soak.OnLatch(false, false, 20);
+    soak.OnLatch(true, false, 30);
+
+    StatsReporter reporter;
+    reporter.Start();
+    // the worker's first report registers it, stdio buffers and all, before anything is armed
+    CHECK(reporter.Request(soak.GetCounters(), 0, 40));
+    CHECK(WaitForReports(reporter, 1));
+
+    AllocationAudit::SetFatal(false);
+    AllocationAudit::Arm();
+
+    // what the render thread does every tenth stats window
+    const uint64_t threadAllocations = AllocationAudit::GetThreadAllocationCount();
+    {
+        ALLOCATION_AUDIT_SCOPE("render_frame");
+        CHECK(reporter.Request(soak.GetCounters(), 7, 60000));
+    }
+    CHECK(AllocationAudit::GetThreadAllocationCount() == threadAllocations);
+    CHECK(AllocationAudit::GetViolationCount() == 0);
+    CHECK(AllocationAudit::GetLockViolationCount() == 0);
+    CHECK(WaitForReports(reporter, 2));
+
+    // reporting in place, as the render thread used to, allocates in the scope
+    {
+        ALLOCATION_AUDIT_SCOPE("render_frame");
+        ThreadManager::LogStats();
+        soak.Report(7, 60000);
+    }
+    CHECK(AllocationAudit::GetViolationCount() > 0);
+    CHECK(AllocationAudit::GetLockViolationCount() > 0);
+
+    // requests faster than the worker reports replace each other or are skipped while it copies
+    // one, none is lost past the last; none of them waits for the worker
+    const uint32_t before = reporter.GetReportCount();
+    const uint64_t locks = AllocationAudit::GetLockViolationCount();
+    for (uint32_t i = 0; i < 100; i++) {
+        ALLOCATION_AUDIT_SCOPE("render_frame");
+        CHECK(reporter.Request(soak.GetCounters(), i, 60000));
+    }
+    CHECK(AllocationAudit::GetLockViolationCount() == locks);
+    CHECK(WaitForReports(reporter, before + 1));
+    reporter.Stop();
+    CHECK(reporter.GetReportCount() <= before + 100);
+    CHECK(!reporter.Request(soak.GetCounters(), 0, 60000));
+
+    AsyncLog::Flush();
+    const std::string log = ReadFile(logPath);
+    CHECK(log.find("soak 1.0min held:1/3") != std::string::npos);
+    CHECK(log.find("underruns:7") != std::string::npos);
+    CHECK(log.find("threadstats StatsReport(worker)") != std::string::npos);
+    CHECK(log.find("threadstats StatsTest(render)") != std::string::npos);
+    return TestResult("StatsReporterTest");
+}
@@ -0,0 +1,188 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// Plays scripted bandwidth traces through StreamQualityController, with a simulated connection
+// that carries the applied bitrate and reconnects when the controller asks for it: a clean
+// link, a bandwidth drop and its recovery, loss spikes, the quality levels CloudXR reports and
+// the policy bounds.
+#include <CloudXRClient.h>
+#include "StreamQualityController.h"
+#include "TestUtil.h"
+
+namespace {
+    // one stretch of a trace
+    struct TraceStep {
+        uint32_t windows;
+        uint32_t availableKbps;
+        float lossRatio;
+        cxrConnectionQuality quality;
+        uint32_t reasons;
+    };
+
+    // What a connection does with the controller: carries min(applied bitrate, available
+    // bandwidth), 1 packet per 10 kbit, and reconnects with the target when asked to.
+    struct Connection {
+        StreamQualityController controller;
+        bool reconnectMode = false;
+        uint32_t reconnects = 0;
+        uint32_t targetChanges = 0;
+        uint32_t packetsReceived = 0;
+        uint32_t packetsLost = 0;
+
+        explicit Connection(const StreamQualityPolicy &policy = StreamQualityPolicy()) {
+            controller.SetPolicy(policy);
+            controller.SetApplied(controller.GetTarget());
+        }
+
+        void Play(const TraceStep &step) {
+            for (uint32_t window = 0; window < step.windows; window++) {
+                const uint32_t applied = controller.GetApplied().bitrateKbps;
+                const uint32_t utilization = step.availableKbps < applied ? step.availableKbps : applied;
+                const uint32_t packets = utilization / 10;
+                const uint32_t lost = uint32_t(packets * step.lossRatio);
+                packetsReceived += packets - lost;
+                packetsLost += lost;
+
+                StreamQualityStats stats;
+                stats.bandwidthAvailableKbps = step.availableKbps;
+                stats.bandwidthUtilizationKbps = utilization;
+                stats.totalPacketsReceived = packetsReceived;
+                stats.totalPacketsLost = packetsLost;
+                stats.quality = step.quality;
+                stats.qualityReasons = step.reasons;
+                if (controller.OnWindow(stats)) {
+                    targetChanges++;
+                }
+                if (reconnectMode && controller.ShouldReconnect()) {
+                    Reconnect();
+                }
+            }
+        }
+
+        void Reconnect() {
+            reconnects++;
+            controller.SetApplied(controller.GetTarget());
+            packetsReceived = 0;
+            packetsLost = 0;
+        }
+    };
+
+    const cxrConnectionQuality kGood = cxrConnectionQuality_Good;
+    const cxrConnectionQuality kPoor = cxrConnectionQuality_Poor;
+    const uint32_t kLowBandwidth = cxrConnectionQualityReason_LowBandwidth;
+    const uint32_t kHighLatency = cxrConnectionQualityReason_HighLatency;
+    const uint32_t kHighPacketLoss = cxrConnectionQualityReason_HighPacketLoss;
+}
+
+int main() {
+    const StreamQualityPolicy policy;
+
+    // a clean link with room to spare keeps the best settings
+    {
+        Connection connection;
+        connection.reconnectMode = true;
+        connection.Play({120, 200000, 0, cxrConnectionQuality_Excellent, 0});
+        const StreamQualitySettings &target = connection.controller.GetTarget();
+        CHECK(target.bitrateKbps == policy.maxBitrateKbps);
+        CHECK(target.resFactor == policy.maxResFactor);
+        CHECK(target.foveation == policy.minFoveation);
+        CHECK(connection.targetChanges == 0);
+        CHECK(connection.reconnects == 0);
+    }
+
+    // the link drops to 30 Mbps: the first window cuts the target below the bandwidth, resolution
+    // and foveation step down the ladder, and the settings reach the connection with a reconnect
+    // once the connection was poor long enough
+    {
+        Connection connection;
+        connection.reconnectMode = true;
+        connection.Play({1, 30000, 0, kPoor, kLowBandwidth});
+        const StreamQualitySettings &target = connection.controller.GetTarget();
+        CHECK(target.bitrateKbps <= uint32_t(30000 * StreamQualityController::kBandwidthShare));
+        CHECK(target.resFactor < policy.maxResFactor);
+        CHECK(target.foveation > policy.minFoveation);
+        CHECK(connection.reconnects == 0);
+        connection.Play({StreamQualityController::kReconnectCooldownWindows - 2, 30000, 0, kPoor, kLowBandwidth});
+        CHECK(connection.reconnects == 0);
+        connection.Play({1, 30000, 0, kPoor, kLowBandwidth});
+        CHECK(connection.reconnects == 1);
+        const StreamQualitySettings applied = connection.controller.GetApplied();
+        CHECK(applied.bitrateKbps <= 30000);
+        CHECK(applied.bitrateKbps >= policy.minBitrateKbps);
+
+        // the reduced stream fits the link; the target no longer compounds and no reconnect follows
+        connection.Play({StreamQualityController::kReconnectCooldownWindows * 2, 30000, 0, kGood, 0});
+        CHECK(connection.reconnects == 1);
+        CHECK(connection.controller.GetTarget().bitrateKbps <= uint32_t(30000 * StreamQualityController::kBandwidthShare));
+        CHECK(connection.controller.GetTarget().bitrateKbps >= applied.bitrateKbps);
+
+        // the link recovers: kIncreaseStepKbps every kIncreaseWindows clean windows, back up to
+        // the best settings; the resolution only comes back with the bitrate
+        const uint32_t steps = (policy.maxBitrateKbps - connection.controller.GetTarget().bitrateKbps) /
+                               StreamQualityController::kIncreaseStepKbps + 1;
+        connection.Play({steps * StreamQualityController::kIncreaseWindows / 2, 200000, 0, kGood, 0});
+        CHECK(connection.controller.GetTarget().bitrateKbps < policy.maxBitrateKbps);
+        CHECK(connection.controller.GetTarget().resFactor < policy.maxResFactor);
+        connection.Play({steps * StreamQualityController::kIncreaseWindows, 200000, 0, kGood, 0});
+        CHECK(connection.controller.GetTarget().bitrateKbps == policy.maxBitrateKbps);
+        CHECK(connection.controller.GetTarget().resFactor == policy.maxResFactor);
+        CHECK(connection.controller.GetTarget().foveation == policy.minFoveation);
+        // a good connection is not worth a reconnect, however far the target moved
+        CHECK(connection.reconnects == 1);
+    }
+
+    // packet loss: each lossy window cuts relative to the applied bitrate, so a burst of them does
+    // not compound before the next connect
+    {
+        Connection connection;
+        connection.Play({1, 200000, 0.05f, kGood, 0});
+        const uint32_t cut = uint32_t(policy.maxBitrateKbps * StreamQualityController::kDecreaseFactor);
+        CHECK(connection.controller.GetTarget().bitrateKbps == cut);
+        connection.Play({5, 200000, 0.05f, kGood, kHighPacketLoss});
+        CHECK(connection.controller.GetTarget().bitrateKbps == cut);
+        // loss under kCongestedLossRatio is tolerated
+        connection.Play({StreamQualityController::kIncreaseWindows, 200000, 0.01f, kGood, 0});
+        CHECK(connection.controller.GetTarget().bitrateKbps == cut + StreamQualityController::kIncreaseStepKbps);
+    }
+
+    // what counts as poor: unstable, bad and poor with a reason; not while CloudXR is still
+    // estimating, and not fair
+    {
+        const cxrConnectionQuality qualities[] = {cxrConnectionQuality_Unstable, cxrConnectionQuality_Bad,
+                                                  cxrConnectionQuality_Poor, cxrConnectionQuality_Fair};
+        for (cxrConnectionQuality quality : qualities) {
+            Connection connection;
+            connection.reconnectMode = true;
+            // lower the target first, then keep the link clean
+            connection.Play({1, 30000, 0, kGood, kLowBandwidth});
+            connection.Play({StreamQualityController::kReconnectCooldownWindows, 30000, 0, quality, kHighLatency});
+            CHECK(connection.reconnects == (quality <= cxrConnectionQuality_Poor ? 1u : 0u));
+        }
+        Connection estimating;
+        estimating.reconnectMode = true;
+        estimating.Play({1, 30000, 0, kGood, kLowBandwidth});
+        estimating.Play({StreamQualityController::kReconnectCooldownWindows, 30000, 0, cxrConnectionQuality_Bad,
+                         cxrConnectionQualityReason_EstimatingQuality});
+        CHECK(estimating.reconnects == 0);
+        // without the reconnect mode the settings wait for the next connect
+        Connection onConnect;
+        onConnect.Play({StreamQualityController::kReconnectCooldownWindows * 2, 30000, 0, kPoor, kLowBandwidth});
+        CHECK(onConnect.reconnects == 0);
+        CHECK(onConnect.controller.ShouldReconnect());
+    }
+
+    // a 5 Mbps link: the target stops at the policy minimum and the lowest level
+    {
+        StreamQualityPolicy narrow;
+        narrow.minFoveation = 20;
+        Connection connection(narrow);
+        connection.reconnectMode = true;
+        connection.Play({StreamQualityController::kReconnectCooldownWindows * 2, 5000, 0.1f, kPoor,
+                         kLowBandwidth | kHighPacketLoss});
+        const StreamQualitySettings &target = connection.controller.GetTarget();
+        CHECK(target.bitrateKbps == narrow.minBitrateKbps);
+        CHECK(target.resFactor == narrow.minResFactor);
+        CHECK(target.foveation == narrow.maxFoveation);
+        CHECK(connection.reconnects == 1);
+        CHECK(connection.controller.GetApplied().bitrateKbps == narrow.minBitrateKbps);
+    }
+    return TestResult("StreamQualityControllerTest");
+}
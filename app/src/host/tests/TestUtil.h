@@ -0,0 +1,64 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_HOST_TEST_UTIL_H
+#define CLIENT_HOST_TEST_UTIL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <time.h>
+
+// Failures are counted and reported, the test goes on; main() returns TestResult().
+#define CHECK(condition) TestUtil::Check((condition), #condition, __FILE__, __LINE__)
+
+namespace TestUtil {
+    inline int &Failures() {
+        static int failures = 0;
+        return failures;
+    }
+
+    inline bool Check(bool condition, const char *text, const char *file, int line) {
+        if (!condition) {
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, text);
+            Failures()++;
+        }
+        return condition;
+    }
+
+    inline uint64_t NowNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+    // A new empty directory under $TMPDIR, left behind for inspection.
+    inline std::string MakeTempDir(const char *name) {
+        const char *tmp = getenv("TMPDIR");
+        std::string path = std::string(tmp != nullptr ? tmp : "/tmp") + "/" + name + "XXXXXX";
+        if (mkdtemp(&path[0]) == nullptr) {
+            perror("mkdtemp");
+            exit(2);
+        }
+        return path;
+    }
+
+    inline bool WriteFile(const std::string &path, const std::string &contents) {
+        FILE *file = fopen(path.c_str(), "w");
+        if (file == nullptr) {
+            return false;
+        }
+        fputs(contents.c_str(), file);
+        return fclose(file) == 0;
+    }
+}
+
+inline int TestResult(const char *name) {
+    if (TestUtil::Failures() == 0) {
+        printf("%s: passed\n", name);
+        return 0;
+    }
+    printf("%s: %d check(s) failed\n", name, TestUtil::Failures());
+    return 1;
+}
+
+#endif //CLIENT_HOST_TEST_UTIL_H
@@ -0,0 +1,214 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+// ThreadManager on Linux: the affinity and priority launch options are parsed into per-role
+// policies, applied to threads registered before and after Configure(), and checked with
+// sched_getaffinity and getpriority; dropping them gives the threads their defaults back. Then
+// the slot table running full: the threads left out are counted once, logged once and keep
+// their scheduling, and a freed slot is used again.
+#include <atomic>
+#include <memory>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include "AsyncLog.h"
+#include "TestUtil.h"
+#include "ThreadManager.h"
+
+namespace {
+    const uint32_t kMaxThreads = 6;
+
+    uint64_t GetAffinity(int tid) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(tid, sizeof(set), &set) != 0) {
+            return 0;
+        }
+        uint64_t mask = 0;
+        for (uint32_t cpu = 0; cpu < 64; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                mask |= 1ULL << cpu;
+            }
+        }
+        return mask;
+    }
+
+    int GetNice(int tid) {
+        return getpriority(PRIO_PROCESS, tid);
+    }
+
+    // A thread that registers with a role and stays until released.
+    class RoleThread {
+
+    public:
+        RoleThread(ThreadRole role, const char *name) : mThread([this, role, name]() {
+            ThreadManager::RegisterCurrentThread(role, name);
+            mTid = int(syscall(SYS_gettid));
+            while (!mReleased.load()) {
+                usleep(1000);
+            }
+        }) {
+            while (mTid.load() == 0) {
+                usleep(100);
+            }
+        }
+
+        ~RoleThread() {
+            mReleased = true;
+            mThread.join();
+        }
+
+        int GetTid() const { return mTid.load(); }
+
+    private:
+        std::atomic<int> mTid{0};
+        std::atomic<bool> mReleased{false};
+        std::thread mThread;
+    };
+
+    bool HasThread(const char *name) {
+        ThreadStats stats[64];
+        const uint32_t count = ThreadManager::GetStats(stats, 64);
+        for (uint32_t i = 0; i < count; i++) {
+            if (std::string(stats[i].name) == name) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint32_t CountOccurrences(const std::string &text, const std::string &pattern) {
+        uint32_t count = 0;
+        for (size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + 1)) {
+            count++;
+        }
+        return count;
+    }
+
+    std::string ReadFile(const std::string &path) {
+        std::string contents;
+        FILE *file = fopen(path.c_str(), "r");
+        if (file == nullptr) {
+            return contents;
+        }
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            contents.append(buffer, read);
+        }
+        fclose(file);
+        return contents;
+    }
+}
+
+int main() {
+    // a small table, so that it runs full below
+    CHECK(ThreadManager::SetMaxThreads(kMaxThreads));
+    const std::string logPath = TestUtil::MakeTempDir("thread_manager") + "/log.txt";
+    AsyncLog::SetFile(logPath.c_str());
+
+    const uint64_t all = ThreadManager::GetCoreMask("all");
+    const long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    CHECK(all == (cpus >= 64 ? ~0ULL : (1ULL << cpus) - 1));
+    // without cpufreq information, or with one cluster, big and little are every core
+    const uint64_t big = ThreadManager::GetCoreMask("big");
+    const uint64_t little = ThreadManager::GetCoreMask("little");
+    CHECK(big != 0 && (big & ~all) == 0);
+    CHECK(little != 0 && (little & ~all) == 0);
+    CHECK((big == all && little == all) || (big & little) == 0);
+    CHECK(ThreadManager::GetCoreMask("medium") == 0);
+
+    // parsing: defaults for the roles not listed, valid entries kept next to invalid ones
+    ThreadPolicy policies[ThreadRole_Count];
+    CHECK(ThreadManager::ParsePolicies("", "", policies));
+    CHECK(policies[ThreadRole_Render].setPriority && policies[ThreadRole_Render].nice == ThreadManager::kDisplayNice);
+    CHECK(policies[ThreadRole_Tracking].setPriority && policies[ThreadRole_Tracking].nice == ThreadManager::kDisplayNice);
+    CHECK(!policies[ThreadRole_Audio].setPriority && policies[ThreadRole_Audio].cpuMask == 0);
+    CHECK(!policies[ThreadRole_Worker].setPriority && policies[ThreadRole_Worker].cpuMask == 0);
+
+    CHECK(ThreadManager::ParsePolicies("render:big,audio:0x1,worker:all", "worker:10,audio:-2", policies));
+    CHECK(policies[ThreadRole_Render].cpuMask == big);
+    CHECK(policies[ThreadRole_Audio].cpuMask == 0x1);
+    CHECK(policies[ThreadRole_Worker].cpuMask == all);
+    CHECK(policies[ThreadRole_Tracking].cpuMask == 0);
+    CHECK(policies[ThreadRole_Worker].setPriority && policies[ThreadRole_Worker].nice == 10);
+    CHECK(policies[ThreadRole_Audio].setPriority && policies[ThreadRole_Audio].nice == -2);
+
+    CHECK(!ThreadManager::ParsePolicies("render:fast,gpu:big,audio,worker:0x2", "worker:20,render:x,tracking:3", policies));
+    CHECK(policies[ThreadRole_Render].cpuMask == 0);
+    CHECK(policies[ThreadRole_Worker].cpuMask == 0x2);
+    CHECK(!policies[ThreadRole_Worker].setPriority);
+    CHECK(policies[ThreadRole_Render].nice == ThreadManager::kDisplayNice);
+    CHECK(policies[ThreadRole_Tracking].nice == 3);
+
+    // applied on registration and by Configure() to the threads already registered; raising the
+    // nice value needs no privilege, lowering it again does
+    const uint64_t lastCpu = 1ULL << (cpus >= 64 ? 63 : cpus - 1);
+    const int originalNice = GetNice(int(syscall(SYS_gettid)));
+    {
+        RoleThread before(ThreadRole_Worker, "WorkerBefore");
+        CHECK(HasThread("WorkerBefore"));
+        CHECK(GetAffinity(before.GetTid()) == GetAffinity(0));
+        CHECK(GetNice(before.GetTid()) == originalNice);
+
+        char affinity[64];
+        snprintf(affinity, sizeof(affinity), "worker:0x%llx", (unsigned long long) lastCpu);
+        CHECK(ThreadManager::Configure(affinity, "worker:7"));
+        CHECK(GetAffinity(before.GetTid()) == lastCpu);
+        CHECK(GetNice(before.GetTid()) == 7);
+
+        RoleThread after(ThreadRole_Worker, "WorkerAfter");
+        CHECK(GetAffinity(after.GetTid()) == lastCpu);
+        CHECK(GetNice(after.GetTid()) == 7);
+        // other roles keep their defaults
+        RoleThread audio(ThreadRole_Audio, "Audio");
+        CHECK(GetAffinity(audio.GetTid()) == GetAffinity(0));
+        CHECK(GetNice(audio.GetTid()) == originalNice);
+
+        // dropped: every core again, and the nice value the thread started with
+        CHECK(ThreadManager::Configure("", ""));
+        CHECK(GetAffinity(before.GetTid()) == all);
+        if (geteuid() == 0) {
+            CHECK(GetNice(before.GetTid()) == originalNice);
+        }
+        CHECK(!ThreadManager::Configure("worker:none", ""));
+    }
+    // exited threads give their slots back
+    CHECK(!HasThread("WorkerBefore"));
+    CHECK(!HasThread("WorkerAfter"));
+
+    // the table is sized once
+    CHECK(!ThreadManager::SetMaxThreads(64));
+
+    // every slot taken: the threads left out are counted and logged once, whatever they call
+    ThreadManager::RegisterCurrentThread(ThreadRole_Render, "Main");
+    std::vector<std::unique_ptr<RoleThread>> fillers;
+    while (ThreadManager::GetUnregisteredCount() == 0 && fillers.size() < kMaxThreads) {
+        fillers.emplace_back(new RoleThread(ThreadRole_Worker, "Filler"));
+    }
+    CHECK(ThreadManager::GetUnregisteredCount() == 1);
+    CHECK(!HasThread("Overflow"));
+    std::thread overflow([]() {
+        for (uint32_t i = 0; i < 10000; i++) {
+            ThreadManager::RegisterCurrentThread(ThreadRole_Audio, "Overflow");
+        }
+    });
+    overflow.join();
+    CHECK(ThreadManager::GetUnregisteredCount() == 2);
+    CHECK(!HasThread("Overflow"));
+
+    // a freed slot is used again
+    fillers.erase(fillers.begin());
+    {
+        RoleThread late(ThreadRole_Worker, "Late");
+        CHECK(HasThread("Late"));
+    }
+    CHECK(ThreadManager::GetUnregisteredCount() == 2);
+    fillers.clear();
+
+    AsyncLog::Flush();
+    CHECK(CountOccurrences(ReadFile(logPath), "not registered, all 6 slots in use") == 1);
+    return TestResult("ThreadManagerTest");
+}
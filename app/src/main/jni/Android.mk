@@ -46,7 +46,44 @@ LOCAL_C_INCLUDES := $(PXR_SDK_ROOT)/include \
 LOCAL_SRC_FILES := ../src/main.cpp \
 				   ../src/CloudXRClientPXR.cpp \
                    ../src/graphicsplugin_opengles.cpp \
+                   ../src/graphicsplugin_factory.cpp \
                    ../src/GLUtils.cpp \
+                   ../src/PxrDeviceState.cpp \
+                   ../src/RenderTargetPool.cpp \
+                   ../src/PxrEventDispatcher.cpp \
+                   ../src/LoopScheduler.cpp \
+                   ../src/AsyncLog.cpp \
+                   ../src/HapticsScheduler.cpp \
+                   ../src/LatencyTracker.cpp \
+                   ../src/PredictionCalibrator.cpp \
+                   ../src/RefreshRateController.cpp \
+                   ../src/StreamQualityController.cpp \
+                   ../src/AllocationAudit.cpp \
+                   ../src/ThreadManager.cpp \
+                   ../src/LaunchOptionsStore.cpp \
+                   ../src/StartupTimeline.cpp \
+                   ../src/ShutdownSequence.cpp \
+                   ../src/AudioStreamSupervisor.cpp \
+                   ../src/MicroBenchmark.cpp \
+                   ../src/FaultInjector.cpp \
+                   ../src/SoakStats.cpp \
+                   ../src/StatsReporter.cpp \
+                   ../src/InputSampler.cpp \
+                   ../src/PoseFilter.cpp \
+
+# ndk-build CXR_ALLOCATION_AUDIT=1 counts heap allocations on the per-frame paths
+ifeq ($(CXR_ALLOCATION_AUDIT),1)
+LOCAL_CFLAGS += -DCXR_ALLOCATION_AUDIT
+endif
+
+# the fault-injection launch option only works in debug builds; ndk-build CXR_FAULT_INJECTION=1
+# adds it to a release build for a soak
+ifeq ($(NDK_DEBUG),1)
+CXR_FAULT_INJECTION ?= 1
+endif
+ifeq ($(CXR_FAULT_INJECTION),1)
+LOCAL_CFLAGS += -DCXR_FAULT_INJECTION
+endif
 
 LOCAL_LDLIBS := -llog -landroid -lGLESv3 -lEGL
 LOCAL_STATIC_LIBRARIES	:= android_native_app_glue
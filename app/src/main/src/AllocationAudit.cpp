@@ -0,0 +1,379 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "AllocationAudit.h"
+#include <atomic>
+#include <errno.h>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "util.h"
+
+#ifdef __ANDROID__
+#include <android/set_abort_message.h>
+#endif
+
+// glibc lets the program replace malloc; everything else only sees operator new
+#if defined(CXR_ALLOCATION_AUDIT) && defined(__GLIBC__)
+#define CXR_ALLOCATION_AUDIT_MALLOC
+#include <dlfcn.h>
+#include <link.h>
+#include <pthread.h>
+
+// glibc's own entry points do the work, so blocks from these, from the variants not replaced
+// below (valloc, pvalloc) and from before main() can all be freed by either side
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *p);
+}
+#endif
+
+namespace {
+    std::atomic<bool> gArmed{false};
+    std::atomic<bool> gFatal{true};
+    std::atomic<const char *> gScopeNames[AllocationAudit::kMaxScopes];
+    std::atomic<uint64_t> gScopeCounts[AllocationAudit::kMaxScopes];
+    std::atomic<uint64_t> gScopeLocks[AllocationAudit::kMaxScopes];
+    std::atomic<uint64_t> gViolations{0};
+    std::atomic<uint64_t> gLockViolations{0};
+    uint32_t gStreamingFrames = 0;
+
+    // innermost scope of the calling thread
+    thread_local const char *tScope = nullptr;
+    // every allocation of the calling thread, armed or not
+    thread_local uint64_t tAllocations = 0;
+
+#ifdef CXR_ALLOCATION_AUDIT_MALLOC
+    // code of the modules whose malloc calls count, found by Arm()
+    struct CodeRange {
+        uintptr_t start;
+        uintptr_t end;
+    };
+    const uint32_t kMaxCodeRanges = 16;
+    CodeRange gCodeRanges[kMaxCodeRanges];
+    std::atomic<uint32_t> gCodeRangeCount{0};
+
+    // the program itself and the C and C++ runtimes; not the graphics driver, which Android
+    // does not let the audit see either
+    bool IsAuditedModule(const char *name) {
+        return name[0] == '\0' || strstr(name, "/libc.so") != nullptr || strstr(name, "/libstdc++.so") != nullptr;
+    }
+
+    int AddCodeRanges(struct dl_phdr_info *info, size_t, void *) {
+        if (!IsAuditedModule(info->dlpi_name)) {
+            return 0;
+        }
+        uint32_t count = gCodeRangeCount.load(std::memory_order_relaxed);
+        for (int i = 0; i < info->dlpi_phnum && count < kMaxCodeRanges; i++) {
+            const ElfW(Phdr) &header = info->dlpi_phdr[i];
+            if (header.p_type == PT_LOAD && (header.p_flags & PF_X) != 0) {
+                gCodeRanges[count].start = info->dlpi_addr + header.p_vaddr;
+                gCodeRanges[count].end = info->dlpi_addr + header.p_vaddr + header.p_memsz;
+                count++;
+            }
+        }
+        gCodeRangeCount.store(count, std::memory_order_release);
+        return 0;
+    }
+
+    void FindCodeRanges() {
+        if (gCodeRangeCount.load(std::memory_order_acquire) == 0) {
+            dl_iterate_phdr(AddCodeRanges, nullptr);
+        }
+    }
+
+    bool IsAuditedCaller(const void *caller) {
+        const uint32_t count = gCodeRangeCount.load(std::memory_order_acquire);
+        const uintptr_t address = uintptr_t(caller);
+        for (uint32_t i = 0; i < count; i++) {
+            if (address >= gCodeRanges[i].start && address < gCodeRanges[i].end) {
+                return true;
+            }
+        }
+        return false;
+    }
+#endif
+
+#ifdef CXR_ALLOCATION_AUDIT
+    // Runs inside the allocator or a lock: no allocation and no log, only write() and abort().
+    [[noreturn]] void AbortInScope(const char *what, const char *scope) {
+        char message[160] = "Allocation audit: ";
+        strcat(message, what);
+        strcat(message, " in ");
+        strncat(message, scope, sizeof(message) - strlen(message) - 2);
+        strcat(message, "\n");
+        ssize_t written = write(STDERR_FILENO, message, strlen(message));
+        (void) written;
+#ifdef __ANDROID__
+        android_set_abort_message(message);
+#endif
+        abort();
+    }
+
+    // The slot of a scope in the report tables; names are literals, so comparing pointers is
+    // enough. kMaxScopes when the tables are full.
+    uint32_t FindScope(const char *scope) {
+        for (uint32_t i = 0; i < AllocationAudit::kMaxScopes; i++) {
+            const char *name = gScopeNames[i].load(std::memory_order_acquire);
+            if (name == nullptr) {
+                const char *expected = nullptr;
+                if (gScopeNames[i].compare_exchange_strong(expected, scope, std::memory_order_acq_rel)) {
+                    name = scope;
+                } else {
+                    name = expected;
+                }
+            }
+            if (name == scope) {
+                return i;
+            }
+        }
+        return AllocationAudit::kMaxScopes;
+    }
+
+    // caller is the code that called malloc or operator new; only used with the malloc hooks
+    void RecordAllocation(const void *caller) {
+        tAllocations++;
+        const char *scope = tScope;
+        if (scope == nullptr || !gArmed.load(std::memory_order_relaxed)) {
+            return;
+        }
+#ifdef CXR_ALLOCATION_AUDIT_MALLOC
+        if (!IsAuditedCaller(caller)) {
+            return;
+        }
+#endif
+        gViolations.fetch_add(1, std::memory_order_relaxed);
+        if (gFatal.load(std::memory_order_relaxed)) {
+            AbortInScope("allocation", scope);
+        }
+        const uint32_t slot = FindScope(scope);
+        if (slot < AllocationAudit::kMaxScopes) {
+            gScopeCounts[slot].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+#ifdef CXR_ALLOCATION_AUDIT_MALLOC
+    // caller is the code that took the lock; try-locks do not count, they never wait
+    void RecordLock(const void *caller) {
+        const char *scope = tScope;
+        if (scope == nullptr || !gArmed.load(std::memory_order_relaxed) || !IsAuditedCaller(caller)) {
+            return;
+        }
+        gLockViolations.fetch_add(1, std::memory_order_relaxed);
+        if (gFatal.load(std::memory_order_relaxed)) {
+            AbortInScope("lock", scope);
+        }
+        const uint32_t slot = FindScope(scope);
+        if (slot < AllocationAudit::kMaxScopes) {
+            gScopeLocks[slot].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // libc's lock functions, looked up before main() so that no lock waits for dlsym
+    typedef int (*MutexLock)(pthread_mutex_t *);
+    typedef int (*RwLock)(pthread_rwlock_t *);
+    MutexLock gMutexLock;
+    RwLock gRwLockRead;
+    RwLock gRwLockWrite;
+
+    __attribute__((constructor(101))) void FindLockFunctions() {
+        gMutexLock = (MutexLock) dlsym(RTLD_NEXT, "pthread_mutex_lock");
+        gRwLockRead = (RwLock) dlsym(RTLD_NEXT, "pthread_rwlock_rdlock");
+        gRwLockWrite = (RwLock) dlsym(RTLD_NEXT, "pthread_rwlock_wrlock");
+    }
+#endif
+
+    // For operator new: counted by the code that called it, not as a malloc() of this file, so
+    // other libraries' new calls that the replacement receives as well are told apart.
+    void *AuditedAlloc(size_t size, const void *caller) {
+        RecordAllocation(caller);
+#ifdef CXR_ALLOCATION_AUDIT_MALLOC
+        return __libc_malloc(size == 0 ? 1 : size);
+#else
+        return malloc(size == 0 ? 1 : size);
+#endif
+    }
+
+    void *AuditedAllocOrThrow(size_t size, const void *caller) {
+        void *p = AuditedAlloc(size, caller);
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+#endif
+}
+
+namespace AllocationAudit {
+    void Arm() {
+#ifdef CXR_ALLOCATION_AUDIT_MALLOC
+        FindCodeRanges();
+#endif
+        gArmed.store(true);
+    }
+
+    void OnStreamingFrame() {
+        gStreamingFrames++;
+        if (gStreamingFrames == kWarmupFrames) {
+            LOGI("Allocation audit armed after %u streaming frames", gStreamingFrames);
+            Arm();
+        } else if (gStreamingFrames > kWarmupFrames && (gStreamingFrames - kWarmupFrames) % kReportFrames == 0) {
+            Report();
+        }
+    }
+
+    bool IsArmed() {
+        return gArmed.load(std::memory_order_relaxed);
+    }
+
+    void SetFatal(bool fatal) {
+        gFatal.store(fatal);
+    }
+
+    uint64_t GetViolationCount() {
+        return gViolations.load(std::memory_order_relaxed);
+    }
+
+    uint64_t GetLockViolationCount() {
+        return gLockViolations.load(std::memory_order_relaxed);
+    }
+
+    uint64_t GetThreadAllocationCount() {
+        return tAllocations;
+    }
+
+    uint64_t Report() {
+        const uint64_t total = GetViolationCount() + GetLockViolationCount();
+        for (uint32_t i = 0; i < kMaxScopes; i++) {
+            const char *name = gScopeNames[i].load(std::memory_order_acquire);
+            if (name == nullptr) {
+                break;
+            }
+            LOGE("Allocation audit: %llu allocations and %llu locks in %s", (unsigned long long) gScopeCounts[i].load(),
+                 (unsigned long long) gScopeLocks[i].load(), name);
+        }
+        if (total == 0 && IsArmed()) {
+            LOGI("Allocation audit: no allocations or locks on audited paths");
+        }
+        return total;
+    }
+
+    Scope::Scope(const char *name) : mPrevious(tScope) {
+        tScope = name;
+    }
+
+    Scope::~Scope() {
+        tScope = mPrevious;
+    }
+}
+
+#ifdef CXR_ALLOCATION_AUDIT
+void *operator new(size_t size) {
+    return AuditedAllocOrThrow(size, __builtin_return_address(0));
+}
+
+void *operator new[](size_t size) {
+    return AuditedAllocOrThrow(size, __builtin_return_address(0));
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return AuditedAlloc(size, __builtin_return_address(0));
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return AuditedAlloc(size, __builtin_return_address(0));
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+    free(p);
+}
+#endif
+
+#ifdef CXR_ALLOCATION_AUDIT_MALLOC
+extern "C" {
+void *malloc(size_t size) {
+    RecordAllocation(__builtin_return_address(0));
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    RecordAllocation(__builtin_return_address(0));
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) {
+    RecordAllocation(__builtin_return_address(0));
+    return __libc_realloc(p, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+    RecordAllocation(__builtin_return_address(0));
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    RecordAllocation(__builtin_return_address(0));
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **out, size_t alignment, size_t size) {
+    RecordAllocation(__builtin_return_address(0));
+    void *p = __libc_memalign(alignment, size);
+    if (p == nullptr) {
+        return ENOMEM;
+    }
+    *out = p;
+    return 0;
+}
+
+void free(void *p) {
+    __libc_free(p);
+}
+
+int pthread_mutex_lock(pthread_mutex_t *mutex) {
+    RecordLock(__builtin_return_address(0));
+    if (gMutexLock == nullptr) {
+        FindLockFunctions();
+    }
+    return gMutexLock(mutex);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t *lock) {
+    RecordLock(__builtin_return_address(0));
+    if (gRwLockRead == nullptr) {
+        FindLockFunctions();
+    }
+    return gRwLockRead(lock);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t *lock) {
+    RecordLock(__builtin_return_address(0));
+    if (gRwLockWrite == nullptr) {
+        FindLockFunctions();
+    }
+    return gRwLockWrite(lock);
+}
+}
+#endif
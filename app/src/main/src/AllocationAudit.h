@@ -0,0 +1,80 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_ALLOCATION_AUDIT_H
+#define CLIENT_APP_ALLOCATION_AUDIT_H
+
+#include <stdint.h>
+
+// Checks that the per-frame and per-packet paths (render_frame, GetTrackingState, RenderAudio,
+// onAudioReady, TriggerHaptic) neither allocate nor wait for a lock once the session is warmed
+// up.
+//
+// Only compiled in with CXR_ALLOCATION_AUDIT (ndk-build CXR_ALLOCATION_AUDIT=1, or -D on a host
+// build). The audit build counts every allocation made while a thread is inside an
+// ALLOCATION_AUDIT_SCOPE after Arm(), and by default aborts the process on the first one, naming
+// the scope on stderr and in the abort message. Report() logs the offending scopes when
+// SetFatal(false) lets the process go on; nothing is logged from inside the allocator.
+//
+// What is seen depends on the C library. With glibc (host builds) malloc, calloc, realloc and
+// memalign are replaced, so allocations inside libc (fopen) and the C++ runtime count as well;
+// calls from other shared libraries, such as the graphics driver inside GL calls, do not. Bionic does not let an app library interpose malloc for the rest of the process,
+// so on Android only operator new/delete are replaced: allocations through operator new in this
+// library are seen, malloc calls in libc and in the prebuilt SDK libraries (CloudXR, Pxr, Oboe)
+// are not. Use malloc debug or heapprofd for those.
+//
+// Locks are only seen with glibc: pthread_mutex_lock and the rwlock read and write locks (what
+// std::mutex and std::shared_mutex use) are replaced as well, and a lock taken by the same
+// modules inside an armed scope counts and aborts like an allocation. Try-locks do not count.
+//
+// Without CXR_ALLOCATION_AUDIT the scopes compile to nothing.
+namespace AllocationAudit {
+    static const uint32_t kMaxScopes = 16;
+    // streaming frames before the audit arms itself, and between two reports
+    static const uint32_t kWarmupFrames = 600;
+    static const uint32_t kReportFrames = 3600;
+
+    // Starts counting; call once the steady state is reached.
+    void Arm();
+
+    // Counts one streaming frame: arms after kWarmupFrames, reports every kReportFrames.
+    // Call outside of any scope.
+    void OnStreamingFrame();
+
+    bool IsArmed();
+
+    // Whether an allocation in an armed scope aborts the process; the default.
+    void SetFatal(bool fatal);
+
+    // Allocations seen inside scopes since Arm().
+    uint64_t GetViolationCount();
+
+    // Locks taken inside scopes since Arm(); always 0 without glibc.
+    uint64_t GetLockViolationCount();
+
+    // Allocations made by the calling thread so far, in or out of scopes; 0 without
+    // CXR_ALLOCATION_AUDIT.
+    uint64_t GetThreadAllocationCount();
+
+    // Logs the scopes that allocated or locked since Arm(); returns the total count.
+    uint64_t Report();
+
+    class Scope {
+
+    public:
+        explicit Scope(const char *name);
+
+        ~Scope();
+
+    private:
+        const char *mPrevious;
+    };
+}
+
+#ifdef CXR_ALLOCATION_AUDIT
+#define ALLOCATION_AUDIT_CONCAT_(a, b) a##b
+#define ALLOCATION_AUDIT_CONCAT(a, b) ALLOCATION_AUDIT_CONCAT_(a, b)
+#define ALLOCATION_AUDIT_SCOPE(name) AllocationAudit::Scope ALLOCATION_AUDIT_CONCAT(allocationAuditScope, __LINE__)(name)
+#else
+#define ALLOCATION_AUDIT_SCOPE(name) do {} while (0)
+#endif
+
+#endif //CLIENT_APP_ALLOCATION_AUDIT_H
@@ -0,0 +1,249 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "AsyncLog.h"
+#include "ThreadManager.h"
+#include <mutex>
+#include <thread>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#endif
+
+namespace {
+    enum LoggerState {
+        LoggerState_NotStarted = 0,
+        LoggerState_Running,
+        LoggerState_Stopped,
+    };
+
+    struct LogRing {
+        AsyncLogRecord records[AsyncLog::kRingCapacity];
+        std::atomic<uint32_t> head{0}; // next record to flush, flusher-owned
+        std::atomic<uint32_t> tail{0}; // next record to write, owner thread
+        std::atomic<bool> inUse{true};
+        std::atomic<int> tid{0};
+        LogRing *next = nullptr;
+    };
+
+    // Gives the ring back for reuse when its thread exits; queued records are still flushed.
+    struct RingOwner {
+        LogRing *ring = nullptr;
+
+        ~RingOwner() {
+            if (ring != nullptr) {
+                ring->inUse.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    std::atomic<LogRing *> gRings{nullptr};
+    std::atomic<int> gState{LoggerState_NotStarted};
+    std::atomic<uint64_t> gDropped{0};
+    std::atomic<int> gMinPriority{AsyncLogPriority_Debug};
+    std::once_flag gStartOnce;
+    std::thread gFlusher;
+
+    // consumer side: serializes draining and the sink
+    std::mutex gFlushMutex;
+    FILE *gFile = nullptr;
+
+    thread_local RingOwner tRing;
+    // record of the current call when it is written synchronously
+    thread_local AsyncLogRecord tSyncRecord;
+    thread_local bool tSyncPending = false;
+
+    // util.h has the shared one, but it pulls in the log macros built on this file
+    uint64_t MonotonicNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+    int CurrentTid() {
+        return (int) syscall(SYS_gettid);
+    }
+
+    char PriorityChar(int priority) {
+        switch (priority) {
+            case AsyncLogPriority_Debug:
+                return 'D';
+            case AsyncLogPriority_Info:
+                return 'I';
+            case AsyncLogPriority_Warn:
+                return 'W';
+            case AsyncLogPriority_Error:
+                return 'E';
+            default:
+                return '?';
+        }
+    }
+
+    LogRing *AcquireRing() {
+        for (LogRing *ring = gRings.load(std::memory_order_acquire); ring != nullptr; ring = ring->next) {
+            bool free = false;
+            if (!ring->inUse.load(std::memory_order_relaxed) &&
+                ring->inUse.compare_exchange_strong(free, true, std::memory_order_acquire)) {
+                ring->tid.store(CurrentTid(), std::memory_order_relaxed);
+                return ring;
+            }
+        }
+        // only reached once per thread that logs, so allocating here is fine
+        auto *ring = new LogRing();
+        ring->tid.store(CurrentTid(), std::memory_order_relaxed);
+        LogRing *head = gRings.load(std::memory_order_relaxed);
+        do {
+            ring->next = head;
+        } while (!gRings.compare_exchange_weak(head, ring, std::memory_order_release, std::memory_order_relaxed));
+        return ring;
+    }
+
+    // Caller holds gFlushMutex (or is the only thread writing synchronously).
+    void WriteRecord(const AsyncLogRecord &record, int tid) {
+        char line[1024];
+        int length = record.format(record.args, record.fmt, line, sizeof(line));
+        if (length < 0) {
+            snprintf(line, sizeof(line), "(bad log format: %s)", record.fmt);
+        } else if (record.suppressed != 0 && size_t(length) < sizeof(line)) {
+            snprintf(line + length, sizeof(line) - length, " [%u similar messages suppressed]", record.suppressed);
+        }
+
+        if (gFile != nullptr) {
+            fprintf(gFile, "%llu.%06llu %5d %c %s: %s\n",
+                    (unsigned long long) (record.timeNs / 1000000000ULL),
+                    (unsigned long long) (record.timeNs % 1000000000ULL / 1000),
+                    tid, PriorityChar(record.priority), record.tag, line);
+            return;
+        }
+#ifdef __ANDROID__
+        __android_log_write(record.priority, record.tag, line);
+#else
+        fprintf(stderr, "%c/%s(%d): %s\n", PriorityChar(record.priority), record.tag, tid, line);
+#endif
+    }
+
+    void DrainRings() {
+        std::lock_guard<std::mutex> lock(gFlushMutex);
+        for (LogRing *ring = gRings.load(std::memory_order_acquire); ring != nullptr; ring = ring->next) {
+            const int tid = ring->tid.load(std::memory_order_relaxed);
+            uint32_t head = ring->head.load(std::memory_order_relaxed);
+            const uint32_t tail = ring->tail.load(std::memory_order_acquire);
+            for (; head != tail; head++) {
+                WriteRecord(ring->records[head % AsyncLog::kRingCapacity], tid);
+            }
+            ring->head.store(head, std::memory_order_release);
+        }
+        if (gFile != nullptr) {
+            fflush(gFile);
+        }
+    }
+
+    void StartFlusher() {
+        int expected = LoggerState_NotStarted;
+        if (!gState.compare_exchange_strong(expected, LoggerState_Running)) {
+            return;
+        }
+        gFlusher = std::thread([]() {
+            ThreadManager::RegisterCurrentThread(ThreadRole_Worker, "AsyncLog");
+            while (gState.load(std::memory_order_acquire) == LoggerState_Running) {
+                DrainRings();
+                std::this_thread::sleep_for(std::chrono::milliseconds(uint32_t(AsyncLog::kFlushIntervalMs)));
+            }
+        });
+        // exit() destroys gFlusher, which terminates the process while the thread still runs
+        atexit(AsyncLog::Shutdown);
+    }
+}
+
+bool AsyncLog::Allow(AsyncLogCallSite &site, uint32_t intervalMs, uint32_t *suppressed) {
+    const uint64_t now = MonotonicNs();
+    uint64_t next = site.nextAllowedNs.load(std::memory_order_relaxed);
+    if (now < next ||
+        !site.nextAllowedNs.compare_exchange_strong(next, now + uint64_t(intervalMs) * 1000000ULL,
+                                                   std::memory_order_relaxed)) {
+        site.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    *suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+AsyncLogRecord *AsyncLog::BeginRecord() {
+    int state = gState.load(std::memory_order_acquire);
+    if (state == LoggerState_NotStarted) {
+        std::call_once(gStartOnce, StartFlusher);
+        state = gState.load(std::memory_order_acquire);
+    }
+    if (state == LoggerState_Stopped) {
+        tSyncPending = true;
+        tSyncRecord.timeNs = MonotonicNs();
+        return &tSyncRecord;
+    }
+
+    if (tRing.ring == nullptr) {
+        tRing.ring = AcquireRing();
+    }
+    LogRing *ring = tRing.ring;
+    const uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+    if (tail - ring->head.load(std::memory_order_acquire) >= kRingCapacity) {
+        gDropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    AsyncLogRecord *record = &ring->records[tail % kRingCapacity];
+    record->timeNs = MonotonicNs();
+    return record;
+}
+
+void AsyncLog::CommitRecord() {
+    if (tSyncPending) {
+        tSyncPending = false;
+        std::lock_guard<std::mutex> lock(gFlushMutex);
+        WriteRecord(tSyncRecord, CurrentTid());
+        return;
+    }
+    LogRing *ring = tRing.ring;
+    ring->tail.store(ring->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void AsyncLog::SetFile(const char *path) {
+    std::lock_guard<std::mutex> lock(gFlushMutex);
+    if (gFile != nullptr) {
+        fclose(gFile);
+        gFile = nullptr;
+    }
+    if (path != nullptr && path[0] != '\0') {
+        gFile = fopen(path, "a");
+    }
+}
+
+void AsyncLog::Flush() {
+    DrainRings();
+}
+
+void AsyncLog::Shutdown() {
+    int expected = LoggerState_Running;
+    if (gState.compare_exchange_strong(expected, LoggerState_Stopped)) {
+        if (gFlusher.joinable()) {
+            gFlusher.join();
+        }
+    } else {
+        gState.store(LoggerState_Stopped);
+    }
+    DrainRings();
+}
+
+uint64_t AsyncLog::GetDroppedCount() {
+    return gDropped.load(std::memory_order_relaxed);
+}
+
+void AsyncLog::SetMinPriority(int priority) {
+    gMinPriority.store(priority, std::memory_order_relaxed);
+}
+
+bool AsyncLog::IsEnabled(int priority) {
+    return priority >= gMinPriority.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,245 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_ASYNC_LOG_H
+#define CLIENT_APP_ASYNC_LOG_H
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
+
+// Log priorities, same values as android_LogPriority so they can be passed straight through.
+enum AsyncLogPriority {
+    AsyncLogPriority_Debug = 3,
+    AsyncLogPriority_Info = 4,
+    AsyncLogPriority_Warn = 5,
+    AsyncLogPriority_Error = 6,
+};
+
+// State of a rate-limited log statement; one function-local static per call site.
+// Zero-initialized, so no guard is emitted for the static.
+struct AsyncLogCallSite {
+    std::atomic<uint64_t> nextAllowedNs{0};
+    std::atomic<uint32_t> suppressed{0};
+};
+
+namespace AsyncLogDetail {
+    static const size_t kMaxStringArg = 64;
+    static const size_t kMaxArgBytes = 224;
+    // "…" in UTF-8
+    static const char kEllipsis[] = "\xE2\x80\xA6";
+
+    // How one argument is kept until the flusher formats it. Strings are copied since the pointer
+    // may be gone by then; a longer one keeps what fits of kMaxStringArg - 1 bytes and ends in
+    // kEllipsis. Everything else by value.
+    template<typename T>
+    struct Arg {
+        typedef T Stored;
+
+        static void Store(Stored &dst, T value) {
+            static_assert(std::is_trivially_copyable<T>::value, "log arguments are kept by value; pass c_str()");
+            dst = value;
+        }
+
+        static T Load(const Stored &stored) {
+            return stored;
+        }
+    };
+
+    struct String {
+        char data[kMaxStringArg];
+    };
+
+    template<>
+    struct Arg<const char *> {
+        typedef String Stored;
+
+        static void Store(Stored &dst, const char *value) {
+            if (value == nullptr) {
+                value = "(null)";
+            }
+            size_t length = 0;
+            while (length < kMaxStringArg && value[length] != '\0') {
+                length++;
+            }
+            if (length < kMaxStringArg) {
+                memcpy(dst.data, value, length + 1);
+                return;
+            }
+            // cut before a whole character, not inside one
+            size_t cut = kMaxStringArg - sizeof(kEllipsis);
+            while (cut > 0 && (uint8_t(value[cut]) & 0xC0) == 0x80) {
+                cut--;
+            }
+            memcpy(dst.data, value, cut);
+            memcpy(dst.data + cut, kEllipsis, sizeof(kEllipsis));
+        }
+
+        static const char *Load(const Stored &stored) {
+            return stored.data;
+        }
+    };
+
+    template<>
+    struct Arg<char *> : Arg<const char *> {
+    };
+
+    // The stored arguments of one call, laid out as a plain struct so it can be copied into a
+    // record and handed back to snprintf in the original order.
+    template<typename... Args>
+    struct ArgPack;
+
+    template<>
+    struct ArgPack<> {
+        void Store() {
+        }
+
+        template<typename... Loaded>
+        int Format(char *out, size_t size, const char *fmt, Loaded... loaded) const {
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wformat-nonliteral"
+#pragma clang diagnostic ignored "-Wformat-security"
+#endif
+            return snprintf(out, size, fmt, loaded...);
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
+        }
+    };
+
+    template<typename T, typename... Rest>
+    struct ArgPack<T, Rest...> {
+        typename Arg<T>::Stored value;
+        ArgPack<Rest...> rest;
+
+        void Store(T first, Rest... others) {
+            Arg<T>::Store(value, first);
+            rest.Store(others...);
+        }
+
+        template<typename... Loaded>
+        int Format(char *out, size_t size, const char *fmt, Loaded... loaded) const {
+            return rest.Format(out, size, fmt, loaded..., Arg<T>::Load(value));
+        }
+    };
+
+    // Never called; the log macros pass their arguments to it in a dead branch so the compiler
+    // checks them against the format string.
+    inline void CheckFormat(const char *, ...) __attribute__((format(printf, 1, 2)));
+
+    inline void CheckFormat(const char *, ...) {
+    }
+
+    typedef int (*FormatFn)(const void *args, const char *fmt, char *out, size_t size);
+
+    template<typename... Args>
+    int FormatRecord(const void *args, const char *fmt, char *out, size_t size) {
+        return static_cast<const ArgPack<Args...> *>(args)->Format(out, size, fmt);
+    }
+}
+
+// One log call as queued by the caller thread.
+struct AsyncLogRecord {
+    uint64_t timeNs;
+    const char *tag;
+    const char *fmt;
+    AsyncLogDetail::FormatFn format;
+    int32_t priority;
+    // calls dropped by the rate limit of this call site since its previous record
+    uint32_t suppressed;
+    alignas(8) uint8_t args[AsyncLogDetail::kMaxArgBytes];
+};
+
+// Logging backend for the LOGI/LOGE macros.
+//
+// A log call only copies the format pointer and its arguments into a fixed-size ring owned by
+// the calling thread and returns; the string is built and written to logcat (or stderr / a
+// file off Android) by a background flusher thread. Format strings must be literals since
+// only the pointer is kept. Rings are single-producer/single-consumer, so the caller never
+// takes a lock; when a ring is full the record is dropped and counted. Rings of exited threads
+// are reused by new threads.
+//
+// Records of different threads are flushed ring by ring, so their relative order in the
+// output is only approximate; lines of the file sink carry their capture time.
+class AsyncLog {
+
+public:
+    static const uint32_t kRingCapacity = 128;
+    static const uint32_t kFlushIntervalMs = 20;
+
+    template<typename... Args>
+    static void Write(int priority, const char *tag, const char *fmt, Args... args) {
+        WriteImpl(priority, tag, 0, fmt, args...);
+    }
+
+    // Same as Write but drops the call when the same call site logged less than intervalMs ago.
+    // The next record written from the call site reports how many calls were dropped.
+    template<typename... Args>
+    static void WriteLimited(AsyncLogCallSite &site, uint32_t intervalMs, int priority, const char *tag,
+                             const char *fmt, Args... args) {
+        uint32_t suppressed = 0;
+        if (!IsEnabled(priority) || !Allow(site, intervalMs, &suppressed)) {
+            return;
+        }
+        WriteImpl(priority, tag, suppressed, fmt, args...);
+    }
+
+    // Writes to this file instead of logcat / stderr. Empty path restores the default sink.
+    static void SetFile(const char *path);
+
+    // Formats and writes everything queued so far, on the calling thread.
+    static void Flush();
+
+    // Flushes and stops the flusher thread; later calls are written synchronously.
+    static void Shutdown();
+
+    // Records dropped because a ring was full.
+    static uint64_t GetDroppedCount();
+
+    // Calls below this priority are dropped before anything is copied. Defaults to Debug.
+    static void SetMinPriority(int priority);
+
+    static bool IsEnabled(int priority);
+
+private:
+    template<typename... Args>
+    static void WriteImpl(int priority, const char *tag, uint32_t suppressed, const char *fmt, Args... args) {
+        typedef AsyncLogDetail::ArgPack<Args...> Pack;
+        static_assert(sizeof(Pack) <= AsyncLogDetail::kMaxArgBytes, "too many log arguments");
+        static_assert(alignof(Pack) <= 8, "log argument alignment");
+
+        if (!IsEnabled(priority)) {
+            return;
+        }
+        AsyncLogRecord *record = BeginRecord();
+        if (record == nullptr) {
+            return;
+        }
+        record->tag = tag;
+        record->fmt = fmt;
+        record->format = &AsyncLogDetail::FormatRecord<Args...>;
+        record->priority = priority;
+        record->suppressed = suppressed;
+        reinterpret_cast<Pack *>(record->args)->Store(args...);
+        CommitRecord();
+    }
+
+    static bool Allow(AsyncLogCallSite &site, uint32_t intervalMs, uint32_t *suppressed);
+
+    // Returns the next free record of the calling thread's ring with timeNs set, or null when the
+    // ring is full. After Shutdown() it returns a scratch record that CommitRecord() writes
+    // synchronously.
+    static AsyncLogRecord *BeginRecord();
+
+    static void CommitRecord();
+};
+
+#define LOG_RATE_LIMITED(intervalMs, priority, tag, ...) do { \
+    if (false) AsyncLogDetail::CheckFormat(__VA_ARGS__); \
+    static AsyncLogCallSite logCallSite; \
+    AsyncLog::WriteLimited(logCallSite, intervalMs, priority, tag, __VA_ARGS__); \
+} while (0)
+
+#endif //CLIENT_APP_ASYNC_LOG_H
@@ -0,0 +1,191 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "AudioStreamSupervisor.h"
+#include <chrono>
+#include <time.h>
+#include "ThreadManager.h"
+#include "util.h"
+
+AudioStreamSupervisor::AudioStreamSupervisor(const char *name, uint32_t fastRetries)
+        : mName(name), mFastRetries(fastRetries) {
+}
+
+AudioStreamSupervisor::~AudioStreamSupervisor() {
+    Close();
+}
+
+oboe::Result AudioStreamSupervisor::Open(const oboe::AudioStreamBuilder &builder, int32_t bufferBursts) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mStream) {
+        return oboe::Result::OK;
+    }
+    mBuilder = builder;
+    mBuilder.setErrorCallback(this);
+    mBufferBursts = bufferBursts;
+    mStarted = false;
+    mStopping = false;
+    mReopenPending = false;
+    const oboe::Result ret = OpenStream();
+    if (ret != oboe::Result::OK) {
+        return ret;
+    }
+    mThread = std::thread([this]() {
+        ThreadManager::RegisterCurrentThread(ThreadRole_Audio, "AudioRecovery");
+        Run();
+    });
+    return ret;
+}
+
+oboe::Result AudioStreamSupervisor::Start() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mStream) {
+        return oboe::Result::ErrorClosed;
+    }
+    const oboe::Result ret = mStream->start();
+    if (ret != oboe::Result::OK) {
+        LOGE("Failed to start %s stream. Error: %s", mName, oboe::convertToText(ret));
+        return ret;
+    }
+    mStarted = true;
+    return ret;
+}
+
+void AudioStreamSupervisor::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWake.notify_one();
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mStream) {
+        mStream->stop();
+    }
+    RetireStream();
+    mStarted = false;
+}
+
+bool AudioStreamSupervisor::IsOpen() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStream != nullptr;
+}
+
+uint32_t AudioStreamSupervisor::SampleXRunCount() {
+    std::unique_lock<std::mutex> lock(mMutex, std::try_to_lock);
+    if (lock.owns_lock()) {
+        uint32_t count = mRetiredXRuns;
+        if (mStream) {
+            const oboe::ResultWithValue<int32_t> xruns = mStream->getXRunCount();
+            count += xruns ? uint32_t(xruns.value()) : 0;
+        }
+        mXRunCount.store(count, std::memory_order_relaxed);
+    }
+    return mXRunCount.load(std::memory_order_relaxed);
+}
+
+bool AudioStreamSupervisor::Write(const void *buffer, int32_t numFrames, int64_t timeoutNs) {
+    mWriters.fetch_add(1);
+    oboe::AudioStream *stream = mActive.load();
+    bool written = false;
+    if (stream != nullptr) {
+        written = bool(stream->write(buffer, numFrames, timeoutNs));
+    }
+    mWriters.fetch_sub(1);
+    if (!written) {
+        mDroppedFrames.fetch_add(uint64_t(numFrames), std::memory_order_relaxed);
+    }
+    return stream != nullptr;
+}
+
+void AudioStreamSupervisor::onErrorAfterClose(oboe::AudioStream *stream, oboe::Result error) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    // a stream we already replaced or are closing ourselves
+    if (mStopping || stream != mStream.get()) {
+        return;
+    }
+    LOGE("Audio %s stream closed by the device: %s, reopening", mName, oboe::convertToText(error));
+    mActive.store(nullptr);
+    mReopenPending = true;
+    mErrorNs = MonotonicNs();
+    mWake.notify_one();
+}
+
+oboe::Result AudioStreamSupervisor::OpenStream() {
+    std::shared_ptr<oboe::AudioStream> stream;
+    oboe::Result ret = mBuilder.openStream(stream);
+    if (ret != oboe::Result::OK) {
+        // retried while the device is gone
+        LOGE_RATE_LIMITED(1000, "Failed to open %s stream. Error: %s", mName, oboe::convertToText(ret));
+        return ret;
+    }
+    if (mBufferBursts > 0) {
+        const int32_t bufferSizeFrames = stream->getFramesPerBurst() * mBufferBursts;
+        ret = stream->setBufferSizeInFrames(bufferSizeFrames);
+        if (ret != oboe::Result::OK) {
+            LOGE("Failed to set %s stream buffer size to: %d. Error: %s", mName, bufferSizeFrames, oboe::convertToText(ret));
+            stream->close();
+            return ret;
+        }
+    }
+    if (mStarted) {
+        ret = stream->start();
+        if (ret != oboe::Result::OK) {
+            LOGE("Failed to start %s stream. Error: %s", mName, oboe::convertToText(ret));
+            stream->close();
+            return ret;
+        }
+    }
+    mStream = stream;
+    mActive.store(mStream.get());
+    return oboe::Result::OK;
+}
+
+void AudioStreamSupervisor::RetireStream() {
+    mActive.store(nullptr);
+    // a writer that read the pointer before it was cleared is at most one write away
+    while (mWriters.load() != 0) {
+        std::this_thread::yield();
+    }
+    if (mStream) {
+        const oboe::ResultWithValue<int32_t> xruns = mStream->getXRunCount();
+        mRetiredXRuns += xruns ? uint32_t(xruns.value()) : 0;
+        mStream->close();
+        mStream.reset();
+    }
+}
+
+void AudioStreamSupervisor::Run() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true) {
+        mWake.wait(lock, [this]() { return mStopping || mReopenPending; });
+        if (mStopping) {
+            return;
+        }
+        mReopenPending = false;
+        RetireStream();
+
+        for (uint32_t attempt = 0; !mStopping; attempt++) {
+            if (OpenStream() == oboe::Result::OK) {
+                const float recoveryMs = float(MonotonicNs() - mErrorNs) / 1e6f;
+                mRerouteCount.fetch_add(1, std::memory_order_relaxed);
+                mLastRecoveryMs.store(recoveryMs, std::memory_order_relaxed);
+                if (recoveryMs > mMaxRecoveryMs.load(std::memory_order_relaxed)) {
+                    mMaxRecoveryMs.store(recoveryMs, std::memory_order_relaxed);
+                }
+                LOGI("Audio %s stream reopened after %.1fms, attempt %u", mName, recoveryMs, attempt + 1);
+                break;
+            }
+            mFailedReopenCount.fetch_add(1, std::memory_order_relaxed);
+            // no device yet; a later route change reports nothing, so keep trying, less often
+            // once the device has been gone for a while
+            if (attempt + 1 == mFastRetries) {
+                LOGE("Audio %s stream not reopened after %u attempts, retrying every %ums", mName, mFastRetries,
+                     kSlowRetryIntervalMs);
+            }
+            const uint32_t intervalMs = attempt + 1 < mFastRetries ? kRetryIntervalMs : kSlowRetryIntervalMs;
+            mWake.wait_for(lock, std::chrono::milliseconds(intervalMs), [this]() { return mStopping; });
+        }
+    }
+}
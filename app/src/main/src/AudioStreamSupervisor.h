@@ -0,0 +1,109 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_AUDIO_STREAM_SUPERVISOR_H
+#define CLIENT_APP_AUDIO_STREAM_SUPERVISOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <stdint.h>
+#include <oboe/Oboe.h>
+
+// Keeps one Oboe stream alive across device disconnects and route changes (headphones,
+// Bluetooth), without tearing the CloudXR session down.
+//
+// Oboe closes a stream whose device went away and reports it through onErrorAfterClose(). The
+// supervisor then reopens the stream with the builder it was first opened with, on its own
+// worker thread, and restarts it if it was started. While no device is available it retries
+// every kRetryIntervalMs for the first kFastRetries attempts, then every kSlowRetryIntervalMs
+// until it succeeds or the stream is closed: a device that comes back after minutes still gets
+// its audio, since a later route change reports nothing to a stream that is already closed.
+// Until the new stream is running, Write() drops the audio and returns right away, so the gap
+// plays as silence and the CloudXR callback never waits on the recovery.
+//
+// Write() takes no lock: it announces itself in a writer count and reads the active stream
+// pointer; the worker clears that pointer and waits for the writers to leave before it closes
+// the old stream.
+class AudioStreamSupervisor : public oboe::AudioStreamErrorCallback {
+
+public:
+    static const uint32_t kRetryIntervalMs = 200;
+    static const uint32_t kFastRetries = 50;
+    static const uint32_t kSlowRetryIntervalMs = 2000;
+
+    // fastRetries only differs from kFastRetries in tests
+    explicit AudioStreamSupervisor(const char *name, uint32_t fastRetries = kFastRetries);
+
+    ~AudioStreamSupervisor();
+
+    // Opens the stream; the builder is kept for reopening. A bufferBursts above 0 sets the buffer
+    // size to that many bursts.
+    oboe::Result Open(const oboe::AudioStreamBuilder &builder, int32_t bufferBursts);
+
+    // Starts the stream, and every stream reopened after it.
+    oboe::Result Start();
+
+    // Stops the worker, then stops and closes the stream.
+    void Close();
+
+    bool IsOpen() const;
+
+    // Writes to the active stream; returns false when there is none, which drops the frames.
+    bool Write(const void *buffer, int32_t numFrames, int64_t timeoutNs);
+
+    uint32_t GetRerouteCount() const { return mRerouteCount.load(std::memory_order_relaxed); }
+
+    uint32_t GetFailedReopenCount() const { return mFailedReopenCount.load(std::memory_order_relaxed); }
+
+    uint64_t GetDroppedFrames() const { return mDroppedFrames.load(std::memory_order_relaxed); }
+
+    // time from the error to the reopened stream running
+    float GetLastRecoveryMs() const { return mLastRecoveryMs.load(std::memory_order_relaxed); }
+
+    float GetMaxRecoveryMs() const { return mMaxRecoveryMs.load(std::memory_order_relaxed); }
+
+    // Underruns or overruns of every stream opened so far. The current stream is not sampled
+    // while the worker is reopening it; the previous sample is returned then.
+    uint32_t SampleXRunCount();
+
+    // Oboe's error thread, after it closed the stream.
+    void onErrorAfterClose(oboe::AudioStream *stream, oboe::Result error) override;
+
+private:
+    // Opens, sizes and (if started) starts a stream and makes it active; mMutex must be held.
+    oboe::Result OpenStream();
+
+    // Deactivates and closes the current stream once no writer uses it; mMutex must be held.
+    void RetireStream();
+
+    void Run();
+
+    const char *mName;
+    const uint32_t mFastRetries;
+    oboe::AudioStreamBuilder mBuilder;
+    int32_t mBufferBursts = 0;
+
+    // Open, Close, Start and the worker; never taken by Write()
+    mutable std::mutex mMutex;
+    std::condition_variable mWake;
+    std::shared_ptr<oboe::AudioStream> mStream;
+    bool mStarted = false;
+    bool mStopping = false;
+    bool mReopenPending = false;
+    uint64_t mErrorNs = 0;
+    // xruns of the streams already closed
+    uint32_t mRetiredXRuns = 0;
+    std::thread mThread;
+
+    std::atomic<oboe::AudioStream *> mActive{nullptr};
+    std::atomic<int32_t> mWriters{0};
+
+    std::atomic<uint32_t> mRerouteCount{0};
+    std::atomic<uint32_t> mFailedReopenCount{0};
+    std::atomic<uint64_t> mDroppedFrames{0};
+    std::atomic<float> mLastRecoveryMs{0};
+    std::atomic<float> mMaxRecoveryMs{0};
+    std::atomic<uint32_t> mXRunCount{0};
+};
+
+#endif //CLIENT_APP_AUDIO_STREAM_SUPERVISOR_H
@@ -1,9 +1,12 @@
 // Copyright (2021-2023) Bytedance Ltd. and/or its affiliates 
 #include <sys/system_properties.h>
-#include <EGL/egl.h>
 #include <GLES3/gl3.h>
 #include "CloudXRClientPXR.h"
-#include "CloudXRClientOptions.h"
+#include "PxrLaunchOptions.h"
+#include "AllocationAudit.h"
+#include "ThreadManager.h"
+#include "StartupTimeline.h"
+#include <future>
 #include "CloudXRCommon.h"
 #include <oboe/Oboe.h>
 #include <CloudXRMatrixHelpers.h>
@@ -11,7 +14,12 @@
 #include <PxrInput.h>
 #include "PxrHelper.h"
 
-static CloudXR::ClientOptions GOptions;
+// builds without /sdcard (the host tests) define their own
+#ifndef CXR_LAUNCH_OPTIONS_PATH
+#define CXR_LAUNCH_OPTIONS_PATH "/sdcard/CloudXRLaunchOptions.txt"
+#endif
+static const char *const kLaunchOptionsPath = CXR_LAUNCH_OPTIONS_PATH;
+static std::atomic<uint32_t> gNextClientId{0};
 
 #define CASE(x) \
 case x:     \
@@ -46,11 +54,33 @@ const char *StateReasonEnumToString(cxrStateReason reason) {
     }
 }
 
-CloudXRClientPXR::CloudXRClientPXR() : mIsPaused(true), mWasPaused(true) {
+CloudXRClientPXR::CloudXRClientPXR(const char *optionsPath) :
+        mHaptics([this](uint32_t controller, float amplitude, float, uint32_t durationMs) {
+            // the Pxr runtime has no frequency control
+            if (durationMs == 0 || mDeviceState.IsControllerConnected(controller)) {
+                Pxr_SetControllerVibration(controller, amplitude, durationMs);
+            }
+        }),
+        mInput([this](uint32_t controller, uint64_t *buttons) {
+            if (!mDeviceState.IsControllerConnected(controller)) {
+                return false;
+            }
+            PxrControllerInputState state;
+            Pxr_GetControllerInputState(controller, &state);
+            *buttons = InputSampler::GetButtonMask(controller, state);
+            return true;
+        }),
+        mClientId(gNextClientId.fetch_add(1)),
+        mOptionsPath(optionsPath != nullptr ? optionsPath : kLaunchOptionsPath),
+        mIsPaused(true), mWasPaused(true) {
     Initialize();
 }
 
 CloudXRClientPXR::~CloudXRClientPXR() {
+    // after the shutdown sequence everything is released already
+    if (!mShutDown) {
+        TeardownReceiver();
+    }
 }
 
 bool CloudXRClientPXR::Start() {
@@ -142,6 +172,34 @@ cxrVector3 cxrConvert(const PxrVector3f &v) {
     return {{v.x / 1000, v.y / 1000, v.z / 1000}};
 }
 
+// Extrapolates a pose by its velocities; Pxr reports them in milli-units per second.
+static PxrSensorState ExtrapolatePose(const PxrSensorState &state, float seconds) {
+    PxrSensorState out = state;
+    if (seconds <= 0) {
+        return out;
+    }
+    out.pose.position.x += state.linearVelocity.x / 1000 * seconds;
+    out.pose.position.y += state.linearVelocity.y / 1000 * seconds;
+    out.pose.position.z += state.linearVelocity.z / 1000 * seconds;
+
+    const float wx = state.angularVelocity.x / 1000;
+    const float wy = state.angularVelocity.y / 1000;
+    const float wz = state.angularVelocity.z / 1000;
+    const float speed = sqrtf(wx * wx + wy * wy + wz * wz);
+    if (speed > 1e-6f) {
+        // rotate by the world space angular velocity: q' = dq * q
+        const float halfAngle = speed * seconds * 0.5f;
+        const float s = sinf(halfAngle) / speed;
+        const float dx = wx * s, dy = wy * s, dz = wz * s, dw = cosf(halfAngle);
+        const PxrQuaternionf &q = state.pose.orientation;
+        out.pose.orientation.x = dw * q.x + dx * q.w + dy * q.z - dz * q.y;
+        out.pose.orientation.y = dw * q.y - dx * q.z + dy * q.w + dz * q.x;
+        out.pose.orientation.z = dw * q.z + dx * q.y - dy * q.x + dz * q.w;
+        out.pose.orientation.w = dw * q.w - dx * q.x - dy * q.y - dz * q.z;
+    }
+    return out;
+}
+
 cxrTrackedDevicePose CloudXRClientPXR::ConvertPose(const PxrSensorState &pose, float rotationX) {
     pxrMatrix4f transform = GetTransformFromPose(&pose.pose);
 
@@ -162,82 +220,143 @@ cxrTrackedDevicePose CloudXRClientPXR::ConvertPose(const PxrSensorState &pose, f
 }
 
 void CloudXRClientPXR::Initialize() {
-    GOptions.ParseFile("/sdcard/CloudXRLaunchOptions.txt");
+    mOptionsStore.Load(mOptionsPath);
+    mOptionsStore.StartWatching();
+    ApplyOptions();
+    mSoak.Start(MonotonicNs() / 1000000);
+    mStatsReporter.Start();
+    StartupTimeline::Mark(StartupPhase_OptionsLoaded);
 }
 
-cxrError CloudXRClientPXR::CreateReceiver() {
+void CloudXRClientPXR::ApplyOptions() {
+    // read the generation first so a publish racing with this is applied next time
+    mOptionsGeneration = mOptionsStore.GetGeneration();
+    const std::shared_ptr<const PxrLaunchOptions> previous = mOptions;
+    mOptions = mOptionsStore.Get();
+    const PxrLaunchOptions &options = *mOptions;
+
+    AsyncLog::SetMinPriority(options.mLogLevel);
+    if (previous == nullptr || options.mThreadAffinity != previous->mThreadAffinity ||
+        options.mThreadPriority != previous->mThreadPriority) {
+        ThreadManager::Configure(options.mThreadAffinity, options.mThreadPriority);
+    }
+    if (previous == nullptr || options.mMaxVideoBitrate != previous->mMaxVideoBitrate ||
+        options.mFoveation != previous->mFoveation) {
+        StreamQualityPolicy policy;
+        if (options.mMaxVideoBitrate > 0) {
+            policy.maxBitrateKbps = options.mMaxVideoBitrate;
+        }
+        policy.minFoveation = (options.mFoveation > 0 && options.mFoveation < 100) ? options.mFoveation : 0;
+        mQuality.SetPolicy(policy);
+    }
+    if (previous == nullptr || options.mFaultInjection != previous->mFaultInjection) {
+        FaultProfile faults;
+        std::string error;
+        FaultInjector::ParseProfile(options.mFaultInjection, &faults, &error);
+#ifdef CXR_FAULT_INJECTION
+        mFaults.SetProfile(faults);
+        if (mFaults.IsEnabled()) {
+            LOGI("Injecting faults: %s", options.mFaultInjection.c_str());
+        }
+#else
+        if (!options.mFaultInjection.empty()) {
+            LOGE("Fault injection is not compiled into this build, ignoring: %s", options.mFaultInjection.c_str());
+        }
+#endif
+    }
+    if (previous == nullptr || options.mPoseFilter != previous->mPoseFilter ||
+        options.mPoseFilterCutoff != previous->mPoseFilterCutoff || options.mPoseFilterBeta != previous->mPoseFilterBeta) {
+        PoseFilterParams params;
+        params.minCutoffHz = options.mPoseFilterCutoff;
+        params.beta = options.mPoseFilterBeta;
+        mPoseFilter.SetParams(params);
+        uint32_t devices = 0;
+        if (options.mPoseFilter != PxrPoseFilter_Off) {
+            devices = (1u << PoseFilterDevice_LeftController) | (1u << PoseFilterDevice_RightController);
+        }
+        if (options.mPoseFilter == PxrPoseFilter_All) {
+            devices |= 1u << PoseFilterDevice_Head;
+        }
+        mPoseFilter.SetDeviceMask(devices);
+        if (mPoseFilter.IsEnabled()) {
+            LOGI("Pose filter mask:0x%x, cutoff:%.2fHz, beta:%.2f", devices, params.minCutoffHz, params.beta);
+        }
+    }
+    if (previous == nullptr) {
+        return;
+    }
 
-    if (Receiver) {
-        return cxrError_Success;
+    // the adaptive quality mode and the log level are read as they are used; the display rate
+    // can change right away; everything CloudXR takes at connect applies with the next one
+    if (options.mRefreshRate != previous->mRefreshRate && options.mRefreshRate > 0 && Receiver != nullptr) {
+        LOGI("Display refresh rate -> %.1f (launch option)", options.mRefreshRate);
+        if (Pxr_SetDisplayRefreshRate(options.mRefreshRate) != 0) {
+            LOGE("Pxr_SetDisplayRefreshRate(%.1f) failed", options.mRefreshRate);
+        }
     }
+    if (options.mServerIP != previous->mServerIP || options.mDebugFlags != previous->mDebugFlags ||
+        options.mMaxVideoBitrate != previous->mMaxVideoBitrate || options.mFoveation != previous->mFoveation) {
+        LOGI("Launch options for the connection changed; they apply at the next connect");
+    }
+    if (options.mStereoLayout != previous->mStereoLayout || options.mEventThread != previous->mEventThread) {
+        LOGI("stereo-layout and event-thread changes apply after a restart");
+    }
+}
 
-//    GOptions.mServerIP = "192.168.1.110";
-    if (GOptions.mServerIP.empty()) {
-        LOGE("No Server specified.");
-        return cxrError_No_Addr;
+StreamQualitySettings CloudXRClientPXR::GetStreamSettings() const {
+    if (mOptions->mAdaptiveQuality == PxrAdaptiveQuality_Off) {
+        StreamQualitySettings settings;
+        settings.bitrateKbps = mOptions->mMaxVideoBitrate;
+        settings.resFactor = 1.0f;
+        settings.foveation = mQuality.GetPolicy().minFoveation;
+        return settings;
     }
+    StreamQualitySettings settings = mQuality.GetTarget();
+    if (mOptions->mMaxVideoBitrate == 0 && settings.bitrateKbps >= mQuality.GetPolicy().maxBitrateKbps) {
+        // no limit was configured and none is needed; leave it to the server
+        settings.bitrateKbps = 0;
+    }
+    return settings;
+}
 
-    GetDeviceDesc(&mDeviceDesc);
+void CloudXRClientPXR::SetDataDir(const std::string &dir) {
+    mDataDir = dir;
+    // one cache per client, clients sharing a data directory read their own options back
+    mOptionsStore.SetCacheFile(dir + "/launch_options_cache_" + std::to_string(mClientId) + ".txt");
+}
 
-    if (mDeviceDesc.receiveAudio) {
-        // Initialize audio playback
-        oboe::AudioStreamBuilder playbackStreamBuilder;
-        playbackStreamBuilder.setDirection(oboe::Direction::Output);
-        playbackStreamBuilder.setPerformanceMode(oboe::PerformanceMode::LowLatency);
-        playbackStreamBuilder.setSharingMode(oboe::SharingMode::Exclusive);
-        playbackStreamBuilder.setFormat(oboe::AudioFormat::I16);
-        playbackStreamBuilder.setChannelCount(oboe::ChannelCount::Stereo);
-        playbackStreamBuilder.setSampleRate(CXR_AUDIO_SAMPLING_RATE);
+void CloudXRClientPXR::SetGraphicsContext(const cxrGraphicsContext &context) {
+    mGraphicsContext = context;
+}
 
-        oboe::Result ret = playbackStreamBuilder.openStream(playbackStream);
-        if (ret != oboe::Result::OK) {
-            LOGE("Failed to open playback stream. Error: %s", oboe::convertToText(ret));
-            return cxrError_Failed;
-        }
+const PxrLaunchOptions &CloudXRClientPXR::GetOptions() const {
+    return *mOptions;
+}
 
-        int bufferSizeFrames = playbackStream->getFramesPerBurst() * 2;
-        ret = playbackStream->setBufferSizeInFrames(bufferSizeFrames);
-        if (ret != oboe::Result::OK) {
-            LOGE("Failed to set playback stream buffer size to: %d. Error: %s", bufferSizeFrames, oboe::convertToText(ret));
-            return cxrError_Failed;
-        }
+cxrError CloudXRClientPXR::CreateReceiver() {
 
-        ret = playbackStream->start();
-        if (ret != oboe::Result::OK) {
-            LOGE("Failed to start playback stream. Error: %s", oboe::convertToText(ret));
-            return cxrError_Failed;
-        }
+    if (Receiver) {
+        return cxrError_Success;
     }
 
-    if (mDeviceDesc.sendAudio) {
-        // Initialize audio recording
-        oboe::AudioStreamBuilder recordingStreamBuilder;
-        recordingStreamBuilder.setDirection(oboe::Direction::Input);
-        recordingStreamBuilder.setPerformanceMode(oboe::PerformanceMode::LowLatency);
-        recordingStreamBuilder.setSharingMode(oboe::SharingMode::Exclusive);
-        recordingStreamBuilder.setFormat(oboe::AudioFormat::I16);
-        recordingStreamBuilder.setChannelCount(oboe::ChannelCount::Stereo);
-        recordingStreamBuilder.setSampleRate(CXR_AUDIO_SAMPLING_RATE);
-        recordingStreamBuilder.setInputPreset(oboe::InputPreset::VoiceCommunication);
-        recordingStreamBuilder.setDataCallback(this);
+//    mOptions->mServerIP = "192.168.1.110";
+    if (mOptions->mServerIP.empty()) {
+        LOGE("No Server specified.");
+        return cxrError_No_Addr;
+    }
 
-        oboe::Result ret = recordingStreamBuilder.openStream(recordingStream);
-        if (ret != oboe::Result::OK) {
-            LOGE("Failed to open recording stream. Error: %s", oboe::convertToText(ret));
-            return cxrError_Failed;
-        }
+    mPrediction.Load(mDataDir, mOptions->mServerIP);
+    InitRefreshRate();
+    GetDeviceDesc(&mDeviceDesc);
 
-        ret = recordingStream->start();
-        if (ret != oboe::Result::OK) {
-            LOGE("Failed to start recording stream. Error: %s", oboe::convertToText(ret));
-            return cxrError_Failed;
-        }
-    }
+    // opening the Oboe streams takes a while and does not depend on the receiver, so it runs
+    // alongside cxrCreateReceiver; nothing uses the streams before the receiver exists
+    std::future<cxrError> audio = std::async(std::launch::async, [this]() {
+        return OpenAudioStreams();
+    });
 
-    LOGI("Trying to create Receiver at %s.", GOptions.mServerIP.c_str());
-    cxrGraphicsContext context{cxrGraphicsContext_GLES};
-    context.egl.display = eglGetCurrentDisplay();
-    context.egl.context = eglGetCurrentContext();
+    LOGI("Trying to create Receiver at %s.", mOptions->mServerIP.c_str());
+    cxrGraphicsContext context = mGraphicsContext;
 
     if (context.egl.context == nullptr) {
         LOGE("Error, null context");
@@ -282,6 +401,9 @@ cxrError CloudXRClientPXR::CreateReceiver() {
                 LOGE("Client state updated: %s, reason: %s", ClientStateEnumToString(state), StateReasonEnumToString(reason));
                 break;
         }
+        if (state == cxrClientState_StreamingSessionInProgress) {
+            StartupTimeline::Mark(StartupPhase_Connected);
+        }
         reinterpret_cast<CloudXRClientPXR *>(context)->mClientState = state;
         LOGE("Client state updated: %s, reason: %s", ClientStateEnumToString(state), StateReasonEnumToString(reason));
     };
@@ -294,37 +416,98 @@ cxrError CloudXRClientPXR::CreateReceiver() {
     desc.shareContext = &context;
     desc.numStreams = 2;
     desc.receiverMode = cxrStreamingMode_XR;
-    desc.debugFlags = GOptions.mDebugFlags;
+    desc.debugFlags = mOptions->mDebugFlags;
     desc.debugFlags |= cxrDebugFlags_EnableAImageReaderDecoder;
     desc.debugFlags |= cxrDebugFlags_OutputLinearRGBColor;
     desc.logMaxSizeKB = CLOUDXR_LOG_MAX_DEFAULT;
     desc.logMaxAgeDays = CLOUDXR_LOG_MAX_DEFAULT;
 
+    mHaptics.Start();
     cxrError err = cxrCreateReceiver(&desc, &Receiver);
+    const cxrError audioErr = audio.get();
     if (err != cxrError_Success) {
         LOGE("Failed to create CloudXR receiver. Error %d, %s.", err, cxrErrorString(err));
+        mHaptics.Stop();
         return err;
     }
+    if (audioErr != cxrError_Success) {
+        cxrDestroyReceiver(Receiver);
+        Receiver = nullptr;
+        mHaptics.Stop();
+        return audioErr;
+    }
+    // recording sends to the receiver, so it only starts once there is one
+    if (mRecording.IsOpen() && mRecording.Start() != oboe::Result::OK) {
+        cxrDestroyReceiver(Receiver);
+        Receiver = nullptr;
+        mHaptics.Stop();
+        return cxrError_Failed;
+    }
 
+    mInput.Start();
+    StartupTimeline::Mark(StartupPhase_ReceiverCreated);
     LOGI("Receiver created!");
     return cxrError_Success;
 }
 
+cxrError CloudXRClientPXR::OpenAudioStreams() {
+    if (mDeviceDesc.receiveAudio) {
+        // Initialize audio playback
+        oboe::AudioStreamBuilder playbackStreamBuilder;
+        playbackStreamBuilder.setDirection(oboe::Direction::Output);
+        playbackStreamBuilder.setPerformanceMode(oboe::PerformanceMode::LowLatency);
+        playbackStreamBuilder.setSharingMode(oboe::SharingMode::Exclusive);
+        playbackStreamBuilder.setFormat(oboe::AudioFormat::I16);
+        playbackStreamBuilder.setChannelCount(oboe::ChannelCount::Stereo);
+        playbackStreamBuilder.setSampleRate(CXR_AUDIO_SAMPLING_RATE);
+
+        // the supervisor reopens it with the same settings after a disconnect or route change
+        if (mPlayback.Open(playbackStreamBuilder, 2) != oboe::Result::OK ||
+            mPlayback.Start() != oboe::Result::OK) {
+            return cxrError_Failed;
+        }
+    }
+
+    if (mDeviceDesc.sendAudio) {
+        // Initialize audio recording
+        oboe::AudioStreamBuilder recordingStreamBuilder;
+        recordingStreamBuilder.setDirection(oboe::Direction::Input);
+        recordingStreamBuilder.setPerformanceMode(oboe::PerformanceMode::LowLatency);
+        recordingStreamBuilder.setSharingMode(oboe::SharingMode::Exclusive);
+        recordingStreamBuilder.setFormat(oboe::AudioFormat::I16);
+        recordingStreamBuilder.setChannelCount(oboe::ChannelCount::Stereo);
+        recordingStreamBuilder.setSampleRate(CXR_AUDIO_SAMPLING_RATE);
+        recordingStreamBuilder.setInputPreset(oboe::InputPreset::VoiceCommunication);
+        recordingStreamBuilder.setDataCallback(this);
+
+        if (mRecording.Open(recordingStreamBuilder, 0) != oboe::Result::OK) {
+            return cxrError_Failed;
+        }
+    }
+
+    StartupTimeline::Mark(StartupPhase_AudioReady);
+    return cxrError_Success;
+}
+
 cxrError CloudXRClientPXR::Connect() {
     mConnectionDesc.async = cxrTrue;
-    mConnectionDesc.maxVideoBitrateKbps = GOptions.mMaxVideoBitrate;
-    mConnectionDesc.clientNetwork = GOptions.mClientNetwork;
-    mConnectionDesc.topology = GOptions.mTopology;
-    cxrError err = cxrConnect(Receiver, GOptions.mServerIP.c_str(), &mConnectionDesc);
+    const StreamQualitySettings settings = GetStreamSettings();
+    mQuality.SetApplied(settings);
+    LOGI("Connecting with bitrate:%ukbps, resFactor:%.2f, foveation:%u",
+         settings.bitrateKbps, settings.resFactor, settings.foveation);
+    mConnectionDesc.maxVideoBitrateKbps = settings.bitrateKbps;
+    mConnectionDesc.clientNetwork = mOptions->mClientNetwork;
+    mConnectionDesc.topology = mOptions->mTopology;
+    cxrError err = cxrConnect(Receiver, mOptions->mServerIP.c_str(), &mConnectionDesc);
     if (!mConnectionDesc.async) {
         if (err != cxrError_Success) {
             LOGE("Failed to connect to CloudXR server at %s. Error %d, %s.",
-                 GOptions.mServerIP.c_str(), (int) err, cxrErrorString(err));
+                 mOptions->mServerIP.c_str(), (int) err, cxrErrorString(err));
             TeardownReceiver();
             return err;
         } else {
             mClientState = cxrClientState_StreamingSessionInProgress;
-            LOGE("Receiver created for server: %s", GOptions.mServerIP.c_str());
+            LOGE("Receiver created for server: %s", mOptions->mServerIP.c_str());
         }
     }
     return cxrError_Success;
@@ -332,16 +515,186 @@ cxrError CloudXRClientPXR::Connect() {
 
 void CloudXRClientPXR::TeardownReceiver() {
     LOGE("TeardownReceiver...");
-    if (playbackStream) {
-        playbackStream->stop();
+    CloseAudioInput();
+    DestroyReceiver();
+    CloseAudioOutput();
+    mPrediction.Save(mDataDir, mOptions->mServerIP);
+    StopHaptics();
+}
+
+void CloudXRClientPXR::AddShutdownSteps(ShutdownSequence &sequence) {
+    sequence.Add("stats reporter", [this]() { mStatsReporter.Stop(); });
+    sequence.Add("soak report", [this]() { mSoak.Report(mPlayback.SampleXRunCount(), MonotonicNs() / 1000000); });
+    sequence.Add("audio input", [this]() { CloseAudioInput(); });
+    sequence.Add("receiver", [this]() {
+        mClientState = cxrClientState_Exiting;
+        DestroyReceiver();
+    });
+    sequence.Add("audio output", [this]() { CloseAudioOutput(); });
+    sequence.Add("haptics", [this]() { StopHaptics(); });
+    sequence.Add("options watcher", [this]() { mOptionsStore.StopWatching(); });
+    sequence.Add("save state", [this]() {
+        mPrediction.Save(mDataDir, mOptions->mServerIP);
+        mShutDown = true;
+    });
+}
+
+void CloudXRClientPXR::AddBenchmarks(MicroBenchmark &benchmark) {
+    PxrSensorState sensor{};
+    sensor.pose.orientation.w = 0.92f;
+    sensor.pose.orientation.x = 0.38f;
+    sensor.pose.position.y = 1.6f;
+    benchmark.Add("ConvertPose", [this, sensor](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            MicroBenchmark::Consume(ConvertPose(sensor, 0.45f));
+        }
+    });
+
+    cxrMatrix34 matrix{};
+    matrix.m[0][0] = matrix.m[1][1] = matrix.m[2][2] = 1.0f;
+    benchmark.Add("cxrToQuaternion", [this, matrix](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            MicroBenchmark::Consume(cxrToQuaternion(matrix));
+        }
+    });
+
+    const pxrMatrix4f transform = GetTransformFromPose(&sensor.pose);
+    benchmark.Add("Matrix4f_Multiply", [transform](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            MicroBenchmark::Consume(Matrix4f_Multiply(&transform, &transform));
+        }
+    });
+    benchmark.Add("GetTransformFromPose", [sensor](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            MicroBenchmark::Consume(GetTransformFromPose(&sensor.pose));
+        }
+    });
+    benchmark.Add("CreateRotation", [](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            MicroBenchmark::Consume(CreateRotation(0.45f, 0, 0));
+        }
+    });
+
+    PxrControllerInputState input{};
+    input.gripValue = 1;
+    benchmark.Add("GetInputId", [input](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            MicroBenchmark::Consume(GetInputId(PXR_CONTROLLER_RIGHT, input));
+        }
+    });
+
+    // the Pxr runtime supplies the controller state, so connected controllers are measured as is
+    benchmark.Add("ProcessControllers", [this](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            ProcessControllers();
+        }
+    });
+    benchmark.Add("DoTracking", [this](uint32_t iterations) {
+        for (uint32_t i = 0; i < iterations; i++) {
+            DoTracking();
+        }
+    });
+
+    // a filter of its own, so the client's state is left alone; all three devices, every frame
+    // moving, which is the most work one call does
+    benchmark.Add("PoseFilter", [sensor](uint32_t iterations) {
+        PoseFilter filter;
+        filter.SetDeviceMask((1u << PoseFilterDevice_Count) - 1);
+        PxrPosef poses[PoseFilterDevice_Count] = {sensor.pose, sensor.pose, sensor.pose};
+        PxrPosef *const targets[PoseFilterDevice_Count] = {&poses[0], &poses[1], &poses[2]};
+        double timeMs = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            const float step = (i & 1) ? 0.002f : -0.002f;
+            for (PxrPosef &pose : poses) {
+                pose.position.x += step;
+                pose.orientation.y += step;
+            }
+            timeMs += 11.1;
+            filter.Filter(timeMs, targets, (1u << PoseFilterDevice_Count) - 1);
+            MicroBenchmark::Consume(poses);
+        }
+    }, PoseFilter::kBudgetNs);
+
+    // a 10 ms frame of a 440 Hz tone, the size the receiver hands over. Connected, RenderAudio
+    // writes to the playback stream and onAudioReady sends to the receiver; before connecting,
+    // as on the device, the frame is dropped and only the client's share is measured
+    std::vector<int16_t> samples(10 * CXR_AUDIO_BYTES_PER_MS / sizeof(int16_t));
+    for (size_t i = 0; i < samples.size(); i++) {
+        const size_t frame = i / CXR_AUDIO_CHANNEL_COUNT;
+        samples[i] = int16_t(8000 * sinf(2 * float(M_PI) * 440 * frame / CXR_AUDIO_SAMPLING_RATE));
     }
-    if (recordingStream) {
-        recordingStream->close();
+    benchmark.Add("RenderAudio", [this, samples](uint32_t iterations) {
+        cxrAudioFrame frame{};
+        frame.streamBuffer = const_cast<int16_t *>(samples.data());
+        frame.streamSizeBytes = uint32_t(samples.size() * sizeof(int16_t));
+        for (uint32_t i = 0; i < iterations; i++) {
+            MicroBenchmark::Consume(RenderAudio(&frame));
+        }
+    });
+    benchmark.Add("onAudioReady", [this, samples](uint32_t iterations) {
+        const int32_t numFrames = int32_t(samples.size() / CXR_AUDIO_CHANNEL_COUNT);
+        for (uint32_t i = 0; i < iterations; i++) {
+            MicroBenchmark::Consume(onAudioReady(nullptr, const_cast<int16_t *>(samples.data()), numFrames));
+        }
+    });
+}
+
+ClientMetrics CloudXRClientPXR::GetMetrics() {
+    ClientMetrics metrics;
+    metrics.clientId = mClientId;
+    metrics.latchedFrames = mSoak.GetLatchCount();
+    metrics.heldFrames = mSoak.GetHeldCount();
+    metrics.injectedHeldFrames = mSoak.GetInjectedHeldCount();
+    metrics.longestHold = mSoak.GetMaxHoldStreak();
+    metrics.reconnects = mSoak.GetReconnectCount();
+    metrics.maxRecoveryMs = mSoak.GetMaxRecoveryMs();
+    metrics.trackingDelays = mSoak.GetTrackingDelayCount();
+    metrics.audioDrops = mSoak.GetAudioDropCount();
+    metrics.audioUnderruns = mPlayback.SampleXRunCount();
+    metrics.predictionHorizonMs = mPrediction.GetHorizonMs();
+    return metrics;
+}
+
+void CloudXRClientPXR::CloseAudioInput() {
+    // onAudioReady sends to the receiver, so recording stops before the receiver goes away
+    LogAudioRecovery("recording", mRecording);
+    mRecording.Close();
+}
+
+void CloudXRClientPXR::LogAudioRecovery(const char *name, const AudioStreamSupervisor &stream) {
+    if (stream.GetRerouteCount() == 0 && stream.GetFailedReopenCount() == 0) {
+        return;
     }
-    if (Receiver != nullptr) {
-        cxrDestroyReceiver(Receiver);
-        Receiver = nullptr;
+    LOGI("Audio %s reroutes:%u failed reopens:%u dropped frames:%llu recovery last:%.1fms max:%.1fms", name,
+         stream.GetRerouteCount(), stream.GetFailedReopenCount(), (unsigned long long) stream.GetDroppedFrames(),
+         stream.GetLastRecoveryMs(), stream.GetMaxRecoveryMs());
+}
+
+void CloudXRClientPXR::DestroyReceiver() {
+    // ends the CloudXR callbacks, RenderAudio included, and the session on the server
+    if (Receiver == nullptr) {
+        return;
     }
+    cxrDestroyReceiver(Receiver);
+    Receiver = nullptr;
+    // nothing folds the edges without tracking callbacks
+    mInput.Stop();
+    LOGI("Input: edges:%llu, short presses:%llu, overflows:%llu, mean edge age:%.2fms",
+         (unsigned long long) mInput.GetEdgeCount(), (unsigned long long) mInput.GetShortPressCount(),
+         (unsigned long long) mInput.GetOverflowCount(), mInput.GetMeanEdgeAgeMs());
+}
+
+void CloudXRClientPXR::CloseAudioOutput() {
+    LogAudioRecovery("playback", mPlayback);
+    mPlayback.Close();
+}
+
+void CloudXRClientPXR::StopHaptics() {
+    // no more haptic callbacks after the receiver is gone
+    mHaptics.Stop();
+    LOGI("Haptics: played:%llu, coalesced:%llu, stale:%llu, rejected:%llu",
+         (unsigned long long) mHaptics.GetPlayedCount(), (unsigned long long) mHaptics.GetCoalescedCount(),
+         (unsigned long long) mHaptics.GetStaleCount(), (unsigned long long) mHaptics.GetRejectedCount());
 }
 
 void CloudXRClientPXR::UpdateClientState() {
@@ -349,11 +702,33 @@ void CloudXRClientPXR::UpdateClientState() {
         return;
     }
 
+    if (mOptionsStore.GetGeneration() != mOptionsGeneration) {
+        ApplyOptions();
+    }
+
+    const uint64_t nowMs = MonotonicNs() / 1000000;
+#ifdef CXR_FAULT_INJECTION
+    if (mClientState == cxrClientState_StreamingSessionInProgress && mFaults.IsReconnectDue(nowMs)) {
+        LOGI("Reconnecting for fault injection");
+        mReconnectRequested = true;
+    } else
+#endif
+    if (mReconnectRequested) {
+        LOGI("Reconnecting to apply new stream quality settings");
+    }
+    if (mReconnectRequested) {
+        mReconnectRequested = false;
+        mSoak.OnReconnect(nowMs);
+        Stop();
+        mClientState = cxrClientState_ReadyToConnect;
+        Start();
+        return;
+    }
+
     if (mConnectionDesc.async) {
         switch (mClientState) {
             case cxrClientState_ConnectionAttemptInProgress: {
-                static int32_t attemptCount = 0;
-                if (++attemptCount % 60 == 0) {
+                if (++mConnectAttemptPolls % 60 == 0) {
                     LOGE("..... waiting for server connection .....");
                 }
                 break;
@@ -378,19 +753,26 @@ void CloudXRClientPXR::GetDeviceDesc(cxrDeviceDesc *params) const {
     params->deliveryType = cxrDeliveryType_Stereo_RGB;
     params->width = recommendW;
     params->height = recommendH;
-    params->fps = 90;
-    params->ipd = Pxr_GetIPD();
-    params->predOffset = -0.02f;
+    float refreshRate = mRefreshRate.GetCurrentRate();
+    if (refreshRate <= 0 && (Pxr_GetDisplayRefreshRate(&refreshRate) != 0 || refreshRate <= 0)) {
+        refreshRate = 90;
+    }
+    params->fps = refreshRate;
+    params->ipd = mDeviceState.GetIPD();
+    // the client extrapolates poses by the calibrated horizon (see DoTracking()) to the time the
+    // frame is actually shown; server prediction on top of that would overshoot
+    params->predOffset = 0;
     params->receiveAudio = true;
     params->sendAudio = false;
     params->embedInfoInVideo = false;
     params->posePollFreq = 0;
     params->ctrlType = cxrControllerType_OculusTouch;
-    params->disablePosePrediction = false;
+    params->disablePosePrediction = true;
     params->angularVelocityInDeviceSpace = false;
     params->disableVVSync = false;
-    params->foveatedScaleFactor = (GOptions.mFoveation > 0 && GOptions.mFoveation < 100) ? GOptions.mFoveation : 0;
-    params->maxResFactor = 1.0f;
+    const StreamQualitySettings settings = GetStreamSettings();
+    params->foveatedScaleFactor = settings.foveation;
+    params->maxResFactor = settings.resFactor;
 
     for (auto eye = 0; eye < PXR_EYE_MAX; eye++) {
         float fovLeft, fovRight, fovUp, fovDown;
@@ -410,20 +792,34 @@ void CloudXRClientPXR::GetDeviceDesc(cxrDeviceDesc *params) const {
 }
 
 void CloudXRClientPXR::GetTrackingState(cxrVRTrackingState *trackingState) {
+    ALLOCATION_AUDIT_SCOPE("GetTrackingState");
+    ThreadManager::TryRegisterCurrentThread(ThreadRole_Tracking, "CXRTracking");
+#ifdef CXR_FAULT_INJECTION
+    const uint32_t delayMs = mFaults.GetTrackingDelayMs();
+    if (delayMs > 0) {
+        mSoak.OnTrackingDelayed();
+        usleep(delayMs * 1000);
+    }
+#endif
     DoTracking();
+    const cxrTrackedDevicePose &hmdPose = TrackingState.hmd.pose;
+    if (hmdPose.poseIsValid) {
+        const double displayTimeMs = mPoseDisplayTimeMs.load(std::memory_order_relaxed);
+        const uint64_t targetNs = displayTimeMs > 0 ? uint64_t((displayTimeMs + mTrackedHorizonMs) * 1e6) : 0;
+        mLatency.RecordPose(MonotonicNs(), targetNs);
+    }
     if (trackingState != nullptr) {
         *trackingState = TrackingState;
     }
 }
 
 void CloudXRClientPXR::GetConnectionStats(uint64_t timeMs) {
-    static uint64_t lastTimeMs = 0;
     if (Receiver == nullptr || mClientState != cxrClientState_StreamingSessionInProgress) {
         return;
     }
-    uint64_t diff = timeMs - lastTimeMs;
+    uint64_t diff = timeMs - mLastStatsTimeMs;
     if (diff > 1000) {
-        lastTimeMs = timeMs;
+        mLastStatsTimeMs = timeMs;
         cxrConnectionStats stats = {0};
         cxrError ret = cxrGetConnectionStats(Receiver, &stats);
         if (ret == cxrError_Success) {
@@ -433,76 +829,169 @@ void CloudXRClientPXR::GetConnectionStats(uint64_t timeMs) {
                 "jitterUs:%d, totalPacketsReceived:%d, totalPacketsLost:%d, totalPacketsDropped:%d, quality:%d, qualityReasons:%d",
                 stats.bandwidthAvailableKbps, stats.bandwidthUtilizationKbps, stats.bandwidthUtilizationPercent, stats.roundTripDelayMs,
                 stats.jitterUs, stats.totalPacketsReceived, stats.totalPacketsLost, stats.totalPacketsDropped, stats.quality, stats.qualityReasons);    
+            LogLatency(stats);
+            UpdateRefreshRate(stats);
+            UpdateStreamQuality(stats);
+            if (++mStatsWindows % kThreadStatsWindows == 0) {
+                mStatsReporter.Request(mSoak.GetCounters(), mPlayback.SampleXRunCount(), MonotonicNs() / 1000000);
+            }
         } else {
             LOGE("cxrGetConnectionStats error %d", ret);
         }
     }
 }
 
+void CloudXRClientPXR::TrackLatency(const cxrFramesLatched &framesLatched, double predictedDisplayTimeMs) {
+    // the frame is tagged with the client time of its tracking sample; Pxr display times are
+    // CLOCK_MONOTONIC based too, the tracker drops display times that do not fit
+    mLatency.OnFrameLatched(framesLatched.timeStamp, MonotonicNs(), uint64_t(predictedDisplayTimeMs * 1e6));
+}
+
+void CloudXRClientPXR::LogLatency(const cxrConnectionStats &stats) {
+    const LatencyHistogram &poseToDisplay = mLatency.GetPoseToDisplay();
+    const LatencyHistogram &poseToLatch = mLatency.GetPoseToLatch();
+    const LatencyHistogram &latchToDisplay = mLatency.GetLatchToDisplay();
+    LOGI("latency poseToDisplay p50:%.1fms p90:%.1fms p99:%.1fms, poseToLatch p50:%.1fms p90:%.1fms p99:%.1fms, "
+         "latchToDisplay p50:%.1fms p99:%.1fms, matched:%u, unmatched:%u, ambiguous:%u",
+         poseToDisplay.GetPercentileMs(50), poseToDisplay.GetPercentileMs(90), poseToDisplay.GetPercentileMs(99),
+         poseToLatch.GetPercentileMs(50), poseToLatch.GetPercentileMs(90), poseToLatch.GetPercentileMs(99),
+         latchToDisplay.GetPercentileMs(50), latchToDisplay.GetPercentileMs(99),
+         poseToLatch.GetCount(), mLatency.GetUnmatchedCount(), mLatency.GetAmbiguousCount());
+    const float horizonMs = mPrediction.GetHorizonMs();
+    if (mPrediction.OnWindow(mLatency.GetMeanResidualMs(), mLatency.GetResidualCount())) {
+        LOGI("Prediction horizon %.1fms -> %.1fms, residual:%.1fms", horizonMs, mPrediction.GetHorizonMs(),
+             mLatency.GetMeanResidualMs());
+    }
+    if (poseToLatch.GetCount() > 0) {
+        // what the client-side stages do not explain is pose upload, server render/encode and network
+        const double clientMs = stats.frameDeliveryTime + stats.frameQueueTime + stats.frameLatchTime;
+        LOGI("latency stages delivery:%.1fms, queue:%.1fms, latch:%.1fms, server+network:%.1fms, display:%.1fms",
+             stats.frameDeliveryTime, stats.frameQueueTime, stats.frameLatchTime,
+             poseToLatch.GetMeanMs() - clientMs, latchToDisplay.GetMeanMs());
+    }
+    mLatency.ResetWindow();
+}
+
+void CloudXRClientPXR::InitRefreshRate() {
+    uint32_t count = 0;
+    float *rates = nullptr;
+    if (Pxr_GetDisplayRefreshRatesAvailable(&count, &rates) != 0 || rates == nullptr) {
+        count = 0;
+    }
+    mRefreshRate.SetAvailableRates(rates, count);
+    for (uint32_t i = 0; i < count; i++) {
+        LOGI("Supported display refresh rate: %.1f", rates[i]);
+    }
+
+    float current = 0;
+    Pxr_GetDisplayRefreshRate(&current);
+    if (mOptions->mRefreshRate > 0 && mOptions->mRefreshRate != current) {
+        LOGI("Display refresh rate %.1f -> %.1f (launch option)", current, mOptions->mRefreshRate);
+        if (Pxr_SetDisplayRefreshRate(mOptions->mRefreshRate) == 0) {
+            current = mOptions->mRefreshRate;
+        } else {
+            LOGE("Pxr_SetDisplayRefreshRate(%.1f) failed", mOptions->mRefreshRate);
+        }
+    }
+    mRefreshRate.SetCurrentRate(current);
+}
+
+void CloudXRClientPXR::OnDisplayRefreshChanged(float rate) {
+    // confirms the switch UpdateRefreshRate() asked for, without restarting its cooldown
+    mRefreshRate.OnRateChanged(rate);
+    // reported to the server with the next tracking state
+    mTargetDisplayRefresh.store(rate);
+    mRefreshChanged.store(true);
+}
+
+void CloudXRClientPXR::UpdateRefreshRate(const cxrConnectionStats &stats) {
+    if (mOptions->mRefreshRate > 0) {
+        return;
+    }
+    const float current = mRefreshRate.GetCurrentRate();
+    const float rate = mRefreshRate.OnWindow(stats.framesPerSecond, stats.frameDeliveryTime);
+    if (rate <= 0) {
+        return;
+    }
+    LOGI("Display refresh rate %.1f -> %.1f, framesPerSecond:%.1f, frameDeliveryTime:%.1fms",
+         current, rate, stats.framesPerSecond, stats.frameDeliveryTime);
+    if (Pxr_SetDisplayRefreshRate(rate) != 0) {
+        LOGE("Pxr_SetDisplayRefreshRate(%.1f) failed", rate);
+        mRefreshRate.SetCurrentRate(current);
+    }
+}
+
+void CloudXRClientPXR::UpdateStreamQuality(const cxrConnectionStats &stats) {
+    if (mOptions->mAdaptiveQuality == PxrAdaptiveQuality_Off) {
+        return;
+    }
+    StreamQualityStats qualityStats;
+    qualityStats.bandwidthAvailableKbps = stats.bandwidthAvailableKbps;
+    qualityStats.bandwidthUtilizationKbps = stats.bandwidthUtilizationKbps;
+    qualityStats.totalPacketsReceived = stats.totalPacketsReceived;
+    qualityStats.totalPacketsLost = stats.totalPacketsLost;
+    qualityStats.quality = stats.quality;
+    qualityStats.qualityReasons = stats.qualityReasons;
+    if (mQuality.OnWindow(qualityStats)) {
+        const StreamQualitySettings &target = mQuality.GetTarget();
+        LOGI("Stream quality target bitrate:%ukbps, resFactor:%.2f, foveation:%u (applied at next connect)",
+             target.bitrateKbps, target.resFactor, target.foveation);
+    }
+    if (mOptions->mAdaptiveQuality == PxrAdaptiveQuality_Reconnect && mQuality.ShouldReconnect()) {
+        mReconnectRequested = true;
+    }
+}
+
 void CloudXRClientPXR::SetPoseData(pxrPose pose) {
     // +1.7 metre height
     const float offsetHeight = 1.7f; 
+    mPoseDisplayTimeMs.store(pose.predictedDisplayTimeMs, std::memory_order_relaxed);
     headPose = pose.headPose;
     headPose.pose.position.y += offsetHeight;
     leftControllerPose = pose.leftControllerPose;
     leftControllerPose.pose.position.y += offsetHeight;
     rightControllerPose = pose.rightControllerPose;
     rightControllerPose.pose.position.y += offsetHeight;
+    if (mPoseFilter.IsEnabled()) {
+        PxrPosef *const poses[PoseFilterDevice_Count] = {
+                &headPose.pose, &leftControllerPose.pose, &rightControllerPose.pose};
+        const uint32_t valid = (headPose.status > 0 ? 1u << PoseFilterDevice_Head : 0) |
+                               (leftControllerPose.status > 0 ? 1u << PoseFilterDevice_LeftController : 0) |
+                               (rightControllerPose.status > 0 ? 1u << PoseFilterDevice_RightController : 0);
+        mPoseFilter.Filter(pose.predictedDisplayTimeMs, poses, valid);
+    }
 }
 
 void CloudXRClientPXR::DoTracking() {
+    // the Pxr poses are predicted for the local display time; extrapolate them further by the
+    // calibrated horizon so they match when the server's frame is actually shown
+    mTrackedHorizonMs = mPrediction.GetHorizonMs();
     ProcessControllers();
 
-    TrackingState.hmd.ipd = Pxr_GetIPD();
+    TrackingState.hmd.ipd = mDeviceState.GetIPD();
     // so we truncate the value to 5 decimal places (sub-millimeter precision)
     TrackingState.hmd.ipd = truncf(TrackingState.hmd.ipd * 10000.0f) / 10000.0f;
     TrackingState.hmd.flags = 0; // reset dynamic flags every frame
     TrackingState.hmd.flags |= cxrHmdTrackingFlags_HasIPD;
 
-    if (mRefreshChanged) {
-        TrackingState.hmd.displayRefresh = std::fminf(mTargetDisplayRefresh, 90.0f);
+    if (mRefreshChanged.exchange(false)) {
+        TrackingState.hmd.displayRefresh = mTargetDisplayRefresh.load();
         TrackingState.hmd.flags |= cxrHmdTrackingFlags_HasRefresh;
-        mRefreshChanged = false;
     }
 
-    TrackingState.hmd.pose = ConvertPose(headPose);
+    TrackingState.hmd.pose = ConvertPose(ExtrapolatePose(headPose, mTrackedHorizonMs / 1000));
     TrackingState.hmd.pose.poseIsValid = (headPose.status > 0) ? cxrTrue : cxrFalse;
     TrackingState.hmd.pose.deviceIsConnected = (headPose.status > 0) ? cxrTrue : cxrFalse;
     TrackingState.hmd.pose.trackingResult = cxrTrackingResult_Running_OK;
 }
 
 void CloudXRClientPXR::ProcessControllers() {
-    // these are Neo3-specific button mappings
-    const static PxrCxrButtonMapping Neo3LeftRemaps[] =
-            {
-                    {PXR_BtnX, cxrButton_X, "BtnX"},
-                    {PXR_BtnY, cxrButton_Y, "BtnY"},
-            };
-
-    const static PxrCxrButtonMapping Neo3RightRemaps[] =
-            {
-                    {PXR_BtnA, cxrButton_A, "BtnA"},
-                    {PXR_BtnB, cxrButton_B, "BtnB"},
-            };
-
-
-    // these are mappings referenced BY INDEX for manual remap logic
-    const static PxrCxrButtonMapping extraRemaps[] =
-            {
-                    {PXR_Menu,          cxrButton_System,         "BtnSystem"},
-                    {PXR_Touch_Trigger, cxrButton_Trigger_Touch,  "TouchTrig"},
-                    {PXR_Trigger,       cxrButton_Trigger_Click,  "BtnTrig"},
-                    {PXR_Touchpad,      cxrButton_Touchpad_Click, "TouchTrack"},
-                    {PXR_Grip,          cxrButton_Grip_Click,     "BtnGrip"}
-            };
-
     if (Pxr_IsRunning()) {
-        PxrControllerCapability cap;
         for (auto hand: {PXR_CONTROLLER_LEFT, PXR_CONTROLLER_RIGHT}) {
-            Pxr_GetControllerCapabilities(hand, &cap);
-            if (Pxr_GetControllerConnectStatus(hand) == 1) {
+            if (mDeviceState.IsControllerConnected(hand)) {
 
-                TrackingState.controller[hand].pose = ConvertPose((hand == PXR_CONTROLLER_LEFT) ? leftControllerPose : rightControllerPose, 0.45f);
+                TrackingState.controller[hand].pose = ConvertPose(ExtrapolatePose((hand == PXR_CONTROLLER_LEFT) ? leftControllerPose : rightControllerPose,
+                                                                               mTrackedHorizonMs / 1000), 0.45f);
 
                 TrackingState.controller[hand].pose.deviceIsConnected = cxrTrue;
                 TrackingState.controller[hand].pose.trackingResult = cxrTrackingResult_Running_OK;
@@ -510,35 +999,12 @@ void CloudXRClientPXR::ProcessControllers() {
                 // stash current state of booleanComps, to evaluate at end of fn for changes in state this frame.
                 const uint64_t priorCompsState = TrackingState.controller[hand].booleanComps;
 
-                // clear changed flags for this pass
-                TrackingState.controller[hand].booleanCompsChanged = 0;
-
                 PxrControllerInputState state;
                 Pxr_GetControllerInputState(hand, &state);
 
-                PxrInputId btnId = GetInputId(hand, state);
-
-                if (hand == PXR_CONTROLLER_LEFT) {
-                    for (auto &mapping: Neo3LeftRemaps) {
-                        if (mapping.cxrId == cxrButton_Num) {
-                            continue;
-                        }
-                        setBooleanButton(TrackingState.controller[hand], btnId, mapping);
-                    }
-                } else {
-                    for (auto &mapping: Neo3RightRemaps) {
-                        if (mapping.cxrId == cxrButton_Num) {
-                            continue;
-                        }
-                        setBooleanButton(TrackingState.controller[hand], btnId, mapping);
-                    }
-                }
-
-                setBooleanButton(TrackingState.controller[hand], btnId, extraRemaps[0]);
-                setBooleanButton(TrackingState.controller[hand], btnId, extraRemaps[1]);
-                setBooleanButton(TrackingState.controller[hand], btnId, extraRemaps[2]);
-                setBooleanButton(TrackingState.controller[hand], btnId, extraRemaps[3]);
-                setBooleanButton(TrackingState.controller[hand], btnId, extraRemaps[4]);
+                // the presses and releases sampled by mInput since the last callback, each one
+                // changing booleanComps for at least one callback, not just the current state
+                TrackingState.controller[hand].booleanComps = mInput.Fold(hand);
 
                 TrackingState.controller[hand].scalarComps[cxrAnalog_Trigger] = state.triggerValue;
                 TrackingState.controller[hand].scalarComps[cxrAnalog_JoystickX] = state.Joystick.x;
@@ -551,40 +1017,34 @@ void CloudXRClientPXR::ProcessControllers() {
     }
 }
 
-bool CloudXRClientPXR::setBooleanButton(cxrControllerTrackingState &ctl, const uint64_t &inBitfield, const PxrCxrButtonMapping &mapping) {
-    const uint64_t prevComps = ctl.booleanComps;
-    const uint64_t btnMask = 1ULL << mapping.cxrId;
-
-    if (inBitfield == mapping.pxrId) {
-        ctl.booleanComps |= btnMask;
-    } else {
-        ctl.booleanComps &= ~btnMask;
-    }
-
-    if (prevComps != ctl.booleanComps) {
-        return true; // we return true when button goes 'down' first frame
-    }
-
-    return false;
-}
-
 cxrBool CloudXRClientPXR::RenderAudio(const cxrAudioFrame *audioFrame) {
-    if (!playbackStream.get()) {
-        return cxrFalse;
+    ALLOCATION_AUDIT_SCOPE("RenderAudio");
+    ThreadManager::TryRegisterCurrentThread(ThreadRole_Audio, "CXRAudioOut");
+#ifdef CXR_FAULT_INJECTION
+    if (mFaults.DropAudio()) {
+        mSoak.OnAudioDropped();
+        return cxrTrue;
     }
-
+#endif
     const uint32_t timeout = audioFrame->streamSizeBytes / CXR_AUDIO_BYTES_PER_MS;
     const uint32_t numFrames = timeout * CXR_AUDIO_SAMPLING_RATE / 1000;
-    playbackStream->write(audioFrame->streamBuffer, numFrames, timeout * oboe::kNanosPerMillisecond);
+    // while the device is being reopened the frame is dropped instead of waiting for it
+    if (!mPlayback.Write(audioFrame->streamBuffer, numFrames, timeout * oboe::kNanosPerMillisecond)) {
+        return cxrFalse;
+    }
 
     return cxrTrue;
 }
 
 oboe::DataCallbackResult CloudXRClientPXR::onAudioReady(oboe::AudioStream *oboeStream, void *audioData, int32_t numFrames) {
+    ALLOCATION_AUDIT_SCOPE("onAudioReady");
+    ThreadManager::TryRegisterCurrentThread(ThreadRole_Audio, "AudioRecord");
     cxrAudioFrame recordedFrame{};
     recordedFrame.streamBuffer = (int16_t *) audioData;
     recordedFrame.streamSizeBytes = numFrames * CXR_AUDIO_CHANNEL_COUNT * CXR_AUDIO_SAMPLE_SIZE;
-    cxrSendAudio(Receiver, &recordedFrame);
+    if (Receiver != nullptr) {
+        cxrSendAudio(Receiver, &recordedFrame);
+    }
 
     return oboe::DataCallbackResult::Continue;
 }
@@ -596,13 +1056,32 @@ bool CloudXRClientPXR::LatchFrame(cxrFramesLatched *framesLatched) {
 
     if (Receiver) {
         if (mClientState == cxrClientState_StreamingSessionInProgress) {
+#ifdef CXR_FAULT_INJECTION
+            const uint32_t stallMs = mFaults.GetLatchStallMs();
+            if (stallMs > 0) {
+                usleep(stallMs * 1000);
+            }
+#endif
             cxrError frameErr = cxrLatchFrame(Receiver, framesLatched, cxrFrameMask_All, timeoutMs);
             frameValid = (frameErr == cxrError_Success);
-            if (!frameValid) {
+            bool injected = false;
+#ifdef CXR_FAULT_INJECTION
+            injected = frameValid && mFaults.DropLatch();
+            if (injected) {
+                // held like a late frame; the soak stats tell the two apart
+                cxrReleaseFrame(Receiver, framesLatched);
+                frameValid = false;
+            }
+#endif
+            mSoak.OnLatch(frameValid, injected, MonotonicNs() / 1000000);
+            if (frameValid) {
+                StartupTimeline::Mark(StartupPhase_FirstFrameLatched);
+            }
+            if (!frameValid && !injected) {
                 if (frameErr == cxrError_Frame_Not_Ready) {
-                    LOGE("Error in LatchFrame, frame not ready for %d ms", timeoutMs);
+                    LOGE_RATE_LIMITED(1000, "Error in LatchFrame, frame not ready for %d ms", timeoutMs);
                 } else {
-                    LOGE("Error in LatchFrame [%0d] = %s", frameErr, cxrErrorString(frameErr));
+                    LOGE_RATE_LIMITED(1000, "Error in LatchFrame [%0d] = %s", frameErr, cxrErrorString(frameErr));
                 }
             }
         }
@@ -618,28 +1097,14 @@ void CloudXRClientPXR::BlitFrame(cxrFramesLatched *framesLatched, bool frameVali
     }
 }
 
-bool CloudXRClientPXR::SetupFramebuffer(GLuint colorTexture, uint32_t eye) {
-    if(Framebuffers[eye] == 0) {
-        GLuint framebuffer;
-        glGenFramebuffers(1, &framebuffer);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
-        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
-
-        GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-
-        if (status != GL_FRAMEBUFFER_COMPLETE) {
-            LOGI("Incomplete frame buffer object!");
-            return false;
-        }
-        Framebuffers[eye] = framebuffer;
-        LOGI("Created FBO %d for eye%d texture %d.", framebuffer, eye, colorTexture);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, Framebuffers[eye]);
+void CloudXRClientPXR::BlitStereoFrame(cxrFramesLatched *framesLatched, bool frameValid, uint32_t eyeWidth, uint32_t eyeHeight) {
+    // both eyes share the bound framebuffer, side by side; one blit puts each eye into its half
+    glViewport(0, 0, eyeWidth * PXR_EYE_MAX, eyeHeight);
+    if (frameValid) {
+        cxrBlitFrame(Receiver, framesLatched, cxrFrameMask_All);
     } else {
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, Framebuffers[eye]);
-        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+        FillBackground();
     }
-    return true;
 }
 
 void CloudXRClientPXR::ReleaseFrame(cxrFramesLatched *framesLatched) {
@@ -670,14 +1135,20 @@ void CloudXRClientPXR::FillBackground() const {
 }
 
 void CloudXRClientPXR::TriggerHaptic(const cxrHapticFeedback *hapticFeedback) {
+    ALLOCATION_AUDIT_SCOPE("TriggerHaptic");
     const cxrHapticFeedback &haptic = *hapticFeedback;
     if (haptic.seconds <= 0) {
         return;
     }
 
-    PxrControllerCapability cap;
-    Pxr_GetControllerCapabilities(haptic.controllerIdx, &cap);
-    if (Pxr_GetControllerConnectStatus(haptic.controllerIdx) == 1) {
-        Pxr_SetControllerVibration(haptic.controllerIdx, haptic.amplitude, haptic.seconds * 1000);
+    // runs on the callback thread that also serves GetTrackingState, so only queue it here
+    HapticPulse pulse;
+    pulse.controller = haptic.controllerIdx;
+    pulse.startAmplitude = haptic.amplitude;
+    pulse.endAmplitude = haptic.amplitude;
+    pulse.frequency = haptic.frequency;
+    pulse.durationMs = std::max<uint32_t>(1, uint32_t(haptic.seconds * 1000));
+    if (!mHaptics.Submit(pulse)) {
+        LOGE_RATE_LIMITED(1000, "Haptic pulse for controller %u rejected", haptic.controllerIdx);
     }
 }
@@ -6,23 +6,74 @@
 #include <math.h>
 #include <stdio.h>
 #include <mutex>
+#include <atomic>
 #include <oboe/Oboe.h>
 #include <unordered_map>
 #include <PxrInput.h>
 #include "util.h"
 #include "PxrTypes.h"
 #include "PxrHelper.h"
+#include "PxrDeviceState.h"
+#include "HapticsScheduler.h"
+#include "LatencyTracker.h"
+#include "PredictionCalibrator.h"
+#include "RefreshRateController.h"
+#include "StreamQualityController.h"
+#include "PxrLaunchOptions.h"
+#include "LaunchOptionsStore.h"
+#include "ShutdownSequence.h"
+#include "AudioStreamSupervisor.h"
+#include "MicroBenchmark.h"
+#include "FaultInjector.h"
+#include "SoakStats.h"
+#include "StatsReporter.h"
+#include "InputSampler.h"
+#include "PoseFilter.h"
+
+// Counters of one client since it was created, for comparing or summing several clients.
+struct ClientMetrics {
+    uint32_t clientId;
+    uint64_t latchedFrames;
+    uint64_t heldFrames;
+    // held because the fault injector dropped the frame, and the longest run of held frames
+    uint64_t injectedHeldFrames;
+    uint32_t longestHold;
+    uint32_t reconnects;
+    uint64_t maxRecoveryMs;
+    uint64_t trackingDelays;
+    uint64_t audioDrops;
+    uint32_t audioUnderruns;
+    float predictionHorizonMs;
+};
 
+// One CloudXR client. Several can run in one process, each with its own launch options file
+// and options cache; what they share is process wide:
+// - the async log and its level, and the ThreadManager policies and thread slots; the options
+//   applied last win,
+// - the StartupTimeline, which times the first client to reach each phase,
+// - the Pxr runtime: display refresh rate switches, controller vibration and the controller
+//   input and tracking state go to the one headset.
 class CloudXRClientPXR : public oboe::AudioStreamDataCallback {
 
 public:
 
-    CloudXRClientPXR();
+    // Reads its launch options from optionsPath, /sdcard/CloudXRLaunchOptions.txt when null.
+    explicit CloudXRClientPXR(const char *optionsPath = nullptr);
 
     ~CloudXRClientPXR();
 
     void Initialize();
 
+    // The active launch options; only valid on the render thread until the next UpdateClientState().
+    const PxrLaunchOptions &GetOptions() const;
+
+    // Directory for state kept between launches, such as the learned prediction horizon and the
+    // last valid launch options, cached per client id.
+    void SetDataDir(const std::string &dir);
+
+    // The graphics device CloudXR decodes and blits with, from the graphics plugin.
+    void SetGraphicsContext(const cxrGraphicsContext &context);
+
     void SetPaused(bool pause);
 
     bool Start();
@@ -41,16 +92,33 @@ public:
 
     cxrError CreateReceiver();
 
+    // Opens the playback stream and starts it, and opens the recording stream without starting it.
+    cxrError OpenAudioStreams();
+
     cxrError Connect();
 
     void TeardownReceiver();
 
+    // Adds the client's teardown in dependency order: the stats reporter, audio input, receiver,
+    // audio output, haptics, the options watcher, then the state kept between launches. Once
+    // the steps ran, deleting the client releases nothing more.
+    void AddShutdownSteps(ShutdownSequence &sequence);
+
+    // Adds the per-frame and per-packet functions: pose conversion and matrix helpers, input
+    // mapping, DoTracking and the two audio callbacks.
+    void AddBenchmarks(MicroBenchmark &benchmark);
+
+    // Render thread.
+    ClientMetrics GetMetrics();
+
     void UpdateClientState();
 
     bool LatchFrame(cxrFramesLatched *framesLatched);
 
     void BlitFrame(cxrFramesLatched *framesLatched, bool frameValid, int eye);
 
+    void BlitStereoFrame(cxrFramesLatched *framesLatched, bool frameValid, uint32_t eyeWidth, uint32_t eyeHeight);
+
     void ReleaseFrame(cxrFramesLatched *framesLatched);
 
     void ProcessControllers();
@@ -69,43 +137,108 @@ public:
 
     void GetConnectionStats(uint64_t timeMs);
 
+    // Runtime confirmed a display refresh rate change; passes it on to the server.
+    void OnDisplayRefreshChanged(float rate);
+
+    // Matches a latched frame to the tracking sample it was rendered with; call right after LatchFrame().
+    void TrackLatency(const cxrFramesLatched &framesLatched, double predictedDisplayTimeMs);
+
     PxrQuaternionf cxrToQuaternion(const cxrMatrix34 &m);
 
     PxrVector3f cxrGetTranslation(const cxrMatrix34 &m);
 
-    bool SetupFramebuffer(GLuint colorTexture, uint32_t eye);
+    PxrDeviceState &GetDeviceState() { return mDeviceState; }
+
+    bool IsStreaming() const { return mClientState == cxrClientState_StreamingSessionInProgress; }
 
 protected:
-    bool mRefreshChanged = false;
-    float_t mTargetDisplayRefresh = 0;
+    // Applies the latest published launch options; render thread.
+    void ApplyOptions();
+
+    void CloseAudioInput();
+
+    void DestroyReceiver();
+
+    void CloseAudioOutput();
+
+    static void LogAudioRecovery(const char *name, const AudioStreamSupervisor &stream);
+
+    void StopHaptics();
 
-    std::shared_ptr<oboe::AudioStream> recordingStream{};
-    std::shared_ptr<oboe::AudioStream> playbackStream{};
+    LaunchOptionsStore mOptionsStore;
+    // snapshot the render thread works with, and the generation it came from
+    std::shared_ptr<const PxrLaunchOptions> mOptions;
+    uint32_t mOptionsGeneration = 0;
+
+    // set on the render thread, sent by the tracking thread
+    std::atomic<bool> mRefreshChanged{false};
+    std::atomic<float> mTargetDisplayRefresh{0};
+    RefreshRateController mRefreshRate;
+    StreamQualityController mQuality;
+    // set by the stats check, handled by UpdateClientState(); both on the render thread
+    bool mReconnectRequested = false;
+    // render thread: stats window start, and UpdateClientState() calls while connecting
+    uint64_t mLastStatsTimeMs = 0;
+    uint32_t mConnectAttemptPolls = 0;
+    // stats windows seen; thread stats are logged every kThreadStatsWindows of them
+    static const uint32_t kThreadStatsWindows = 10;
+    uint32_t mStatsWindows = 0;
+
+    // reopened in place when the audio device disconnects or the route changes
+    AudioStreamSupervisor mRecording{"recording"};
+    AudioStreamSupervisor mPlayback{"playback"};
 
     cxrVRTrackingState TrackingState = {};
     cxrReceiverHandle Receiver = nullptr;
-    cxrClientState mClientState = cxrClientState_ReadyToConnect;
+    // written by the CloudXR callback thread
+    std::atomic<cxrClientState> mClientState{cxrClientState_ReadyToConnect};
     cxrDeviceDesc mDeviceDesc = {};
     cxrConnectionDesc mConnectionDesc = {};
     PxrSensorState headPose = {};
     PxrSensorState leftControllerPose = {};
     PxrSensorState rightControllerPose = {};
 
+    PxrDeviceState mDeviceState;
+    HapticsScheduler mHaptics;
+    // button edges between two tracking callbacks
+    InputSampler mInput;
+    LatencyTracker mLatency;
+    PredictionCalibrator mPrediction;
+#ifdef CXR_FAULT_INJECTION
+    FaultInjector mFaults;
+#endif
+    SoakStats mSoak;
+    // logs the thread and soak stats off the render thread
+    StatsReporter mStatsReporter;
+    // render thread only
+    PoseFilter mPoseFilter;
+    // display time the current poses were predicted for, written by SetPoseData()
+    std::atomic<double> mPoseDisplayTimeMs{0};
+    // horizon applied to the tracking state being built, tracking thread only
+    float mTrackedHorizonMs = 0;
+    const uint32_t mClientId;
+    const std::string mOptionsPath;
+    std::string mDataDir;
+    cxrGraphicsContext mGraphicsContext{};
+
     bool mIsPaused;
     bool mWasPaused;
+    // set by the last shutdown step, the destructor has nothing left to do then
+    bool mShutDown = false;
 
     uint32_t mDefaultBGColor = 0xFF000000; // black to start until we set around OnResume.
     uint32_t mBGColor = mDefaultBGColor;
 
-    struct PxrCxrButtonMapping {
-        unsigned int pxrId;
-        cxrButtonId cxrId;
-        char nameStr[32];
-    };
+    void LogLatency(const cxrConnectionStats &stats);
+
+    void InitRefreshRate();
+
+    void UpdateRefreshRate(const cxrConnectionStats &stats);
 
-    GLuint Framebuffers[2];
+    // Settings for the next connection: the quality controller's target, or the launch options.
+    StreamQualitySettings GetStreamSettings() const;
 
-    bool setBooleanButton(cxrControllerTrackingState &ctl, const uint64_t &inBitfield, const PxrCxrButtonMapping &mapping);
+    void UpdateStreamQuality(const cxrConnectionStats &stats);
 
 };
 
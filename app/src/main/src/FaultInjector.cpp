@@ -0,0 +1,135 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "FaultInjector.h"
+#include <stdlib.h>
+#include <sstream>
+
+namespace {
+    const uint32_t kMaxDelayMs = 10000;
+
+    uint64_t SplitMix64(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    uint32_t ToPpm(float percent) {
+        return uint32_t(percent * 10000.0f + 0.5f);
+    }
+
+    bool ParsePercent(const std::string &text, float *percent) {
+        char *end = nullptr;
+        *percent = strtof(text.c_str(), &end);
+        return end != text.c_str() && *end == '\0' && *percent >= 0 && *percent <= 100;
+    }
+
+    bool ParseUint(const std::string &text, uint32_t max, uint32_t *value) {
+        char *end = nullptr;
+        const unsigned long parsed = strtoul(text.c_str(), &end, 10);
+        if (end == text.c_str() || *end != '\0' || text[0] == '-' || parsed > max) {
+            return false;
+        }
+        *value = uint32_t(parsed);
+        return true;
+    }
+
+    // MS@P
+    bool ParseDelay(const std::string &text, uint32_t *delayMs, float *percent) {
+        const size_t at = text.find('@');
+        return at != std::string::npos && ParseUint(text.substr(0, at), kMaxDelayMs, delayMs) &&
+               ParsePercent(text.substr(at + 1), percent);
+    }
+}
+
+bool FaultInjector::ParseProfile(const std::string &text, FaultProfile *profile, std::string *error) {
+    *profile = FaultProfile();
+    std::stringstream list(text);
+    std::string entry;
+    while (std::getline(list, entry, ',')) {
+        if (entry.empty()) {
+            continue;
+        }
+        const size_t colon = entry.find(':');
+        const std::string key = entry.substr(0, colon);
+        const std::string value = colon == std::string::npos ? std::string() : entry.substr(colon + 1);
+        bool valid = false;
+        if (key == "latch-drop") {
+            valid = ParsePercent(value, &profile->latchDropPercent);
+        } else if (key == "latch-stall") {
+            valid = ParseDelay(value, &profile->latchStallMs, &profile->latchStallPercent);
+        } else if (key == "tracking-delay") {
+            valid = ParseDelay(value, &profile->trackingDelayMs, &profile->trackingDelayPercent);
+        } else if (key == "audio-drop") {
+            valid = ParsePercent(value, &profile->audioDropPercent);
+        } else if (key == "reconnect") {
+            valid = ParseUint(value, 24 * 3600, &profile->reconnectIntervalS) && profile->reconnectIntervalS > 0;
+        } else if (key == "seed") {
+            valid = ParseUint(value, UINT32_MAX, &profile->seed);
+        }
+        if (!valid) {
+            *error = "invalid fault-injection entry " + entry;
+            return false;
+        }
+    }
+    return true;
+}
+
+void FaultInjector::SetProfile(const FaultProfile &profile) {
+    mSeed.store(profile.seed, std::memory_order_relaxed);
+    mLatchDropPpm.store(ToPpm(profile.latchDropPercent), std::memory_order_relaxed);
+    mLatchStallMs.store(profile.latchStallMs, std::memory_order_relaxed);
+    mLatchStallPpm.store(profile.latchStallMs > 0 ? ToPpm(profile.latchStallPercent) : 0, std::memory_order_relaxed);
+    mTrackingDelayMs.store(profile.trackingDelayMs, std::memory_order_relaxed);
+    mTrackingDelayPpm.store(profile.trackingDelayMs > 0 ? ToPpm(profile.trackingDelayPercent) : 0, std::memory_order_relaxed);
+    mAudioDropPpm.store(ToPpm(profile.audioDropPercent), std::memory_order_relaxed);
+    mReconnectIntervalS.store(profile.reconnectIntervalS, std::memory_order_relaxed);
+    mNextReconnectMs = 0;
+    for (std::atomic<uint64_t> &draws : mDraws) {
+        draws.store(0, std::memory_order_relaxed);
+    }
+    mEnabled.store(mLatchDropPpm.load(std::memory_order_relaxed) != 0 || mLatchStallPpm.load(std::memory_order_relaxed) != 0 ||
+                   mTrackingDelayPpm.load(std::memory_order_relaxed) != 0 || mAudioDropPpm.load(std::memory_order_relaxed) != 0 ||
+                   profile.reconnectIntervalS != 0, std::memory_order_relaxed);
+}
+
+bool FaultInjector::DropLatch() {
+    return Roll(Site_LatchDrop, mLatchDropPpm.load(std::memory_order_relaxed));
+}
+
+uint32_t FaultInjector::GetLatchStallMs() {
+    return Roll(Site_LatchStall, mLatchStallPpm.load(std::memory_order_relaxed)) ? mLatchStallMs.load(std::memory_order_relaxed) : 0;
+}
+
+bool FaultInjector::IsReconnectDue(uint64_t nowMs) {
+    const uint32_t intervalS = mReconnectIntervalS.load(std::memory_order_relaxed);
+    if (intervalS == 0) {
+        return false;
+    }
+    if (mNextReconnectMs == 0) {
+        mNextReconnectMs = nowMs + intervalS * 1000ULL;
+        return false;
+    }
+    if (nowMs < mNextReconnectMs) {
+        return false;
+    }
+    mNextReconnectMs = nowMs + intervalS * 1000ULL;
+    return true;
+}
+
+uint32_t FaultInjector::GetTrackingDelayMs() {
+    return Roll(Site_TrackingDelay, mTrackingDelayPpm.load(std::memory_order_relaxed)) ? mTrackingDelayMs.load(std::memory_order_relaxed) : 0;
+}
+
+bool FaultInjector::DropAudio() {
+    return Roll(Site_AudioDrop, mAudioDropPpm.load(std::memory_order_relaxed));
+}
+
+bool FaultInjector::Roll(Site site, uint32_t ppm) {
+    if (ppm == 0) {
+        return false;
+    }
+    const uint64_t draw = mDraws[site].fetch_add(1, std::memory_order_relaxed);
+    const uint64_t stream = (uint64_t(mSeed.load(std::memory_order_relaxed)) << 8) | uint64_t(site);
+    const uint64_t x = SplitMix64(SplitMix64(stream) ^ draw);
+    return uint32_t((x >> 32) % 1000000) < ppm;
+}
@@ -0,0 +1,89 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_FAULT_INJECTOR_H
+#define CLIENT_APP_FAULT_INJECTOR_H
+
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+// Faults to inject into a live session, from the fault-injection launch option: a comma
+// separated list of
+//   latch-drop:P          drop P percent of latched frames, as if the latch timed out
+//   latch-stall:MS@P      stall the render thread for MS before P percent of the latches
+//   tracking-delay:MS@P   answer P percent of the GetTrackingState callbacks MS late
+//   audio-drop:P          drop P percent of the received audio frames
+//   reconnect:S           tear the session down and reconnect every S seconds
+//   seed:N                seed of the random streams, so a run can be repeated
+struct FaultProfile {
+    uint32_t seed = 1;
+    float latchDropPercent = 0;
+    uint32_t latchStallMs = 0;
+    float latchStallPercent = 0;
+    uint32_t trackingDelayMs = 0;
+    float trackingDelayPercent = 0;
+    float audioDropPercent = 0;
+    uint32_t reconnectIntervalS = 0;
+};
+
+// Decides, per call site, whether the next frame, callback or audio packet gets a fault.
+//
+// The client only calls it in builds with CXR_FAULT_INJECTION (debug builds, or ndk-build
+// CXR_FAULT_INJECTION=1); without it the hooks are not compiled and a profile is only parsed.
+//
+// The profile can change at any time from the render thread; the checks run on the render,
+// tracking and audio threads and only touch atomics. Each site has its own random stream, a
+// hash of the profile seed, the site and a draw counter, so the sites of one instance never
+// share a stream, and the same profile produces the same faults in every instance: clients
+// given the same seed fail alike, clients that should not need seeds of their own. Every check
+// is a single relaxed load when nothing is injected.
+class FaultInjector {
+
+public:
+    // Parses the launch option text; an empty text is the empty profile.
+    static bool ParseProfile(const std::string &text, FaultProfile *profile, std::string *error);
+
+    void SetProfile(const FaultProfile &profile);
+
+    bool IsEnabled() const { return mEnabled.load(std::memory_order_relaxed); }
+
+    // render thread
+    bool DropLatch();
+
+    uint32_t GetLatchStallMs();
+
+    // Whether the session is due for an injected reconnect; restarts the interval when it is.
+    bool IsReconnectDue(uint64_t nowMs);
+
+    // tracking thread
+    uint32_t GetTrackingDelayMs();
+
+    // audio thread
+    bool DropAudio();
+
+private:
+    enum Site {
+        Site_LatchDrop,
+        Site_LatchStall,
+        Site_TrackingDelay,
+        Site_AudioDrop,
+        Site_Count,
+    };
+
+    // true with the given probability in parts per million
+    bool Roll(Site site, uint32_t ppm);
+
+    std::atomic<bool> mEnabled{false};
+    std::atomic<uint32_t> mSeed{1};
+    std::atomic<uint64_t> mDraws[Site_Count] = {};
+    std::atomic<uint32_t> mLatchDropPpm{0};
+    std::atomic<uint32_t> mLatchStallMs{0};
+    std::atomic<uint32_t> mLatchStallPpm{0};
+    std::atomic<uint32_t> mTrackingDelayMs{0};
+    std::atomic<uint32_t> mTrackingDelayPpm{0};
+    std::atomic<uint32_t> mAudioDropPpm{0};
+    std::atomic<uint32_t> mReconnectIntervalS{0};
+    // render thread only
+    uint64_t mNextReconnectMs = 0;
+};
+
+#endif //CLIENT_APP_FAULT_INJECTOR_H
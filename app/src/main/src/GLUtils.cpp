@@ -1,9 +1,51 @@
 #include "GLUtils.h"
 #include <cstdlib>
 #include <cstring>
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
 #include <GLES2/gl2ext.h>
+#include <EGL/eglext.h>
 #include "util.h"
 
+namespace {
+    const uint32_t kProgramBinaryMagic = 0x42505843; // "CXPB"
+    const uint32_t kProgramBinaryVersion = 1;
+
+    struct ProgramBinaryHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t format;
+        uint32_t length;
+    };
+
+    struct CachedProgram {
+        GLenum format;
+        std::vector<uint8_t> binary;
+    };
+
+    std::mutex gProgramCacheMutex;
+    std::string gProgramCacheDir;
+    // binaries loaded from or written to disk this run, so warm-up results are used without a read
+    std::unordered_map<uint64_t, CachedProgram> gProgramCache;
+    GLUtils::ProgramCacheStats gProgramCacheStats = {};
+
+    std::string ProgramCachePath(const std::string &dir, uint64_t key) {
+        char name[32];
+        snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long) key);
+        return dir + name;
+    }
+
+    uint64_t Fnv1a(uint64_t hash, const char *data, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            hash ^= (uint8_t) data[i];
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+}
+
 GLuint GLUtils::LoadShader(GLenum shaderType, const char *pSource)
 {
     GLuint shader = 0;
@@ -38,6 +80,36 @@ GLuint GLUtils::LoadShader(GLenum shaderType, const char *pSource)
 }
 
 GLuint GLUtils::CreateProgram(const char *pVertexShaderSource, const char *pFragShaderSource, GLuint &vertexShaderHandle, GLuint &fragShaderHandle)
+{
+    bool cacheEnabled;
+    {
+        std::lock_guard<std::mutex> lock(gProgramCacheMutex);
+        cacheEnabled = !gProgramCacheDir.empty();
+    }
+    if (!cacheEnabled)
+    {
+        return LinkProgram(pVertexShaderSource, pFragShaderSource, vertexShaderHandle, fragShaderHandle, false);
+    }
+
+    const uint64_t key = ProgramCacheKey(pVertexShaderSource, pFragShaderSource, GetDriverString());
+    GLuint program = LoadCachedProgram(key);
+    if (program)
+    {
+        vertexShaderHandle = 0;
+        fragShaderHandle = 0;
+        LOGI("GLUtils::CreateProgram program = %d (cached %016llx)", program, (unsigned long long) key);
+        return program;
+    }
+
+    program = LinkProgram(pVertexShaderSource, pFragShaderSource, vertexShaderHandle, fragShaderHandle, true);
+    if (program)
+    {
+        StoreCachedProgram(key, program);
+    }
+    return program;
+}
+
+GLuint GLUtils::LinkProgram(const char *pVertexShaderSource, const char *pFragShaderSource, GLuint &vertexShaderHandle, GLuint &fragShaderHandle, bool retrievable)
 {
     GLuint program = 0;
     FUN_BEGIN_TIME("GLUtils::CreateProgram")
@@ -53,6 +125,10 @@ GLuint GLUtils::CreateProgram(const char *pVertexShaderSource, const char *pFrag
             CheckGLError("glAttachShader");
             glAttachShader(program, fragShaderHandle);
             CheckGLError("glAttachShader");
+            if (retrievable)
+            {
+                glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            }
             glLinkProgram(program);
             GLint linkStatus = GL_FALSE;
             glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
@@ -104,4 +180,205 @@ void GLUtils::CheckGLError(const char *pGLOperation)
         LOGE("GLUtils::CheckGLError GL Operation %s() glError (0x%x)\n", pGLOperation, error);
     }
 
-}
\ No newline at end of file
+}
+
+void GLUtils::SetProgramCacheDir(const std::string &dir)
+{
+    std::lock_guard<std::mutex> lock(gProgramCacheMutex);
+    gProgramCacheDir = dir;
+    gProgramCache.clear();
+    gProgramCacheStats = {};
+}
+
+GLUtils::ProgramCacheStats GLUtils::GetProgramCacheStats()
+{
+    std::lock_guard<std::mutex> lock(gProgramCacheMutex);
+    return gProgramCacheStats;
+}
+
+uint64_t GLUtils::ProgramCacheKey(const char *pVertexShaderSource, const char *pFragShaderSource, const std::string &driver)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    // the separators keep ("ab", "c") and ("a", "bc") apart
+    hash = Fnv1a(hash, pVertexShaderSource, strlen(pVertexShaderSource) + 1);
+    hash = Fnv1a(hash, pFragShaderSource, strlen(pFragShaderSource) + 1);
+    hash = Fnv1a(hash, driver.c_str(), driver.size() + 1);
+    return hash;
+}
+
+bool GLUtils::ReadProgramBinary(const std::string &path, uint64_t key, GLenum &format, std::vector<uint8_t> &binary)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        return false;
+    }
+    ProgramBinaryHeader header = {};
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                 header.magic == kProgramBinaryMagic &&
+                 header.version == kProgramBinaryVersion &&
+                 header.key == key && header.length > 0;
+    if (valid)
+    {
+        binary.resize(header.length);
+        valid = fread(binary.data(), 1, header.length, file) == header.length;
+        format = header.format;
+    }
+    fclose(file);
+    return valid;
+}
+
+bool GLUtils::WriteProgramBinary(const std::string &path, uint64_t key, GLenum format, const std::vector<uint8_t> &binary)
+{
+    // write to a temporary file first so a crash never leaves a truncated binary behind
+    const std::string tmpPath = path + ".tmp";
+    FILE *file = fopen(tmpPath.c_str(), "wb");
+    if (!file)
+    {
+        LOGE("GLUtils::WriteProgramBinary could not open %s", tmpPath.c_str());
+        return false;
+    }
+    ProgramBinaryHeader header = {kProgramBinaryMagic, kProgramBinaryVersion, key, format, (uint32_t) binary.size()};
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(binary.data(), 1, binary.size(), file) == binary.size();
+    written = (fclose(file) == 0) && written;
+    if (!written || rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+GLuint GLUtils::LoadCachedProgram(uint64_t key)
+{
+    CachedProgram cached;
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(gProgramCacheMutex);
+        path = ProgramCachePath(gProgramCacheDir, key);
+        auto it = gProgramCache.find(key);
+        if (it != gProgramCache.end())
+        {
+            cached = it->second;
+        }
+    }
+    if (cached.binary.empty() && !ReadProgramBinary(path, key, cached.format, cached.binary))
+    {
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, cached.format, cached.binary.data(), (GLsizei) cached.binary.size());
+    GLint linkStatus = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+    if (linkStatus != GL_TRUE)
+    {
+        // typically a driver update; the caller compiles from source and replaces the entry
+        LOGI("GLUtils::LoadCachedProgram binary %016llx rejected by the driver", (unsigned long long) key);
+        glDeleteProgram(program);
+        std::lock_guard<std::mutex> lock(gProgramCacheMutex);
+        gProgramCache.erase(key);
+        gProgramCacheStats.rejected++;
+        remove(path.c_str());
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(gProgramCacheMutex);
+    gProgramCache.emplace(key, std::move(cached));
+    gProgramCacheStats.hits++;
+    return program;
+}
+
+void GLUtils::StoreCachedProgram(uint64_t key, GLuint program)
+{
+    {
+        std::lock_guard<std::mutex> lock(gProgramCacheMutex);
+        gProgramCacheStats.misses++;
+    }
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        // the driver keeps no binaries (GL_NUM_PROGRAM_BINARY_FORMATS is 0)
+        return;
+    }
+    CachedProgram cached;
+    cached.binary.resize((size_t) length);
+    glGetProgramBinary(program, length, nullptr, &cached.format, cached.binary.data());
+
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(gProgramCacheMutex);
+        path = ProgramCachePath(gProgramCacheDir, key);
+    }
+    if (!WriteProgramBinary(path, key, cached.format, cached.binary))
+    {
+        LOGE("GLUtils::StoreCachedProgram could not write %s", path.c_str());
+    }
+    std::lock_guard<std::mutex> lock(gProgramCacheMutex);
+    gProgramCache[key] = std::move(cached);
+}
+
+std::string GLUtils::GetDriverString()
+{
+    const char *renderer = (const char *) glGetString(GL_RENDERER);
+    const char *version = (const char *) glGetString(GL_VERSION);
+    return std::string(renderer ? renderer : "") + "|" + (version ? version : "");
+}
+
+std::future<void> GLUtils::WarmProgramCache(EGLDisplay display, EGLContext shareContext,
+                                            std::vector<std::pair<const char *, const char *>> sources)
+{
+    return std::async(std::launch::async, [display, shareContext, sources]() {
+        FUN_BEGIN_TIME("GLUtils::WarmProgramCache")
+            EGLint configId = 0;
+            eglQueryContext(display, shareContext, EGL_CONFIG_ID, &configId);
+            const EGLint configAttribs[] = {EGL_CONFIG_ID, configId, EGL_NONE};
+            EGLConfig config = nullptr;
+            EGLint numConfigs = 0;
+            if (!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs < 1)
+            {
+                LOGE("GLUtils::WarmProgramCache no config for context");
+                return;
+            }
+
+            const EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
+            EGLContext context = eglCreateContext(display, config, shareContext, contextAttribs);
+            if (context == EGL_NO_CONTEXT)
+            {
+                LOGE("GLUtils::WarmProgramCache eglCreateContext() failed");
+                return;
+            }
+            EGLSurface surface = EGL_NO_SURFACE;
+            const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+            if (!extensions || !strstr(extensions, "EGL_KHR_surfaceless_context"))
+            {
+                const EGLint surfaceAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+                surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+            }
+
+            if (eglMakeCurrent(display, surface, surface, context))
+            {
+                for (auto &source: sources)
+                {
+                    GLuint vertexShader = 0;
+                    GLuint fragShader = 0;
+                    GLuint program = CreateProgram(source.first, source.second, vertexShader, fragShader);
+                    DeleteProgram(program);
+                }
+                eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            }
+            else
+            {
+                LOGE("GLUtils::WarmProgramCache eglMakeCurrent() failed");
+            }
+
+            if (surface != EGL_NO_SURFACE)
+            {
+                eglDestroySurface(display, surface);
+            }
+            eglDestroyContext(display, context);
+        FUN_END_TIME("GLUtils::WarmProgramCache")
+    });
+}
@@ -2,7 +2,11 @@
 #define GL_UTILS_H_
 
 #include <GLES3/gl3.h>
+#include <EGL/egl.h>
+#include <future>
 #include <string>
+#include <utility>
+#include <vector>
 
 #define SHADER_TO_STRING(s) #s
 
@@ -12,6 +16,8 @@ class GLUtils {
 public:
     static GLuint LoadShader(GLenum shaderType, const char *pSource);
 
+    // Links a program from source, or from the program binary cache when a binary for the same
+    // sources and driver is available.
     static GLuint CreateProgram(const char *pVertexShaderSource, const char *pFragShaderSource,
                                 GLuint &vertexShaderHandle,
                                 GLuint &fragShaderHandle);
@@ -20,6 +26,45 @@ public:
 
     static void CheckGLError(const char *pGLOperation);
 
+    // Enables the program binary cache, stored in dir. The cache is disabled until this is called.
+    // Binaries kept in memory from an earlier directory are dropped.
+    static void SetProgramCacheDir(const std::string &dir);
+
+    struct ProgramCacheStats {
+        // programs created from a cached binary
+        uint32_t hits;
+        // programs compiled from source, their binary then cached
+        uint32_t misses;
+        // cached binaries the driver did not accept, compiled from source instead
+        uint32_t rejected;
+    };
+
+    // Counts since the last SetProgramCacheDir().
+    static ProgramCacheStats GetProgramCacheStats();
+
+    // Compiles the given (vertex, fragment) source pairs on a worker thread, using a context
+    // shared with shareContext, so later CreateProgram calls load them from the cache.
+    static std::future<void> WarmProgramCache(EGLDisplay display, EGLContext shareContext,
+                                              std::vector<std::pair<const char *, const char *>> sources);
+
+    // Cache key of a program: a hash of both shader sources and the driver identification.
+    static uint64_t ProgramCacheKey(const char *pVertexShaderSource, const char *pFragShaderSource, const std::string &driver);
+
+    // Program binary file format; no GL calls, so these work without a context.
+    static bool ReadProgramBinary(const std::string &path, uint64_t key, GLenum &format, std::vector<uint8_t> &binary);
+
+    static bool WriteProgramBinary(const std::string &path, uint64_t key, GLenum format, const std::vector<uint8_t> &binary);
+
+private:
+    static GLuint LinkProgram(const char *pVertexShaderSource, const char *pFragShaderSource,
+                              GLuint &vertexShaderHandle,
+                              GLuint &fragShaderHandle, bool retrievable);
+
+    static GLuint LoadCachedProgram(uint64_t key);
+
+    static void StoreCachedProgram(uint64_t key, GLuint program);
+
+    static std::string GetDriverString();
 };
 
-#endif
\ No newline at end of file
+#endif
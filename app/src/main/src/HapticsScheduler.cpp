@@ -0,0 +1,238 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "HapticsScheduler.h"
+#include "ThreadManager.h"
+#include "util.h"
+#include <algorithm>
+#include <time.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+    const uint64_t kNoDeadline = UINT64_MAX;
+}
+
+HapticsScheduler::HapticsScheduler(VibrationSink sink) : mSink(std::move(sink)) {
+}
+
+HapticsScheduler::~HapticsScheduler() {
+    Stop();
+}
+
+void HapticsScheduler::Start() {
+    if (mRunning.exchange(true)) {
+        return;
+    }
+    mWakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    mThread = std::thread([this]() {
+        ThreadManager::RegisterCurrentThread(ThreadRole_Worker, "Haptics");
+        Run();
+    });
+}
+
+void HapticsScheduler::Stop() {
+    if (!mRunning.exchange(false)) {
+        return;
+    }
+    Wake();
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+    if (mWakeFd >= 0) {
+        close(mWakeFd);
+        mWakeFd = -1;
+    }
+
+    // drop whatever is still queued and silence controllers that still vibrate
+    mQueueHead.store(mQueueTail.load(std::memory_order_acquire), std::memory_order_release);
+    const uint64_t now = MonotonicNs();
+    for (uint32_t controller = 0; controller < kMaxControllers; controller++) {
+        ActivePulse &active = mActive[controller];
+        if (active.active && active.sentUntilNs > now) {
+            mSink(controller, 0, 0, 0);
+        }
+        active = ActivePulse();
+    }
+}
+
+bool HapticsScheduler::Submit(const HapticPulse &pulse) {
+    if (!mRunning.load(std::memory_order_relaxed) || pulse.controller >= kMaxControllers) {
+        mRejectedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    const uint32_t tail = mQueueTail.load(std::memory_order_relaxed);
+    if (tail - mQueueHead.load(std::memory_order_acquire) >= kQueueCapacity) {
+        mRejectedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    QueuedPulse &queued = mQueue[tail % kQueueCapacity];
+    queued.pulse = pulse;
+    queued.submitNs = MonotonicNs();
+    mQueueTail.store(tail + 1, std::memory_order_release);
+
+    // pairs with the fence in Wait(): either the worker sees the new tail before it sleeps or
+    // this sees it sleeping and wakes it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mSleeping.load(std::memory_order_relaxed)) {
+        Wake();
+    }
+    return true;
+}
+
+void HapticsScheduler::Run() {
+    while (mRunning.load(std::memory_order_relaxed)) {
+        uint64_t now = MonotonicNs();
+        const uint64_t staleDeadlineNs = mStaleDeadlineNs.load(std::memory_order_relaxed);
+
+        uint32_t head = mQueueHead.load(std::memory_order_relaxed);
+        const uint32_t tail = mQueueTail.load(std::memory_order_acquire);
+        for (; head != tail; head++) {
+            const QueuedPulse &queued = mQueue[head % kQueueCapacity];
+            if (now - queued.submitNs > staleDeadlineNs) {
+                mStaleCount.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            Merge(queued, now);
+        }
+        mQueueHead.store(head, std::memory_order_release);
+
+        Wait(Play(now));
+    }
+}
+
+void HapticsScheduler::Wait(uint64_t next) {
+    mSleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mRunning.load(std::memory_order_relaxed) &&
+        mQueueHead.load(std::memory_order_relaxed) == mQueueTail.load(std::memory_order_acquire)) {
+        int timeoutMs = -1;
+        if (next != kNoDeadline) {
+            const uint64_t now = MonotonicNs();
+            timeoutMs = next > now ? int((next - now + 999999) / 1000000) : 0;
+        }
+        if (timeoutMs != 0) {
+            struct pollfd pfd = {mWakeFd, POLLIN, 0};
+            poll(&pfd, 1, timeoutMs);
+        }
+    }
+    mSleeping.store(false, std::memory_order_relaxed);
+
+    // reset the counter; EAGAIN when nobody woke us
+    uint64_t count;
+    if (read(mWakeFd, &count, sizeof(count)) < 0) {
+        return;
+    }
+}
+
+void HapticsScheduler::Wake() {
+    const uint64_t one = 1;
+    // only fails once the counter saturates, and the worker is awake then anyway
+    ssize_t written = write(mWakeFd, &one, sizeof(one));
+    (void) written;
+}
+
+void HapticsScheduler::Merge(const QueuedPulse &queued, uint64_t now) {
+    const HapticPulse &pulse = queued.pulse;
+    ActivePulse &active = mActive[pulse.controller];
+
+    if (pulse.durationMs == 0) {
+        // stop request; Play() sends the stop if something is still playing
+        if (active.active) {
+            active.current.endNs = now;
+            active.resume = false;
+        }
+        return;
+    }
+
+    Envelope incoming;
+    incoming.startAmplitude = pulse.startAmplitude;
+    incoming.endAmplitude = pulse.endAmplitude;
+    incoming.frequency = pulse.frequency;
+    incoming.startNs = now;
+    incoming.endNs = now + uint64_t(pulse.durationMs) * 1000000ULL;
+
+    if (!active.active || now >= active.current.endNs) {
+        active.active = true;
+        active.current = incoming;
+        active.resume = false;
+        return;
+    }
+    mCoalescedCount.fetch_add(1, std::memory_order_relaxed);
+
+    // up to three overlapping pulses: the strongest one now plays, and of the others the one
+    // strongest when it ends resumes after it; ramps that cross are not split further
+    Envelope candidates[3] = {incoming, active.current, active.next};
+    const uint32_t count = active.resume ? 3 : 2;
+    uint32_t strongest = 0;
+    for (uint32_t i = 1; i < count; i++) {
+        const float amplitude = AmplitudeAt(candidates[i], now);
+        const float strongestAmplitude = AmplitudeAt(candidates[strongest], now);
+        if (amplitude > strongestAmplitude ||
+            (amplitude == strongestAmplitude && candidates[i].endNs > candidates[strongest].endNs)) {
+            strongest = i;
+        }
+    }
+    const Envelope current = candidates[strongest];
+    bool resume = false;
+    Envelope next;
+    for (uint32_t i = 0; i < count; i++) {
+        if (i == strongest || candidates[i].endNs <= current.endNs) {
+            continue;
+        }
+        if (!resume || AmplitudeAt(candidates[i], current.endNs) > AmplitudeAt(next, current.endNs)) {
+            next = candidates[i];
+            resume = true;
+        }
+    }
+    active.current = current;
+    active.resume = resume;
+    active.next = next;
+}
+
+uint64_t HapticsScheduler::Play(uint64_t now) {
+    uint64_t next = kNoDeadline;
+    for (uint32_t controller = 0; controller < kMaxControllers; controller++) {
+        ActivePulse &active = mActive[controller];
+        if (!active.active) {
+            continue;
+        }
+        if (now >= active.current.endNs && active.resume && now < active.next.endNs) {
+            // the stronger pulse is over, back to the one it covered
+            active.current = active.next;
+            active.resume = false;
+        }
+        if (now >= active.current.endNs) {
+            // cut short by a stop request
+            if (active.sentUntilNs > now) {
+                mSink(controller, 0, 0, 0);
+            }
+            active = ActivePulse();
+            continue;
+        }
+
+        const Envelope &envelope = active.current;
+        const float amplitude = AmplitudeAt(envelope, now);
+        const bool ramp = envelope.startAmplitude != envelope.endAmplitude;
+        const uint64_t until = ramp ? std::min<uint64_t>(envelope.endNs, now + kEnvelopeStepMs * 1000000ULL) : envelope.endNs;
+        if (amplitude != active.sentAmplitude || active.sentUntilNs < until) {
+            const uint32_t durationMs = uint32_t((until - now + 999999) / 1000000);
+            mSink(controller, amplitude, envelope.frequency, durationMs);
+            mPlayedCount.fetch_add(1, std::memory_order_relaxed);
+            active.sentAmplitude = amplitude;
+            active.sentUntilNs = until;
+        }
+        next = std::min(next, std::min(active.sentUntilNs, envelope.endNs));
+    }
+    return next;
+}
+
+float HapticsScheduler::AmplitudeAt(const Envelope &envelope, uint64_t timeNs) {
+    if (timeNs <= envelope.startNs || envelope.endNs <= envelope.startNs) {
+        return envelope.startAmplitude;
+    }
+    if (timeNs >= envelope.endNs) {
+        return envelope.endAmplitude;
+    }
+    const float t = float(timeNs - envelope.startNs) / float(envelope.endNs - envelope.startNs);
+    return envelope.startAmplitude + (envelope.endAmplitude - envelope.startAmplitude) * t;
+}
@@ -0,0 +1,134 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_HAPTICS_SCHEDULER_H
+#define CLIENT_APP_HAPTICS_SCHEDULER_H
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <stdint.h>
+
+// One vibration request. The amplitude ramps linearly from startAmplitude to endAmplitude over
+// the duration; a constant pulse has both set to the same value.
+struct HapticPulse {
+    uint32_t controller = 0;
+    float startAmplitude = 0;
+    float endAmplitude = 0;
+    // Hz, 0 when unspecified; only forwarded to the sink
+    float frequency = 0;
+    uint32_t durationMs = 0;
+};
+
+// Plays haptic pulses on a worker thread so the CloudXR callback thread never waits on the
+// runtime's vibration calls.
+//
+// Submit() only copies the pulse into a fixed-size single-producer/single-consumer queue. The
+// worker drains the queue, drops pulses that waited longer than the stale deadline, and merges
+// pulses that overlap the one already playing on the same controller: the stronger of the two
+// plays, so a burst of short pulses becomes one call to the sink instead of one per pulse. When
+// the weaker one outlasts it, it is kept and resumes once the stronger one ends, so a short
+// strong pulse on top of a long weak rumble does not stretch into a long strong one. Ramps are
+// played in kEnvelopeStepMs steps.
+//
+// Submit() takes no lock: it only writes to an eventfd when the worker announced it is about to
+// sleep, so the callback thread never blocks on the worker.
+class HapticsScheduler {
+
+public:
+    // Plays amplitude [0, 1] at frequency (0 = device default) for durationMs on a controller.
+    // A durationMs of 0 stops the vibration.
+    typedef std::function<void(uint32_t controller, float amplitude, float frequency, uint32_t durationMs)> VibrationSink;
+
+    static const uint32_t kMaxControllers = 2;
+    static const uint32_t kQueueCapacity = 64;
+    static const uint32_t kEnvelopeStepMs = 10;
+    static const uint32_t kDefaultStaleDeadlineMs = 50;
+
+    explicit HapticsScheduler(VibrationSink sink);
+
+    ~HapticsScheduler();
+
+    void Start();
+
+    // Stops the worker and silences every controller that still vibrates.
+    void Stop();
+
+    // Queues a pulse; returns false when it is rejected (worker stopped, bad controller, queue full).
+    // Only one thread may submit.
+    bool Submit(const HapticPulse &pulse);
+
+    // Pulses still queued this long after Submit() are dropped instead of played late.
+    void SetStaleDeadlineMs(uint32_t deadlineMs) {
+        mStaleDeadlineNs.store(uint64_t(deadlineMs) * 1000000ULL, std::memory_order_relaxed);
+    }
+
+    uint64_t GetPlayedCount() const { return mPlayedCount.load(std::memory_order_relaxed); }
+
+    uint64_t GetCoalescedCount() const { return mCoalescedCount.load(std::memory_order_relaxed); }
+
+    uint64_t GetStaleCount() const { return mStaleCount.load(std::memory_order_relaxed); }
+
+    uint64_t GetRejectedCount() const { return mRejectedCount.load(std::memory_order_relaxed); }
+
+private:
+    struct QueuedPulse {
+        HapticPulse pulse;
+        uint64_t submitNs;
+    };
+
+    // one pulse placed on the worker's clock
+    struct Envelope {
+        float startAmplitude = 0;
+        float endAmplitude = 0;
+        float frequency = 0;
+        uint64_t startNs = 0;
+        uint64_t endNs = 0;
+    };
+
+    // what the worker currently plays on one controller
+    struct ActivePulse {
+        bool active = false;
+        Envelope current;
+        // a weaker pulse that outlasts current, played from current.endNs on
+        bool resume = false;
+        Envelope next;
+        // sink state: last amplitude sent and when that call runs out
+        float sentAmplitude = 0;
+        uint64_t sentUntilNs = 0;
+    };
+
+    void Run();
+
+    // Applies one dequeued pulse to the controller's active pulse.
+    void Merge(const QueuedPulse &queued, uint64_t now);
+
+    // Calls the sink where the output has to change; returns the next time it has to run.
+    uint64_t Play(uint64_t now);
+
+    static float AmplitudeAt(const Envelope &envelope, uint64_t timeNs);
+
+    VibrationSink mSink;
+
+    QueuedPulse mQueue[kQueueCapacity];
+    std::atomic<uint32_t> mQueueHead{0}; // worker-owned
+    std::atomic<uint32_t> mQueueTail{0}; // submitter-owned
+
+    ActivePulse mActive[kMaxControllers];
+
+    std::atomic<uint64_t> mStaleDeadlineNs{kDefaultStaleDeadlineMs * 1000000ULL};
+    std::atomic<uint64_t> mPlayedCount{0};
+    std::atomic<uint64_t> mCoalescedCount{0};
+    std::atomic<uint64_t> mStaleCount{0};
+    std::atomic<uint64_t> mRejectedCount{0};
+
+    // sleeps until a submit or the next deadline
+    void Wait(uint64_t next);
+
+    void Wake();
+
+    int mWakeFd = -1;
+    std::atomic<bool> mSleeping{false};
+    std::atomic<bool> mRunning{false};
+    std::thread mThread;
+};
+
+#endif //CLIENT_APP_HAPTICS_SCHEDULER_H
@@ -0,0 +1,191 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "InputSampler.h"
+#include <chrono>
+#include <time.h>
+#include <CloudXRCommon.h>
+#include "ThreadManager.h"
+#include "util.h"
+
+namespace {
+    // analog values above this count as a click, as in GetInputId()
+    const float kClickThreshold = 0.65f;
+
+    uint64_t Bit(cxrButtonId button) {
+        return 1ULL << button;
+    }
+}
+
+InputSampler::InputSampler(Source source) : mSource(std::move(source)) {
+}
+
+InputSampler::~InputSampler() {
+    Stop();
+}
+
+void InputSampler::Start() {
+    if (mRunning.exchange(true)) {
+        return;
+    }
+    mThread = std::thread([this]() {
+        ThreadManager::RegisterCurrentThread(ThreadRole_Tracking, "InputSampler");
+        Run();
+    });
+}
+
+void InputSampler::Stop() {
+    if (!mRunning.exchange(false)) {
+        return;
+    }
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+}
+
+uint64_t InputSampler::GetButtonMask(uint32_t controller, const PxrControllerInputState &state) {
+    const bool left = controller == PXR_CONTROLLER_LEFT;
+    uint64_t buttons = 0;
+    if (state.AXValue) {
+        buttons |= Bit(left ? cxrButton_X : cxrButton_A);
+    }
+    if (state.BYValue) {
+        buttons |= Bit(left ? cxrButton_Y : cxrButton_B);
+    }
+    if (state.backValue) {
+        buttons |= Bit(cxrButton_System);
+    }
+    if (state.triggerTouchValue) {
+        buttons |= Bit(cxrButton_Trigger_Touch);
+    }
+    if (state.triggerValue > kClickThreshold) {
+        buttons |= Bit(cxrButton_Trigger_Click);
+    }
+    if (state.touchpadValue) {
+        buttons |= Bit(cxrButton_Touchpad_Click);
+    }
+    if (state.gripValue > kClickThreshold) {
+        buttons |= Bit(cxrButton_Grip_Click);
+    }
+    return buttons;
+}
+
+bool InputSampler::Push(Controller &controller, uint64_t nowNs, const uint64_t *masks, uint32_t count) {
+    const uint32_t tail = controller.tail.load(std::memory_order_relaxed);
+    if (tail - controller.head.load(std::memory_order_acquire) + count > kQueueCapacity) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        controller.queue[(tail + i) % kQueueCapacity] = {nowNs, masks[i]};
+    }
+    controller.tail.store(tail + count, std::memory_order_release);
+    if (count > 0) {
+        controller.queued = masks[count - 1];
+    }
+    return true;
+}
+
+void InputSampler::Sample(uint64_t nowNs) {
+    for (uint32_t i = 0; i < kMaxControllers; i++) {
+        Controller &controller = mControllers[i];
+        uint64_t buttons = 0;
+        if (!mSource(i, &buttons)) {
+            buttons = 0;
+        }
+        if (buttons != controller.sampled) {
+            mEdgeCount.fetch_add(1, std::memory_order_relaxed);
+            if (controller.overflowed) {
+                controller.droppedReleases |= controller.sampled & ~buttons;
+                controller.droppedPresses |= buttons & ~controller.sampled;
+            }
+            controller.sampled = buttons;
+        } else if (!controller.overflowed) {
+            continue;
+        }
+
+        if (!controller.overflowed) {
+            if (!Push(controller, nowNs, &buttons, 1)) {
+                controller.overflowed = true;
+                controller.droppedReleases = controller.queued & ~buttons;
+                controller.droppedPresses = buttons & ~controller.queued;
+                mOverflowCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            continue;
+        }
+        // after an overflow: the releases, then the presses of what was dropped, then the
+        // current mask, each only when it changes something
+        uint64_t masks[3];
+        uint32_t count = 0;
+        uint64_t mask = controller.queued & ~controller.droppedReleases;
+        if (mask != controller.queued) {
+            masks[count++] = mask;
+        }
+        if ((mask | controller.droppedPresses) != mask) {
+            mask |= controller.droppedPresses;
+            masks[count++] = mask;
+        }
+        if (buttons != mask) {
+            masks[count++] = buttons;
+        }
+        if (Push(controller, nowNs, masks, count)) {
+            controller.overflowed = false;
+            controller.droppedReleases = 0;
+            controller.droppedPresses = 0;
+        }
+    }
+}
+
+uint64_t InputSampler::Fold(uint32_t controller) {
+    if (controller >= kMaxControllers) {
+        return 0;
+    }
+    Controller &c = mControllers[controller];
+    const uint64_t nowNs = MonotonicNs();
+    uint64_t current = c.reported;
+    // buttons that changed in this fold; a second change of one waits for the next fold
+    uint64_t changed = 0;
+    uint32_t head = c.head.load(std::memory_order_relaxed);
+    const uint32_t tail = c.tail.load(std::memory_order_acquire);
+    uint64_t ageSumNs = 0;
+    uint32_t folded = 0;
+    for (; head != tail; head++) {
+        const Edge &edge = c.queue[head % kQueueCapacity];
+        const uint64_t changing = edge.buttons ^ current;
+        if ((changing & changed) != 0) {
+            const uint64_t shortPresses = changing & changed & current;
+            if (shortPresses != 0) {
+                mShortPressCount.fetch_add(uint64_t(__builtin_popcountll(shortPresses)), std::memory_order_relaxed);
+            }
+            break;
+        }
+        changed |= changing;
+        current = edge.buttons;
+        ageSumNs += nowNs > edge.timeNs ? nowNs - edge.timeNs : 0;
+        folded++;
+    }
+    c.head.store(head, std::memory_order_release);
+    c.reported = current;
+
+    if (folded > 0) {
+        mEdgeAgeSumNs.fetch_add(ageSumNs, std::memory_order_relaxed);
+        mFoldedEdgeCount.fetch_add(folded, std::memory_order_relaxed);
+    }
+    return current;
+}
+
+float InputSampler::GetMeanEdgeAgeMs() const {
+    const uint64_t count = mFoldedEdgeCount.load(std::memory_order_relaxed);
+    return count > 0 ? float(mEdgeAgeSumNs.load(std::memory_order_relaxed) / count) / 1e6f : 0;
+}
+
+void InputSampler::Run() {
+    auto next = std::chrono::steady_clock::now();
+    while (mRunning.load(std::memory_order_relaxed)) {
+        Sample(MonotonicNs());
+        next += std::chrono::microseconds(uint32_t(kSampleIntervalUs));
+        const auto now = std::chrono::steady_clock::now();
+        if (next < now) {
+            // fell behind, e.g. after the device slept; do not catch up with a burst
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
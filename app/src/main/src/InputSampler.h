@@ -0,0 +1,104 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_INPUT_SAMPLER_H
+#define CLIENT_APP_INPUT_SAMPLER_H
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <stdint.h>
+// PxrInput.h uses u_int64_t without including its definition
+#include <sys/types.h>
+#include <PxrInput.h>
+
+// Samples the controller buttons on its own thread, far more often than the server asks for
+// tracking, so a press shorter than the tracking interval still reaches the server. A press
+// shorter than kSampleIntervalUs is only seen when a sample lands on it, so with the share of
+// the interval it covers.
+//
+// Every change of a controller's button mask is pushed, with its time, into a fixed-size
+// single-producer/single-consumer queue per controller. Fold() drains the queue on the tracking
+// thread one step at a time: it takes changes as long as no button goes down and up again, or
+// up and down again, within one fold, and leaves the rest for the next one. So every press shows
+// as down for at least one tracking update and every release as up for at least one, a release
+// and re-press between two folds included, while changes of different buttons still fold
+// together. When a queue is full, the changes that did not fit are summed up into their releases
+// and presses and pushed, followed by the current mask, once there is room again: a burst loses
+// timing but not presses.
+class InputSampler {
+
+public:
+    // Reads the cxrButton mask of a controller; false when the controller is not available.
+    typedef std::function<bool(uint32_t controller, uint64_t *buttons)> Source;
+
+    static const uint32_t kMaxControllers = 2;
+    static const uint32_t kQueueCapacity = 64;
+    static const uint32_t kSampleIntervalUs = 1000;
+
+    explicit InputSampler(Source source);
+
+    ~InputSampler();
+
+    void Start();
+
+    void Stop();
+
+    // Buttons to report for the controller; only one thread may fold.
+    uint64_t Fold(uint32_t controller);
+
+    // cxrButton bits of every pressed Pxr input; each input maps on its own, so pressing two
+    // buttons at once reports both.
+    static uint64_t GetButtonMask(uint32_t controller, const PxrControllerInputState &state);
+
+    uint64_t GetEdgeCount() const { return mEdgeCount.load(std::memory_order_relaxed); }
+
+    // presses already released when they were folded, whose release waited for the next fold
+    uint64_t GetShortPressCount() const { return mShortPressCount.load(std::memory_order_relaxed); }
+
+    uint64_t GetOverflowCount() const { return mOverflowCount.load(std::memory_order_relaxed); }
+
+    // mean time from a change being sampled to it being folded
+    float GetMeanEdgeAgeMs() const;
+
+    // Samples every controller once; the worker calls it every kSampleIntervalUs.
+    void Sample(uint64_t nowNs);
+
+private:
+    struct Edge {
+        uint64_t timeNs;
+        uint64_t buttons;
+    };
+
+    struct Controller {
+        Edge queue[kQueueCapacity];
+        std::atomic<uint32_t> head{0}; // folder-owned
+        std::atomic<uint32_t> tail{0}; // sampler-owned
+        // sampler side: last mask read, last mask queued, and the releases and presses of the
+        // changes that did not fit in the queue
+        uint64_t sampled = 0;
+        uint64_t queued = 0;
+        bool overflowed = false;
+        uint64_t droppedReleases = 0;
+        uint64_t droppedPresses = 0;
+        // fold side: mask reported by the last Fold()
+        uint64_t reported = 0;
+    };
+
+    // Pushes the masks; false, pushing nothing, when they do not all fit.
+    static bool Push(Controller &controller, uint64_t nowNs, const uint64_t *masks, uint32_t count);
+
+    void Run();
+
+    Source mSource;
+    Controller mControllers[kMaxControllers];
+
+    std::atomic<uint64_t> mEdgeCount{0};
+    std::atomic<uint64_t> mShortPressCount{0};
+    std::atomic<uint64_t> mOverflowCount{0};
+    std::atomic<uint64_t> mEdgeAgeSumNs{0};
+    std::atomic<uint64_t> mFoldedEdgeCount{0};
+
+    std::atomic<bool> mRunning{false};
+    std::thread mThread;
+};
+
+#endif //CLIENT_APP_INPUT_SAMPLER_H
@@ -0,0 +1,131 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "LatencyTracker.h"
+#include <math.h>
+#include <string.h>
+
+void LatencyHistogram::Add(uint64_t latencyNs) {
+    uint64_t bucket = latencyNs / kBucketNs;
+    if (bucket >= kBucketCount) {
+        bucket = kBucketCount - 1;
+    }
+    mBuckets[bucket]++;
+    mCount++;
+    mSumNs += latencyNs;
+}
+
+void LatencyHistogram::Reset() {
+    memset(mBuckets, 0, sizeof(mBuckets));
+    mCount = 0;
+    mSumNs = 0;
+}
+
+double LatencyHistogram::GetMeanMs() const {
+    return mCount == 0 ? 0.0 : mSumNs / 1e6 / mCount;
+}
+
+double LatencyHistogram::GetPercentileMs(double percentile) const {
+    if (mCount == 0) {
+        return 0.0;
+    }
+    // smallest bucket with at least percentile% of the samples at or below it
+    const double target = ceil(mCount * percentile / 100.0);
+    uint32_t seen = 0;
+    for (uint32_t bucket = 0; bucket < kBucketCount; bucket++) {
+        seen += mBuckets[bucket];
+        if (seen > 0 && seen >= target) {
+            return (bucket + 1) * kBucketNs / 1e6;
+        }
+    }
+    return kBucketCount * kBucketNs / 1e6;
+}
+
+void LatencyTracker::RecordPose(uint64_t sampleNs, uint64_t targetNs) {
+    const uint32_t count = mWriteCount.load(std::memory_order_relaxed);
+    PoseSample &sample = mHistory[count % kHistorySize];
+
+    const uint32_t sequence = sample.sequence.load(std::memory_order_relaxed);
+    sample.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    sample.sampleNs.store(sampleNs, std::memory_order_relaxed);
+    sample.targetNs.store(targetNs, std::memory_order_relaxed);
+    sample.sequence.store(sequence + 2, std::memory_order_release);
+
+    mWriteCount.store(count + 1, std::memory_order_release);
+}
+
+bool LatencyTracker::ReadSample(uint32_t index, uint64_t *sampleNs, uint64_t *targetNs) const {
+    const PoseSample &sample = mHistory[index % kHistorySize];
+    const uint32_t before = sample.sequence.load(std::memory_order_acquire);
+    if (before & 1) {
+        return false;
+    }
+    *sampleNs = sample.sampleNs.load(std::memory_order_relaxed);
+    *targetNs = sample.targetNs.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return sample.sequence.load(std::memory_order_relaxed) == before;
+}
+
+bool LatencyTracker::OnFrameLatched(uint64_t frameSampleNs, uint64_t latchNs, uint64_t displayNs) {
+    if (frameSampleNs == 0) {
+        mUnmatchedCount++;
+        return false;
+    }
+    const uint32_t count = mWriteCount.load(std::memory_order_acquire);
+    const uint32_t available = count < kHistorySize ? count : kHistorySize;
+
+    uint32_t matches = 0;
+    uint64_t matchedSkewNs = 0;
+    uint64_t matchedSampleNs = 0;
+    uint64_t matchedTargetNs = 0;
+    // newest first; the writer may overwrite the oldest entries meanwhile, ReadSample() skips those
+    for (uint32_t i = 1; i <= available; i++) {
+        uint64_t sampleNs = 0;
+        uint64_t targetNs = 0;
+        if (!ReadSample(count - i, &sampleNs, &targetNs) || sampleNs > latchNs) {
+            continue;
+        }
+        const uint64_t skewNs = sampleNs > frameSampleNs ? sampleNs - frameSampleNs : frameSampleNs - sampleNs;
+        if (skewNs > kMaxSampleSkewNs) {
+            // samples are recorded in time order, so the rest of the ring is older still
+            if (sampleNs < frameSampleNs) {
+                break;
+            }
+            continue;
+        }
+        if (++matches == 1 || skewNs < matchedSkewNs) {
+            matchedSkewNs = skewNs;
+            matchedSampleNs = sampleNs;
+            matchedTargetNs = targetNs;
+        }
+    }
+
+    if (matches == 0) {
+        mUnmatchedCount++;
+        return false;
+    }
+    if (matches > 1) {
+        mAmbiguousCount++;
+        return false;
+    }
+
+    mPoseToLatch.Add(latchNs - matchedSampleNs);
+    if (displayNs >= latchNs && displayNs - latchNs <= kMaxLatchToDisplayNs) {
+        mLatchToDisplay.Add(displayNs - latchNs);
+        mPoseToDisplay.Add(displayNs - matchedSampleNs);
+        if (matchedTargetNs != 0) {
+            mResidualSumNs += int64_t(displayNs) - int64_t(matchedTargetNs);
+            mResidualCount++;
+        }
+    }
+    return true;
+}
+
+void LatencyTracker::ResetWindow() {
+    mPoseToLatch.Reset();
+    mLatchToDisplay.Reset();
+    mPoseToDisplay.Reset();
+    mUnmatchedCount = 0;
+    mAmbiguousCount = 0;
+    mResidualSumNs = 0;
+    mResidualCount = 0;
+}
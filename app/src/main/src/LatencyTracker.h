@@ -0,0 +1,106 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_LATENCY_TRACKER_H
+#define CLIENT_APP_LATENCY_TRACKER_H
+
+#include <atomic>
+#include <stdint.h>
+
+// Fixed-bucket latency histogram, 0.5 ms buckets up to 200 ms; longer samples go to the last bucket.
+class LatencyHistogram {
+
+public:
+    static const uint64_t kBucketNs = 500000;
+    static const uint32_t kBucketCount = 400;
+
+    void Add(uint64_t latencyNs);
+
+    void Reset();
+
+    uint32_t GetCount() const { return mCount; }
+
+    double GetMeanMs() const;
+
+    // Upper bound in ms of the bucket holding the given percentile (0-100); 0 when empty.
+    double GetPercentileMs(double percentile) const;
+
+private:
+    uint32_t mBuckets[kBucketCount] = {};
+    uint32_t mCount = 0;
+    uint64_t mSumNs = 0;
+};
+
+// Measures pose-to-display latency by matching each latched frame back to the tracking sample
+// the server rendered it with.
+//
+// RecordPose() stores the time of every tracking sample handed to the server; it is called on
+// the CloudXR callback thread and only writes into a fixed ring guarded by per-entry sequence
+// numbers. OnFrameLatched() runs on the render thread with the frame's sample time tag
+// (cxrFramesLatched::timeStamp): it picks the recorded sample nearest to the tag, within
+// kMaxSampleSkewNs since the tag and the recorded time are not taken at the same instant, and
+// adds the pose-to-latch, latch-to-display and pose-to-display times to the histograms. When the
+// sample carries the time its pose was predicted for, the difference to the actual display time
+// is accumulated as well; that is the prediction horizon still missing. Frames are skipped when
+// no sample, or more than one sample, is within the skew of the tag.
+//
+// Times are CLOCK_MONOTONIC ns, so this has no runtime dependency and can be fed synthetic samples.
+class LatencyTracker {
+
+public:
+    static const uint32_t kHistorySize = 256;
+    // largest difference between a frame's tag and the recorded sample time still matched
+    static const uint64_t kMaxSampleSkewNs = 2000000ULL;
+    // display times more than this after the latch are treated as a clock mismatch
+    static const uint64_t kMaxLatchToDisplayNs = 1000000000ULL;
+
+    // targetNs is the time the pose was predicted for, 0 when unknown.
+    void RecordPose(uint64_t sampleNs, uint64_t targetNs = 0);
+
+    // frameSampleNs is the frame's sample time tag, displayNs the predicted display time of the
+    // frame; either 0 when unknown. Returns whether a unique sample matched.
+    bool OnFrameLatched(uint64_t frameSampleNs, uint64_t latchNs, uint64_t displayNs);
+
+    const LatencyHistogram &GetPoseToLatch() const { return mPoseToLatch; }
+
+    const LatencyHistogram &GetLatchToDisplay() const { return mLatchToDisplay; }
+
+    const LatencyHistogram &GetPoseToDisplay() const { return mPoseToDisplay; }
+
+    uint32_t GetUnmatchedCount() const { return mUnmatchedCount; }
+
+    uint32_t GetAmbiguousCount() const { return mAmbiguousCount; }
+
+    // Mean of display time minus predicted-for time over the matched frames that have both;
+    // positive when poses are predicted too short.
+    double GetMeanResidualMs() const {
+        return mResidualCount == 0 ? 0.0 : mResidualSumNs / 1e6 / mResidualCount;
+    }
+
+    uint32_t GetResidualCount() const { return mResidualCount; }
+
+    // Starts a new reporting window: clears the histograms and counters, keeps the sample history.
+    void ResetWindow();
+
+private:
+    struct PoseSample {
+        std::atomic<uint32_t> sequence{0}; // odd while being written
+        std::atomic<uint64_t> sampleNs{0};
+        std::atomic<uint64_t> targetNs{0};
+    };
+
+    // Copies entry index into sampleNs/targetNs; false if it was being written.
+    bool ReadSample(uint32_t index, uint64_t *sampleNs, uint64_t *targetNs) const;
+
+    PoseSample mHistory[kHistorySize];
+    std::atomic<uint32_t> mWriteCount{0}; // written by RecordPose() only
+
+    // render thread only
+    LatencyHistogram mPoseToLatch;
+    LatencyHistogram mLatchToDisplay;
+    LatencyHistogram mPoseToDisplay;
+    uint32_t mUnmatchedCount = 0;
+    uint32_t mAmbiguousCount = 0;
+    int64_t mResidualSumNs = 0;
+    uint32_t mResidualCount = 0;
+};
+
+#endif //CLIENT_APP_LATENCY_TRACKER_H
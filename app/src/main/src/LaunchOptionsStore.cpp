@@ -0,0 +1,274 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "LaunchOptionsStore.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include "ThreadManager.h"
+#include "FaultInjector.h"
+#include "util.h"
+
+namespace {
+    const uint32_t kMinBitrateKbps = 1000;
+    const uint32_t kMaxBitrateKbps = 1000000;
+    const uint32_t kMaxFoveation = 100;
+    const float kMinRefreshRate = 30.0f;
+    const float kMaxRefreshRate = 240.0f;
+    const float kMaxPoseFilterCutoff = 100.0f;
+    const float kMaxPoseFilterBeta = 100.0f;
+
+    bool ReadFile(const std::string &path, std::string &text) {
+        FILE *file = fopen(path.c_str(), "r");
+        if (file == nullptr) {
+            return false;
+        }
+        text.clear();
+        char buffer[1024];
+        size_t count;
+        while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            text.append(buffer, count);
+        }
+        const bool ok = ferror(file) == 0;
+        fclose(file);
+        return ok;
+    }
+
+    bool WriteFile(const std::string &path, const std::string &text) {
+        const std::string tmpPath = path + ".tmp";
+        FILE *file = fopen(tmpPath.c_str(), "w");
+        if (file == nullptr) {
+            return false;
+        }
+        const bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+        if (fclose(file) != 0 || !ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+            remove(tmpPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    std::string DirectoryOf(const std::string &path) {
+        const size_t slash = path.rfind('/');
+        return slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    }
+
+    std::string FileNameOf(const std::string &path) {
+        const size_t slash = path.rfind('/');
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+}
+
+LaunchOptionsStore::LaunchOptionsStore() : mOptions(std::make_shared<PxrLaunchOptions>()) {
+}
+
+LaunchOptionsStore::~LaunchOptionsStore() {
+    StopWatching();
+}
+
+std::shared_ptr<PxrLaunchOptions> LaunchOptionsStore::Parse(const std::string &text, std::string &error) {
+    std::shared_ptr<PxrLaunchOptions> options = std::make_shared<PxrLaunchOptions>();
+    const ParseStatus status = options->ParseString(text);
+    if (status != ParseStatus_Success) {
+        error = "parse failed with status " + std::to_string(int(status));
+        return nullptr;
+    }
+    if (!Validate(*options, error)) {
+        return nullptr;
+    }
+    return options;
+}
+
+bool LaunchOptionsStore::Validate(const PxrLaunchOptions &options, std::string &error) {
+    if (options.mMaxVideoBitrate != 0 &&
+        (options.mMaxVideoBitrate < kMinBitrateKbps || options.mMaxVideoBitrate > kMaxBitrateKbps)) {
+        error = "maxVideoBitrateKbps " + std::to_string(options.mMaxVideoBitrate) + " out of range";
+        return false;
+    }
+    if (options.mFoveation > kMaxFoveation) {
+        error = "foveation " + std::to_string(options.mFoveation) + " above " + std::to_string(kMaxFoveation);
+        return false;
+    }
+    if (options.mRefreshRate != 0 && (options.mRefreshRate < kMinRefreshRate || options.mRefreshRate > kMaxRefreshRate)) {
+        error = "refresh-rate " + std::to_string(options.mRefreshRate) + " out of range";
+        return false;
+    }
+    if (!(options.mPoseFilterCutoff > 0 && options.mPoseFilterCutoff <= kMaxPoseFilterCutoff)) {
+        error = "pose-filter-cutoff " + std::to_string(options.mPoseFilterCutoff) + " out of range";
+        return false;
+    }
+    if (!(options.mPoseFilterBeta >= 0 && options.mPoseFilterBeta <= kMaxPoseFilterBeta)) {
+        error = "pose-filter-beta " + std::to_string(options.mPoseFilterBeta) + " out of range";
+        return false;
+    }
+    ThreadPolicy policies[ThreadRole_Count];
+    if (!ThreadManager::ParsePolicies(options.mThreadAffinity, options.mThreadPriority, policies)) {
+        error = "invalid thread-affinity or thread-priority";
+        return false;
+    }
+    FaultProfile faults;
+    if (!FaultInjector::ParseProfile(options.mFaultInjection, &faults, &error)) {
+        return false;
+    }
+    return true;
+}
+
+bool LaunchOptionsStore::Load(const std::string &path) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPath = path;
+    std::string text;
+    if (!ReadFile(path, text)) {
+        LOGE("Launch options %s not readable: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+    if (mLoadedFile && text == mText) {
+        return true;
+    }
+    std::string error;
+    std::shared_ptr<PxrLaunchOptions> options = Parse(text, error);
+    if (options == nullptr) {
+        LOGE("Launch options %s rejected, keeping the active ones: %s", path.c_str(), error.c_str());
+        return false;
+    }
+    mLoadedFile = true;
+    Publish(options, text, true);
+    LOGI("Launch options loaded from %s, generation %u", path.c_str(), GetGeneration());
+    return true;
+}
+
+void LaunchOptionsStore::SetCacheFile(const std::string &path) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCachePath = path;
+    if (mLoadedFile) {
+        WriteFile(mCachePath, mText);
+        return;
+    }
+
+    std::string text;
+    if (!ReadFile(path, text)) {
+        return;
+    }
+    std::string error;
+    std::shared_ptr<PxrLaunchOptions> options = Parse(text, error);
+    if (options == nullptr) {
+        LOGE("Cached launch options %s rejected: %s", path.c_str(), error.c_str());
+        return;
+    }
+    Publish(options, text, false);
+    LOGI("Launch options file unusable, using the last valid options from %s", path.c_str());
+}
+
+void LaunchOptionsStore::Publish(const std::shared_ptr<const PxrLaunchOptions> &options, const std::string &text,
+                                 bool cache) {
+    std::atomic_store(&mOptions, options);
+    mText = text;
+    mGeneration.fetch_add(1, std::memory_order_release);
+    if (cache && !mCachePath.empty() && !WriteFile(mCachePath, text)) {
+        LOGE("Failed to cache launch options to %s", mCachePath.c_str());
+    }
+}
+
+std::shared_ptr<const PxrLaunchOptions> LaunchOptionsStore::Get() const {
+    return std::atomic_load(&mOptions);
+}
+
+bool LaunchOptionsStore::StartWatching() {
+    if (mPath.empty() || mWatching.exchange(true)) {
+        return false;
+    }
+    mWakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    mInotifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (mInotifyFd >= 0 &&
+        inotify_add_watch(mInotifyFd, DirectoryOf(mPath).c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE) < 0) {
+        LOGE("inotify on %s failed (%s), polling every %u ms", DirectoryOf(mPath).c_str(), strerror(errno),
+             kPollIntervalMs);
+        close(mInotifyFd);
+        mInotifyFd = -1;
+    }
+    FileChanged();
+    mThread = std::thread([this]() {
+        ThreadManager::RegisterCurrentThread(ThreadRole_Worker, "OptionsWatch");
+        Watch();
+    });
+    return true;
+}
+
+void LaunchOptionsStore::StopWatching() {
+    if (!mWatching.exchange(false)) {
+        return;
+    }
+    const uint64_t one = 1;
+    ssize_t written = write(mWakeFd, &one, sizeof(one));
+    (void) written;
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+    if (mInotifyFd >= 0) {
+        close(mInotifyFd);
+        mInotifyFd = -1;
+    }
+    close(mWakeFd);
+    mWakeFd = -1;
+}
+
+void LaunchOptionsStore::Watch() {
+    const std::string path = mPath;
+    const std::string fileName = FileNameOf(path);
+    bool pending = false;
+    while (mWatching.load()) {
+        struct pollfd fds[2] = {{mWakeFd, POLLIN, 0}, {mInotifyFd, POLLIN, 0}};
+        const bool inotify = mInotifyFd >= 0;
+        const int timeoutMs = inotify ? (pending ? int(kDebounceMs) : -1) : int(kPollIntervalMs);
+        const int ready = poll(fds, inotify ? 2 : 1, timeoutMs);
+        if (!mWatching.load()) {
+            break;
+        }
+        if (ready < 0) {
+            if (errno != EINTR) {
+                LOGE("Launch options watcher poll failed: %s", strerror(errno));
+                break;
+            }
+            continue;
+        }
+
+        if (inotify && (fds[1].revents & POLLIN)) {
+            // events may carry a name padded to alignment, so the buffer is read whole
+            alignas(struct inotify_event) char buffer[4096];
+            ssize_t length;
+            while ((length = read(mInotifyFd, buffer, sizeof(buffer))) > 0) {
+                for (char *p = buffer; p < buffer + length;) {
+                    const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(p);
+                    if (event->len > 0 && fileName == event->name && (event->mask & IN_DELETE) == 0) {
+                        // wait for the writes to settle before reading
+                        pending = true;
+                    }
+                    p += sizeof(struct inotify_event) + event->len;
+                }
+            }
+            continue;
+        }
+        if (ready == 0) {
+            if (pending || (!inotify && FileChanged())) {
+                pending = false;
+                Load(path);
+            }
+        }
+    }
+}
+
+bool LaunchOptionsStore::FileChanged() {
+    struct stat st;
+    int64_t size = -1;
+    int64_t mtimeNs = -1;
+    if (stat(mPath.c_str(), &st) == 0) {
+        size = int64_t(st.st_size);
+        mtimeNs = int64_t(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    }
+    const bool changed = size != mFileSize || mtimeNs != mFileMtimeNs;
+    mFileSize = size;
+    mFileMtimeNs = mtimeNs;
+    return changed;
+}
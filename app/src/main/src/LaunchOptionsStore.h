@@ -0,0 +1,89 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_LAUNCH_OPTIONS_STORE_H
+#define CLIENT_APP_LAUNCH_OPTIONS_STORE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <stdint.h>
+#include "PxrLaunchOptions.h"
+
+// Owns the active launch options and reloads them when the options file changes.
+//
+// Every load parses into a new PxrLaunchOptions and validates it; only options that pass are
+// published, as an immutable snapshot swapped in with std::atomic_store, so readers on any
+// thread see either the old or the new set and never a half-parsed one. A file that fails
+// keeps the previous snapshot. GetGeneration() changes with every publish, so a thread can
+// cheaply check whether it has to apply anything.
+//
+// The text of the last snapshot that passed is kept in a cache file. When the options file is
+// missing or broken at startup, the cached options are used instead of the defaults.
+//
+// The watcher thread uses inotify on the file's directory and reloads once writes settled for
+// kDebounceMs; where inotify is not available it checks the file's size and mtime every
+// kPollIntervalMs.
+class LaunchOptionsStore {
+
+public:
+    static const uint32_t kDebounceMs = 200;
+    static const uint32_t kPollIntervalMs = 2000;
+
+    // Starts with the default options.
+    LaunchOptionsStore();
+
+    ~LaunchOptionsStore();
+
+    // Reads, parses and validates the file; publishes it when it passed and differs from the
+    // active options. Returns false when the file could not be used.
+    bool Load(const std::string &path);
+
+    // Where the last valid options are kept. Falls back to them when the options file did not
+    // load, otherwise stores the active ones.
+    void SetCacheFile(const std::string &path);
+
+    // Watches the file given to Load() for changes.
+    bool StartWatching();
+
+    void StopWatching();
+
+    std::shared_ptr<const PxrLaunchOptions> Get() const;
+
+    uint32_t GetGeneration() const { return mGeneration.load(std::memory_order_acquire); }
+
+    // Parses and validates options text; returns null and sets error when it does not pass.
+    static std::shared_ptr<PxrLaunchOptions> Parse(const std::string &text, std::string &error);
+
+    // Checks values the option handlers accept but the client cannot use.
+    static bool Validate(const PxrLaunchOptions &options, std::string &error);
+
+private:
+    // Publishes the options; mMutex must be held.
+    void Publish(const std::shared_ptr<const PxrLaunchOptions> &options, const std::string &text, bool cache);
+
+    void Watch();
+
+    // Polling fallback: true when size or mtime changed since the last call.
+    bool FileChanged();
+
+    // serializes loads from the watcher and the client
+    std::mutex mMutex;
+    std::string mPath;
+    std::string mCachePath;
+    // text of the active options, empty for the defaults
+    std::string mText;
+    bool mLoadedFile = false;
+
+    std::shared_ptr<const PxrLaunchOptions> mOptions;
+    std::atomic<uint32_t> mGeneration{0};
+
+    int mInotifyFd = -1;
+    int mWakeFd = -1;
+    int64_t mFileSize = -1;
+    int64_t mFileMtimeNs = -1;
+    std::atomic<bool> mWatching{false};
+    std::thread mThread;
+};
+
+#endif //CLIENT_APP_LAUNCH_OPTIONS_STORE_H
@@ -0,0 +1,110 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "LoopScheduler.h"
+#include <time.h>
+#include "util.h"
+
+namespace {
+    uint64_t ClockNs(clockid_t clock) {
+        struct timespec ts;
+        clock_gettime(clock, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+    const char *LoopStateToString(LoopState state) {
+        switch (state) {
+            case LoopState_Paused:
+                return "paused";
+            case LoopState_Idle:
+                return "idle";
+            case LoopState_Streaming:
+                return "streaming";
+            default:
+                return "";
+        }
+    }
+}
+
+void LoopScheduler::SetState(LoopState state) {
+    if (state == mState) {
+        return;
+    }
+    LOGI("Main loop %s -> %s", LoopStateToString(mState), LoopStateToString(state));
+    mState = state;
+    // render the first idle frame right away so the last streamed image is replaced
+    mNextIdleFrameNs = 0;
+}
+
+int LoopScheduler::GetPollTimeoutMs() const {
+    switch (mState) {
+        case LoopState_Paused:
+            return kPausedPollTimeoutMs;
+        case LoopState_Idle: {
+            const uint64_t now = ClockNs(CLOCK_MONOTONIC);
+            if (now >= mNextIdleFrameNs) {
+                return 0;
+            }
+            // round up so the wake-up is never before the deadline
+            return int((mNextIdleFrameNs - now + 999999) / 1000000);
+        }
+        case LoopState_Streaming:
+        default:
+            return 0;
+    }
+}
+
+bool LoopScheduler::ShouldRenderFrame() {
+    switch (mState) {
+        case LoopState_Paused:
+            return false;
+        case LoopState_Idle: {
+            const uint64_t now = ClockNs(CLOCK_MONOTONIC);
+            if (now < mNextIdleFrameNs) {
+                return false;
+            }
+            mNextIdleFrameNs = now + kIdleFrameIntervalNs;
+            mStats[mState].frames++;
+            return true;
+        }
+        case LoopState_Streaming:
+        default:
+            mStats[mState].frames++;
+            return true;
+    }
+}
+
+void LoopScheduler::OnIterationEnd() {
+    const uint64_t now = ClockNs(CLOCK_MONOTONIC);
+    const uint64_t cpuNow = ClockNs(CLOCK_THREAD_CPUTIME_ID);
+    if (mIterationStartNs != 0) {
+        LoopStats &stats = mStats[mState];
+        stats.iterations++;
+        stats.wallTimeNs += now - mIterationStartNs;
+        stats.cpuTimeNs += cpuNow - mIterationStartCpuNs;
+    } else {
+        mLastLogNs = now;
+    }
+    mIterationStartNs = now;
+    mIterationStartCpuNs = cpuNow;
+
+    if (now - mLastLogNs >= kLogIntervalNs) {
+        LogStats(now - mLastLogNs);
+        mLastLogNs = now;
+    }
+}
+
+void LoopScheduler::LogStats(uint64_t intervalNs) {
+    const double seconds = intervalNs / 1e9;
+    for (int state = 0; state < LoopState_Count; state++) {
+        const LoopStats &stats = mStats[state];
+        LoopStats &logged = mLoggedStats[state];
+        if (stats.iterations == logged.iterations) {
+            continue;
+        }
+        LOGI("loopstats %s: iterations/s:%.1f, frames/s:%.1f, cpu:%.1fms/s",
+             LoopStateToString((LoopState) state),
+             (stats.iterations - logged.iterations) / seconds,
+             (stats.frames - logged.frames) / seconds,
+             (stats.cpuTimeNs - logged.cpuTimeNs) / 1e6 / seconds);
+        logged = stats;
+    }
+}
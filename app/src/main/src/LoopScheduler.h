@@ -0,0 +1,67 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_LOOP_SCHEDULER_H
+#define CLIENT_APP_LOOP_SCHEDULER_H
+
+#include <stdint.h>
+
+enum LoopState {
+    // app in the background, nothing to render
+    LoopState_Paused = 0,
+    // foreground but not streaming (disconnected, connecting, waiting for the XR session)
+    LoopState_Idle,
+    // streaming; the Pxr frame calls pace the loop
+    LoopState_Streaming,
+    LoopState_Count
+};
+
+struct LoopStats {
+    uint64_t iterations = 0;
+    uint64_t frames = 0;
+    uint64_t cpuTimeNs = 0;
+    uint64_t wallTimeNs = 0;
+};
+
+// Decides how long the main loop may block in ALooper_pollAll and whether it renders a frame,
+// so the loop only spins at display rate while a stream is being shown. Also keeps per-state
+// iteration counts and main thread CPU time.
+class LoopScheduler {
+
+public:
+    static const int kPausedPollTimeoutMs = 100;
+    static const uint64_t kIdleFrameIntervalNs = 100000000; // 10 Hz
+
+    void SetState(LoopState state);
+
+    LoopState GetState() const {
+        return mState;
+    }
+
+    // Timeout for the next ALooper_pollAll call of this iteration.
+    int GetPollTimeoutMs() const;
+
+    // Whether this iteration renders a frame. Consumes the idle frame slot when it returns true.
+    bool ShouldRenderFrame();
+
+    // Accounts the iteration that just finished; logs the stats every kLogIntervalNs.
+    void OnIterationEnd();
+
+    const LoopStats &GetStats(LoopState state) const {
+        return mStats[state];
+    }
+
+private:
+    static const uint64_t kLogIntervalNs = 10000000000ULL;
+
+    void LogStats(uint64_t intervalNs);
+
+    LoopState mState = LoopState_Paused;
+    uint64_t mNextIdleFrameNs = 0;
+
+    uint64_t mIterationStartNs = 0;
+    uint64_t mIterationStartCpuNs = 0;
+    uint64_t mLastLogNs = 0;
+    LoopStats mStats[LoopState_Count];
+    LoopStats mLoggedStats[LoopState_Count];
+};
+
+#endif //CLIENT_APP_LOOP_SCHEDULER_H
@@ -0,0 +1,99 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "MicroBenchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include "AllocationAudit.h"
+#include "util.h"
+
+namespace {
+    double ElapsedNs(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool IsOverBudget(const BenchmarkResult &result) {
+        return result.budgetNsPerOp > 0 && result.nsPerOp > result.budgetNsPerOp;
+    }
+}
+
+void MicroBenchmark::Add(const char *name, Body body, double budgetNsPerOp) {
+    mEntries.push_back({name, std::move(body), budgetNsPerOp});
+}
+
+const std::vector<BenchmarkResult> &MicroBenchmark::Run() {
+    mResults.clear();
+    for (const Entry &entry : mEntries) {
+        const double minRunNs = double(kMinRunMs) * 1e6;
+        uint32_t iterations = 1;
+        for (;;) {
+            const auto start = std::chrono::steady_clock::now();
+            entry.body(iterations);
+            if (ElapsedNs(start) >= minRunNs || iterations >= kMaxIterations) {
+                break;
+            }
+            iterations *= 2;
+        }
+
+        double nsPerOp[kRepetitions];
+        const uint64_t allocationsBefore = AllocationAudit::GetThreadAllocationCount();
+        for (uint32_t i = 0; i < kRepetitions; i++) {
+            const auto start = std::chrono::steady_clock::now();
+            entry.body(iterations);
+            nsPerOp[i] = ElapsedNs(start) / iterations;
+        }
+        const uint64_t allocations = AllocationAudit::GetThreadAllocationCount() - allocationsBefore;
+        std::sort(nsPerOp, nsPerOp + kRepetitions);
+
+        BenchmarkResult result;
+        result.name = entry.name;
+        result.iterations = iterations;
+        result.nsPerOp = nsPerOp[kRepetitions / 2];
+        result.minNsPerOp = nsPerOp[0];
+#ifdef CXR_ALLOCATION_AUDIT
+        result.allocsPerOp = double(allocations) / (double(iterations) * kRepetitions);
+#else
+        (void) allocations;
+        result.allocsPerOp = -1;
+#endif
+        result.budgetNsPerOp = entry.budgetNsPerOp;
+        mResults.push_back(result);
+    }
+    return mResults;
+}
+
+void MicroBenchmark::Log() const {
+    for (const BenchmarkResult &result : mResults) {
+        LOGI("benchmark %s: %.1f ns/op (min %.1f), %.2f allocs/op, %llu iterations", result.name, result.nsPerOp,
+             result.minNsPerOp, result.allocsPerOp, (unsigned long long) result.iterations);
+        if (IsOverBudget(result)) {
+            LOGE("benchmark %s over budget: %.1f ns/op, budget %.1f", result.name, result.nsPerOp, result.budgetNsPerOp);
+        }
+    }
+}
+
+uint32_t MicroBenchmark::GetOverBudgetCount() const {
+    return uint32_t(std::count_if(mResults.begin(), mResults.end(), IsOverBudget));
+}
+
+bool MicroBenchmark::WriteJson(const std::string &path) const {
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        LOGE("Failed to write benchmark results to %s", path.c_str());
+        return false;
+    }
+    fprintf(file, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < mResults.size(); i++) {
+        const BenchmarkResult &result = mResults[i];
+        fprintf(file, "    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f, \"min_ns_per_op\": %.2f, "
+                      "\"allocs_per_op\": %.3f, \"budget_ns_per_op\": %.2f, \"over_budget\": %s}%s\n",
+                result.name, (unsigned long long) result.iterations, result.nsPerOp, result.minNsPerOp,
+                result.allocsPerOp, result.budgetNsPerOp, IsOverBudget(result) ? "true" : "false",
+                i + 1 < mResults.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    const bool written = fclose(file) == 0;
+    if (written) {
+        LOGI("Benchmark results written to %s", path.c_str());
+    }
+    return written;
+}
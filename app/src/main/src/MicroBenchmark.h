@@ -0,0 +1,68 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_MICRO_BENCHMARK_H
+#define CLIENT_APP_MICRO_BENCHMARK_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+struct BenchmarkResult {
+    const char *name;
+    uint64_t iterations;
+    // median of kRepetitions runs
+    double nsPerOp;
+    double minNsPerOp;
+    // -1 when allocations are not counted, see AllocationAudit::GetThreadAllocationCount()
+    double allocsPerOp;
+    // 0 when the operation has no budget
+    double budgetNsPerOp;
+};
+
+// Times the client's hot functions on the calling thread and writes the results as JSON, so
+// runs from two releases can be diffed.
+//
+// Each body runs its operation the given number of times. The iteration count doubles until
+// one run takes kMinRunMs, then the body is run kRepetitions more times at that count.
+// Allocations are counted in builds with CXR_ALLOCATION_AUDIT. An operation added with a budget
+// is logged as an error when its median exceeds it; the host benchmark fails then.
+class MicroBenchmark {
+
+public:
+    typedef std::function<void(uint32_t iterations)> Body;
+
+    static const uint32_t kMinRunMs = 50;
+    static const uint32_t kRepetitions = 5;
+    static const uint32_t kMaxIterations = 1u << 24;
+
+    void Add(const char *name, Body body, double budgetNsPerOp = 0);
+
+    const std::vector<BenchmarkResult> &Run();
+
+    void Log() const;
+
+    // Operations of the last Run() whose median exceeded their budget.
+    uint32_t GetOverBudgetCount() const;
+
+    // {"benchmarks": [{"name", "iterations", "ns_per_op", "min_ns_per_op", "allocs_per_op",
+    //                 "budget_ns_per_op", "over_budget"}]}
+    bool WriteJson(const std::string &path) const;
+
+    // Keeps the compiler from dropping a computation whose result is otherwise unused.
+    template<typename T>
+    static void Consume(const T &value) {
+        asm volatile("" : : "r"(&value) : "memory");
+    }
+
+private:
+    struct Entry {
+        const char *name;
+        Body body;
+        double budgetNsPerOp;
+    };
+
+    std::vector<Entry> mEntries;
+    std::vector<BenchmarkResult> mResults;
+};
+
+#endif //CLIENT_APP_MICRO_BENCHMARK_H
@@ -0,0 +1,149 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "PoseFilter.h"
+#include <math.h>
+
+namespace {
+    const float kTwoPi = 6.28318530718f;
+
+    // smoothing factor of a first-order low-pass at cutoffHz for a step of dt seconds
+    inline float Alpha(float cutoffHz, float dt) {
+        return dt / (dt + 1.0f / (kTwoPi * cutoffHz));
+    }
+}
+
+void PoseFilter::SetParams(const PoseFilterParams &params) {
+    mParams = params;
+}
+
+void PoseFilter::SetDeviceMask(uint32_t mask) {
+    mDeviceMask = mask & ((1u << PoseFilterDevice_Count) - 1);
+    mPrimed &= mDeviceMask;
+}
+
+void PoseFilter::Reset() {
+    mPrimed = 0;
+}
+
+void PoseFilter::Filter(double timeMs, PxrPosef *const poses[PoseFilterDevice_Count], uint32_t validMask) {
+    const uint32_t active = mDeviceMask & validMask;
+    const double stepMs = timeMs - mLastTimeMs;
+    mLastTimeMs = timeMs;
+    if (active == 0) {
+        mPrimed = 0;
+        return;
+    }
+    uint32_t primed = mPrimed & active;
+    if (stepMs <= 0 || stepMs > kMaxStepMs) {
+        primed = 0;
+    }
+    const float dt = float(stepMs / 1000.0);
+
+    // gather; lanes without a device keep their state, so every step below leaves them as is
+    alignas(16) float raw[Channel_Count][kLanes];
+    for (uint32_t c = 0; c < Channel_Count; c++) {
+        for (uint32_t l = 0; l < kLanes; l++) {
+            raw[c][l] = mValue[c][l];
+        }
+    }
+    for (uint32_t l = 0; l < PoseFilterDevice_Count; l++) {
+        if ((active & (1u << l)) == 0) {
+            continue;
+        }
+        const PxrPosef &pose = *poses[l];
+        raw[Channel_PosX][l] = pose.position.x;
+        raw[Channel_PosY][l] = pose.position.y;
+        raw[Channel_PosZ][l] = pose.position.z;
+        float sign = 1.0f;
+        if (primed & (1u << l)) {
+            // q and -q are the same rotation; stay next to the filtered one
+            const float dot = pose.orientation.x * mValue[Channel_RotX][l] + pose.orientation.y * mValue[Channel_RotY][l] +
+                              pose.orientation.z * mValue[Channel_RotZ][l] + pose.orientation.w * mValue[Channel_RotW][l];
+            sign = dot < 0 ? -1.0f : 1.0f;
+        }
+        raw[Channel_RotX][l] = sign * pose.orientation.x;
+        raw[Channel_RotY][l] = sign * pose.orientation.y;
+        raw[Channel_RotZ][l] = sign * pose.orientation.z;
+        raw[Channel_RotW][l] = sign * pose.orientation.w;
+    }
+
+    if (primed != 0) {
+        alignas(16) float positionSq[kLanes] = {};
+        alignas(16) float rotationSq[kLanes] = {};
+        for (uint32_t c = Channel_PosX; c <= Channel_PosZ; c++) {
+            for (uint32_t l = 0; l < kLanes; l++) {
+                const float d = raw[c][l] - mValue[c][l];
+                positionSq[l] += d * d;
+            }
+        }
+        for (uint32_t c = Channel_RotX; c <= Channel_RotW; c++) {
+            for (uint32_t l = 0; l < kLanes; l++) {
+                const float d = raw[c][l] - mValue[c][l];
+                rotationSq[l] += d * d;
+            }
+        }
+
+        const float alphaSpeed = Alpha(mParams.derivativeCutoffHz, dt);
+        const float invDt = 1.0f / dt;
+        alignas(16) float alphaPosition[kLanes];
+        alignas(16) float alphaRotation[kLanes];
+        for (uint32_t l = 0; l < kLanes; l++) {
+            // a small rotation changes the unit quaternion by about half its angle
+            const float positionSpeed = sqrtf(positionSq[l]) * invDt;
+            const float rotationSpeed = 2.0f * sqrtf(rotationSq[l]) * invDt;
+            mSpeed[0][l] += alphaSpeed * (positionSpeed - mSpeed[0][l]);
+            mSpeed[1][l] += alphaSpeed * (rotationSpeed - mSpeed[1][l]);
+            alphaPosition[l] = Alpha(mParams.minCutoffHz + mParams.beta * mSpeed[0][l], dt);
+            alphaRotation[l] = Alpha(mParams.minCutoffHz + mParams.beta * mSpeed[1][l], dt);
+        }
+
+        for (uint32_t c = Channel_PosX; c <= Channel_PosZ; c++) {
+            for (uint32_t l = 0; l < kLanes; l++) {
+                mValue[c][l] += alphaPosition[l] * (raw[c][l] - mValue[c][l]);
+            }
+        }
+        for (uint32_t c = Channel_RotX; c <= Channel_RotW; c++) {
+            for (uint32_t l = 0; l < kLanes; l++) {
+                mValue[c][l] += alphaRotation[l] * (raw[c][l] - mValue[c][l]);
+            }
+        }
+        alignas(16) float norm[kLanes] = {};
+        for (uint32_t c = Channel_RotX; c <= Channel_RotW; c++) {
+            for (uint32_t l = 0; l < kLanes; l++) {
+                norm[l] += mValue[c][l] * mValue[c][l];
+            }
+        }
+        for (uint32_t l = 0; l < kLanes; l++) {
+            norm[l] = norm[l] > 0 ? 1.0f / sqrtf(norm[l]) : 0;
+        }
+        for (uint32_t c = Channel_RotX; c <= Channel_RotW; c++) {
+            for (uint32_t l = 0; l < kLanes; l++) {
+                mValue[c][l] = norm[l] > 0 ? mValue[c][l] * norm[l] : raw[c][l];
+            }
+        }
+    }
+
+    // scatter; devices seen for the first time start from the raw pose
+    for (uint32_t l = 0; l < PoseFilterDevice_Count; l++) {
+        const uint32_t bit = 1u << l;
+        if ((active & bit) == 0) {
+            continue;
+        }
+        if ((primed & bit) == 0) {
+            for (uint32_t c = 0; c < Channel_Count; c++) {
+                mValue[c][l] = raw[c][l];
+            }
+            mSpeed[0][l] = 0;
+            mSpeed[1][l] = 0;
+            continue;
+        }
+        PxrPosef &pose = *poses[l];
+        pose.position.x = mValue[Channel_PosX][l];
+        pose.position.y = mValue[Channel_PosY][l];
+        pose.position.z = mValue[Channel_PosZ][l];
+        pose.orientation.x = mValue[Channel_RotX][l];
+        pose.orientation.y = mValue[Channel_RotY][l];
+        pose.orientation.z = mValue[Channel_RotZ][l];
+        pose.orientation.w = mValue[Channel_RotW][l];
+    }
+    mPrimed = active;
+}
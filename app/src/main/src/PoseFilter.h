@@ -0,0 +1,72 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_POSE_FILTER_H
+#define CLIENT_APP_POSE_FILTER_H
+
+#include <stdint.h>
+#include "PxrTypes.h"
+
+enum PoseFilterDevice {
+    PoseFilterDevice_Head = 0,
+    PoseFilterDevice_LeftController,
+    PoseFilterDevice_RightController,
+    PoseFilterDevice_Count,
+};
+
+// One Euro filter parameters: the cutoff frequency is minCutoffHz at rest and rises by beta Hz
+// per m/s (position) or rad/s (orientation) of filtered speed, so slow hands are smoothed and
+// fast ones follow with little lag. The speed itself is low-passed at derivativeCutoffHz.
+struct PoseFilterParams {
+    float minCutoffHz = 1.0f;
+    float beta = 2.0f;
+    float derivativeCutoffHz = 1.0f;
+};
+
+// Adaptive (One Euro) smoothing of head and controller poses, applied once per frame before the
+// poses are extrapolated and sent to the server.
+//
+// The state is kept as structure of arrays, one lane per device, and every step runs across all
+// lanes at once, so one Filter() call costs about as much as filtering a single device. The
+// speed driving the cutoff is the magnitude of the whole position or orientation derivative, so
+// all axes of a device share one cutoff. Orientations are kept in the hemisphere of the
+// previous sample and normalized after filtering. A lane restarts from the raw pose when its
+// device was not filtered in the previous call or the time step is not usable.
+class PoseFilter {
+
+public:
+    static const uint32_t kLanes = 4;
+    // time steps outside of this range restart the filter
+    static const uint32_t kMaxStepMs = 100;
+    // cost of one Filter() call for all devices, checked by the pose filter benchmark
+    static const uint32_t kBudgetNs = 1000;
+
+    void SetParams(const PoseFilterParams &params);
+
+    // Devices to filter, as a mask of 1 << PoseFilterDevice; 0 disables the filter.
+    void SetDeviceMask(uint32_t mask);
+
+    bool IsEnabled() const { return mDeviceMask != 0; }
+
+    // Filters poses[device] in place for every device in the mask whose pose is valid (validMask).
+    void Filter(double timeMs, PxrPosef *const poses[PoseFilterDevice_Count], uint32_t validMask);
+
+    void Reset();
+
+private:
+    enum Channel {
+        Channel_PosX, Channel_PosY, Channel_PosZ,
+        Channel_RotX, Channel_RotY, Channel_RotZ, Channel_RotW,
+        Channel_Count,
+    };
+
+    PoseFilterParams mParams;
+    uint32_t mDeviceMask = 0;
+    double mLastTimeMs = 0;
+    // lanes that hold a filtered sample from the previous call
+    uint32_t mPrimed = 0;
+
+    alignas(16) float mValue[Channel_Count][kLanes] = {};
+    // filtered speed: [0] position in m/s, [1] orientation in rad/s
+    alignas(16) float mSpeed[2][kLanes] = {};
+};
+
+#endif //CLIENT_APP_POSE_FILTER_H
@@ -0,0 +1,96 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "PredictionCalibrator.h"
+#include <math.h>
+#include <stdio.h>
+#include "util.h"
+
+void PredictionCalibrator::SetHorizonMs(float horizonMs) {
+    if (!(horizonMs >= kMinHorizonMs)) {
+        horizonMs = kMinHorizonMs;
+    } else if (horizonMs > kMaxHorizonMs) {
+        horizonMs = kMaxHorizonMs;
+    }
+    mHorizonMs.store(horizonMs, std::memory_order_relaxed);
+    mSmoothedResidualMs = 0;
+}
+
+bool PredictionCalibrator::OnWindow(double residualMs, uint32_t sampleCount) {
+    if (sampleCount < kMinSamples) {
+        return false;
+    }
+    mSmoothedResidualMs += kSmoothing * (residualMs - mSmoothedResidualMs);
+    if (fabs(mSmoothedResidualMs) < kDeadbandMs) {
+        return false;
+    }
+
+    const float horizon = GetHorizonMs();
+    float step = float(mSmoothedResidualMs);
+    if (step > kMaxStepMs) {
+        step = kMaxStepMs;
+    } else if (step < -kMaxStepMs) {
+        step = -kMaxStepMs;
+    }
+    float next = horizon + step;
+    if (next < kMinHorizonMs) {
+        next = kMinHorizonMs;
+    } else if (next > kMaxHorizonMs) {
+        next = kMaxHorizonMs;
+    }
+    if (next == horizon) {
+        return false;
+    }
+    mHorizonMs.store(next, std::memory_order_relaxed);
+    mSmoothedResidualMs -= next - horizon;
+    return true;
+}
+
+std::string PredictionCalibrator::GetPath(const std::string &dir, const std::string &server) {
+    std::string name = server;
+    for (char &c : name) {
+        if (!isalnum((unsigned char) c) && c != '.' && c != '-') {
+            c = '_';
+        }
+    }
+    return dir + "/prediction_" + name + ".txt";
+}
+
+bool PredictionCalibrator::Load(const std::string &dir, const std::string &server) {
+    if (dir.empty() || server.empty()) {
+        return false;
+    }
+    const std::string path = GetPath(dir, server);
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return false;
+    }
+    float horizonMs = 0;
+    const bool ok = fscanf(file, "%f", &horizonMs) == 1;
+    fclose(file);
+    if (!ok) {
+        LOGE("Ignoring unreadable prediction horizon in %s", path.c_str());
+        return false;
+    }
+    SetHorizonMs(horizonMs);
+    LOGI("Prediction horizon for %s: %.1fms", server.c_str(), GetHorizonMs());
+    return true;
+}
+
+bool PredictionCalibrator::Save(const std::string &dir, const std::string &server) const {
+    if (dir.empty() || server.empty()) {
+        return false;
+    }
+    const std::string path = GetPath(dir, server);
+    const std::string tmpPath = path + ".tmp";
+    FILE *file = fopen(tmpPath.c_str(), "w");
+    if (file == nullptr) {
+        LOGE("Failed to write prediction horizon to %s", tmpPath.c_str());
+        return false;
+    }
+    const bool ok = fprintf(file, "%.2f\n", GetHorizonMs()) > 0;
+    if (fclose(file) != 0 || !ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        LOGE("Failed to write prediction horizon to %s", path.c_str());
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
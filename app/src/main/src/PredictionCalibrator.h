@@ -0,0 +1,53 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_PREDICTION_CALIBRATOR_H
+#define CLIENT_APP_PREDICTION_CALIBRATOR_H
+
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+// Learns how far ahead of the local display time poses have to be extrapolated before they are
+// sent to the server.
+//
+// Each reporting window the measured residual (actual display time minus the time the pose was
+// predicted for, see LatencyTracker) is smoothed with an exponential moving average. The
+// horizon only moves when the smoothed residual leaves a deadband, by at most kMaxStepMs per
+// window, and stays within [kMinHorizonMs, kMaxHorizonMs]. The part of the residual a step
+// accounts for is taken out of the average right away, so the next windows do not push the
+// horizon past the target while the new horizon shows up in the measurements.
+class PredictionCalibrator {
+
+public:
+    static constexpr float kMinHorizonMs = 0.0f;
+    static constexpr float kMaxHorizonMs = 80.0f;
+    static constexpr float kDefaultHorizonMs = 0.0f;
+    static constexpr float kSmoothing = 0.3f;
+    static constexpr float kDeadbandMs = 1.0f;
+    static constexpr float kMaxStepMs = 4.0f;
+    // windows with fewer matched frames are ignored
+    static const uint32_t kMinSamples = 10;
+
+    // Read by the tracking thread, updated by the render thread.
+    float GetHorizonMs() const {
+        return mHorizonMs.load(std::memory_order_relaxed);
+    }
+
+    void SetHorizonMs(float horizonMs);
+
+    // Feeds one reporting window; returns true when the horizon changed.
+    bool OnWindow(double residualMs, uint32_t sampleCount);
+
+    // Per-server persistence of the learned horizon in dir. Load() keeps the current horizon
+    // when nothing was stored for the server.
+    bool Load(const std::string &dir, const std::string &server);
+
+    bool Save(const std::string &dir, const std::string &server) const;
+
+private:
+    static std::string GetPath(const std::string &dir, const std::string &server);
+
+    std::atomic<float> mHorizonMs{kDefaultHorizonMs};
+    double mSmoothedResidualMs = 0;
+};
+
+#endif //CLIENT_APP_PREDICTION_CALIBRATOR_H
@@ -0,0 +1,43 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "PxrDeviceState.h"
+#include <PxrApi.h>
+#include "util.h"
+
+void PxrDeviceState::Refresh() {
+    OnIpdChanged();
+    for (uint32_t hand = 0; hand < PXR_CONTROLLER_COUNT; hand++) {
+        RefreshController(hand);
+    }
+}
+
+void PxrDeviceState::RefreshIfStale(uint64_t timeMs) {
+    if (timeMs - mLastRefreshMs < kRefreshIntervalMs) {
+        return;
+    }
+    mLastRefreshMs = timeMs;
+    Refresh();
+}
+
+void PxrDeviceState::OnControllerEvent(const PxrEventDataControllerChanged &event) {
+    // The event payload differs per event type, so just re-query the controller it refers to.
+    if (event.controller < PXR_CONTROLLER_COUNT) {
+        RefreshController(event.controller);
+    }
+}
+
+void PxrDeviceState::OnIpdChanged() {
+    mIpd.store(Pxr_GetIPD(), std::memory_order_relaxed);
+}
+
+void PxrDeviceState::RefreshController(uint32_t hand) {
+    const bool connected = Pxr_GetControllerConnectStatus(hand) == 1;
+    PxrControllerCapability cap = {};
+    if (connected && Pxr_GetControllerCapabilities(hand, &cap) == 0) {
+        mControllerType[hand].store(cap.type, std::memory_order_relaxed);
+        mControllerAbilities[hand].store(cap.Abilities, std::memory_order_relaxed);
+    }
+
+    if (mControllerConnected[hand].exchange(connected, std::memory_order_relaxed) != connected) {
+        LOGI("controller %d %s, type:%d", hand, connected ? "connected" : "disconnected", cap.type);
+    }
+}
@@ -0,0 +1,59 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_PXR_DEVICE_STATE_H
+#define CLIENT_APP_PXR_DEVICE_STATE_H
+
+#include <atomic>
+#include <stdint.h>
+#include <sys/types.h>
+#include "PxrTypes.h"
+#include "PxrInput.h"
+
+// Cached headset/controller properties. Every Pxr_Get* query is a round trip into the
+// runtime service, so the hot paths (tracking callback, haptics, render loop) read these
+// values instead. The cache is written from the render thread only (event dispatch and a
+// low-rate refresh) and read lock-free from any thread.
+class PxrDeviceState {
+
+public:
+
+    // Queries every cached property from the runtime.
+    void Refresh();
+
+    // Re-queries everything if the last full refresh is older than the refresh interval.
+    // Catches changes the runtime does not report through an event.
+    void RefreshIfStale(uint64_t timeMs);
+
+    void OnControllerEvent(const PxrEventDataControllerChanged &event);
+
+    void OnIpdChanged();
+
+    float GetIPD() const {
+        return mIpd.load(std::memory_order_relaxed);
+    }
+
+    bool IsControllerConnected(uint32_t hand) const {
+        return hand < PXR_CONTROLLER_COUNT && mControllerConnected[hand].load(std::memory_order_relaxed);
+    }
+
+    PxrControllerType GetControllerType(uint32_t hand) const {
+        return hand < PXR_CONTROLLER_COUNT ? (PxrControllerType) mControllerType[hand].load(std::memory_order_relaxed) : PXR_NO_DEVICE;
+    }
+
+    uint64_t GetControllerAbilities(uint32_t hand) const {
+        return hand < PXR_CONTROLLER_COUNT ? mControllerAbilities[hand].load(std::memory_order_relaxed) : 0;
+    }
+
+private:
+    static const uint64_t kRefreshIntervalMs = 2000;
+
+    void RefreshController(uint32_t hand);
+
+    std::atomic<float> mIpd{0.0f};
+    std::atomic<bool> mControllerConnected[PXR_CONTROLLER_COUNT]{};
+    std::atomic<int> mControllerType[PXR_CONTROLLER_COUNT]{};
+    std::atomic<uint64_t> mControllerAbilities[PXR_CONTROLLER_COUNT]{};
+
+    uint64_t mLastRefreshMs = 0;
+};
+
+#endif //CLIENT_APP_PXR_DEVICE_STATE_H
@@ -0,0 +1,97 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "PxrEventDispatcher.h"
+#include <PxrApi.h>
+#include "util.h"
+#include "ThreadManager.h"
+
+PxrEventDispatcher::PxrEventDispatcher() :
+        mPool(new PxrEventDataBuffer[PXR_MAX_EVENT_COUNT]),
+        mQueue(new PxrEventDataBuffer[kQueueCapacity]) {
+    for (int i = 0; i < PXR_MAX_EVENT_COUNT; i++) {
+        mPoolPointers[i] = &mPool[i];
+    }
+}
+
+PxrEventDispatcher::~PxrEventDispatcher() {
+    StopPollingThread();
+}
+
+void PxrEventDispatcher::SetHandler(PxrStructureType type, Handler handler) {
+    if (type > PXR_TYPE_UNKNOWN && type < kMaxEventType) {
+        mHandlers[type] = std::move(handler);
+    }
+}
+
+void PxrEventDispatcher::Dispatch(uint32_t maxEvents) {
+    if (!mPollingThreadRunning.load(std::memory_order_relaxed)) {
+        Poll();
+    }
+
+    uint32_t head = mQueueHead.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < maxEvents && head != mQueueTail.load(std::memory_order_acquire); i++) {
+        const PxrEventDataBuffer &event = mQueue[head % kQueueCapacity];
+        if (event.type > PXR_TYPE_UNKNOWN && event.type < kMaxEventType && mHandlers[event.type]) {
+            mHandlers[event.type](event);
+        }
+        head++;
+        mQueueHead.store(head, std::memory_order_release);
+    }
+}
+
+void PxrEventDispatcher::StartPollingThread(uint32_t intervalMs) {
+    if (mPollingThreadRunning.exchange(true)) {
+        return;
+    }
+    mPollingThread = std::thread([this, intervalMs]() {
+        ThreadManager::RegisterCurrentThread(ThreadRole_Worker, "PxrEvents");
+        while (mPollingThreadRunning.load(std::memory_order_relaxed)) {
+            Poll();
+            std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+        }
+    });
+}
+
+void PxrEventDispatcher::StopPollingThread() {
+    if (!mPollingThreadRunning.exchange(false)) {
+        return;
+    }
+    if (mPollingThread.joinable()) {
+        mPollingThread.join();
+    }
+}
+
+uint32_t PxrEventDispatcher::GetQueuedCount() const {
+    return mQueueTail.load(std::memory_order_acquire) - mQueueHead.load(std::memory_order_acquire);
+}
+
+void PxrEventDispatcher::Poll() {
+    // Only poll when a full poll fits; events left in the runtime are picked up later
+    // instead of being dropped here.
+    if (kQueueCapacity - GetQueuedCount() < PXR_MAX_EVENT_COUNT) {
+        return;
+    }
+
+    int eventCount = 0;
+    if (!Pxr_PollEvent(PXR_MAX_EVENT_COUNT, &eventCount, mPoolPointers)) {
+        return;
+    }
+    for (int i = 0; i < eventCount && i < PXR_MAX_EVENT_COUNT; i++) {
+        if (mPool[i].type == PXR_TYPE_EVENT_DATA_EVENTS_LOST) {
+            auto *lost = (PxrEventDataEventsLost *) &mPool[i];
+            mDroppedCount.fetch_add(lost->lostEventCount, std::memory_order_relaxed);
+        }
+        if (!Push(mPool[i])) {
+            mDroppedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool PxrEventDispatcher::Push(const PxrEventDataBuffer &event) {
+    const uint32_t tail = mQueueTail.load(std::memory_order_relaxed);
+    if (tail - mQueueHead.load(std::memory_order_acquire) >= kQueueCapacity) {
+        return false;
+    }
+    mQueue[tail % kQueueCapacity] = event;
+    mQueueTail.store(tail + 1, std::memory_order_release);
+    return true;
+}
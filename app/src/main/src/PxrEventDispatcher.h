@@ -0,0 +1,71 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_PXR_EVENT_DISPATCHER_H
+#define CLIENT_APP_PXR_EVENT_DISPATCHER_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include "PxrTypes.h"
+
+// Typed dispatch of Pxr runtime events to registered handlers.
+//
+// Events are polled into a pool and copied into a fixed-size single-producer/single-consumer
+// queue. Both are allocated once by the constructor, which keeps their ~42KB off the stack of
+// android_main, where the dispatcher lives; nothing is allocated per event. Dispatch() runs at most maxEvents
+// handlers per call; the rest stay queued for the next call, so a burst of events is spread
+// over several frames instead of stalling one. Polling happens either inside Dispatch() or,
+// after StartPollingThread(), on a dedicated thread; handlers always run on the thread that
+// calls Dispatch().
+class PxrEventDispatcher {
+
+public:
+    typedef std::function<void(const PxrEventDataBuffer &event)> Handler;
+
+    static const uint32_t kQueueCapacity = 64;
+    static const int kMaxEventType = PXR_TYPE_EVENT_DATA_MAIN_SESSION_VISIBILITY_CHANGED_EXTX + 1;
+
+    PxrEventDispatcher();
+
+    ~PxrEventDispatcher();
+
+    // Registers the handler of an event type, replacing any previous one. Not thread-safe;
+    // register everything before the first Dispatch().
+    void SetHandler(PxrStructureType type, Handler handler);
+
+    // Polls (unless the polling thread runs) and runs the handlers of up to maxEvents queued events.
+    void Dispatch(uint32_t maxEvents);
+
+    void StartPollingThread(uint32_t intervalMs);
+
+    void StopPollingThread();
+
+    uint32_t GetQueuedCount() const;
+
+    // Events lost because the queue was full or the runtime reported lost events.
+    uint64_t GetDroppedCount() const {
+        return mDroppedCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    void Poll();
+
+    bool Push(const PxrEventDataBuffer &event);
+
+    Handler mHandlers[kMaxEventType];
+
+    // poll target, reused every poll
+    std::unique_ptr<PxrEventDataBuffer[]> mPool;
+    PxrEventDataBuffer *mPoolPointers[PXR_MAX_EVENT_COUNT];
+
+    std::unique_ptr<PxrEventDataBuffer[]> mQueue;
+    std::atomic<uint32_t> mQueueHead{0}; // next slot to read, consumer-owned
+    std::atomic<uint32_t> mQueueTail{0}; // next slot to write, producer-owned
+
+    std::atomic<uint64_t> mDroppedCount{0};
+
+    std::thread mPollingThread;
+    std::atomic<bool> mPollingThreadRunning{false};
+};
+
+#endif //CLIENT_APP_PXR_EVENT_DISPATCHER_H
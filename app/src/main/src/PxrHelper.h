@@ -14,6 +14,8 @@ typedef struct pxrPose_ {
     PxrSensorState headPose;
     PxrSensorState leftControllerPose;
     PxrSensorState rightControllerPose;
+    // time the poses are predicted for
+    double predictedDisplayTimeMs;
 } pxrPose;
 
 typedef enum {
@@ -0,0 +1,190 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_PXR_LAUNCH_OPTIONS_H
+#define CLIENT_APP_PXR_LAUNCH_OPTIONS_H
+
+#include <stdlib.h>
+#include <string>
+#include "CloudXRClientOptions.h"
+#include "AsyncLog.h"
+
+// How the eye layer swapchain is laid out.
+enum PxrStereoLayout {
+    // one swapchain per eye, one framebuffer bind and blit per eye
+    PxrStereoLayout_Stereo = 0,
+    // both eyes side by side in a single swapchain, one framebuffer bind per frame
+    PxrStereoLayout_DoubleWide,
+};
+
+// When the stream quality controller may change bitrate, resolution and foveation.
+enum PxrAdaptiveQuality {
+    // use the launch options as they are
+    PxrAdaptiveQuality_Off = 0,
+    // apply the controller's settings whenever the client connects
+    PxrAdaptiveQuality_OnConnect,
+    // also reconnect when a poor connection needs settings far from the current ones
+    PxrAdaptiveQuality_Reconnect,
+};
+
+// Which tracked poses are smoothed by the pose filter before they are sent to the server.
+enum PxrPoseFilter {
+    PxrPoseFilter_Off = 0,
+    PxrPoseFilter_Controllers,
+    // controllers and head
+    PxrPoseFilter_All,
+};
+
+// CloudXR launch options plus the options specific to the Pico client.
+//
+// The handlers capture this, so an instance must not be copied; parse into a new instance
+// instead. Values a handler does not recognize fail the parse with ParseStatus_BadVal.
+class PxrLaunchOptions : public CloudXR::ClientOptions {
+
+public:
+    PxrStereoLayout mStereoLayout;
+    bool mEventThread;
+    // fixed display refresh rate in Hz, 0 to pick it from the stream statistics
+    float mRefreshRate;
+    PxrAdaptiveQuality mAdaptiveQuality;
+    // per-role thread affinity and nice values, parsed by ThreadManager::Configure()
+    std::string mThreadAffinity;
+    std::string mThreadPriority;
+    // lowest AsyncLogPriority that is logged
+    int mLogLevel;
+    // faults injected into the session, parsed by FaultInjector::ParseProfile(); only injected in
+    // builds with CXR_FAULT_INJECTION
+    std::string mFaultInjection;
+    // where the startup micro-benchmarks write their JSON results; empty to skip them
+    std::string mBenchmarkOutput;
+    PxrPoseFilter mPoseFilter;
+    // One Euro cutoff at rest in Hz, and its increase in Hz per m/s or rad/s
+    float mPoseFilterCutoff;
+    float mPoseFilterBeta;
+
+    PxrLaunchOptions() :
+            ClientOptions(),
+            mStereoLayout(PxrStereoLayout_Stereo),
+            mEventThread(false),
+            mRefreshRate(0),
+            mAdaptiveQuality(PxrAdaptiveQuality_Off),
+            mLogLevel(AsyncLogPriority_Debug),
+            mPoseFilter(PxrPoseFilter_Off),
+            mPoseFilterCutoff(1.0f),
+            mPoseFilterBeta(2.0f) {
+        AddOption("stereo-layout", "sl", true, "Eye layer layout: stereo (default) or double-wide.",
+                  HANDLER_LAMBDA_FN
+                  {
+                      if (tok == "stereo") {
+                          mStereoLayout = PxrStereoLayout_Stereo;
+                      } else if (tok == "double-wide") {
+                          mStereoLayout = PxrStereoLayout_DoubleWide;
+                      } else {
+                          return ParseStatus_BadVal;
+                      }
+                      return ParseStatus_Success;
+                  });
+        AddOption("event-thread", "et", true, "Poll Pxr events on a dedicated thread: 1 enables, 0 disables (default).",
+                  HANDLER_LAMBDA_FN
+                  {
+                      if (tok != "0" && tok != "1") {
+                          return ParseStatus_BadVal;
+                      }
+                      mEventThread = (tok == "1");
+                      return ParseStatus_Success;
+                  });
+        AddOption("refresh-rate", "rr", true, "Display refresh rate in Hz, or auto (default) to adapt it to the stream.",
+                  HANDLER_LAMBDA_FN
+                  {
+                      if (tok == "auto") {
+                          mRefreshRate = 0;
+                          return ParseStatus_Success;
+                      }
+                      char *end = nullptr;
+                      mRefreshRate = strtof(tok.c_str(), &end);
+                      return (end != tok.c_str() && *end == '\0' && mRefreshRate > 0) ? ParseStatus_Success : ParseStatus_BadVal;
+                  });
+        AddOption("adaptive-quality", "aq", true, "Adapt bitrate, resolution and foveation to the network: off (default), on or reconnect.",
+                  HANDLER_LAMBDA_FN
+                  {
+                      if (tok == "off") {
+                          mAdaptiveQuality = PxrAdaptiveQuality_Off;
+                      } else if (tok == "on") {
+                          mAdaptiveQuality = PxrAdaptiveQuality_OnConnect;
+                      } else if (tok == "reconnect") {
+                          mAdaptiveQuality = PxrAdaptiveQuality_Reconnect;
+                      } else {
+                          return ParseStatus_BadVal;
+                      }
+                      return ParseStatus_Success;
+                  });
+        AddOption("thread-affinity", "ta", true, "Cores per thread role, e.g. render:big,audio:little (big, little, all or a hex mask).",
+                  HANDLER_LAMBDA_FN
+                  {
+                      mThreadAffinity = tok;
+                      return ParseStatus_Success;
+                  });
+        AddOption("thread-priority", "tp", true, "Nice value per thread role, e.g. render:-4,worker:10 (render and tracking default to -4).",
+                  HANDLER_LAMBDA_FN
+                  {
+                      mThreadPriority = tok;
+                      return ParseStatus_Success;
+                  });
+        AddOption("log-level", "ll", true, "Lowest priority that is logged: debug (default), info, warn or error.",
+                  HANDLER_LAMBDA_FN
+                  {
+                      if (tok == "debug") {
+                          mLogLevel = AsyncLogPriority_Debug;
+                      } else if (tok == "info") {
+                          mLogLevel = AsyncLogPriority_Info;
+                      } else if (tok == "warn") {
+                          mLogLevel = AsyncLogPriority_Warn;
+                      } else if (tok == "error") {
+                          mLogLevel = AsyncLogPriority_Error;
+                      } else {
+                          return ParseStatus_BadVal;
+                      }
+                      return ParseStatus_Success;
+                  });
+        AddOption("fault-injection", "fi", true, "Faults injected into the session, e.g. latch-drop:1,latch-stall:40@0.5,tracking-delay:8@2,audio-drop:1,reconnect:600,seed:7.",
+                  HANDLER_LAMBDA_FN
+                  {
+                      mFaultInjection = tok;
+                      return ParseStatus_Success;
+                  });
+        AddOption("benchmark", "bm", true, "Benchmark the client's per-frame functions at startup and write the results to this JSON file.",
+                  HANDLER_LAMBDA_FN
+                  {
+                      mBenchmarkOutput = tok;
+                      return ParseStatus_Success;
+                  });
+        AddOption("pose-filter", "pf", true, "Smooth tracked poses with an adaptive filter: off (default), controllers or all.",
+                  HANDLER_LAMBDA_FN
+                  {
+                      if (tok == "off") {
+                          mPoseFilter = PxrPoseFilter_Off;
+                      } else if (tok == "controllers") {
+                          mPoseFilter = PxrPoseFilter_Controllers;
+                      } else if (tok == "all") {
+                          mPoseFilter = PxrPoseFilter_All;
+                      } else {
+                          return ParseStatus_BadVal;
+                      }
+                      return ParseStatus_Success;
+                  });
+        AddOption("pose-filter-cutoff", "pfc", true, "Pose filter cutoff frequency at rest in Hz (default 1).",
+                  HANDLER_LAMBDA_FN
+                  {
+                      char *end = nullptr;
+                      mPoseFilterCutoff = strtof(tok.c_str(), &end);
+                      return (end != tok.c_str() && *end == '\0') ? ParseStatus_Success : ParseStatus_BadVal;
+                  });
+        AddOption("pose-filter-beta", "pfb", true, "Pose filter cutoff increase in Hz per m/s or rad/s of motion (default 2).",
+                  HANDLER_LAMBDA_FN
+                  {
+                      char *end = nullptr;
+                      mPoseFilterBeta = strtof(tok.c_str(), &end);
+                      return (end != tok.c_str() && *end == '\0') ? ParseStatus_Success : ParseStatus_BadVal;
+                  });
+    }
+};
+
+#endif //CLIENT_APP_PXR_LAUNCH_OPTIONS_H
@@ -0,0 +1,105 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "RefreshRateController.h"
+#include <algorithm>
+#include <cmath>
+
+void RefreshRateController::SetAvailableRates(const float *rates, uint32_t count) {
+    mRateCount = 0;
+    for (uint32_t i = 0; i < count && mRateCount < kMaxRates; i++) {
+        if (rates[i] <= 0 || std::find(mRates, mRates + mRateCount, rates[i]) != mRates + mRateCount) {
+            continue;
+        }
+        mRates[mRateCount++] = rates[i];
+    }
+    std::sort(mRates, mRates + mRateCount);
+}
+
+void RefreshRateController::SetCurrentRate(float rate) {
+    mPendingRate = 0;
+    if (rate == mCurrentRate) {
+        return;
+    }
+    mCurrentRate = rate;
+    mMissedWindows = 0;
+    mHeadroomWindows = 0;
+    mCooldown = kCooldownWindows;
+}
+
+bool RefreshRateController::OnRateChanged(float rate) {
+    if (mPendingRate > 0 && SameRate(rate, mPendingRate)) {
+        // the switch OnWindow() asked for; its cooldown is already running
+        mPendingRate = 0;
+        return false;
+    }
+    if (mPendingRate == 0 && SameRate(rate, mCurrentRate)) {
+        return false;
+    }
+    SetCurrentRate(rate);
+    return true;
+}
+
+void RefreshRateController::SwitchTo(float rate) {
+    SetCurrentRate(rate);
+    mPendingRate = rate;
+}
+
+float RefreshRateController::OnWindow(float framesPerSecond, float frameDeliveryTimeMs) {
+    const int current = CurrentIndex();
+    if (current < 0 || framesPerSecond <= 0) {
+        return 0;
+    }
+    if (mWindowsSinceUp > 0 && ++mWindowsSinceUp > kProbationWindows) {
+        mWindowsSinceUp = 0;
+        mUpWindowsRequired = kUpWindows;
+    }
+    if (mCooldown > 0) {
+        mCooldown--;
+        return 0;
+    }
+
+    if (framesPerSecond < mCurrentRate * kMissedRatio) {
+        mMissedWindows++;
+        mHeadroomWindows = 0;
+        if (mMissedWindows >= kDownWindows && current > 0) {
+            // highest rate the measured frame rate still covers, at least one step down
+            int target = current - 1;
+            while (target > 0 && mRates[target] * kMissedRatio > framesPerSecond) {
+                target--;
+            }
+            if (mWindowsSinceUp > 0) {
+                // the last step up did not hold
+                mUpWindowsRequired = std::min(mUpWindowsRequired * 2, kUpWindows * kMaxUpBackoff);
+                mWindowsSinceUp = 0;
+            }
+            SwitchTo(mRates[target]);
+            return mCurrentRate;
+        }
+        return 0;
+    }
+    mMissedWindows = 0;
+
+    if (current + 1 < int(mRateCount) && framesPerSecond >= mCurrentRate * kKeepUpRatio &&
+        frameDeliveryTimeMs < kDeliveryBudget * 1000.0f / mRates[current + 1]) {
+        if (++mHeadroomWindows >= mUpWindowsRequired) {
+            SwitchTo(mRates[current + 1]);
+            mWindowsSinceUp = 1;
+            return mCurrentRate;
+        }
+    } else {
+        mHeadroomWindows = 0;
+    }
+    return 0;
+}
+
+int RefreshRateController::CurrentIndex() const {
+    for (uint32_t i = 0; i < mRateCount; i++) {
+        if (SameRate(mRates[i], mCurrentRate)) {
+            return int(i);
+        }
+    }
+    return -1;
+}
+
+bool RefreshRateController::SameRate(float a, float b) {
+    return std::abs(a - b) < 0.5f;
+}
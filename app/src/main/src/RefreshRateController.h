@@ -0,0 +1,78 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_REFRESH_RATE_CONTROLLER_H
+#define CLIENT_APP_REFRESH_RATE_CONTROLLER_H
+
+#include <stdint.h>
+
+// Picks the display refresh rate the stream can sustain, from the per-second connection stats.
+//
+// The rate steps down when the received frame rate stays below kMissedRatio of the current rate
+// for kDownWindows windows in a row, to the highest supported rate the measured frame rate
+// covers. It steps up one rate when the frame rate keeps up with the current rate and the frame
+// delivery time fits into kDeliveryBudget of the higher rate's frame time for kUpWindows windows
+// in a row. Stepping down reacts faster than stepping up, and no decision is made for
+// kCooldownWindows windows after a switch, so the rate does not flap around a threshold.
+// A step up that has to be undone within kProbationWindows doubles the windows needed for the
+// next step up (up to kMaxUpBackoff times kUpWindows); staying up that long resets it.
+//
+// A rate returned by OnWindow() is pending until the runtime confirms it through
+// OnRateChanged(); the confirmation does not start another cooldown.
+//
+// Only plain numbers go in and out; applying the rate is up to the caller.
+class RefreshRateController {
+
+public:
+    static const uint32_t kMaxRates = 8;
+    static constexpr float kMissedRatio = 0.9f;
+    static constexpr float kKeepUpRatio = 0.97f;
+    static constexpr float kDeliveryBudget = 0.8f;
+    static const uint32_t kDownWindows = 3;
+    static const uint32_t kUpWindows = 10;
+    static const uint32_t kCooldownWindows = 5;
+    static const uint32_t kProbationWindows = 30;
+    static const uint32_t kMaxUpBackoff = 32;
+
+    // Supported rates in any order; duplicates and rates <= 0 are ignored.
+    void SetAvailableRates(const float *rates, uint32_t count);
+
+    // The rate the display runs at now, e.g. at startup or after a switch failed.
+    void SetCurrentRate(float rate);
+
+    // The runtime reports the display switched to rate; a confirmation of the pending switch is
+    // ignored, anything else is taken as the current rate. Returns whether the rate changed.
+    bool OnRateChanged(float rate);
+
+    // The rate of the last OnWindow() switch the runtime has not confirmed yet, 0 when none.
+    float GetPendingRate() const { return mPendingRate; }
+
+    float GetCurrentRate() const { return mCurrentRate; }
+
+    uint32_t GetRateCount() const { return mRateCount; }
+
+    // Feeds one stats window. Returns the rate to switch to, or 0 to stay at the current one.
+    // A returned rate becomes the current rate right away.
+    float OnWindow(float framesPerSecond, float frameDeliveryTimeMs);
+
+private:
+    // index of the current rate in mRates, or -1 when it is not one of them
+    int CurrentIndex() const;
+
+    // runtimes report rates like 71.99 for 72
+    static bool SameRate(float a, float b);
+
+    void SwitchTo(float rate);
+
+    float mRates[kMaxRates] = {};
+    uint32_t mRateCount = 0;
+    float mCurrentRate = 0;
+    float mPendingRate = 0;
+
+    uint32_t mMissedWindows = 0;
+    uint32_t mHeadroomWindows = 0;
+    uint32_t mCooldown = 0;
+    uint32_t mUpWindowsRequired = kUpWindows;
+    // windows since the last step up, 0 when the last switch was not a step up
+    uint32_t mWindowsSinceUp = 0;
+};
+
+#endif //CLIENT_APP_REFRESH_RATE_CONTROLLER_H
@@ -0,0 +1,69 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "RenderTargetPool.h"
+#include <PxrApi.h>
+#include "util.h"
+
+RenderTargetPool::~RenderTargetPool() {
+    Release();
+}
+
+bool RenderTargetPool::Create(int layerId, uint32_t eyeCount) {
+    Release();
+
+    for (uint32_t eye = 0; eye < eyeCount && eye < PXR_EYE_MAX; eye++) {
+        uint32_t imageCount = 0;
+        Pxr_GetLayerImageCount(layerId, (PxrEyeType) eye, &imageCount);
+        if (imageCount > kMaxImages) {
+            LOGE("Layer %d eye%d has %d images, only %d supported", layerId, eye, imageCount, kMaxImages);
+            imageCount = kMaxImages;
+        }
+
+        for (uint32_t i = 0; i < imageCount; i++) {
+            uint64_t image = 0;
+            Pxr_GetLayerImage(layerId, (PxrEyeType) eye, i, &image);
+            if (!CreateFramebuffer((GLuint) image, mFramebuffers[eye][i])) {
+                Release();
+                return false;
+            }
+        }
+        mImageCounts[eye] = imageCount;
+        LOGI("Created %d render targets for layer %d eye%d", imageCount, layerId, eye);
+    }
+    return IsValid();
+}
+
+void RenderTargetPool::Release() {
+    for (uint32_t eye = 0; eye < PXR_EYE_MAX; eye++) {
+        // also covers a partially created eye, whose count is not set yet
+        for (auto &framebuffer: mFramebuffers[eye]) {
+            if (framebuffer != 0) {
+                glDeleteFramebuffers(1, &framebuffer);
+                framebuffer = 0;
+            }
+        }
+        mImageCounts[eye] = 0;
+    }
+}
+
+bool RenderTargetPool::Bind(uint32_t eye, uint32_t imageIndex) const {
+    if (eye >= PXR_EYE_MAX || imageIndex >= mImageCounts[eye]) {
+        return false;
+    }
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mFramebuffers[eye][imageIndex]);
+    return true;
+}
+
+bool RenderTargetPool::CreateFramebuffer(GLuint colorTexture, GLuint &framebuffer) {
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+
+    GLenum status = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOGE("Incomplete frame buffer object for texture %d, status 0x%x", colorTexture, status);
+        return false;
+    }
+    return true;
+}
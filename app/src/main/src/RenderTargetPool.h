@@ -0,0 +1,48 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_RENDER_TARGET_POOL_H
+#define CLIENT_APP_RENDER_TARGET_POOL_H
+
+#include <GLES3/gl3.h>
+#include <stdint.h>
+#include "PxrTypes.h"
+
+// Framebuffers for the swapchain images of a Pxr layer: one complete FBO per image per eye,
+// created and validated when the layer is created. Binding a render target is then a single
+// glBindFramebuffer, without re-attaching the swapchain texture (and having the driver
+// re-validate the framebuffer) every frame.
+class RenderTargetPool {
+
+public:
+    static const uint32_t kMaxImages = 8;
+
+    RenderTargetPool() = default;
+    RenderTargetPool(const RenderTargetPool &) = delete;
+    RenderTargetPool &operator=(const RenderTargetPool &) = delete;
+
+    ~RenderTargetPool();
+
+    // Queries the swapchain images of the first eyeCount eyes of the layer and creates a
+    // framebuffer for each of them. Any previously created framebuffers are released first.
+    bool Create(int layerId, uint32_t eyeCount = PXR_EYE_MAX);
+
+    void Release();
+
+    // Binds the framebuffer of the given swapchain image as GL_DRAW_FRAMEBUFFER.
+    bool Bind(uint32_t eye, uint32_t imageIndex) const;
+
+    uint32_t GetImageCount(uint32_t eye) const {
+        return eye < PXR_EYE_MAX ? mImageCounts[eye] : 0;
+    }
+
+    bool IsValid() const {
+        return mImageCounts[PXR_EYE_LEFT] > 0;
+    }
+
+private:
+    bool CreateFramebuffer(GLuint colorTexture, GLuint &framebuffer);
+
+    GLuint mFramebuffers[PXR_EYE_MAX][kMaxImages] = {};
+    uint32_t mImageCounts[PXR_EYE_MAX] = {};
+};
+
+#endif //CLIENT_APP_RENDER_TARGET_POOL_H
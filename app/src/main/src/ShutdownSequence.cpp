@@ -0,0 +1,56 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "ShutdownSequence.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include "ThreadManager.h"
+#include "util.h"
+
+void ShutdownSequence::Add(const char *name, Step step) {
+    mSteps.push_back({name, std::move(step)});
+}
+
+double ShutdownSequence::Run(uint32_t deadlineMs) {
+    std::atomic<const char *> current{"start"};
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+
+    std::thread watchdog([&]() {
+        ThreadManager::RegisterCurrentThread(ThreadRole_Worker, "ShutdownWatch");
+        std::unique_lock<std::mutex> lock(mutex);
+        if (finished.wait_for(lock, std::chrono::milliseconds(deadlineMs), [&done]() { return done; })) {
+            return;
+        }
+        const char *step = current.load();
+        if (mDeadlineHandler) {
+            mDeadlineHandler(step);
+            return;
+        }
+        LOGE("Shutdown missed its %u ms deadline in step %s, exiting", deadlineMs, step);
+        AsyncLog::Flush();
+        _exit(0);
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    for (const Entry &entry : mSteps) {
+        current.store(entry.name);
+        const auto stepStart = std::chrono::steady_clock::now();
+        entry.step();
+        const std::chrono::duration<double, std::milli> stepMs = std::chrono::steady_clock::now() - stepStart;
+        LOGI("shutdown %s: %.1fms", entry.name, stepMs.count());
+    }
+    const std::chrono::duration<double, std::milli> totalMs = std::chrono::steady_clock::now() - start;
+    LOGI("shutdown total: %.1fms", totalMs.count());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+    }
+    finished.notify_one();
+    watchdog.join();
+    return totalMs.count();
+}
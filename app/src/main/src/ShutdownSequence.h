@@ -0,0 +1,40 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_SHUTDOWN_SEQUENCE_H
+#define CLIENT_APP_SHUTDOWN_SEQUENCE_H
+
+#include <functional>
+#include <vector>
+#include <stdint.h>
+
+// Runs the teardown steps in the order they were added, on the calling thread, and logs how
+// long each one took.
+//
+// A watchdog thread enforces a deadline on the whole sequence: when a step is still running at
+// the deadline it logs the step and ends the process with _exit(), so a hung driver or network
+// call cannot keep a dead session alive on the device.
+class ShutdownSequence {
+
+public:
+    typedef std::function<void()> Step;
+
+    void Add(const char *name, Step step);
+
+    // Runs every step; returns the total time in ms. Does not return when the deadline passes.
+    double Run(uint32_t deadlineMs);
+
+    // Called instead of _exit() when the deadline passes; for tests.
+    void SetDeadlineHandler(std::function<void(const char *step)> handler) {
+        mDeadlineHandler = std::move(handler);
+    }
+
+private:
+    struct Entry {
+        const char *name;
+        Step step;
+    };
+
+    std::vector<Entry> mSteps;
+    std::function<void(const char *step)> mDeadlineHandler;
+};
+
+#endif //CLIENT_APP_SHUTDOWN_SEQUENCE_H
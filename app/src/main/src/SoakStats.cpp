@@ -0,0 +1,83 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "SoakStats.h"
+#include <stdio.h>
+#include <unistd.h>
+#include "util.h"
+
+void SoakStats::Start(uint64_t nowMs) {
+    mStartMs = nowMs;
+    mStartRssKb = ReadRssKb();
+}
+
+void SoakStats::OnLatch(bool frameValid, bool injected, uint64_t nowMs) {
+    mLatches++;
+    if (!frameValid) {
+        mHeld++;
+        if (injected) {
+            mInjectedHeld++;
+        }
+        if (++mHoldStreak > mMaxHoldStreak) {
+            mMaxHoldStreak = mHoldStreak;
+        }
+        return;
+    }
+    mHoldStreak = 0;
+    if (mReconnectStartMs != 0) {
+        mLastRecoveryMs = nowMs - mReconnectStartMs;
+        if (mLastRecoveryMs > mMaxRecoveryMs) {
+            mMaxRecoveryMs = mLastRecoveryMs;
+        }
+        mReconnectStartMs = 0;
+        LOGI("soak reconnect recovered in %llums", (unsigned long long) mLastRecoveryMs);
+    }
+}
+
+void SoakStats::OnReconnect(uint64_t nowMs) {
+    mReconnects++;
+    mReconnectStartMs = nowMs;
+}
+
+SoakStats::Counters SoakStats::GetCounters() const {
+    Counters counters;
+    counters.startMs = mStartMs;
+    counters.startRssKb = mStartRssKb;
+    counters.latches = mLatches;
+    counters.held = mHeld;
+    counters.injectedHeld = mInjectedHeld;
+    counters.maxHoldStreak = mMaxHoldStreak;
+    counters.reconnects = mReconnects;
+    counters.lastRecoveryMs = mLastRecoveryMs;
+    counters.maxRecoveryMs = mMaxRecoveryMs;
+    counters.trackingDelays = mTrackingDelays.load(std::memory_order_relaxed);
+    counters.audioDrops = mAudioDrops.load(std::memory_order_relaxed);
+    return counters;
+}
+
+void SoakStats::Report(uint32_t audioUnderruns, uint64_t nowMs) const {
+    Report(GetCounters(), audioUnderruns, nowMs);
+}
+
+void SoakStats::Report(const Counters &counters, uint32_t audioUnderruns, uint64_t nowMs) {
+    const uint64_t rssKb = ReadRssKb();
+    LOGI("soak %.1fmin held:%llu/%llu (%.3f%%, %llu injected, longest %u), reconnects:%u recovery last:%llums max:%llums, "
+         "tracking delays:%llu, audio drops:%llu underruns:%u, rss:%llukB (%+lldkB)",
+         (nowMs - counters.startMs) / 60000.0, (unsigned long long) counters.held,
+         (unsigned long long) counters.latches,
+         counters.latches > 0 ? 100.0 * counters.held / counters.latches : 0.0,
+         (unsigned long long) counters.injectedHeld, counters.maxHoldStreak, counters.reconnects,
+         (unsigned long long) counters.lastRecoveryMs, (unsigned long long) counters.maxRecoveryMs,
+         (unsigned long long) counters.trackingDelays, (unsigned long long) counters.audioDrops, audioUnderruns,
+         (unsigned long long) rssKb, (long long) rssKb - (long long) counters.startRssKb);
+}
+
+uint64_t SoakStats::ReadRssKb() {
+    FILE *file = fopen("/proc/self/statm", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    unsigned long long sizePages = 0, residentPages = 0;
+    const bool read = fscanf(file, "%llu %llu", &sizePages, &residentPages) == 2;
+    fclose(file);
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    return read ? residentPages * uint64_t(pageSize > 0 ? pageSize : 4096) / 1024 : 0;
+}
@@ -0,0 +1,89 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_SOAK_STATS_H
+#define CLIENT_APP_SOAK_STATS_H
+
+#include <atomic>
+#include <stdint.h>
+
+// Long-run health of a session, for soak runs with and without injected faults: how often the
+// previous frame had to be held, how long reconnects take to show a frame again, how much
+// audio was lost and whether memory keeps growing.
+//
+// The latch and reconnect counters are updated on the render thread; the fault counters from
+// the tracking and audio threads.
+class SoakStats {
+
+public:
+    void Start(uint64_t nowMs);
+
+    // One latch attempt while streaming; injected when the fault injector dropped it.
+    void OnLatch(bool frameValid, bool injected, uint64_t nowMs);
+
+    void OnReconnect(uint64_t nowMs);
+
+    void OnTrackingDelayed() { mTrackingDelays.fetch_add(1, std::memory_order_relaxed); }
+
+    void OnAudioDropped() { mAudioDrops.fetch_add(1, std::memory_order_relaxed); }
+
+    // render thread
+    uint64_t GetLatchCount() const { return mLatches; }
+
+    uint64_t GetHeldCount() const { return mHeld; }
+
+    uint64_t GetInjectedHeldCount() const { return mInjectedHeld; }
+
+    uint32_t GetMaxHoldStreak() const { return mMaxHoldStreak; }
+
+    uint32_t GetReconnectCount() const { return mReconnects; }
+
+    uint64_t GetMaxRecoveryMs() const { return mMaxRecoveryMs; }
+
+    uint64_t GetTrackingDelayCount() const { return mTrackingDelays.load(std::memory_order_relaxed); }
+
+    uint64_t GetAudioDropCount() const { return mAudioDrops.load(std::memory_order_relaxed); }
+
+    // What Report() logs, copied out so another thread can log it.
+    struct Counters {
+        uint64_t startMs;
+        uint64_t startRssKb;
+        uint64_t latches;
+        uint64_t held;
+        uint64_t injectedHeld;
+        uint32_t maxHoldStreak;
+        uint32_t reconnects;
+        uint64_t lastRecoveryMs;
+        uint64_t maxRecoveryMs;
+        uint64_t trackingDelays;
+        uint64_t audioDrops;
+    };
+
+    // render thread
+    Counters GetCounters() const;
+
+    // Logs the counters since Start() along with the playback underruns and the resident memory.
+    // Reads /proc through stdio, so not for the render thread while streaming.
+    void Report(uint32_t audioUnderruns, uint64_t nowMs) const;
+
+    static void Report(const Counters &counters, uint32_t audioUnderruns, uint64_t nowMs);
+
+    // Resident set size from /proc/self/statm, 0 when unreadable.
+    static uint64_t ReadRssKb();
+
+private:
+    uint64_t mStartMs = 0;
+    uint64_t mStartRssKb = 0;
+    uint64_t mLatches = 0;
+    uint64_t mHeld = 0;
+    uint64_t mInjectedHeld = 0;
+    uint32_t mHoldStreak = 0;
+    uint32_t mMaxHoldStreak = 0;
+    uint32_t mReconnects = 0;
+    // 0 while no reconnect is waiting for its first frame
+    uint64_t mReconnectStartMs = 0;
+    uint64_t mLastRecoveryMs = 0;
+    uint64_t mMaxRecoveryMs = 0;
+    std::atomic<uint64_t> mTrackingDelays{0};
+    std::atomic<uint64_t> mAudioDrops{0};
+};
+
+#endif //CLIENT_APP_SOAK_STATS_H
@@ -0,0 +1,83 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "StartupTimeline.h"
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "util.h"
+
+namespace {
+    const char *const kPhaseNames[StartupPhase_Count] = {
+            "main", "options", "graphics", "pxr", "audio", "receiver", "connected", "firstLatch", "firstSubmit"};
+
+    std::atomic<uint64_t> gPhaseNs[StartupPhase_Count];
+    // how long the process had been running when android_main was entered, 0 when unknown
+    std::atomic<uint64_t> gProcessAgeNs{0};
+
+    uint64_t ClockNs(clockid_t clock) {
+        struct timespec ts;
+        clock_gettime(clock, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+    // Process start comes from /proc/self/stat, in clock ticks since boot.
+    uint64_t ReadProcessAgeNs() {
+        FILE *file = fopen("/proc/self/stat", "r");
+        if (file == nullptr) {
+            return 0;
+        }
+        char line[512];
+        const bool read = fgets(line, sizeof(line), file) != nullptr;
+        fclose(file);
+        const char *fields = read ? strrchr(line, ')') : nullptr;
+        unsigned long long startTicks = 0;
+        // starttime is field 22, the 20th after the name
+        if (fields == nullptr ||
+            sscanf(fields + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu",
+                   &startTicks) != 1) {
+            return 0;
+        }
+        const long ticks = sysconf(_SC_CLK_TCK);
+        const uint64_t startNs = startTicks * (1000000000ULL / uint64_t(ticks > 0 ? ticks : 100));
+        const uint64_t bootNs = ClockNs(CLOCK_BOOTTIME);
+        return bootNs > startNs ? bootNs - startNs : 0;
+    }
+}
+
+void StartupTimeline::Mark(StartupPhase phase) {
+    if (gPhaseNs[phase].load(std::memory_order_relaxed) != 0) {
+        return;
+    }
+    uint64_t expected = 0;
+    if (!gPhaseNs[phase].compare_exchange_strong(expected, ClockNs(CLOCK_MONOTONIC))) {
+        return;
+    }
+    if (phase == StartupPhase_MainEntered) {
+        gProcessAgeNs.store(ReadProcessAgeNs());
+    } else if (phase == StartupPhase_FirstFrameSubmitted) {
+        Report();
+    }
+}
+
+uint64_t StartupTimeline::GetPhaseNs(StartupPhase phase) {
+    return gPhaseNs[phase].load(std::memory_order_relaxed);
+}
+
+void StartupTimeline::Report() {
+    const uint64_t mainNs = GetPhaseNs(StartupPhase_MainEntered);
+    if (mainNs == 0) {
+        return;
+    }
+    LOGI("startup process start -> main: %.1fms", gProcessAgeNs.load() / 1e6);
+    for (int i = StartupPhase_MainEntered + 1; i < StartupPhase_Count; i++) {
+        const uint64_t phaseNs = GetPhaseNs(StartupPhase(i));
+        if (phaseNs != 0) {
+            LOGI("startup %s: %.1fms after main", kPhaseNames[i], (phaseNs - mainNs) / 1e6);
+        }
+    }
+}
+
+const char *StartupTimeline::GetPhaseName(StartupPhase phase) {
+    return phase < StartupPhase_Count ? kPhaseNames[phase] : "unknown";
+}
@@ -0,0 +1,40 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_STARTUP_TIMELINE_H
+#define CLIENT_APP_STARTUP_TIMELINE_H
+
+#include <stdint.h>
+
+// Bring-up phases, in the order they are usually reached. Phases that run in parallel may be
+// reached in a different order.
+enum StartupPhase {
+    StartupPhase_MainEntered = 0,
+    StartupPhase_OptionsLoaded,
+    StartupPhase_GraphicsReady,
+    StartupPhase_PxrReady,
+    StartupPhase_AudioReady,
+    StartupPhase_ReceiverCreated,
+    StartupPhase_Connected,
+    StartupPhase_FirstFrameLatched,
+    StartupPhase_FirstFrameSubmitted,
+    StartupPhase_Count,
+};
+
+// CLOCK_MONOTONIC time at which each bring-up phase was first reached, from android_main to the
+// first streamed frame. Marking is lock-free and allocation-free, so it can sit on the frame
+// path; only the first mark of a phase counts. The timeline is logged once the first frame was
+// submitted, relative to android_main and to the process start.
+class StartupTimeline {
+
+public:
+    static void Mark(StartupPhase phase);
+
+    // 0 when the phase was not reached yet.
+    static uint64_t GetPhaseNs(StartupPhase phase);
+
+    // Logs the phases reached so far.
+    static void Report();
+
+    static const char *GetPhaseName(StartupPhase phase);
+};
+
+#endif //CLIENT_APP_STARTUP_TIMELINE_H
@@ -0,0 +1,87 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "StatsReporter.h"
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "ThreadManager.h"
+
+StatsReporter::~StatsReporter() {
+    Stop();
+}
+
+void StatsReporter::Start() {
+    if (mRunning.load(std::memory_order_relaxed)) {
+        return;
+    }
+    mSlotState.store(SlotState_Free, std::memory_order_relaxed);
+    mReportCount.store(0, std::memory_order_relaxed);
+    mWakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    mRunning.store(true, std::memory_order_release);
+    mThread = std::thread([this]() {
+        ThreadManager::RegisterCurrentThread(ThreadRole_Worker, "StatsReport");
+        Run();
+    });
+}
+
+void StatsReporter::Stop() {
+    if (!mRunning.exchange(false)) {
+        return;
+    }
+    Wake();
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+    if (mWakeFd >= 0) {
+        close(mWakeFd);
+        mWakeFd = -1;
+    }
+}
+
+bool StatsReporter::Request(const SoakStats::Counters &soak, uint32_t audioUnderruns, uint64_t nowMs) {
+    if (!mRunning.load(std::memory_order_acquire)) {
+        return false;
+    }
+    // a pending request is replaced; while the worker copies the slot this one is skipped
+    uint32_t state = SlotState_Free;
+    if (!mSlotState.compare_exchange_strong(state, SlotState_Writing, std::memory_order_acquire) &&
+        (state != SlotState_Pending ||
+         !mSlotState.compare_exchange_strong(state, SlotState_Writing, std::memory_order_acquire))) {
+        return true;
+    }
+    mSoak = soak;
+    mAudioUnderruns = audioUnderruns;
+    mNowMs = nowMs;
+    mSlotState.store(SlotState_Pending, std::memory_order_release);
+    Wake();
+    return true;
+}
+
+void StatsReporter::Run() {
+    while (mRunning.load(std::memory_order_acquire)) {
+        uint32_t state = SlotState_Pending;
+        if (!mSlotState.compare_exchange_strong(state, SlotState_Reading, std::memory_order_acquire)) {
+            struct pollfd pfd = {mWakeFd, POLLIN, 0};
+            poll(&pfd, 1, -1);
+            // reset the counter; EAGAIN when the request came before the poll
+            uint64_t count;
+            ssize_t read = ::read(mWakeFd, &count, sizeof(count));
+            (void) read;
+            continue;
+        }
+        const SoakStats::Counters soak = mSoak;
+        const uint32_t audioUnderruns = mAudioUnderruns;
+        const uint64_t nowMs = mNowMs;
+        mSlotState.store(SlotState_Free, std::memory_order_release);
+
+        ThreadManager::LogStats();
+        SoakStats::Report(soak, audioUnderruns, nowMs);
+        mReportCount.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void StatsReporter::Wake() {
+    const uint64_t one = 1;
+    // only fails once the counter saturates, and the worker is awake then anyway
+    ssize_t written = write(mWakeFd, &one, sizeof(one));
+    (void) written;
+}
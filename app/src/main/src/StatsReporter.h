@@ -0,0 +1,56 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_STATS_REPORTER_H
+#define CLIENT_APP_STATS_REPORTER_H
+
+#include <atomic>
+#include <thread>
+#include <stdint.h>
+#include "SoakStats.h"
+
+// Logs the per-thread CPU time and the soak counters on a worker thread.
+//
+// Both reports read /proc through stdio, which allocates and can block on the file system, so
+// the render thread only copies the soak counters into a slot and wakes the worker through an
+// eventfd. A request the worker has not picked up yet is replaced by the next one. Request()
+// takes no lock: the slot is claimed with a compare-and-swap, and a request that finds the
+// worker copying the slot is skipped, the counters are cumulative and the next one carries them.
+class StatsReporter {
+
+public:
+    ~StatsReporter();
+
+    void Start();
+
+    // Lets a report in progress finish, then stops the worker; pending requests are dropped.
+    void Stop();
+
+    // Render thread; neither allocates nor locks. Returns false when the worker is not running.
+    bool Request(const SoakStats::Counters &soak, uint32_t audioUnderruns, uint64_t nowMs);
+
+    // Reports logged since Start().
+    uint32_t GetReportCount() const { return mReportCount.load(std::memory_order_acquire); }
+
+private:
+    enum SlotState {
+        SlotState_Free,
+        SlotState_Writing,
+        SlotState_Pending,
+        SlotState_Reading,
+    };
+
+    void Run();
+
+    void Wake();
+
+    std::atomic<bool> mRunning{false};
+    int mWakeFd = -1;
+    std::atomic<uint32_t> mSlotState{SlotState_Free};
+    SoakStats::Counters mSoak{};
+    uint32_t mAudioUnderruns = 0;
+    uint64_t mNowMs = 0;
+    std::thread mThread;
+
+    std::atomic<uint32_t> mReportCount{0};
+};
+
+#endif //CLIENT_APP_STATS_REPORTER_H
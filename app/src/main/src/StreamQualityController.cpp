@@ -0,0 +1,118 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "StreamQualityController.h"
+#include <algorithm>
+#include <CloudXRClient.h>
+
+namespace {
+    // bitrate, as a fraction of the policy maximum, below which each level starts
+    const float kLevelThresholds[StreamQualityController::kLevelCount] = {1.0f, 0.6f, 0.4f, 0.25f};
+}
+
+void StreamQualityController::SetPolicy(const StreamQualityPolicy &policy) {
+    mPolicy = policy;
+    mPolicy.minBitrateKbps = std::min(mPolicy.minBitrateKbps, mPolicy.maxBitrateKbps);
+    mPolicy.minResFactor = std::min(mPolicy.minResFactor, mPolicy.maxResFactor);
+    mPolicy.maxFoveation = std::max(mPolicy.maxFoveation, mPolicy.minFoveation);
+    mLevel = 0;
+    mTarget = SettingsForLevel(mLevel);
+    mTarget.bitrateKbps = mPolicy.maxBitrateKbps;
+    mCleanWindows = 0;
+    mPoorWindows = 0;
+}
+
+bool StreamQualityController::OnWindow(const StreamQualityStats &stats) {
+    mWindowsSinceApplied++;
+
+    const uint32_t received = stats.totalPacketsReceived - mLastPacketsReceived;
+    const uint32_t lost = stats.totalPacketsLost - mLastPacketsLost;
+    mLastPacketsReceived = stats.totalPacketsReceived;
+    mLastPacketsLost = stats.totalPacketsLost;
+    const float lossRatio = (received + lost) > 0 ? float(lost) / float(received + lost) : 0.0f;
+
+    const bool congested = lossRatio > kCongestedLossRatio ||
+                           (stats.qualityReasons & (cxrConnectionQualityReason_LowBandwidth |
+                                                    cxrConnectionQualityReason_HighPacketLoss)) != 0 ||
+                           (stats.bandwidthAvailableKbps > 0 &&
+                            stats.bandwidthAvailableKbps < stats.bandwidthUtilizationKbps);
+    // unstable, bad and poor all count; quality reasons are 0 while CloudXR is still estimating
+    const bool poor = stats.quality <= cxrConnectionQuality_Poor &&
+                      stats.qualityReasons != cxrConnectionQualityReason_EstimatingQuality;
+    mPoorWindows = poor ? mPoorWindows + 1 : 0;
+
+    const StreamQualitySettings previous = mTarget;
+    uint32_t bitrate = mTarget.bitrateKbps;
+    const uint32_t share = uint32_t(stats.bandwidthAvailableKbps * kBandwidthShare);
+    if (congested) {
+        mCleanWindows = 0;
+        // relative to what the connection runs with, so windows that keep reporting the same
+        // congestion until the next connect do not compound the cut
+        bitrate = std::min(bitrate, uint32_t(GetAppliedBitrate() * kDecreaseFactor));
+        if (share > 0) {
+            bitrate = std::min(bitrate, share);
+        }
+    } else if (++mCleanWindows >= kIncreaseWindows) {
+        mCleanWindows = 0;
+        if (stats.bandwidthAvailableKbps == 0 || bitrate + kIncreaseStepKbps <= share) {
+            bitrate += kIncreaseStepKbps;
+        }
+    }
+    mTarget.bitrateKbps = std::max(mPolicy.minBitrateKbps, std::min(bitrate, mPolicy.maxBitrateKbps));
+
+    UpdateLevel();
+    return mTarget.bitrateKbps != previous.bitrateKbps || mTarget.resFactor != previous.resFactor ||
+           mTarget.foveation != previous.foveation;
+}
+
+void StreamQualityController::SetApplied(const StreamQualitySettings &settings) {
+    mApplied = settings;
+    mWindowsSinceApplied = 0;
+    mPoorWindows = 0;
+    // a new connection starts its packet counters at 0
+    mLastPacketsReceived = 0;
+    mLastPacketsLost = 0;
+}
+
+bool StreamQualityController::ShouldReconnect() const {
+    if (mWindowsSinceApplied < kReconnectCooldownWindows || mPoorWindows < kPoorWindowsBeforeReconnect) {
+        return false;
+    }
+    if (mTarget.resFactor != mApplied.resFactor || mTarget.foveation != mApplied.foveation) {
+        return true;
+    }
+    const uint32_t applied = GetAppliedBitrate();
+    const uint32_t change = applied > mTarget.bitrateKbps ? applied - mTarget.bitrateKbps : mTarget.bitrateKbps - applied;
+    return float(change) / float(std::max<uint32_t>(applied, 1)) > kReconnectBitrateChange;
+}
+
+uint32_t StreamQualityController::GetAppliedBitrate() const {
+    // 0 leaves the bitrate to the server, which is bounded by the policy maximum here
+    return mApplied.bitrateKbps > 0 ? mApplied.bitrateKbps : mPolicy.maxBitrateKbps;
+}
+
+void StreamQualityController::UpdateLevel() {
+    const float ratio = float(mTarget.bitrateKbps) / float(std::max<uint32_t>(mPolicy.maxBitrateKbps, 1));
+    uint32_t level = mLevel;
+    // move down the ladder once the bitrate is clearly below the level's threshold, back up
+    // once it is clearly above it
+    while (level + 1 < kLevelCount && ratio < kLevelThresholds[level + 1] - kLevelMargin) {
+        level++;
+    }
+    while (level > 0 && ratio > kLevelThresholds[level] + kLevelMargin) {
+        level--;
+    }
+    if (level != mLevel) {
+        mLevel = level;
+        const uint32_t bitrate = mTarget.bitrateKbps;
+        mTarget = SettingsForLevel(level);
+        mTarget.bitrateKbps = bitrate;
+    }
+}
+
+StreamQualitySettings StreamQualityController::SettingsForLevel(uint32_t level) const {
+    const float t = float(level) / float(kLevelCount - 1);
+    StreamQualitySettings settings;
+    settings.bitrateKbps = mTarget.bitrateKbps;
+    settings.resFactor = mPolicy.maxResFactor - (mPolicy.maxResFactor - mPolicy.minResFactor) * t;
+    settings.foveation = mPolicy.minFoveation + uint32_t((mPolicy.maxFoveation - mPolicy.minFoveation) * t + 0.5f);
+    return settings;
+}
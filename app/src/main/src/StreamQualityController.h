@@ -0,0 +1,102 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_STREAM_QUALITY_CONTROLLER_H
+#define CLIENT_APP_STREAM_QUALITY_CONTROLLER_H
+
+#include <stdint.h>
+
+// One window of connection statistics, copied from cxrConnectionStats.
+struct StreamQualityStats {
+    uint32_t bandwidthAvailableKbps = 0;
+    uint32_t bandwidthUtilizationKbps = 0;
+    // cumulative packet counters since the connection started
+    uint32_t totalPacketsReceived = 0;
+    uint32_t totalPacketsLost = 0;
+    // cxrConnectionQuality, and a mask of cxrConnectionQualityReason
+    uint32_t quality = 0;
+    uint32_t qualityReasons = 0;
+};
+
+// Limits the controller stays within.
+struct StreamQualityPolicy {
+    uint32_t minBitrateKbps = 10000;
+    uint32_t maxBitrateKbps = 100000;
+    float minResFactor = 0.7f;
+    float maxResFactor = 1.0f;
+    // foveation never goes below this (the launch option) nor above maxFoveation
+    uint32_t minFoveation = 0;
+    uint32_t maxFoveation = 50;
+};
+
+struct StreamQualitySettings {
+    uint32_t bitrateKbps = 0;
+    float resFactor = 1.0f;
+    uint32_t foveation = 0;
+};
+
+// Chooses the video bitrate, resolution factor and foveation of the stream from the connection
+// statistics.
+//
+// The bitrate target follows AIMD: a congested window (packet loss above kCongestedLossRatio,
+// a low bandwidth or packet loss quality reason, or less available bandwidth than in use) cuts
+// it to kDecreaseFactor of the applied bitrate or kBandwidthShare of the available bandwidth,
+// whichever is lower; kIncreaseWindows clean windows in a row raise it by kIncreaseStepKbps
+// while it stays under kBandwidthShare of the available bandwidth. Resolution and foveation
+// follow the bitrate through a fixed ladder of levels; a level only changes once the bitrate
+// moved kLevelMargin past its threshold.
+//
+// CloudXR takes these settings only when connecting, so the client reads GetTarget() when it
+// (re)connects and reports that with SetApplied(). ShouldReconnect() tells when the target
+// drifted far enough from the applied settings, on a poor connection, to be worth a reconnect;
+// it allows that at most once per kReconnectCooldownWindows.
+class StreamQualityController {
+
+public:
+    static constexpr float kCongestedLossRatio = 0.02f;
+    static constexpr float kDecreaseFactor = 0.7f;
+    static constexpr float kBandwidthShare = 0.8f;
+    static const uint32_t kIncreaseStepKbps = 2000;
+    static const uint32_t kIncreaseWindows = 5;
+    static constexpr float kLevelMargin = 0.05f;
+    static const uint32_t kLevelCount = 4;
+    static const uint32_t kPoorWindowsBeforeReconnect = 10;
+    static const uint32_t kReconnectCooldownWindows = 60;
+    // relative bitrate difference between target and applied that is worth a reconnect
+    static constexpr float kReconnectBitrateChange = 0.3f;
+
+    void SetPolicy(const StreamQualityPolicy &policy);
+
+    const StreamQualityPolicy &GetPolicy() const { return mPolicy; }
+
+    // Feeds one stats window; returns true when the target changed.
+    bool OnWindow(const StreamQualityStats &stats);
+
+    const StreamQualitySettings &GetTarget() const { return mTarget; }
+
+    // The settings the current connection was made with; also restarts the packet counters.
+    void SetApplied(const StreamQualitySettings &settings);
+
+    const StreamQualitySettings &GetApplied() const { return mApplied; }
+
+    bool ShouldReconnect() const;
+
+private:
+    void UpdateLevel();
+
+    uint32_t GetAppliedBitrate() const;
+
+    StreamQualitySettings SettingsForLevel(uint32_t level) const;
+
+    StreamQualityPolicy mPolicy;
+    StreamQualitySettings mTarget;
+    StreamQualitySettings mApplied;
+    uint32_t mLevel = 0;
+
+    uint32_t mLastPacketsReceived = 0;
+    uint32_t mLastPacketsLost = 0;
+    uint32_t mCleanWindows = 0;
+    uint32_t mPoorWindows = 0;
+    // windows since the applied settings were set
+    uint32_t mWindowsSinceApplied = 0;
+};
+
+#endif //CLIENT_APP_STREAM_QUALITY_CONTROLLER_H
@@ -0,0 +1,384 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#include "ThreadManager.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include "util.h"
+
+namespace {
+    const char *const kRoleNames[ThreadRole_Count] = {"render", "tracking", "audio", "worker"};
+    const uint32_t kMaxCpus = 64;
+
+    struct ThreadSlot {
+        int tid = 0;
+        ThreadRole role = ThreadRole_Worker;
+        char name[16] = {};
+        // what the thread had before a policy changed it, restored when the policy is dropped
+        bool pinned = false;
+        int originalNice = 0;
+        // values at the previous LogStats()
+        uint64_t lastCpuTimeMs = 0;
+        uint64_t lastVoluntarySwitches = 0;
+        uint64_t lastInvoluntarySwitches = 0;
+    };
+
+    // frees the calling thread's slot when it exits, so a recycled tid is not reconfigured
+    struct SlotOwner {
+        ThreadSlot *slot = nullptr;
+        // no slot was free; the thread runs with the default policy and does not try again
+        bool unregistered = false;
+
+        ~SlotOwner();
+    };
+
+    std::mutex gMutex;
+    // sized once, before the first thread registers; the slots never move
+    std::vector<ThreadSlot> gSlots(ThreadManager::kMaxThreads);
+    bool gSlotsInUse = false;
+    ThreadPolicy gPolicies[ThreadRole_Count];
+    bool gPoliciesInitialized = false;
+    std::atomic<uint32_t> gUnregisteredCount{0};
+    thread_local SlotOwner tSlot;
+
+    SlotOwner::~SlotOwner() {
+        if (slot != nullptr) {
+            std::lock_guard<std::mutex> lock(gMutex);
+            slot->tid = 0;
+        }
+    }
+
+    int CurrentTid() {
+        return int(syscall(SYS_gettid));
+    }
+
+    ThreadPolicy DefaultPolicy(ThreadRole role) {
+        ThreadPolicy policy;
+        if (role == ThreadRole_Render || role == ThreadRole_Tracking) {
+            policy.setPriority = true;
+            policy.nice = ThreadManager::kDisplayNice;
+        }
+        return policy;
+    }
+
+    void InitPolicies() {
+        if (gPoliciesInitialized) {
+            return;
+        }
+        gPoliciesInitialized = true;
+        for (int i = 0; i < ThreadRole_Count; i++) {
+            gPolicies[i] = DefaultPolicy(ThreadRole(i));
+        }
+    }
+
+    void Apply(ThreadSlot &slot) {
+        const ThreadPolicy &policy = gPolicies[slot.role];
+        // a dropped affinity goes back to every core
+        const uint64_t mask = policy.cpuMask != 0 ? policy.cpuMask : (slot.pinned ? ThreadManager::GetCoreMask("all") : 0);
+        if (mask != 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (uint32_t cpu = 0; cpu < kMaxCpus; cpu++) {
+                if (mask & (1ULL << cpu)) {
+                    CPU_SET(cpu, &set);
+                }
+            }
+            if (sched_setaffinity(slot.tid, sizeof(set), &set) != 0) {
+                LOGE("Thread %s: sched_setaffinity 0x%llx failed: %s", slot.name,
+                     (unsigned long long) mask, strerror(errno));
+            }
+            slot.pinned = policy.cpuMask != 0;
+        }
+        const int nice = policy.setPriority ? policy.nice : slot.originalNice;
+        if (setpriority(PRIO_PROCESS, slot.tid, nice) != 0) {
+            LOGE("Thread %s: setpriority %d failed: %s", slot.name, nice, strerror(errno));
+        }
+    }
+
+    uint64_t ReadMaxFrequency(uint32_t cpu) {
+        char path[96];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cpufreq/cpuinfo_max_freq", cpu);
+        FILE *file = fopen(path, "r");
+        if (file == nullptr) {
+            return 0;
+        }
+        unsigned long long frequency = 0;
+        if (fscanf(file, "%llu", &frequency) != 1) {
+            frequency = 0;
+        }
+        fclose(file);
+        return frequency;
+    }
+
+    bool ReadThreadStats(int tid, ThreadStats *stats) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+        FILE *file = fopen(path, "r");
+        if (file == nullptr) {
+            return false;
+        }
+        char line[512];
+        const bool read = fgets(line, sizeof(line), file) != nullptr;
+        fclose(file);
+        // the name field may contain spaces; fields are counted from the closing parenthesis
+        const char *fields = read ? strrchr(line, ')') : nullptr;
+        unsigned long long utime = 0;
+        unsigned long long stime = 0;
+        if (fields == nullptr ||
+            sscanf(fields + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2) {
+            return false;
+        }
+        const long ticks = sysconf(_SC_CLK_TCK);
+        stats->cpuTimeMs = (utime + stime) * 1000ULL / uint64_t(ticks > 0 ? ticks : 100);
+
+        snprintf(path, sizeof(path), "/proc/self/task/%d/status", tid);
+        file = fopen(path, "r");
+        if (file == nullptr) {
+            return false;
+        }
+        stats->voluntarySwitches = 0;
+        stats->involuntarySwitches = 0;
+        unsigned long long value;
+        while (fgets(line, sizeof(line), file) != nullptr) {
+            if (sscanf(line, "voluntary_ctxt_switches: %llu", &value) == 1) {
+                stats->voluntarySwitches = value;
+            } else if (sscanf(line, "nonvoluntary_ctxt_switches: %llu", &value) == 1) {
+                stats->involuntarySwitches = value;
+            }
+        }
+        fclose(file);
+        return true;
+    }
+
+    // Gives the calling thread a slot and applies its policy; gMutex is held.
+    void Register(ThreadRole role, const char *name) {
+        InitPolicies();
+        gSlotsInUse = true;
+        ThreadSlot *slot = nullptr;
+        for (uint32_t i = 0; i < gSlots.size() && slot == nullptr; i++) {
+            if (gSlots[i].tid == 0) {
+                slot = &gSlots[i];
+            }
+        }
+        if (slot == nullptr) {
+            tSlot.unregistered = true;
+            if (gUnregisteredCount.fetch_add(1, std::memory_order_relaxed) == 0) {
+                LOGE("Thread %s not registered, all %u slots in use; later threads are not logged",
+                     name, uint32_t(gSlots.size()));
+            }
+            return;
+        }
+        *slot = ThreadSlot();
+        slot->tid = CurrentTid();
+        slot->role = role;
+        errno = 0;
+        const int nice = getpriority(PRIO_PROCESS, slot->tid);
+        slot->originalNice = errno == 0 ? nice : 0;
+        strncpy(slot->name, name, sizeof(slot->name) - 1);
+        pthread_setname_np(pthread_self(), slot->name);
+        Apply(*slot);
+        tSlot.slot = slot;
+    }
+
+    bool ParseRole(const std::string &name, ThreadRole *role) {
+        for (int i = 0; i < ThreadRole_Count; i++) {
+            if (name == kRoleNames[i]) {
+                *role = ThreadRole(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Calls handler(role, value) for each "role:value" entry of a comma separated list.
+    template<typename Handler>
+    bool ParseEntries(const std::string &list, Handler handler) {
+        bool valid = true;
+        size_t start = 0;
+        while (start < list.size()) {
+            size_t end = list.find(',', start);
+            if (end == std::string::npos) {
+                end = list.size();
+            }
+            const std::string entry = list.substr(start, end - start);
+            start = end + 1;
+            if (entry.empty()) {
+                continue;
+            }
+            const size_t colon = entry.find(':');
+            ThreadRole role;
+            if (colon == std::string::npos || !ParseRole(entry.substr(0, colon), &role) ||
+                !handler(role, entry.substr(colon + 1))) {
+                LOGE("Ignoring thread option entry '%s'", entry.c_str());
+                valid = false;
+            }
+        }
+        return valid;
+    }
+}
+
+void ThreadManager::RegisterCurrentThread(ThreadRole role, const char *name) {
+    if (tSlot.slot != nullptr || tSlot.unregistered) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(gMutex);
+    Register(role, name);
+}
+
+void ThreadManager::TryRegisterCurrentThread(ThreadRole role, const char *name) {
+    if (tSlot.slot != nullptr || tSlot.unregistered) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(gMutex, std::try_to_lock);
+    if (lock.owns_lock()) {
+        Register(role, name);
+    }
+}
+
+bool ThreadManager::SetMaxThreads(uint32_t count) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (gSlotsInUse) {
+        return false;
+    }
+    gSlots.resize(std::max(count, 1u));
+    return true;
+}
+
+uint32_t ThreadManager::GetUnregisteredCount() {
+    return gUnregisteredCount.load(std::memory_order_relaxed);
+}
+
+bool ThreadManager::Configure(const std::string &affinity, const std::string &priority) {
+    ThreadPolicy policies[ThreadRole_Count];
+    const bool valid = ParsePolicies(affinity, priority, policies);
+    for (int i = 0; i < ThreadRole_Count; i++) {
+        SetPolicy(ThreadRole(i), policies[i]);
+        LOGI("Thread role %s: cpu mask 0x%llx, nice %s%d", kRoleNames[i], (unsigned long long) policies[i].cpuMask,
+             policies[i].setPriority ? "" : "unchanged ", policies[i].nice);
+    }
+    return valid;
+}
+
+bool ThreadManager::ParsePolicies(const std::string &affinity, const std::string &priority,
+                                  ThreadPolicy policies[ThreadRole_Count]) {
+    for (int i = 0; i < ThreadRole_Count; i++) {
+        policies[i] = DefaultPolicy(ThreadRole(i));
+    }
+
+    bool valid = ParseEntries(affinity, [&policies](ThreadRole role, const std::string &value) {
+        uint64_t mask = 0;
+        if (value.compare(0, 2, "0x") == 0) {
+            mask = strtoull(value.c_str() + 2, nullptr, 16);
+        } else {
+            mask = GetCoreMask(value);
+        }
+        if (mask == 0) {
+            return false;
+        }
+        policies[role].cpuMask = mask;
+        return true;
+    });
+    valid = ParseEntries(priority, [&policies](ThreadRole role, const std::string &value) {
+        char *end = nullptr;
+        const long nice = strtol(value.c_str(), &end, 10);
+        if (end == value.c_str() || *end != '\0' || nice < -20 || nice > 19) {
+            return false;
+        }
+        policies[role].setPriority = true;
+        policies[role].nice = int(nice);
+        return true;
+    }) && valid;
+    return valid;
+}
+
+void ThreadManager::SetPolicy(ThreadRole role, const ThreadPolicy &policy) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    InitPolicies();
+    gPolicies[role] = policy;
+    for (uint32_t i = 0; i < gSlots.size(); i++) {
+        if (gSlots[i].tid != 0 && gSlots[i].role == role) {
+            Apply(gSlots[i]);
+        }
+    }
+}
+
+uint64_t ThreadManager::GetCoreMask(const std::string &cores) {
+    const long configured = sysconf(_SC_NPROCESSORS_CONF);
+    const uint32_t count = configured > 0 ? std::min<uint32_t>(uint32_t(configured), kMaxCpus) : 1;
+    const uint64_t all = count >= 64 ? ~0ULL : (1ULL << count) - 1;
+    if (cores == "all") {
+        return all;
+    }
+    if (cores != "big" && cores != "little") {
+        return 0;
+    }
+
+    uint64_t frequencies[kMaxCpus] = {};
+    uint64_t highest = 0;
+    for (uint32_t cpu = 0; cpu < count; cpu++) {
+        frequencies[cpu] = ReadMaxFrequency(cpu);
+        highest = std::max(highest, frequencies[cpu]);
+    }
+    uint64_t big = 0;
+    for (uint32_t cpu = 0; cpu < count; cpu++) {
+        if (frequencies[cpu] == highest) {
+            big |= 1ULL << cpu;
+        }
+    }
+    // no frequency information or a single cluster: every core counts as both
+    if (highest == 0 || big == all) {
+        return all;
+    }
+    return cores == "big" ? big : all & ~big;
+}
+
+uint32_t ThreadManager::GetStats(ThreadStats *stats, uint32_t maxCount) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < gSlots.size() && count < maxCount; i++) {
+        const ThreadSlot &slot = gSlots[i];
+        if (slot.tid == 0) {
+            continue;
+        }
+        ThreadStats &entry = stats[count];
+        memcpy(entry.name, slot.name, sizeof(entry.name));
+        entry.role = slot.role;
+        entry.tid = slot.tid;
+        if (ReadThreadStats(slot.tid, &entry)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void ThreadManager::LogStats() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    for (uint32_t i = 0; i < gSlots.size(); i++) {
+        ThreadSlot &slot = gSlots[i];
+        ThreadStats stats;
+        if (slot.tid == 0 || !ReadThreadStats(slot.tid, &stats)) {
+            continue;
+        }
+        LOGI("threadstats %s(%s) tid:%d, cpuMs:%llu, voluntarySwitches:%llu, involuntarySwitches:%llu",
+             slot.name, kRoleNames[slot.role], slot.tid,
+             (unsigned long long) (stats.cpuTimeMs - slot.lastCpuTimeMs),
+             (unsigned long long) (stats.voluntarySwitches - slot.lastVoluntarySwitches),
+             (unsigned long long) (stats.involuntarySwitches - slot.lastInvoluntarySwitches));
+        slot.lastCpuTimeMs = stats.cpuTimeMs;
+        slot.lastVoluntarySwitches = stats.voluntarySwitches;
+        slot.lastInvoluntarySwitches = stats.involuntarySwitches;
+    }
+}
+
+const char *ThreadManager::GetRoleName(ThreadRole role) {
+    return role < ThreadRole_Count ? kRoleNames[role] : "unknown";
+}
@@ -0,0 +1,96 @@
+// Copyright (2021-2023) Bytedance Ltd. and/or its affiliates
+#ifndef CLIENT_APP_THREAD_MANAGER_H
+#define CLIENT_APP_THREAD_MANAGER_H
+
+#include <string>
+#include <stdint.h>
+
+// What a thread does; affinity and priority are configured per role.
+enum ThreadRole {
+    // android_main: event loop, frame latch, blit and submit
+    ThreadRole_Render = 0,
+    // CloudXR callback thread that samples poses
+    ThreadRole_Tracking,
+    // CloudXR audio playback and Oboe recording callbacks
+    ThreadRole_Audio,
+    // haptics, logging and event polling
+    ThreadRole_Worker,
+    ThreadRole_Count,
+};
+
+struct ThreadPolicy {
+    // cores the thread may run on, 0 leaves the affinity alone
+    uint64_t cpuMask = 0;
+    // nice value, only applied when setPriority is set
+    bool setPriority = false;
+    int nice = 0;
+};
+
+struct ThreadStats {
+    char name[16];
+    ThreadRole role;
+    int tid;
+    uint64_t cpuTimeMs;
+    uint64_t voluntarySwitches;
+    uint64_t involuntarySwitches;
+};
+
+// Names the client's threads and applies the affinity and priority of their role.
+//
+// Threads register themselves once; later calls from the same thread return right away, so the
+// callbacks the client does not create (CloudXR, Oboe) register on their first call. A thread
+// that finds every slot taken keeps its default scheduling and is not tried again; the first
+// such miss is logged. Configure()
+// reapplies the policies to every thread registered so far, so threads started before the launch
+// options are read still get them.
+//
+// Affinity is given per role as big, little, all or a hex CPU mask; big cores are the ones with
+// the highest cpuinfo_max_freq. Priorities are nice values. Both go through sched_setaffinity
+// and setpriority on the thread id, which behave the same on Linux.
+class ThreadManager {
+
+public:
+    // slots by default, enough for the threads of one client
+    static const uint32_t kMaxThreads = 32;
+    // Android's THREAD_PRIORITY_DISPLAY, the default for the render and tracking roles
+    static const int kDisplayNice = -4;
+
+    // Names the calling thread (at most 15 chars are kept) and applies its role's policy.
+    static void RegisterCurrentThread(ThreadRole role, const char *name);
+
+    // The same for callbacks on threads the client does not start (CloudXR, Oboe): never waits.
+    // While another thread registers or reconfigures, it returns and the next call tries again.
+    static void TryRegisterCurrentThread(ThreadRole role, const char *name);
+
+    // Sizes the slot table, for processes running several clients. Only possible before the
+    // first thread registers; returns false after that.
+    static bool SetMaxThreads(uint32_t count);
+
+    // Threads that found every slot taken.
+    static uint32_t GetUnregisteredCount();
+
+    // Parses the launch option values, for example "render:big,audio:little" and
+    // "render:-4,worker:10", and applies them. Roles not listed get their defaults back.
+    // Returns false when an entry could not be parsed; the valid entries are still applied.
+    static bool Configure(const std::string &affinity, const std::string &priority);
+
+    // Parses the launch option values into one policy per role without applying them.
+    static bool ParsePolicies(const std::string &affinity, const std::string &priority,
+                              ThreadPolicy policies[ThreadRole_Count]);
+
+    static void SetPolicy(ThreadRole role, const ThreadPolicy &policy);
+
+    // Mask of the big, little or all cores; 0 when the name is unknown.
+    static uint64_t GetCoreMask(const std::string &cores);
+
+    // Fills up to maxCount entries with the CPU time and context switches of the registered
+    // threads; returns the number filled.
+    static uint32_t GetStats(ThreadStats *stats, uint32_t maxCount);
+
+    // Logs each thread's CPU time and context switches since the previous call.
+    static void LogStats();
+
+    static const char *GetRoleName(ThreadRole role);
+};
+
+#endif //CLIENT_APP_THREAD_MANAGER_H
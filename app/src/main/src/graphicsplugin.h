@@ -1,11 +1,56 @@
 #pragma once
 #include "PxrApi.h"
+#include <CloudXRClient.h>
 #include "util.h"
 
+// CPU and GPU time spent on the render targets of one frame.
+struct FrameTiming {
+    uint64_t cpuTimeNs = 0;
+    // 0 if GPU timing is not supported by the driver, or the result was not usable
+    uint64_t gpuTimeNs = 0;
+};
+
+struct GraphicsOptions {
+    // A context without any surface on the platform's surfaceless display (Mesa), for running
+    // without a window system; otherwise the context gets a small pbuffer, as on the device.
+    bool surfaceless = false;
+};
+
+// The CloudXR Android client decodes and blits into GLES only, and the Pxr eye layers are
+// GL swapchains, so OpenGL ES is the only backend that can present a CloudXR frame.
+enum GraphicsApi {
+    GraphicsApi_OpenGLES,
+};
+
 struct IGraphicsPlugin {
     virtual ~IGraphicsPlugin() = default;
+    virtual GraphicsApi GetApi() const = 0;
     virtual void InitializeDevice() = 0;
+
+    // Describes the device to CloudXR, which decodes and blits with it; false before
+    // InitializeDevice or when the device cannot be handed to CloudXR.
+    virtual bool GetCloudXRContext(cxrGraphicsContext *context) const = 0;
+
+    // Creates one render target per swapchain image of the first eyeCount eyes of the layer,
+    // replacing any existing ones.
+    virtual bool CreateRenderTargets(int layerId, uint32_t eyeCount) = 0;
+    virtual void ReleaseRenderTargets() = 0;
+    virtual bool BindRenderTarget(uint32_t eye, uint32_t imageIndex) = 0;
+
+    // Brackets the per-frame render target work. GPU results arrive a few frames late, so
+    // GetFrameTiming returns the most recent frame whose results are available.
+    virtual void BeginFrameTiming() = 0;
+    virtual void EndFrameTiming() = 0;
+    virtual FrameTiming GetFrameTiming() const = 0;
+
+    // Releases every graphics object and the device. The plugin is unusable afterwards.
+    virtual void Shutdown() = 0;
 };
 
 // Create a opengles graphics plugin.
-std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_OpenGLES();
+std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_OpenGLES(const GraphicsOptions &options);
+
+// Create the graphics plugin for the api, or the OpenGL ES one when the api is unknown.
+std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin(GraphicsApi api, const GraphicsOptions &options = GraphicsOptions());
+
+const char *GetGraphicsApiName(GraphicsApi api);
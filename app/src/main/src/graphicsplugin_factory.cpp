@@ -0,0 +1,20 @@
+#include "graphicsplugin.h"
+#include "util.h"
+
+// No default branches: -Wswitch points at both switches when a backend is added. The returns
+// after them only satisfy the compiler, every GraphicsApi value has its case.
+std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin(GraphicsApi api, const GraphicsOptions &options) {
+    switch (api) {
+        case GraphicsApi_OpenGLES:
+            return CreateGraphicsPlugin_OpenGLES(options);
+    }
+    return nullptr;
+}
+
+const char *GetGraphicsApiName(GraphicsApi api) {
+    switch (api) {
+        case GraphicsApi_OpenGLES:
+            return "OpenGLES";
+    }
+    return "unknown";
+}
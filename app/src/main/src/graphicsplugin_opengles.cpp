@@ -1,5 +1,6 @@
 #include "graphicsplugin.h"
 #include "GLUtils.h"
+#include "RenderTargetPool.h"
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 #include <GLES2/gl2.h>
@@ -7,52 +8,183 @@
 #include <GLES3/gl3.h>
 #include <GLES3/gl32.h>
 #include "util.h"
+#include <chrono>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
 
 namespace {
 
+    const int kTimerQueryCount = 4;
+
+    bool HasExtension(const char *extensions, const char *name) {
+        if (extensions == nullptr) {
+            return false;
+        }
+        const size_t length = strlen(name);
+        for (const char *p = strstr(extensions, name); p != nullptr; p = strstr(p + length, name)) {
+            if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0')) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     struct OpenGLESGraphicsPlugin : public IGraphicsPlugin {
-        OpenGLESGraphicsPlugin() = default;
+        explicit OpenGLESGraphicsPlugin(const GraphicsOptions &options) : mOptions(options) {}
         OpenGLESGraphicsPlugin(const OpenGLESGraphicsPlugin &) = delete;
         OpenGLESGraphicsPlugin &operator=(const OpenGLESGraphicsPlugin &) = delete;
         OpenGLESGraphicsPlugin(OpenGLESGraphicsPlugin &&) = delete;
         OpenGLESGraphicsPlugin &operator=(OpenGLESGraphicsPlugin &&) = delete;
         ~OpenGLESGraphicsPlugin() override {}
 
+        GraphicsApi GetApi() const override {
+            return GraphicsApi_OpenGLES;
+        }
+
         void InitializeDevice() override {
-            InitContext();
+            if (InitContext()) {
+                InitTimerQueries();
+            }
+        }
+
+        bool GetCloudXRContext(cxrGraphicsContext *context) const override {
+            if (mDisplay == EGL_NO_DISPLAY || mContext == EGL_NO_CONTEXT) {
+                return false;
+            }
+            context->type = cxrGraphicsContext_GLES;
+            context->egl.display = mDisplay;
+            context->egl.context = mContext;
+            return true;
+        }
+
+        bool CreateRenderTargets(int layerId, uint32_t eyeCount) override {
+            return mRenderTargets.Create(layerId, eyeCount);
+        }
+
+        void ReleaseRenderTargets() override {
+            mRenderTargets.Release();
+        }
+
+        bool BindRenderTarget(uint32_t eye, uint32_t imageIndex) override {
+            return mRenderTargets.Bind(eye, imageIndex);
+        }
+
+        void BeginFrameTiming() override {
+            mFrameBeginTime = std::chrono::steady_clock::now();
+            if (!mTimerQueriesSupported) {
+                return;
+            }
+            // collect the oldest query before reusing it; it was issued kTimerQueryCount frames ago
+            GLuint query = mTimerQueries[mTimerQueryIndex];
+            if (mTimerQueryPending[mTimerQueryIndex]) {
+                GLuint available = 0;
+                glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+                if (available) {
+                    // results are undefined across a GPU disjoint event (e.g. a clock change);
+                    // reading the flag clears it
+                    GLint disjoint = 0;
+                    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+                    // 64 bits, as the extension defines the result; 32 wrap after 4.3 s
+                    GLuint64 elapsedNs = 0;
+                    if (!disjoint) {
+                        mGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedNs);
+                    }
+                    mFrameTiming.gpuTimeNs = elapsedNs;
+                }
+                mTimerQueryPending[mTimerQueryIndex] = false;
+            }
+            glBeginQuery(GL_TIME_ELAPSED_EXT, query);
+        }
+
+        void EndFrameTiming() override {
+            if (mTimerQueriesSupported) {
+                glEndQuery(GL_TIME_ELAPSED_EXT);
+                mTimerQueryPending[mTimerQueryIndex] = true;
+                mTimerQueryIndex = (mTimerQueryIndex + 1) % kTimerQueryCount;
+            }
+            mFrameTiming.cpuTimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - mFrameBeginTime).count();
+        }
+
+        FrameTiming GetFrameTiming() const override {
+            return mFrameTiming;
+        }
+
+        void Shutdown() override {
+            if (mDisplay == EGL_NO_DISPLAY) {
+                return;
+            }
+            mRenderTargets.Release();
+            if (mTimerQueriesSupported) {
+                glDeleteQueries(kTimerQueryCount, mTimerQueries);
+                mTimerQueriesSupported = false;
+            }
+            eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (mSurface != EGL_NO_SURFACE) {
+                eglDestroySurface(mDisplay, mSurface);
+                mSurface = EGL_NO_SURFACE;
+            }
+            if (mContext != EGL_NO_CONTEXT) {
+                eglDestroyContext(mDisplay, mContext);
+                mContext = EGL_NO_CONTEXT;
+            }
+            eglTerminate(mDisplay);
+            mDisplay = EGL_NO_DISPLAY;
+        }
+
+        EGLDisplay GetDisplay() const {
+            if (!mOptions.surfaceless) {
+                return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+            }
+            // without a window system the default display may not exist; Mesa has a platform
+            // for exactly this
+            const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+            auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+            if (getPlatformDisplay != nullptr && HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+                return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            }
+            return eglGetDisplay(EGL_DEFAULT_DISPLAY);
         }
 
         bool InitContext() {
-            EGLint numConfigs;
-            EGLConfig config = nullptr;
-            EGLContext context;
-            EGLSurface tinySurface;
-            EGLSurface mainSurface;
-            EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-            eglInitialize(display, nullptr, nullptr);
-            const int MAX_CONFIGS = 1024;
-            EGLConfig configs[MAX_CONFIGS];
-            eglGetConfigs(display, configs, MAX_CONFIGS, &numConfigs);
+            EGLDisplay display = GetDisplay();
+            if (display == EGL_NO_DISPLAY || eglInitialize(display, nullptr, nullptr) != EGL_TRUE) {
+                LOGE("eglInitialize() failed");
+                return false;
+            }
+            mDisplay = display;
+
+            // A surfaceless context is made current without any surface, which also works on
+            // drivers without pbuffer support (e.g. headless Mesa).
+            const bool surfaceless = mOptions.surfaceless;
+            if (surfaceless && !HasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) {
+                LOGE("EGL_KHR_surfaceless_context is not supported");
+                return false;
+            }
+            const EGLint surfaceType = surfaceless ? 0 : (EGL_WINDOW_BIT | EGL_PBUFFER_BIT);
+
+            const EGLint chooseAttribs[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+                                            EGL_SURFACE_TYPE, surfaceType,
+                                            EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+                                            EGL_ALPHA_SIZE, 8, EGL_DEPTH_SIZE, 24, EGL_NONE};
             const EGLint configAttribs[] = {EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
                                             EGL_ALPHA_SIZE, 8, EGL_DEPTH_SIZE, 24,
                                             EGL_SAMPLE_BUFFERS, 0, EGL_SAMPLES,
                                             0, EGL_NONE};
 
-            for (int i = 0; i < numConfigs; i++) {
-                EGLint value = 0;
-                eglGetConfigAttrib(display, configs[i], EGL_RENDERABLE_TYPE, &value);
-                if ((value & EGL_OPENGL_ES3_BIT) != EGL_OPENGL_ES3_BIT) {
-                    continue;
-                }
-
-                // Without EGL_KHR_surfaceless_context, the config needs to support both pbuffers and window surfaces.
-                eglGetConfigAttrib(display, configs[i], EGL_SURFACE_TYPE, &value);
-                if ((value & (EGL_WINDOW_BIT | EGL_PBUFFER_BIT)) != (EGL_WINDOW_BIT | EGL_PBUFFER_BIT)) {
-                    continue;
-                }
-
+            // eglChooseConfig only returns configs with at least the requested sizes, so just
+            // the candidates are checked for an exact match.
+            const int MAX_CONFIGS = 64;
+            EGLConfig configs[MAX_CONFIGS];
+            EGLint numConfigs = 0;
+            EGLConfig config = nullptr;
+            eglChooseConfig(display, chooseAttribs, configs, MAX_CONFIGS, &numConfigs);
+            for (int i = 0; i < numConfigs && config == nullptr; i++) {
                 int j = 0;
                 for (; configAttribs[j] != EGL_NONE; j += 2) {
+                    EGLint value = 0;
                     eglGetConfigAttrib(display, configs[i], configAttribs[j], &value);
                     if (value != configAttribs[j + 1]) {
                         break;
@@ -60,35 +192,66 @@ namespace {
                 }
                 if (configAttribs[j] == EGL_NONE) {
                     config = configs[i];
-                    break;
                 }
             }
-            if (config == 0) {
+            if (config == nullptr) {
                 LOGE("Failed to find EGLConfig");
                 return false;
             }
             EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE, EGL_NONE, EGL_NONE};
-            context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
-            if (context == EGL_NO_CONTEXT) {
+            mContext = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+            if (mContext == EGL_NO_CONTEXT) {
                 LOGE("eglCreateContext() failed");
                 return false;
             }
-            const EGLint surfaceAttribs[] = {EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE};
-            tinySurface = eglCreatePbufferSurface(display, config, surfaceAttribs);
-            if (tinySurface == EGL_NO_SURFACE) {
-                LOGE("eglCreatePbufferSurface() failed");
-                eglDestroyContext(display, context);
-                context = EGL_NO_CONTEXT;
+            if (!surfaceless) {
+                const EGLint surfaceAttribs[] = {EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE};
+                mSurface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+                if (mSurface == EGL_NO_SURFACE) {
+                    LOGE("eglCreatePbufferSurface() failed");
+                    eglDestroyContext(display, mContext);
+                    mContext = EGL_NO_CONTEXT;
+                    return false;
+                }
+            }
+            if (eglMakeCurrent(display, mSurface, mSurface, mContext) != EGL_TRUE) {
+                LOGE("eglMakeCurrent() failed");
                 return false;
             }
-            mainSurface = tinySurface;
-            eglMakeCurrent(display, mainSurface, mainSurface, context);
+            LOGI("EGL context created%s", surfaceless ? " (surfaceless)" : "");
             return true;
         }
+
+        void InitTimerQueries() {
+            mTimerQueriesSupported = HasExtension((const char *) glGetString(GL_EXTENSIONS), "GL_EXT_disjoint_timer_query");
+            if (mTimerQueriesSupported) {
+                mGetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VEXTPROC) eglGetProcAddress("glGetQueryObjectui64vEXT");
+                mTimerQueriesSupported = mGetQueryObjectui64v != nullptr;
+            }
+            if (mTimerQueriesSupported) {
+                glGenQueries(kTimerQueryCount, mTimerQueries);
+            }
+        }
+
+    private:
+        const GraphicsOptions mOptions;
+        EGLDisplay mDisplay = EGL_NO_DISPLAY;
+        EGLContext mContext = EGL_NO_CONTEXT;
+        EGLSurface mSurface = EGL_NO_SURFACE;
+
+        RenderTargetPool mRenderTargets;
+
+        bool mTimerQueriesSupported = false;
+        PFNGLGETQUERYOBJECTUI64VEXTPROC mGetQueryObjectui64v = nullptr;
+        GLuint mTimerQueries[kTimerQueryCount] = {};
+        bool mTimerQueryPending[kTimerQueryCount] = {};
+        int mTimerQueryIndex = 0;
+        std::chrono::steady_clock::time_point mFrameBeginTime;
+        FrameTiming mFrameTiming;
     };
 }  // namespace
 
-std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_OpenGLES() {
-    return std::make_shared<OpenGLESGraphicsPlugin>();
+std::shared_ptr<IGraphicsPlugin> CreateGraphicsPlugin_OpenGLES(const GraphicsOptions &options) {
+    return std::make_shared<OpenGLESGraphicsPlugin>(options);
 }
 
@@ -1,4 +1,5 @@
 #include "graphicsplugin.h"
+#include "GLUtils.h"
 #include "PxrApi.h"
 #include "PxrInput.h"
 #include <GLES3/gl3.h>
@@ -8,17 +9,31 @@
 #include <oboe/Oboe.h>
 #include <CloudXRMatrixHelpers.h>
 #include "PxrHelper.h"
+#include "PxrEventDispatcher.h"
+#include "LoopScheduler.h"
+#include "AllocationAudit.h"
+#include "ThreadManager.h"
+#include "StartupTimeline.h"
+#include "ShutdownSequence.h"
+#include "MicroBenchmark.h"
+#include <future>
 #include <unistd.h>
 
-const int MaxEventCount = 20;
+// events handled per loop iteration; the rest wait for the next one
+const int MaxEventsPerFrame = 8;
+// the whole teardown, after which the process exits even if a step hangs
+const uint32_t ShutdownDeadlineMs = 3000;
 
 struct AndroidAppState {
     bool resumed = false;
     int recommendW{};
     int recommendH{};
     int eyeLayerId = 0;
-    uint64_t layerImages[PXR_EYE_MAX][3] = {0};
-    PxrEventDataBuffer *eventDataPointer[MaxEventCount]{};
+    bool doubleWide = false;
+    std::shared_ptr<IGraphicsPlugin> graphics;
+    uint64_t lastFrameTimingLogMs = 0;
+    PxrEventDispatcher events;
+    LoopScheduler scheduler;
     pxrPose pose{};
     CloudXRClientPXR *cloudxr = nullptr;
 };
@@ -101,11 +116,13 @@ void pxrapi_init_layers(struct android_app *app) {
     s->recommendW = recommendW;
     s->recommendH = recommendH;
 
+    s->doubleWide = s->cloudxr->GetOptions().mStereoLayout == PxrStereoLayout_DoubleWide;
+
     PxrLayerParam layerParam = {};
     layerParam.layerId = layerId;
     layerParam.layerShape = PXR_LAYER_PROJECTION;
-    layerParam.layerLayout = PXR_LAYER_LAYOUT_STEREO;
-    layerParam.width = recommendW;
+    layerParam.layerLayout = s->doubleWide ? PXR_LAYER_LAYOUT_DOUBLE_WIDE : PXR_LAYER_LAYOUT_STEREO;
+    layerParam.width = s->doubleWide ? recommendW * PXR_EYE_MAX : recommendW;
     layerParam.height = recommendH;
     layerParam.faceCount = 1;
     layerParam.mipmapCount = 1;
@@ -115,20 +132,69 @@ void pxrapi_init_layers(struct android_app *app) {
     int ret = Pxr_CreateLayer(&layerParam);
     LOGI("Pxr_CreateLayer ret = %d", ret);
 
-    int eyeCounts = 2;
-    for (int i = 0; i < eyeCounts; i++) {
-        uint32_t imageCounts = 0;
-        Pxr_GetLayerImageCount(layerId, (PxrEyeType) i, &imageCounts);
-        for (int j = 0; j < imageCounts; j++) {
-            Pxr_GetLayerImage(layerId, (PxrEyeType) i, j, &s->layerImages[i][j]);
-        }
+    // a double-wide layer has a single swapchain holding both eyes
+    if (!s->graphics->CreateRenderTargets(layerId, s->doubleWide ? 1 : PXR_EYE_MAX)) {
+        LOGE("Failed to create render targets for layer %d", layerId);
     }
 }
 
+void pxrapi_recreate_layers(struct android_app *app) {
+    auto *s = (AndroidAppState *) app->userData;
+    s->graphics->ReleaseRenderTargets();
+    Pxr_DestroyLayer(s->eyeLayerId);
+    pxrapi_init_layers(app);
+}
+
 void pxrapi_init_events(struct android_app *app) {
     auto *s = (AndroidAppState *) app->userData;
-    for (auto &i: s->eventDataPointer) {
-        i = new PxrEventDataBuffer;
+    PxrEventDispatcher &events = s->events;
+
+    events.SetHandler(PXR_TYPE_EVENT_DATA_SESSION_STATE_READY, [](const PxrEventDataBuffer &) {
+        Pxr_BeginXr();
+    });
+    events.SetHandler(PXR_TYPE_EVENT_DATA_SESSION_STATE_STOPPING, [](const PxrEventDataBuffer &) {
+        Pxr_EndXr();
+    });
+    events.SetHandler(PXR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED, [](const PxrEventDataBuffer &event) {
+        auto &data = (const PxrEventDataSessionStateChanged &) event;
+        LOGI("EVENT_DATA_SESSION_STATE_CHANGED state:%d", data.state);
+    });
+    events.SetHandler(PXR_TYPE_EVENT_DATA_CONTROLLER, [s](const PxrEventDataBuffer &event) {
+        auto &data = (const PxrEventDataControllerChanged &) event;
+        LOGI("EVENT_DATA_CONTROLLER type:%d, eventLevel:%d, eventtype:%d, controller:%d, status:%d",
+             data.type, data.eventLevel, data.eventtype, data.controller, data.status);
+        s->cloudxr->GetDeviceState().OnControllerEvent(data);
+    });
+    events.SetHandler(PXR_TYPE_EVENT_HARDIPD_STATE_CHANGED, [s](const PxrEventDataBuffer &) {
+        s->cloudxr->GetDeviceState().OnIpdChanged();
+    });
+    events.SetHandler(PXR_TYPE_EVENT_RENDER_TEXTURE_CHANGED, [app](const PxrEventDataBuffer &event) {
+        auto &data = (const PxrEventDataRenderTextureChanged &) event;
+        LOGI("EVENT_RENDER_TEXTURE_CHANGED width:%d, height:%d", data.width, data.height);
+        pxrapi_recreate_layers(app);
+    });
+    events.SetHandler(PXR_TYPE_EVENT_DATA_REFRESH_RATE_CHANGED, [s](const PxrEventDataBuffer &event) {
+        auto &data = (const PxrEventDataRefreshRateChanged &) event;
+        LOGI("EVENT_DATA_REFRESH_RATE_CHANGED rate:%f", data.refrashRate);
+        s->cloudxr->OnDisplayRefreshChanged(data.refrashRate);
+    });
+    events.SetHandler(PXR_TYPE_EVENT_DATA_MAIN_SESSION_VISIBILITY_CHANGED_EXTX, [](const PxrEventDataBuffer &event) {
+        auto &data = (const PXrEventDataMainSessionVisibilityChangedEXTX &) event;
+        LOGI("EVENT_DATA_MAIN_SESSION_VISIBILITY_CHANGED visible:%d", data.visible);
+    });
+    events.SetHandler(PXR_TYPE_EVENT_DATA_PERF_SETTINGS_EXT, [](const PxrEventDataBuffer &event) {
+        // includes thermal notifications (PXR_PERF_SETTINGS_SUB_DOMAIN_THERMAL)
+        auto &data = (const PxrEventDataPerfSettings &) event;
+        LOGI("EVENT_DATA_PERF_SETTINGS domain:%d, subDomain:%d, level:%d -> %d",
+             data.domain, data.subDomain, data.fromLevel, data.toLevel);
+    });
+    events.SetHandler(PXR_TYPE_EVENT_DATA_EVENTS_LOST, [](const PxrEventDataBuffer &event) {
+        auto &data = (const PxrEventDataEventsLost &) event;
+        LOGE("EVENT_DATA_EVENTS_LOST count:%d", data.lostEventCount);
+    });
+
+    if (s->cloudxr->GetOptions().mEventThread) {
+        events.StartPollingThread(5);
     }
 }
 
@@ -140,39 +206,57 @@ void pxrapi_init(struct android_app *app) {
     pxrapi_init_events(app);
 }
 
-void pxrapi_deinit(struct android_app *app) {
+// Client first, so no callback runs into Pxr or GL objects that are already gone; then the
+// eye layer, Pxr and EGL; the log last so every step is written.
+void add_shutdown_steps(struct android_app *app, ShutdownSequence &sequence) {
     auto *s = (AndroidAppState *) app->userData;
-    //destroy eye layer
-    Pxr_DestroyLayer(s->eyeLayerId);
-    for (auto &i: s->eventDataPointer) {
-        delete i;
-    }
-    Pxr_Shutdown();
+    s->cloudxr->AddShutdownSteps(sequence);
+    sequence.Add("event thread", [s]() {
+        s->events.StopPollingThread();
+    });
+    sequence.Add("client", [s]() {
+        delete s->cloudxr;
+        s->cloudxr = nullptr;
+    });
+    sequence.Add("eye layer", [s]() {
+        s->graphics->ReleaseRenderTargets();
+        Pxr_DestroyLayer(s->eyeLayerId);
+    });
+    sequence.Add("pxr", []() {
+        Pxr_Shutdown();
+    });
+    sequence.Add("graphics", [s]() {
+        s->graphics->Shutdown();
+    });
+    sequence.Add("log", []() {
+        AsyncLog::Shutdown();
+    });
 }
 
 void dispatch_events(struct android_app *app) {
-    int eventCount = 0;
     auto *s = (AndroidAppState *) app->userData;
+    s->events.Dispatch(MaxEventsPerFrame);
+    s->cloudxr->GetDeviceState().RefreshIfStale(GetSysCurrentTime());
+}
 
-    if (Pxr_PollEvent(MaxEventCount, &eventCount, s->eventDataPointer)) {
-        for (int i = 0; i < eventCount; i++) {
-            if (s->eventDataPointer[i]->type == PXR_TYPE_EVENT_DATA_SESSION_STATE_READY) {
-                Pxr_BeginXr();
-            } else if (s->eventDataPointer[i]->type == PXR_TYPE_EVENT_DATA_SESSION_STATE_STOPPING) {
-                Pxr_EndXr();
-            } else if (s->eventDataPointer[i]->type == PXR_TYPE_EVENT_DATA_CONTROLLER) {
-                PxrEventDataControllerChanged *data = ((PxrEventDataControllerChanged*)s->eventDataPointer[i]);
-                LOGI("EVENT_DATA_CONTROLLER type:%d, eventLevel:%d, eventtype:%d, controller:%d, status:%d", 
-                    data->type, data->eventLevel, data->eventtype, data->controller, data->status);
-            }
-        }
+void update_loop_state(struct android_app *app) {
+    auto *s = (AndroidAppState *) app->userData;
+    const bool running = Pxr_IsRunning();
+    if (running && s->cloudxr->IsStreaming()) {
+        s->scheduler.SetState(LoopState_Streaming);
+    } else if (running || s->resumed) {
+        s->scheduler.SetState(LoopState_Idle);
+    } else {
+        s->scheduler.SetState(LoopState_Paused);
     }
 }
 
-void render_frame(android_app *app, CloudXRClientPXR *cloudXR) {
+// While not streaming this only submits a cleared layer, without controller, stats or frame work.
+void render_frame(android_app *app, CloudXRClientPXR *cloudXR, bool streaming) {
     if (!Pxr_IsRunning()) {
         return;
     }
+    ALLOCATION_AUDIT_SCOPE("render_frame");
 
     auto *s = (AndroidAppState *) app->userData;
     int sensorFrameIndex;
@@ -184,9 +268,10 @@ void render_frame(android_app *app, CloudXRClientPXR *cloudXR) {
     Pxr_GetPredictedDisplayTime(&predictedDisplayTimeMs);
     Pxr_GetPredictedMainSensorState(predictedDisplayTimeMs, &sensorState, &sensorFrameIndex);
     s->pose.headPose = sensorState;
+    s->pose.predictedDisplayTimeMs = predictedDisplayTimeMs;
 
-    for (int i = 0; i < PXR_CONTROLLER_COUNT; i++) {
-        if (Pxr_GetControllerConnectStatus(i) == 1) {
+    for (int i = 0; i < PXR_CONTROLLER_COUNT && streaming; i++) {
+        if (cloudXR->GetDeviceState().IsControllerConnected(i)) {
             PxrControllerTracking tracking;
             float sensorController[7];
             sensorController[0] = sensorState.pose.orientation.x;
@@ -211,17 +296,34 @@ void render_frame(android_app *app, CloudXRClientPXR *cloudXR) {
 
     cxrFramesLatched framesLatched;
     bool frameValid = cloudXR->LatchFrame(&framesLatched);
+    if (frameValid) {
+        cloudXR->TrackLatency(framesLatched, predictedDisplayTimeMs);
+    }
 
     int imageIndex = 0;
-    Pxr_GetLayerNextImageIndex(0, &imageIndex);
+    Pxr_GetLayerNextImageIndex(s->eyeLayerId, &imageIndex);
 
-    for (int eye = 0; eye < PXR_EYE_MAX; eye++) {
-        if (cloudXR->SetupFramebuffer(s->layerImages[eye][imageIndex], eye)){
-            cxrVideoFrame &vf = framesLatched.frames[eye];
-            glViewport(0, 0, vf.widthFinal, vf.heightFinal);
-            cloudXR->BlitFrame(&framesLatched, frameValid, eye);
+    s->graphics->BeginFrameTiming();
+    if (s->doubleWide) {
+        if (s->graphics->BindRenderTarget(PXR_EYE_LEFT, imageIndex)) {
+            cloudXR->BlitStereoFrame(&framesLatched, frameValid, s->recommendW, s->recommendH);
+        }
+    } else {
+        for (int eye = 0; eye < PXR_EYE_MAX; eye++) {
+            if (s->graphics->BindRenderTarget(eye, imageIndex)) {
+                cxrVideoFrame &vf = framesLatched.frames[eye];
+                glViewport(0, 0, vf.widthFinal, vf.heightFinal);
+                cloudXR->BlitFrame(&framesLatched, frameValid, eye);
+            }
         }
     }
+    s->graphics->EndFrameTiming();
+
+    if (uint64_t(predictedDisplayTimeMs) - s->lastFrameTimingLogMs > 1000) {
+        s->lastFrameTimingLogMs = uint64_t(predictedDisplayTimeMs);
+        FrameTiming timing = s->graphics->GetFrameTiming();
+        LOGI("frametiming cpu:%.3fms, gpu:%.3fms", timing.cpuTimeNs / 1e6, timing.gpuTimeNs / 1e6);
+    }
 
     PxrLayerProjection layerProjection = {};
     layerProjection.header.layerId = s->eyeLayerId;
@@ -242,6 +344,9 @@ void render_frame(android_app *app, CloudXRClientPXR *cloudXR) {
 
     Pxr_SubmitLayer((PxrLayerHeader *) &layerProjection);
     Pxr_EndFrame();
+    if (frameValid) {
+        StartupTimeline::Mark(StartupPhase_FirstFrameSubmitted);
+    }
 }
 
 /**
@@ -250,18 +355,50 @@ void render_frame(android_app *app, CloudXRClientPXR *cloudXR) {
  * event loop for receiving input events and doing other things.
  */
 void android_main(struct android_app *app) {
+    StartupTimeline::Mark(StartupPhase_MainEntered);
     JNIEnv *Env;
     AndroidAppState appState = {};
     app->activity->vm->AttachCurrentThread(&Env, nullptr);
     app->userData = &appState;
     app->onAppCmd = app_handle_cmd;
-
-    auto *cloudXR = new CloudXRClientPXR();
+    ThreadManager::RegisterCurrentThread(ThreadRole_Render, "Render");
+
+    // the client only reads the launch options when it is created, which needs neither GL nor
+    // Pxr, so it is created while EGL comes up; Pxr then needs both the context and the options
+    std::future<CloudXRClientPXR *> client = std::async(std::launch::async, []() {
+        return new CloudXRClientPXR();
+    });
+
+    GLUtils::SetProgramCacheDir(app->activity->internalDataPath);
+    GraphicsOptions graphicsOptions;
+#ifdef CXR_SURFACELESS_EGL
+    // builds without a window system, e.g. the host tests
+    graphicsOptions.surfaceless = true;
+#endif
+    appState.graphics = CreateGraphicsPlugin(GraphicsApi_OpenGLES, graphicsOptions);
+    appState.graphics->InitializeDevice();
+    StartupTimeline::Mark(StartupPhase_GraphicsReady);
+
+    auto *cloudXR = client.get();
     appState.cloudxr = cloudXR;
-
-    std::shared_ptr<IGraphicsPlugin> graphicsPlugin=  CreateGraphicsPlugin_OpenGLES();
-    graphicsPlugin->InitializeDevice();
+    cxrGraphicsContext graphicsContext{};
+    if (appState.graphics->GetCloudXRContext(&graphicsContext)) {
+        cloudXR->SetGraphicsContext(graphicsContext);
+    } else {
+        LOGE("No %s device to hand to CloudXR", GetGraphicsApiName(appState.graphics->GetApi()));
+    }
+    cloudXR->SetDataDir(app->activity->internalDataPath);
     pxrapi_init(app);
+    StartupTimeline::Mark(StartupPhase_PxrReady);
+    cloudXR->GetDeviceState().Refresh();
+
+    if (!cloudXR->GetOptions().mBenchmarkOutput.empty()) {
+        MicroBenchmark benchmark;
+        cloudXR->AddBenchmarks(benchmark);
+        benchmark.Run();
+        benchmark.Log();
+        benchmark.WriteJson(cloudXR->GetOptions().mBenchmarkOutput);
+    }
 
     while (app->destroyRequested == 0) {
         // Read all pending events.
@@ -270,7 +407,10 @@ void android_main(struct android_app *app) {
             struct android_poll_source *source;
             // If the timeout is zero, returns immediately without blocking.
             // If the timeout is negative, waits indefinitely until an event appears.
-            const int timeoutMilliseconds = (!appState.resumed && !Pxr_IsRunning() && app->destroyRequested == 0) ? 100 : 0;
+            // The scheduler only lets the loop spin while streaming; otherwise it blocks until
+            // the next low-rate idle frame is due.
+            update_loop_state(app);
+            const int timeoutMilliseconds = app->destroyRequested == 0 ? appState.scheduler.GetPollTimeoutMs() : 0;
             if (ALooper_pollAll(timeoutMilliseconds, nullptr, &events, (void **) &source) < 0) {
                 break;
             }
@@ -283,11 +423,26 @@ void android_main(struct android_app *app) {
         dispatch_events(app);
         cloudXR->UpdateClientState();
         cloudXR->HandleStateChanges();
-        render_frame(app, cloudXR);
+        update_loop_state(app);
+        if (appState.scheduler.ShouldRenderFrame()) {
+            const bool streaming = appState.scheduler.GetState() == LoopState_Streaming;
+            render_frame(app, cloudXR, streaming);
+#ifdef CXR_ALLOCATION_AUDIT
+            if (streaming) {
+                AllocationAudit::OnStreamingFrame();
+            }
+#endif
+        }
+        appState.scheduler.OnIterationEnd();
     }
     LOGE("thread exit app->destroyRequested:%d", app->destroyRequested);
-    pxrapi_deinit(app);
-    sleep(1);
-    //exit needed to release so resouces
-    exit(0);
+#ifdef CXR_ALLOCATION_AUDIT
+    AllocationAudit::Report();
+#endif
+    ShutdownSequence shutdown;
+    add_shutdown_steps(app, shutdown);
+    shutdown.Run(ShutdownDeadlineMs);
+    // everything is released and the log is flushed; static destructors and atexit handlers of
+    // the SDK libraries would only add time, or hang, after that
+    _exit(0);
 }
\ No newline at end of file
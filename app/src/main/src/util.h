@@ -24,6 +24,7 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <unistd.h>
+#include <sys/time.h>
 #include <algorithm>
 #include <cmath>
 #include <cstdarg>
@@ -53,18 +54,30 @@
 #include <sys/system_properties.h>
 #include <PxrEnums.h>
 #include <PxrInput.h>
+#include "AsyncLog.h"
 
 
 #ifndef LOGI
-#define LOGI(...) \
-  __android_log_print(ANDROID_LOG_INFO, "CloudXRPXR_LOGI", __VA_ARGS__)
+#define LOGI(...) do { \
+  if (false) AsyncLogDetail::CheckFormat(__VA_ARGS__); \
+  AsyncLog::Write(ANDROID_LOG_INFO, "CloudXRPXR_LOGI", __VA_ARGS__); \
+} while (0)
 #endif  // LOGI
 
 #ifndef LOGE
-#define LOGE(...) \
-  __android_log_print(ANDROID_LOG_ERROR, "CloudXRPXR_LOGE", __VA_ARGS__)
+#define LOGE(...) do { \
+  if (false) AsyncLogDetail::CheckFormat(__VA_ARGS__); \
+  AsyncLog::Write(ANDROID_LOG_ERROR, "CloudXRPXR_LOGE", __VA_ARGS__); \
+} while (0)
 #endif  // LOGE
 
+// Log at most once per intervalMs from this call site; for logs inside per-frame paths.
+#define LOGI_RATE_LIMITED(intervalMs, ...) \
+  LOG_RATE_LIMITED(intervalMs, ANDROID_LOG_INFO, "CloudXRPXR_LOGI", __VA_ARGS__)
+
+#define LOGE_RATE_LIMITED(intervalMs, ...) \
+  LOG_RATE_LIMITED(intervalMs, ANDROID_LOG_ERROR, "CloudXRPXR_LOGE", __VA_ARGS__)
+
 #define GO_CHECK_GL_ERROR(...)   { \
     int errorCode = glGetError();                               \
     if (errorCode != GL_NO_ERROR) {\
@@ -86,4 +99,12 @@ static long long GetSysCurrentTime()
     return curTime;
 }
 
+// CLOCK_MONOTONIC, the clock of the Pxr display times
+inline uint64_t MonotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
 #endif
\ No newline at end of file